@@ -0,0 +1,45 @@
+#include "EngineTypes.h"
+
+// Engine libraries
+#include "PAssetCooker.h"
+
+// External libraries
+#include <SDL/SDL.h>
+
+// Offline asset cooker, run from the engine folder so asset paths match the ones the engine loads
+// --force cooks every asset even if it's up to date, --no-validate copies shaders without compiling them
+// --compact-vertices cooks models with half float positions, packed colours and octahedral normals
+// --pack PATH builds a pack archive from the cooked folder, any other argument replaces the default source folders
+int main(int argc, char* argv[])
+{
+	PSCookerSettings settings;
+	TArray<PString> folders;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const PString arg = argv[i];
+
+		if (arg == "--force")
+			settings.force = true;
+		else if (arg == "--no-validate")
+			settings.validateShaders = false;
+		else if (arg == "--compact-vertices")
+			settings.compactVertices = true;
+		else if (arg == "--pack" && i + 1 < argc)
+			settings.packPath = argv[++i];
+		else if (arg.rfind("--", 0) == 0)
+			std::cout << "Unknown argument: " << arg << std::endl;
+		else
+			folders.push_back(arg);
+	}
+
+	if (!folders.empty())
+		settings.sourceFolders = folders;
+
+	PAssetCooker cooker(settings);
+	const bool success = cooker.Run();
+
+	SDL_Quit();
+
+	return success ? 0 : -1;
+}
@@ -0,0 +1,374 @@
+// Internal headers
+#include "PAssetCooker.h"
+#include "Core/PFileSystem.h"
+#include "Core/PJson.h"
+#include "Core/PMappedFile.h"
+#include "Core/PPackFile.h"
+#include "Core/PThreadPool.h"
+#include "Debug/PProfiler.h"
+#include "Graphics/PCookedMesh.h"
+#include "Graphics/PHeadlessContext.h"
+#include "Graphics/PTextureEncoder.h"
+
+// External libraries
+#include <GLEW/glew.h>
+#include <STB_IMAGE/stb_image.h>
+
+// System libraries
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+// Enum for how an asset is cooked
+enum PECookType : PUi8
+{
+	CT_TEXTURE = 0U,    // Block-compressed into a DDS file
+	CT_MESH,            // Imported and written as a .pmesh file
+	CT_SHADER           // Validated and copied
+};
+
+// Structure for one asset of a run
+struct PSCookJob
+{
+	PString sourcePath;
+	PString outputPath;
+	PECookType type = CT_TEXTURE;
+	PUi64 hash = 0;             // Content hash of the source and everything it reads
+	bool upToDate = false;      // The manifest and the output already match the source
+	bool cooked = false;
+	PString error;
+};
+
+// FNV-1a over a block of bytes, continuing from hash
+static PUi64 HashBytes(const PUi8* data, const PUi64& size, PUi64 hash = 14695981039346656037ULL)
+{
+	for (PUi64 i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+// Work out how a file is cooked from its extension, false if the cooker doesn't handle it
+static bool GetCookType(const std::filesystem::path& path, PECookType& outType)
+{
+	PString extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+		outType = CT_TEXTURE;
+	else if (extension == ".obj" || extension == ".gltf" || extension == ".glb")
+		outType = CT_MESH;
+	else if (extension == ".vertex" || extension == ".vert" || extension == ".frag")
+		outType = CT_SHADER;
+	else
+		return false;
+
+	return true;
+}
+
+// Hash a source file together with the cooker version, the vertex layout and the external buffers of a glTF file,
+// so editing a .bin or switching layouts cooks its model again
+static bool HashSource(PSCookJob& job, const bool& compactVertices)
+{
+	PMappedFile file;
+	if (!file.Open(job.sourcePath))
+	{
+		job.error = "couldn't read the file";
+		return false;
+	}
+
+	const bool compactMesh = job.type == CT_MESH && compactVertices;
+	const PUi64 version = (static_cast<PUi64>(PASSET_COOKER_VERSION) << 16) | (static_cast<PUi64>(compactMesh) << 8) | job.type;
+	job.hash = HashBytes(reinterpret_cast<const PUi8*>(&version), sizeof(version));
+	job.hash = HashBytes(file.GetData(), file.GetSize(), job.hash);
+
+	const std::filesystem::path sourcePath(job.sourcePath);
+	if (job.type != CT_MESH || sourcePath.extension() != ".gltf")
+		return true;
+
+	PSJsonValue document;
+	if (!PJson::Parse(reinterpret_cast<const char*>(file.GetData()), static_cast<size_t>(file.GetSize()), document))
+		return true;
+
+	const PSJsonValue* buffers = document.Find("buffers");
+	for (size_t i = 0; buffers && i < buffers->Size(); ++i)
+	{
+		const PString uri = buffers->values[i].GetString("uri");
+		if (uri.empty() || uri.rfind("data:", 0) == 0)
+			continue;
+
+		PMappedFile buffer;
+		if (buffer.Open((sourcePath.parent_path() / uri).string()))
+			job.hash = HashBytes(buffer.GetData(), buffer.GetSize(), job.hash);
+	}
+
+	return true;
+}
+
+// Decode an image and block-compress it with a full mip chain, BC1 if it's opaque and BC7 if it has alpha
+static bool CookTexture(PSCookJob& job)
+{
+	// DDS files store the top row first, loaders flip them the same way they flip decoded images
+	stbi_set_flip_vertically_on_load_thread(false);
+
+	PMappedFile file;
+	int width = 0, height = 0, channels = 0;
+	unsigned char* pixels = file.Open(job.sourcePath) ?
+		stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &channels, 4) : nullptr;
+	if (pixels == nullptr)
+	{
+		job.error = file.IsOpen() ? stbi_failure_reason() : "couldn't read the file";
+		return false;
+	}
+
+	bool opaque = true;
+	const PUi64 pixelCount = static_cast<PUi64>(width) * height;
+	for (PUi64 i = 0; opaque && i < pixelCount; ++i)
+		opaque = pixels[i * 4 + 3] == 255;
+
+	PSCompressedImage image;
+	const bool encoded = PTextureEncoder::Encode(pixels, width, height, opaque ? CF_BC1 : CF_BC7, true, false, image);
+	stbi_image_free(pixels);
+
+	if (!encoded || !PCompressedTexture::SaveDDS(job.outputPath, image))
+	{
+		job.error = "couldn't encode the image";
+		return false;
+	}
+
+	PDebug::Log("Cooked " + job.sourcePath + " to " + job.outputPath + " (" + (opaque ? "BC1, " : "BC7, ") +
+		std::to_string(image.mips.size()) + " mips)", LT_SUCCESS);
+
+	return true;
+}
+
+// Compile a shader on the current context, error holds the driver's log if it fails
+static bool ValidateShader(const PString& sourcePath, PString& outError)
+{
+	PString source;
+	if (!PFileSystem::Get().ReadText(sourcePath, source))
+	{
+		outError = "couldn't read the file";
+		return false;
+	}
+
+	const PString extension = std::filesystem::path(sourcePath).extension().string();
+	const GLuint shader = glCreateShader(extension == ".frag" ? GL_FRAGMENT_SHADER : GL_VERTEX_SHADER);
+
+	const char* sourceCStr = source.c_str();
+	glShaderSource(shader, 1, &sourceCStr, nullptr);
+	glCompileShader(shader);
+
+	GLint success = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+	if (!success)
+	{
+		char infoLog[512];
+		glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+		outError = infoLog;
+	}
+
+	glDeleteShader(shader);
+
+	return success != 0;
+}
+
+bool PAssetCooker::Run()
+{
+	PPROFILE_SCOPE("Cook");
+
+	const auto start = std::chrono::steady_clock::now();
+	m_Stats = PSCookStats();
+
+	// Every source the last run cooked and the hash it was cooked from
+	const std::filesystem::path manifestPath = std::filesystem::path(PCOOKED_DIRECTORY) / PCOOK_MANIFEST_NAME;
+	std::unordered_map<PString, PUi64> manifest;
+	{
+		std::ifstream stream(manifestPath);
+		PString line;
+		while (std::getline(stream, line))
+		{
+			// Lines that don't parse are skipped, so their assets are simply cooked again
+			const size_t space = line.find(' ');
+			if (space == PString::npos || space == 0 || space + 1 == line.size())
+				continue;
+
+			PUi64 hash = 0;
+			const std::from_chars_result result = std::from_chars(line.data(), line.data() + space, hash, 16);
+			if (result.ec == std::errc() && result.ptr == line.data() + space)
+				manifest[line.substr(space + 1)] = hash;
+		}
+	}
+
+	TArray<PSCookJob> jobs;
+	TArray<PString> scannedFolders;
+	std::error_code error;
+
+	for (const PString& folder : m_Settings.sourceFolders)
+	{
+		if (!std::filesystem::is_directory(folder, error))
+		{
+			PDebug::Log("Skipping " + folder + ": it isn't a folder", LT_WARN);
+			continue;
+		}
+
+		scannedFolders.push_back((std::filesystem::path(folder).lexically_normal() / "").generic_string());
+
+		for (const auto& file : std::filesystem::recursive_directory_iterator(folder, error))
+		{
+			PSCookJob job;
+			if (!file.is_regular_file() || !GetCookType(file.path(), job.type))
+				continue;
+
+			job.sourcePath = file.path().lexically_normal().generic_string();
+			job.outputPath = PFileSystem::GetCookedPath(job.sourcePath);
+			jobs.push_back(std::move(job));
+		}
+	}
+
+	// Hash and cook textures and models in parallel, each task only touches its own job
+	const bool force = m_Settings.force;
+	const bool compactVertices = m_Settings.compactVertices;
+	const PSVertexLayoutInfo layout = compactVertices ? PCompactVertexLayout::GetInfo() : PStandardVertexLayout::GetInfo();
+
+	PThreadPool::Get().ParallelFor(static_cast<PUi32>(jobs.size()), 1,
+		[&jobs, &manifest, force, compactVertices, &layout](const PUi32 begin, const PUi32 end)
+		{
+			for (PUi32 i = begin; i < end; ++i)
+			{
+				PSCookJob& job = jobs[i];
+				if (!HashSource(job, compactVertices))
+					continue;
+
+				std::error_code fileError;
+				const auto entry = manifest.find(job.sourcePath);
+				job.upToDate = !force && entry != manifest.end() && entry->second == job.hash &&
+					std::filesystem::is_regular_file(job.outputPath, fileError);
+
+				// A source saved again without changes would look newer than its output to the engine,
+				// which would then load the source in place of the cooked file
+				if (job.upToDate)
+				{
+					std::error_code sourceError, outputError;
+					const auto sourceTime = std::filesystem::last_write_time(job.sourcePath, sourceError);
+					const auto outputTime = std::filesystem::last_write_time(job.outputPath, outputError);
+
+					if (!sourceError && !outputError && sourceTime > outputTime)
+						std::filesystem::last_write_time(job.outputPath, std::filesystem::file_time_type::clock::now(), outputError);
+				}
+
+				if (job.upToDate || job.type == CT_SHADER)
+					continue;
+
+				std::filesystem::create_directories(std::filesystem::path(job.outputPath).parent_path(), fileError);
+
+				if (job.type == CT_TEXTURE)
+					job.cooked = CookTexture(job);
+				else if (!(job.cooked = PCookedMesh::Cook(job.sourcePath, job.outputPath, layout)))
+					job.error = "couldn't import the model";
+			}
+		});
+
+	// Shaders are compiled on this thread, the only one with a context
+	PHeadlessContext context;
+	bool hasContext = false, triedContext = false;
+
+	for (PSCookJob& job : jobs)
+	{
+		if (job.type != CT_SHADER || job.upToDate || !job.error.empty())
+			continue;
+
+		if (m_Settings.validateShaders && !triedContext)
+		{
+			triedContext = true;
+			hasContext = context.Create();
+
+			// GLEW built for GLX reports a missing X display after loading the core entry points
+			const GLenum glewResult = hasContext ? glewInit() : GLEW_OK;
+			hasContext = hasContext && (glewResult == GLEW_OK || glewResult == GLEW_ERROR_NO_GLX_DISPLAY);
+
+			if (!hasContext)
+				PDebug::Log("No GL context for shader validation, shaders are copied without compiling them", LT_WARN);
+		}
+
+		if (hasContext && !ValidateShader(job.sourcePath, job.error))
+			continue;
+
+		std::filesystem::create_directories(std::filesystem::path(job.outputPath).parent_path(), error);
+		job.cooked = std::filesystem::copy_file(job.sourcePath, job.outputPath, std::filesystem::copy_options::overwrite_existing, error);
+		if (!job.cooked)
+			job.error = "couldn't copy the file: " + error.message();
+	}
+
+	context.Destroy();
+
+	// Failed assets are left out of the manifest so the next run tries them again
+	std::ostringstream manifestText;
+	std::unordered_map<PString, bool> sources;
+
+	for (const PSCookJob& job : jobs)
+	{
+		sources[job.sourcePath] = true;
+
+		if (job.upToDate)
+			++m_Stats.skipped;
+		else if (job.cooked)
+			++m_Stats.cooked;
+		else
+		{
+			++m_Stats.failed;
+			PDebug::Log("Failed to cook " + job.sourcePath + ": " + job.error, LT_ERROR);
+			continue;
+		}
+
+		manifestText << std::hex << job.hash << std::dec << ' ' << job.sourcePath << '\n';
+	}
+
+	// Remove the outputs of deleted sources so stale assets don't end up in packs,
+	// sources outside the folders cooked this run keep their entries
+	for (const auto& [sourcePath, hash] : manifest)
+	{
+		if (sources.count(sourcePath) > 0)
+			continue;
+
+		const bool scanned = std::any_of(scannedFolders.begin(), scannedFolders.end(),
+			[&sourcePath](const PString& folder) { return sourcePath.rfind(folder, 0) == 0; });
+
+		if (!scanned)
+		{
+			manifestText << std::hex << hash << std::dec << ' ' << sourcePath << '\n';
+			continue;
+		}
+
+		if (std::filesystem::remove(PFileSystem::GetCookedPath(sourcePath), error))
+			++m_Stats.removed;
+	}
+
+	std::filesystem::create_directories(PCOOKED_DIRECTORY, error);
+
+	std::ofstream manifestStream(manifestPath, std::ios::trunc);
+	manifestStream << manifestText.str();
+	if (!manifestStream.good())
+		PDebug::Log("Failed to write the cook manifest: " + manifestPath.string(), LT_ERROR);
+
+	m_Stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	PDebug::Log("Cooked " + std::to_string(m_Stats.cooked) + " assets, " + std::to_string(m_Stats.skipped) + " up to date, " +
+		std::to_string(m_Stats.failed) + " failed, " + std::to_string(m_Stats.removed) + " removed in " +
+		std::to_string(m_Stats.seconds) + "s", m_Stats.failed > 0 ? LT_ERROR : LT_SUCCESS);
+
+	if (m_Stats.failed > 0)
+		return false;
+
+	return m_Settings.packPath.empty() || PPackFile::Write(m_Settings.packPath, PCOOKED_DIRECTORY);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Bump whenever cooked output changes for the same source, every asset is cooked again
+#define PASSET_COOKER_VERSION 4
+
+// Name of the manifest the cooker keeps in PCOOKED_DIRECTORY
+#define PCOOK_MANIFEST_NAME "CookManifest.txt"
+
+// Structure for what a cooker run does
+struct PSCookerSettings
+{
+	TArray<PString> sourceFolders = { "Textures", "Shaders", "Models" };  // Folders searched for assets, relative to the working directory
+	PString packPath;               // Pack archive built from the cooked folder afterwards, empty to skip
+	bool force = false;             // Cook every asset even if it's up to date
+	bool validateShaders = true;    // Compile shaders on a headless GL context before copying them
+	bool compactVertices = false;   // Cook models in PCompactVertexLayout instead of PStandardVertexLayout
+};
+
+// Structure counting what a cooker run did
+struct PSCookStats
+{
+	PUi32 cooked = 0;       // Assets written this run
+	PUi32 skipped = 0;      // Assets whose output was already up to date
+	PUi32 failed = 0;       // Assets that couldn't be cooked
+	PUi32 removed = 0;      // Outputs deleted because their source is gone
+	double seconds = 0.0;   // Time the run took
+};
+
+// Class for the offline asset cooker
+// Images are block-compressed into DDS files with mips, OBJ and glTF models become .pmesh files and shaders are
+// validated and copied, all under PCOOKED_DIRECTORY where PFileSystem::ResolveCooked finds them.
+// A manifest records the content hash each output was cooked from, so only changed assets are cooked again.
+// Textures and models are cooked in parallel across the thread pool, shaders on the main thread with the GL context
+class PAssetCooker
+{
+public:
+	PAssetCooker(const PSCookerSettings& settings) : m_Settings(settings) {}
+	~PAssetCooker() = default;
+
+	// Cook every asset in the source folders, false if any of them failed
+	bool Run();
+
+	// Get what the last run did
+	const PSCookStats& GetStats() const { return m_Stats; }
+
+private:
+	// What to do on a run
+	PSCookerSettings m_Settings;
+
+	// What the last run did
+	PSCookStats m_Stats;
+};
@@ -0,0 +1,26 @@
+#version 460 core
+
+in vec3 fColour;
+in vec2 fTexCoords;
+flat in uint fMaterial;
+
+// Material entry written by the engine, one per texture
+struct Material {
+	uvec2 handle;
+	uint layer;
+	uint padding;
+};
+
+layout (std430, binding = 1) readonly buffer MaterialTable {
+	Material materials[];
+};
+
+// Every texture of the batch is a layer of this array
+uniform sampler2DArray colourArray;
+
+// out = going out of the shader into something else
+out vec4 finalColour;
+
+void main() {
+	finalColour = texture(colourArray, vec3(fTexCoords, float(materials[fMaterial].layer))) * vec4(fColour, 1.0);
+}
\ No newline at end of file
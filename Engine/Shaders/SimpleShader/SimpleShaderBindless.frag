@@ -0,0 +1,26 @@
+#version 460 core
+#extension GL_ARB_bindless_texture : require
+
+in vec3 fColour;
+in vec2 fTexCoords;
+flat in uint fMaterial;
+
+// Material entry written by the engine, one per texture
+struct Material {
+	uvec2 handle;
+	uint layer;
+	uint padding;
+};
+
+layout (std430, binding = 1) readonly buffer MaterialTable {
+	Material materials[];
+};
+
+// out = going out of the shader into something else
+out vec4 finalColour;
+
+void main() {
+	// The handle is a resident texture, so no texture unit is involved
+	sampler2D colourMap = sampler2D(materials[fMaterial].handle);
+	finalColour = texture(colourMap, fTexCoords) * vec4(fColour, 1.0);
+}
\ No newline at end of file
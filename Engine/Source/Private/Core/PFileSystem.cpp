@@ -0,0 +1,225 @@
+// Internal headers
+#include "Core/PFileSystem.h"
+#include "Core/PPackFile.h"
+
+// System libraries
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <mutex>
+
+void PFileData::Close()
+{
+	m_Mapping.Close();
+	TArray<PUi8>().swap(m_Buffer);
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Open = false;
+}
+
+PFileSystem& PFileSystem::Get()
+{
+	static PFileSystem fileSystem;
+	return fileSystem;
+}
+
+PFileSystem::PFileSystem()
+{
+	m_LooseFiles = true;
+	m_CookedData = true;
+	m_LooseReads = m_PackReads = m_Misses = 0;
+	m_StoredBytes = m_ExtractedBytes = 0;
+}
+
+PFileSystem::~PFileSystem() = default;
+
+bool PFileSystem::Mount(const PString& packPath)
+{
+	TUnique<PPackFile> pack = TMakeUnique<PPackFile>();
+	if (!pack->Open(packPath))
+		return false;
+
+	PDebug::Log("Mounted pack " + packPath + " with " + std::to_string(pack->GetEntryCount()) + " files");
+
+	std::unique_lock lock(m_Mutex);
+	m_Packs.push_back(std::move(pack));
+
+	return true;
+}
+
+bool PFileSystem::Open(const PString& path, PFileData& outFile)
+{
+	outFile.Close();
+
+	// Loose files win so assets can be edited without rebuilding the packs
+	std::error_code error;
+	if (m_LooseFiles && std::filesystem::is_regular_file(path, error))
+	{
+		if (outFile.m_Mapping.Open(path))
+		{
+			outFile.m_Data = outFile.m_Mapping.GetData();
+			outFile.m_Size = outFile.m_Mapping.GetSize();
+			outFile.m_Open = true;
+			++m_LooseReads;
+			return true;
+		}
+	}
+
+	const PString normalisedPath = NormalisePath(path);
+
+	std::shared_lock lock(m_Mutex);
+
+	for (auto pack = m_Packs.rbegin(); pack != m_Packs.rend(); ++pack)
+	{
+		const PSPackEntry* entry = (*pack)->Find(normalisedPath);
+		if (!entry)
+			continue;
+
+		// Raw entries are read in place, the pack stays mapped as long as it's mounted
+		if (entry->compression == PC_NONE)
+		{
+			outFile.m_Data = entry->size > 0 ? (*pack)->GetStoredData(*entry) : nullptr;
+		}
+		else
+		{
+			outFile.m_Buffer.resize(entry->size);
+			if (!(*pack)->Extract(*entry, outFile.m_Buffer.data()))
+			{
+				PDebug::Log("Failed to extract " + path + " from pack " + (*pack)->GetPath() + ": data is corrupt", LT_ERROR);
+				outFile.Close();
+				return false;
+			}
+
+			outFile.m_Data = outFile.m_Buffer.data();
+			m_ExtractedBytes += entry->size;
+		}
+
+		outFile.m_Size = entry->size;
+		outFile.m_Open = true;
+		++m_PackReads;
+		m_StoredBytes += entry->storedSize;
+		return true;
+	}
+
+	++m_Misses;
+	return false;
+}
+
+bool PFileSystem::ReadText(const PString& path, PString& outText)
+{
+	PFileData file;
+	if (!Open(path, file))
+		return false;
+
+	outText.assign(reinterpret_cast<const char*>(file.GetData()), static_cast<size_t>(file.GetSize()));
+
+	return true;
+}
+
+bool PFileSystem::Exists(const PString& path)
+{
+	std::error_code error;
+	if (m_LooseFiles && std::filesystem::is_regular_file(path, error))
+		return true;
+
+	const PString normalisedPath = NormalisePath(path);
+
+	std::shared_lock lock(m_Mutex);
+
+	for (const TUnique<PPackFile>& pack : m_Packs)
+	{
+		if (pack->Find(normalisedPath))
+			return true;
+	}
+
+	return false;
+}
+
+PString PFileSystem::ResolveCooked(const PString& path)
+{
+	if (!m_CookedData)
+		return path;
+
+	const PString cookedPath = GetCookedPath(path);
+	if (!Exists(cookedPath))
+		return path;
+
+	// A source saved after it was cooked is used until the cooker runs again, so edits show up without a cook.
+	// Cooked files that are only in a pack can't be dated and are always used
+	if (m_LooseFiles)
+	{
+		std::error_code sourceError, cookedError;
+		const auto sourceTime = std::filesystem::last_write_time(path, sourceError);
+		const auto cookedTime = std::filesystem::last_write_time(cookedPath, cookedError);
+
+		if (!sourceError && !cookedError && sourceTime > cookedTime)
+		{
+			PDebug::Log(path + " changed since it was cooked, loading the source", LT_WARN);
+			return path;
+		}
+	}
+
+	return cookedPath;
+}
+
+PString PFileSystem::GetCookedPath(const PString& sourcePath)
+{
+	// Keeps the source's case, so loose cooked files are found on case sensitive file systems too
+	std::filesystem::path cookedPath = std::filesystem::path(PCOOKED_DIRECTORY) / MakeRelative(sourcePath);
+
+	PString extension = cookedPath.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+		cookedPath.replace_extension(".dds");
+	else if (extension == ".obj" || extension == ".gltf" || extension == ".glb")
+		cookedPath.replace_extension(".pmesh");
+
+	return cookedPath.generic_string();
+}
+
+PSFileSystemStats PFileSystem::GetStats() const
+{
+	PSFileSystemStats stats;
+	stats.looseReads = m_LooseReads;
+	stats.packReads = m_PackReads;
+	stats.misses = m_Misses;
+	stats.storedBytes = m_StoredBytes;
+	stats.extractedBytes = m_ExtractedBytes;
+
+	return stats;
+}
+
+PString PFileSystem::NormalisePath(const PString& path)
+{
+	PString result = MakeRelative(path);
+
+	// Windows paths aren't case sensitive, so neither are packs
+	std::transform(result.begin(), result.end(), result.begin(),
+		[](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	return result;
+}
+
+PString PFileSystem::MakeRelative(const PString& path)
+{
+	std::filesystem::path normalised = std::filesystem::path(path).lexically_normal();
+
+	// Absolute paths under the working directory are named like relative ones
+	if (normalised.is_absolute())
+	{
+		std::error_code error;
+		const std::filesystem::path relative = normalised.lexically_relative(std::filesystem::current_path(error));
+
+		if (!error && !relative.empty() && *relative.begin() != "..")
+			normalised = relative;
+	}
+
+	PString result = normalised.generic_string();
+
+	if (result.rfind("./", 0) == 0)
+		result.erase(0, 2);
+
+	return result;
+}
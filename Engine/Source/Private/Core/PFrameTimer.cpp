@@ -0,0 +1,102 @@
+// Internal headers
+#include "Core/PFrameTimer.h"
+#include "Debug/PProfiler.h"
+
+// System libraries
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Longest frame fed to the simulation, longer stalls are dropped so the ticks can't fall further and further behind
+#define LMAX_FRAME_DELTA 0.25
+
+// Ticks allowed in a single frame before the rest of the backlog is dropped
+#define LMAX_TICKS_PER_FRAME 8
+
+PFrameTimer::PFrameTimer()
+{
+	m_TickDelta = 1.0 / 60.0;
+	m_FrameCapDelta = 0.0;
+	m_FrameDelta = 0.0;
+	m_Accumulator = 0.0;
+	m_FrameCount = 0;
+
+	// Start from the requested 1ms with a millisecond of headroom, measurements narrow it down
+	// The guess has to stay below any frame cap or the timer would spin without ever measuring a sleep
+	m_SleepEstimate = 0.002;
+	m_SleepMean = 0.001;
+	m_SleepM2 = 0.0;
+	m_SleepCount = 1;
+}
+
+void PFrameTimer::SetTickRate(const double& ticksPerSecond)
+{
+	if (ticksPerSecond <= 0.0)
+	{
+		PDebug::Log("Tick rate must be above 0", LT_WARN);
+		return;
+	}
+
+	m_TickDelta = 1.0 / ticksPerSecond;
+}
+
+void PFrameTimer::SetFrameCap(const double& framesPerSecond)
+{
+	m_FrameCapDelta = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0;
+}
+
+void PFrameTimer::BeginFrame()
+{
+	const PClock::time_point now = PClock::now();
+
+	// The first frame has nothing to measure against
+	m_FrameDelta = m_FrameCount > 0 ? std::chrono::duration<double>(now - m_FrameStart).count() : 0.0;
+	m_FrameStart = now;
+	++m_FrameCount;
+
+	m_Accumulator += std::min(m_FrameDelta, LMAX_FRAME_DELTA);
+
+	// Don't let a slow simulation queue up more ticks than it can ever run
+	m_Accumulator = std::min(m_Accumulator, m_TickDelta * LMAX_TICKS_PER_FRAME);
+}
+
+bool PFrameTimer::ShouldTick()
+{
+	if (m_Accumulator < m_TickDelta)
+		return false;
+
+	m_Accumulator -= m_TickDelta;
+	return true;
+}
+
+void PFrameTimer::LimitFrame()
+{
+	if (m_FrameCapDelta <= 0.0)
+		return;
+
+	PPROFILE_SCOPE("Frame Cap");
+
+	const PClock::time_point target = m_FrameStart +
+		std::chrono::duration_cast<PClock::duration>(std::chrono::duration<double>(m_FrameCapDelta));
+
+	// Sleep in 1ms steps while even a slow wake up would land before the target
+	while (std::chrono::duration<double>(target - PClock::now()).count() > m_SleepEstimate)
+	{
+		const PClock::time_point sleepStart = PClock::now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		const double slept = std::chrono::duration<double>(PClock::now() - sleepStart).count();
+
+		// Update the mean and deviation of real sleep lengths, the estimate keeps one deviation of headroom
+		++m_SleepCount;
+		const double delta = slept - m_SleepMean;
+		m_SleepMean += delta / static_cast<double>(m_SleepCount);
+		m_SleepM2 += delta * (slept - m_SleepMean);
+		m_SleepEstimate = m_SleepMean + std::sqrt(m_SleepM2 / static_cast<double>(m_SleepCount - 1));
+	}
+
+	// Spin through the remainder, which is too short to trust the scheduler with
+	while (PClock::now() < target)
+	{
+		std::this_thread::yield();
+	}
+}
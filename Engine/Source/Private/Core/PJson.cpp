@@ -0,0 +1,327 @@
+// Internal headers
+#include "Core/PJson.h"
+
+// System libraries
+#include <cctype>
+#include <cstdlib>
+
+// Deepest nesting accepted, stops hostile files from overflowing the stack
+#define LMAX_DEPTH 256
+
+// Structure tracking the parse position
+struct PSJsonReader
+{
+	const char* current;
+	const char* end;
+	PString error;
+
+	// Skip spaces and line breaks
+	void SkipWhitespace()
+	{
+		while (current < end && (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r'))
+			++current;
+	}
+
+	// Record the first error and fail
+	bool Fail(const PString& message)
+	{
+		if (error.empty())
+			error = message;
+
+		return false;
+	}
+};
+
+// Append a code point to a string as UTF-8
+static void AppendUTF8(PString& string, const PUi32& codePoint)
+{
+	if (codePoint < 0x80)
+	{
+		string += static_cast<char>(codePoint);
+	}
+	else if (codePoint < 0x800)
+	{
+		string += static_cast<char>(0xC0 | (codePoint >> 6));
+		string += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+	else if (codePoint < 0x10000)
+	{
+		string += static_cast<char>(0xE0 | (codePoint >> 12));
+		string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		string += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+	else
+	{
+		string += static_cast<char>(0xF0 | (codePoint >> 18));
+		string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+		string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		string += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+}
+
+// Read four hex digits of a \u escape
+static bool ReadHex4(PSJsonReader& reader, PUi32& outValue)
+{
+	if (reader.end - reader.current < 4)
+		return false;
+
+	outValue = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		const char c = *reader.current++;
+		outValue <<= 4;
+
+		if (c >= '0' && c <= '9')
+			outValue |= static_cast<PUi32>(c - '0');
+		else if (c >= 'a' && c <= 'f')
+			outValue |= static_cast<PUi32>(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')
+			outValue |= static_cast<PUi32>(c - 'A' + 10);
+		else
+			return false;
+	}
+
+	return true;
+}
+
+static bool ParseString(PSJsonReader& reader, PString& outString)
+{
+	// Skip the opening quote
+	++reader.current;
+
+	while (reader.current < reader.end)
+	{
+		const char c = *reader.current++;
+
+		if (c == '"')
+			return true;
+
+		if (c != '\\')
+		{
+			outString += c;
+			continue;
+		}
+
+		if (reader.current >= reader.end)
+			break;
+
+		const char escape = *reader.current++;
+		switch (escape)
+		{
+		case '"': outString += '"'; break;
+		case '\\': outString += '\\'; break;
+		case '/': outString += '/'; break;
+		case 'b': outString += '\b'; break;
+		case 'f': outString += '\f'; break;
+		case 'n': outString += '\n'; break;
+		case 'r': outString += '\r'; break;
+		case 't': outString += '\t'; break;
+		case 'u':
+		{
+			PUi32 codePoint = 0;
+			if (!ReadHex4(reader, codePoint))
+				return reader.Fail("Invalid unicode escape");
+
+			// Characters outside the basic plane are written as a surrogate pair
+			if (codePoint >= 0xD800 && codePoint <= 0xDBFF && reader.end - reader.current >= 6 &&
+				reader.current[0] == '\\' && reader.current[1] == 'u')
+			{
+				reader.current += 2;
+
+				PUi32 low = 0;
+				if (!ReadHex4(reader, low))
+					return reader.Fail("Invalid unicode escape");
+
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+			}
+
+			AppendUTF8(outString, codePoint);
+			break;
+		}
+		default:
+			return reader.Fail("Invalid escape in string");
+		}
+	}
+
+	return reader.Fail("Unterminated string");
+}
+
+static bool ParseValue(PSJsonReader& reader, PSJsonValue& outValue, const int& depth)
+{
+	if (depth > LMAX_DEPTH)
+		return reader.Fail("Document is nested too deeply");
+
+	reader.SkipWhitespace();
+	if (reader.current >= reader.end)
+		return reader.Fail("Unexpected end of document");
+
+	const char c = *reader.current;
+
+	if (c == '{' || c == '[')
+	{
+		const bool isObject = c == '{';
+		const char close = isObject ? '}' : ']';
+		outValue.type = isObject ? JT_OBJECT : JT_ARRAY;
+		++reader.current;
+
+		reader.SkipWhitespace();
+		if (reader.current < reader.end && *reader.current == close)
+		{
+			++reader.current;
+			return true;
+		}
+
+		while (true)
+		{
+			if (isObject)
+			{
+				reader.SkipWhitespace();
+				if (reader.current >= reader.end || *reader.current != '"')
+					return reader.Fail("Expected a member name");
+
+				PString key;
+				if (!ParseString(reader, key))
+					return false;
+
+				reader.SkipWhitespace();
+				if (reader.current >= reader.end || *reader.current != ':')
+					return reader.Fail("Expected ':' after member name");
+
+				++reader.current;
+				outValue.keys.push_back(std::move(key));
+			}
+
+			outValue.values.emplace_back();
+			if (!ParseValue(reader, outValue.values.back(), depth + 1))
+				return false;
+
+			reader.SkipWhitespace();
+			if (reader.current >= reader.end)
+				return reader.Fail("Unexpected end of document");
+
+			if (*reader.current == ',')
+			{
+				++reader.current;
+				continue;
+			}
+
+			if (*reader.current == close)
+			{
+				++reader.current;
+				return true;
+			}
+
+			return reader.Fail(isObject ? "Expected ',' or '}'" : "Expected ',' or ']'");
+		}
+	}
+
+	if (c == '"')
+	{
+		outValue.type = JT_STRING;
+		return ParseString(reader, outValue.string);
+	}
+
+	// Keywords
+	const size_t remaining = static_cast<size_t>(reader.end - reader.current);
+	if (remaining >= 4 && PString(reader.current, 4) == "true")
+	{
+		outValue.type = JT_BOOL;
+		outValue.boolean = true;
+		reader.current += 4;
+		return true;
+	}
+
+	if (remaining >= 5 && PString(reader.current, 5) == "false")
+	{
+		outValue.type = JT_BOOL;
+		reader.current += 5;
+		return true;
+	}
+
+	if (remaining >= 4 && PString(reader.current, 4) == "null")
+	{
+		reader.current += 4;
+		return true;
+	}
+
+	// Numbers, copied out since the mapped data isn't null terminated
+	const char* numberEnd = reader.current;
+	while (numberEnd < reader.end && (std::isdigit(static_cast<unsigned char>(*numberEnd)) || *numberEnd == '-' ||
+		*numberEnd == '+' || *numberEnd == '.' || *numberEnd == 'e' || *numberEnd == 'E'))
+	{
+		++numberEnd;
+	}
+
+	if (numberEnd == reader.current)
+		return reader.Fail(PString("Unexpected character '") + c + "'");
+
+	const PString number(reader.current, numberEnd);
+	char* parsedEnd = nullptr;
+	outValue.type = JT_NUMBER;
+	outValue.number = std::strtod(number.c_str(), &parsedEnd);
+
+	if (parsedEnd != number.c_str() + number.size())
+		return reader.Fail("Invalid number " + number);
+
+	reader.current = numberEnd;
+
+	return true;
+}
+
+const PSJsonValue* PSJsonValue::Find(const PString& key) const
+{
+	if (type != JT_OBJECT)
+		return nullptr;
+
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		if (keys[i] == key)
+			return &values[i];
+	}
+
+	return nullptr;
+}
+
+double PSJsonValue::GetNumber(const PString& key, const double& fallback) const
+{
+	const PSJsonValue* value = Find(key);
+	return value && value->type == JT_NUMBER ? value->number : fallback;
+}
+
+int PSJsonValue::GetInt(const PString& key, const int& fallback) const
+{
+	const PSJsonValue* value = Find(key);
+	return value && value->type == JT_NUMBER ? static_cast<int>(value->number) : fallback;
+}
+
+PString PSJsonValue::GetString(const PString& key, const PString& fallback) const
+{
+	const PSJsonValue* value = Find(key);
+	return value && value->type == JT_STRING ? value->string : fallback;
+}
+
+bool PJson::Parse(const char* data, const size_t& size, PSJsonValue& outValue, PString* error)
+{
+	PSJsonReader reader;
+	reader.current = data;
+	reader.end = data + size;
+
+	// Skip a UTF-8 byte order mark
+	if (size >= 3 && static_cast<PUi8>(data[0]) == 0xEF && static_cast<PUi8>(data[1]) == 0xBB &&
+		static_cast<PUi8>(data[2]) == 0xBF)
+	{
+		reader.current += 3;
+	}
+
+	outValue = PSJsonValue();
+	bool success = ParseValue(reader, outValue, 0);
+
+	reader.SkipWhitespace();
+	if (success && reader.current != reader.end)
+		success = reader.Fail("Unexpected data after the document");
+
+	if (!success && error)
+		*error = reader.error;
+
+	return success;
+}
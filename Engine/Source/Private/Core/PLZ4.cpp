@@ -0,0 +1,234 @@
+// Internal headers
+#include "Core/PLZ4.h"
+
+// System libraries
+#include <cstring>
+
+// Shortest match the format can encode
+#define LMIN_MATCH 4
+
+// The last bytes of a block are always literals, and the last match has to start before this many bytes from the end
+#define LLAST_LITERALS 5
+#define LMATCH_FIND_LIMIT 12
+
+// Furthest back a match can reach
+#define LMAX_OFFSET 65535
+
+// Entries in the match finder's hash table
+#define LHASH_BITS 16
+
+// Read 4 bytes without caring about alignment
+static PUi32 Read32(const PUi8* source)
+{
+	PUi32 value;
+	std::memcpy(&value, source, sizeof(value));
+	return value;
+}
+
+// Hash the next 4 bytes into a table slot
+static PUi32 Hash32(const PUi32& sequence)
+{
+	return (sequence * 2654435761U) >> (32 - LHASH_BITS);
+}
+
+// Write a length that doesn't fit in its token nibble as a run of 255s and a remainder
+static bool WriteLength(PUi64 length, PUi8*& output, const PUi8* outputEnd)
+{
+	while (length >= 255)
+	{
+		if (output >= outputEnd)
+			return false;
+
+		*output++ = 255;
+		length -= 255;
+	}
+
+	if (output >= outputEnd)
+		return false;
+
+	*output++ = static_cast<PUi8>(length);
+	return true;
+}
+
+// Write a sequence of literals followed by a match, matchLength is 0 for the final literals-only sequence
+static bool WriteSequence(const PUi8* literals, const PUi64& literalLength, const PUi32& offset, const PUi64& matchLength,
+	PUi8*& output, const PUi8* outputEnd)
+{
+	if (output >= outputEnd)
+		return false;
+
+	PUi8* token = output++;
+	*token = static_cast<PUi8>((literalLength >= 15 ? 15 : literalLength) << 4);
+
+	if (literalLength >= 15 && !WriteLength(literalLength - 15, output, outputEnd))
+		return false;
+
+	if (static_cast<PUi64>(outputEnd - output) < literalLength)
+		return false;
+
+	std::memcpy(output, literals, literalLength);
+	output += literalLength;
+
+	if (matchLength == 0)
+		return true;
+
+	if (outputEnd - output < 2)
+		return false;
+
+	*output++ = static_cast<PUi8>(offset & 0xFF);
+	*output++ = static_cast<PUi8>(offset >> 8);
+
+	const PUi64 matchCode = matchLength - LMIN_MATCH;
+	*token |= static_cast<PUi8>(matchCode >= 15 ? 15 : matchCode);
+
+	return matchCode < 15 || WriteLength(matchCode - 15, output, outputEnd);
+}
+
+PUi64 PLZ4::GetMaxCompressedSize(const PUi64& size)
+{
+	return size + size / 255 + 16;
+}
+
+PUi64 PLZ4::Compress(const PUi8* source, const PUi64& sourceSize, PUi8* destination, const PUi64& destinationCapacity)
+{
+	PUi8* output = destination;
+	const PUi8* outputEnd = destination + destinationCapacity;
+
+	const PUi8* input = source;
+	const PUi8* anchor = source;
+	const PUi8* sourceEnd = source + sourceSize;
+
+	// Blocks too small to hold a match are stored as literals
+	if (sourceSize > LMATCH_FIND_LIMIT)
+	{
+		const PUi8* matchLimit = sourceEnd - LLAST_LITERALS;
+		const PUi8* findLimit = sourceEnd - LMATCH_FIND_LIMIT;
+
+		// Last position each hash of 4 bytes was seen at
+		TArray<PUi32> table(static_cast<size_t>(1) << LHASH_BITS, 0);
+
+		++input;
+
+		while (input < findLimit)
+		{
+			const PUi32 sequence = Read32(input);
+			const PUi32 slot = Hash32(sequence);
+			const PUi8* reference = source + table[slot];
+			table[slot] = static_cast<PUi32>(input - source);
+
+			if (reference >= input || input - reference > LMAX_OFFSET || Read32(reference) != sequence)
+			{
+				// Step further the longer nothing matches, incompressible data goes by quickly
+				input += 1 + ((input - anchor) >> 6);
+				continue;
+			}
+
+			// Grow the match backwards over literals that also match
+			while (input > anchor && reference > source && input[-1] == reference[-1])
+			{
+				--input;
+				--reference;
+			}
+
+			PUi64 matchLength = LMIN_MATCH;
+			while (input + matchLength < matchLimit && input[matchLength] == reference[matchLength])
+				++matchLength;
+
+			if (!WriteSequence(anchor, static_cast<PUi64>(input - anchor), static_cast<PUi32>(input - reference), matchLength,
+				output, outputEnd))
+				return 0;
+
+			input += matchLength;
+			anchor = input;
+
+			// Remember a position inside the match so the next one can start right after it
+			if (input - 2 > source && input < findLimit)
+				table[Hash32(Read32(input - 2))] = static_cast<PUi32>(input - 2 - source);
+		}
+	}
+
+	if (!WriteSequence(anchor, static_cast<PUi64>(sourceEnd - anchor), 0, 0, output, outputEnd))
+		return 0;
+
+	return static_cast<PUi64>(output - destination);
+}
+
+bool PLZ4::Decompress(const PUi8* source, const PUi64& sourceSize, PUi8* destination, const PUi64& destinationSize)
+{
+	const PUi8* input = source;
+	const PUi8* inputEnd = source + sourceSize;
+	PUi8* output = destination;
+	PUi8* outputEnd = destination + destinationSize;
+
+	while (input < inputEnd)
+	{
+		const PUi8 token = *input++;
+
+		PUi64 literalLength = token >> 4;
+		if (literalLength == 15)
+		{
+			PUi8 extra;
+			do
+			{
+				if (input >= inputEnd)
+					return false;
+
+				extra = *input++;
+				literalLength += extra;
+			} while (extra == 255);
+		}
+
+		if (literalLength > static_cast<PUi64>(inputEnd - input) || literalLength > static_cast<PUi64>(outputEnd - output))
+			return false;
+
+		std::memcpy(output, input, literalLength);
+		input += literalLength;
+		output += literalLength;
+
+		// The last sequence has no match
+		if (input == inputEnd)
+			break;
+
+		if (inputEnd - input < 2)
+			return false;
+
+		const PUi64 offset = static_cast<PUi64>(input[0]) | (static_cast<PUi64>(input[1]) << 8);
+		input += 2;
+
+		if (offset == 0 || offset > static_cast<PUi64>(output - destination))
+			return false;
+
+		PUi64 matchLength = token & 0x0F;
+		if (matchLength == 15)
+		{
+			PUi8 extra;
+			do
+			{
+				if (input >= inputEnd)
+					return false;
+
+				extra = *input++;
+				matchLength += extra;
+			} while (extra == 255);
+		}
+
+		matchLength += LMIN_MATCH;
+		if (matchLength > static_cast<PUi64>(outputEnd - output))
+			return false;
+
+		// Matches closer than their length repeat the bytes they're copying, so they go one byte at a time
+		const PUi8* match = output - offset;
+		if (offset >= matchLength)
+		{
+			std::memcpy(output, match, matchLength);
+			output += matchLength;
+		}
+		else
+		{
+			for (PUi64 i = 0; i < matchLength; ++i)
+				*output++ = match[i];
+		}
+	}
+
+	return output == outputEnd;
+}
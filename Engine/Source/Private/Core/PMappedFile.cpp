@@ -0,0 +1,129 @@
+// Internal headers
+#include "Core/PMappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+PMappedFile::PMappedFile()
+{
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Open = false;
+	m_FileHandle = m_MappingHandle = nullptr;
+}
+
+PMappedFile::~PMappedFile()
+{
+	Close();
+}
+
+bool PMappedFile::Open(const PString& path)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_FileHandle = file;
+	m_Size = static_cast<PUi64>(size.QuadPart);
+
+	// Empty files can't be mapped, they're still valid
+	if (m_Size > 0)
+	{
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		m_MappingHandle = mapping;
+		m_Data = static_cast<const PUi8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (m_Data == nullptr)
+		{
+			Close();
+			return false;
+		}
+	}
+#else
+	const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		close(file);
+		return false;
+	}
+
+	m_Size = static_cast<PUi64>(info.st_size);
+
+	// Empty files can't be mapped, they're still valid
+	if (m_Size > 0)
+	{
+		void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			m_Size = 0;
+			return false;
+		}
+
+		// Files are read front to back, let the kernel read ahead
+		madvise(data, m_Size, MADV_SEQUENTIAL);
+		m_Data = static_cast<const PUi8*>(data);
+	}
+
+	// The mapping keeps the file alive on its own
+	close(file);
+#endif
+
+	m_Path = path;
+	m_Open = true;
+
+	return true;
+}
+
+void PMappedFile::Close()
+{
+#if defined(_WIN32)
+	if (m_Data != nullptr)
+		UnmapViewOfFile(m_Data);
+
+	if (m_MappingHandle != nullptr)
+		CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+
+	if (m_FileHandle != nullptr)
+		CloseHandle(static_cast<HANDLE>(m_FileHandle));
+#else
+	if (m_Data != nullptr)
+		munmap(const_cast<PUi8*>(m_Data), m_Size);
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Open = false;
+	m_FileHandle = m_MappingHandle = nullptr;
+	m_Path.clear();
+}
@@ -0,0 +1,290 @@
+// Internal headers
+#include "Core/PPackFile.h"
+#include "Core/PFileSystem.h"
+#include "Core/PLZ4.h"
+#include "Core/PThreadPool.h"
+
+// System libraries
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Structure for a file being packed
+struct PSPackSource
+{
+	PString path;            // Path on disk
+	PString name;            // Normalised name stored in the pack
+	TArray<PUi8> data;       // Compressed data, empty if the file is stored raw
+	PSPackEntry entry;
+	PString error;
+};
+
+// Round a byte offset up to the entry alignment
+static PUi64 AlignOffset(const PUi64& offset)
+{
+	return (offset + PPACK_ALIGNMENT - 1) / PPACK_ALIGNMENT * PPACK_ALIGNMENT;
+}
+
+bool PPackFile::Open(const PString& path)
+{
+	m_Header = nullptr;
+
+	if (!m_File.Open(path))
+	{
+		PDebug::Log("Failed to open pack: " + path, LT_ERROR);
+		return false;
+	}
+
+	const PUi64 size = m_File.GetSize();
+	const PUi8* data = m_File.GetData();
+	const PSPackHeader* header = reinterpret_cast<const PSPackHeader*>(data);
+
+	PString error;
+	if (size < sizeof(PSPackHeader) || header->magic != PPACK_MAGIC)
+		error = "not a pack file";
+	else if (header->version != PPACK_VERSION)
+		error = "version " + std::to_string(header->version) + " isn't supported, build it again";
+	else if (header->tocOffset % alignof(PSPackEntry) != 0 ||
+		header->tocOffset + static_cast<PUi64>(header->entryCount) * sizeof(PSPackEntry) > size ||
+		header->namesOffset + header->namesBytes > size)
+		error = "table of contents runs past the end of the file";
+
+	const PSPackEntry* entries = error.empty() ? reinterpret_cast<const PSPackEntry*>(data + header->tocOffset) : nullptr;
+
+	// Check every entry once so reads never have to
+	for (PUi32 i = 0; error.empty() && i < header->entryCount; ++i)
+	{
+		const PSPackEntry& entry = entries[i];
+
+		if (entry.offset + entry.storedSize > size || entry.offset % PPACK_ALIGNMENT != 0 ||
+			static_cast<PUi64>(entry.nameOffset) + entry.nameLength > header->namesBytes ||
+			(entry.compression == PC_NONE && entry.storedSize != entry.size) || entry.compression > PC_LZ4 ||
+			(i > 0 && entries[i - 1].hash > entry.hash))
+			error = "entry " + std::to_string(i) + " is invalid";
+	}
+
+	if (!error.empty())
+	{
+		PDebug::Log("Failed to open pack - " + path + ": " + error, LT_ERROR);
+		m_File.Close();
+		return false;
+	}
+
+	m_Header = header;
+	m_Entries = entries;
+	m_Names = reinterpret_cast<const char*>(data + header->namesOffset);
+
+	return true;
+}
+
+const PSPackEntry* PPackFile::Find(const PString& normalisedPath) const
+{
+	if (!m_Header)
+		return nullptr;
+
+	const PUi64 hash = HashPath(normalisedPath);
+	const PSPackEntry* end = m_Entries + m_Header->entryCount;
+	const PSPackEntry* entry = std::lower_bound(m_Entries, end, hash,
+		[](const PSPackEntry& a, const PUi64& b) { return a.hash < b; });
+
+	// Compare the names too in case two paths share a hash
+	for (; entry != end && entry->hash == hash; ++entry)
+	{
+		if (entry->nameLength == normalisedPath.size() &&
+			std::memcmp(m_Names + entry->nameOffset, normalisedPath.data(), entry->nameLength) == 0)
+			return entry;
+	}
+
+	return nullptr;
+}
+
+bool PPackFile::Extract(const PSPackEntry& entry, PUi8* outData) const
+{
+	const PUi8* stored = GetStoredData(entry);
+
+	switch (entry.compression)
+	{
+	case PC_NONE:
+		std::memcpy(outData, stored, entry.size);
+		return true;
+	case PC_LZ4:
+		return PLZ4::Decompress(stored, entry.storedSize, outData, entry.size);
+	default:
+		return false;
+	}
+}
+
+bool PPackFile::Write(const PString& outputPath, const PString& folder, const bool& compress)
+{
+	std::error_code error;
+	if (!std::filesystem::is_directory(folder, error))
+	{
+		PDebug::Log("Failed to build pack: " + folder + " isn't a folder", LT_ERROR);
+		return false;
+	}
+
+	const std::filesystem::path output = std::filesystem::absolute(outputPath, error).lexically_normal();
+
+	TArray<PSPackSource> sources;
+	for (const auto& file : std::filesystem::recursive_directory_iterator(folder, error))
+	{
+		if (!file.is_regular_file() || std::filesystem::absolute(file.path(), error).lexically_normal() == output)
+			continue;
+
+		PSPackSource source;
+		source.path = file.path().string();
+		source.name = PFileSystem::NormalisePath(source.path);
+		sources.push_back(std::move(source));
+	}
+
+	// Compress every file in parallel, each task only touches its own source
+	PThreadPool::Get().ParallelFor(static_cast<PUi32>(sources.size()), 1, [&sources, compress](const PUi32 begin, const PUi32 end)
+		{
+			for (PUi32 i = begin; i < end; ++i)
+			{
+				PSPackSource& source = sources[i];
+
+				PMappedFile file;
+				if (!file.Open(source.path))
+				{
+					source.error = "couldn't read " + source.path;
+					continue;
+				}
+
+				source.entry.hash = HashPath(source.name);
+				source.entry.size = file.GetSize();
+				source.entry.storedSize = file.GetSize();
+				source.entry.compression = PC_NONE;
+
+				if (!compress || file.GetSize() == 0)
+					continue;
+
+				source.data.resize(PLZ4::GetMaxCompressedSize(file.GetSize()));
+				const PUi64 compressedSize = PLZ4::Compress(file.GetData(), file.GetSize(), source.data.data(), source.data.size());
+
+				// Files that don't shrink are stored as they are and read in place
+				if (compressedSize == 0 || compressedSize >= file.GetSize())
+				{
+					TArray<PUi8>().swap(source.data);
+					continue;
+				}
+
+				source.data.resize(compressedSize);
+				source.data.shrink_to_fit();
+				source.entry.storedSize = compressedSize;
+				source.entry.compression = PC_LZ4;
+			}
+		});
+
+	for (const PSPackSource& source : sources)
+	{
+		if (!source.error.empty())
+		{
+			PDebug::Log("Failed to build pack - " + outputPath + ": " + source.error, LT_ERROR);
+			return false;
+		}
+	}
+
+	// The table of contents is binary searched by hash
+	std::sort(sources.begin(), sources.end(), [](const PSPackSource& a, const PSPackSource& b)
+		{
+			return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.name < b.name;
+		});
+
+	for (size_t i = 1; i < sources.size(); ++i)
+	{
+		if (sources[i].name == sources[i - 1].name)
+		{
+			PDebug::Log("Failed to build pack - " + outputPath + ": two files normalise to " + sources[i].name, LT_ERROR);
+			return false;
+		}
+	}
+
+	PSPackHeader header;
+	header.entryCount = static_cast<PUi32>(sources.size());
+	header.tocOffset = sizeof(PSPackHeader);
+	header.namesOffset = header.tocOffset + sources.size() * sizeof(PSPackEntry);
+
+	for (PSPackSource& source : sources)
+	{
+		source.entry.nameOffset = static_cast<PUi32>(header.namesBytes);
+		source.entry.nameLength = static_cast<PUi32>(source.name.size());
+		header.namesBytes += source.name.size();
+	}
+
+	PUi64 dataOffset = header.namesOffset + header.namesBytes;
+	PUi64 storedBytes = 0, originalBytes = 0;
+
+	for (PSPackSource& source : sources)
+	{
+		dataOffset = AlignOffset(dataOffset);
+		source.entry.offset = dataOffset;
+		dataOffset += source.entry.storedSize;
+		storedBytes += source.entry.storedSize;
+		originalBytes += source.entry.size;
+	}
+
+	std::ofstream stream(outputPath, std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+	{
+		PDebug::Log("Failed to build pack: couldn't write " + outputPath, LT_ERROR);
+		return false;
+	}
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const PSPackSource& source : sources)
+		stream.write(reinterpret_cast<const char*>(&source.entry), sizeof(PSPackEntry));
+
+	for (const PSPackSource& source : sources)
+		stream.write(source.name.data(), static_cast<std::streamsize>(source.name.size()));
+
+	static const char padding[PPACK_ALIGNMENT] = {};
+
+	for (const PSPackSource& source : sources)
+	{
+		const PUi64 position = static_cast<PUi64>(stream.tellp());
+		stream.write(padding, static_cast<std::streamsize>(source.entry.offset - position));
+
+		if (source.entry.compression != PC_NONE)
+		{
+			stream.write(reinterpret_cast<const char*>(source.data.data()), static_cast<std::streamsize>(source.data.size()));
+			continue;
+		}
+
+		// Raw files are copied straight from their mapping
+		PMappedFile file;
+		if (!file.Open(source.path) || file.GetSize() != source.entry.size)
+		{
+			PDebug::Log("Failed to build pack - " + outputPath + ": " + source.path + " changed while packing", LT_ERROR);
+			return false;
+		}
+
+		stream.write(reinterpret_cast<const char*>(file.GetData()), static_cast<std::streamsize>(file.GetSize()));
+	}
+
+	if (!stream.good())
+	{
+		PDebug::Log("Failed to build pack: couldn't write " + outputPath, LT_ERROR);
+		return false;
+	}
+
+	PDebug::Log("Built pack " + outputPath + " with " + std::to_string(sources.size()) + " files, " +
+		std::to_string(originalBytes / 1024) + "KB stored in " + std::to_string(storedBytes / 1024) + "KB", LT_SUCCESS);
+
+	return true;
+}
+
+PUi64 PPackFile::HashPath(const PString& normalisedPath)
+{
+	// FNV-1a
+	PUi64 hash = 14695981039346656037ULL;
+	for (const char& c : normalisedPath)
+	{
+		hash ^= static_cast<PUi8>(c);
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
@@ -0,0 +1,146 @@
+// Internal headers
+#include "Core/PThreadPool.h"
+#include "Debug/PProfiler.h"
+
+// System libraries
+#include <atomic>
+
+PThreadPool::PThreadPool(const PUi32& workerCount)
+{
+	m_Stopping = false;
+
+	for (PUi32 i = 0; i < workerCount; ++i)
+	{
+		m_Workers.emplace_back([this, i]()
+			{
+				if (PProfiler::IsEnabled())
+					PProfiler::SetThreadName("Worker " + std::to_string(i));
+
+				WorkerLoop();
+			});
+	}
+
+	PDebug::Log("Thread pool created with " + std::to_string(workerCount) + " workers");
+}
+
+PThreadPool::~PThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+
+	m_Condition.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+}
+
+PThreadPool& PThreadPool::Get()
+{
+	// Leave a core for the thread that owns the GL context
+	static PThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+	return pool;
+}
+
+void PThreadPool::Enqueue(std::function<void()> task)
+{
+	// Without workers the task runs immediately on the caller
+	if (m_Workers.empty())
+	{
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Tasks.push(std::move(task));
+	}
+
+	m_Condition.notify_one();
+}
+
+void PThreadPool::ParallelFor(const PUi32& count, const PUi32& minBatchSize, const std::function<void(PUi32, PUi32)>& func)
+{
+	if (count == 0)
+		return;
+
+	// One batch per thread, unless that makes the batches smaller than requested
+	const PUi32 threadCount = GetWorkerCount() + 1;
+	PUi32 batchSize = (count + threadCount - 1) / threadCount;
+	if (batchSize < minBatchSize)
+		batchSize = minBatchSize;
+
+	const PUi32 batchCount = (count + batchSize - 1) / batchSize;
+
+	if (batchCount <= 1)
+	{
+		func(0, count);
+		return;
+	}
+
+	// Shared between the caller and the helpers, helpers may outlive the call if they start late
+	struct PSParallelJob
+	{
+		std::atomic<PUi32> nextBatch = 0;
+		std::atomic<PUi32> finishedBatches = 0;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	TShared<PSParallelJob> job = TMakeShared<PSParallelJob>();
+
+	// Batches are claimed from a counter, so a busy pool just means the caller does more of them
+	auto runBatches = [job, &func, count, batchSize, batchCount]()
+		{
+			PUi32 batch;
+			while ((batch = job->nextBatch.fetch_add(1)) < batchCount)
+			{
+				const PUi32 begin = batch * batchSize;
+				const PUi32 end = begin + batchSize < count ? begin + batchSize : count;
+				func(begin, end);
+
+				if (job->finishedBatches.fetch_add(1) + 1 == batchCount)
+				{
+					std::lock_guard<std::mutex> lock(job->mutex);
+					job->finished.notify_all();
+				}
+			}
+		};
+
+	for (PUi32 i = 1; i < batchCount && i < threadCount; ++i)
+	{
+		Enqueue(runBatches);
+	}
+
+	runBatches();
+
+	// Wait for the batches still running on workers
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->finished.wait(lock, [&job, batchCount]() { return job->finishedBatches.load() == batchCount; });
+}
+
+void PThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+
+			if (m_Stopping && m_Tasks.empty())
+				return;
+
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop();
+		}
+
+		PPROFILE_SCOPE("Worker Task");
+		task();
+	}
+}
@@ -0,0 +1,193 @@
+// Internal headers
+#include "Debug/PMemoryTracker.h"
+
+// System libraries
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+// Structure for a registered resource
+struct PSTrackedResource
+{
+	PString name;
+	PEResourceType type = RT_MESH;
+	PUi64 cpuBytes = 0;
+	PUi64 gpuBytes = 0;
+};
+
+// Everything the tracker holds, behind one lock
+struct PSMemoryTrackerState
+{
+	std::mutex mutex;
+	std::unordered_map<PUi64, PSTrackedResource> resources;
+	PSResourceMemory totals[RT_COUNT];
+	PUi64 nextHandle = 1;
+};
+
+// Constructed on first use so resources created during static initialization are counted too
+static PSMemoryTrackerState& GetState()
+{
+	static PSMemoryTrackerState state;
+	return state;
+}
+
+// Format a byte count as kilobytes or megabytes
+static PString FormatBytes(const PUi64& bytes)
+{
+	if (bytes >= 1024 * 1024)
+		return std::to_string(bytes / (1024 * 1024)) + "." + std::to_string(bytes % (1024 * 1024) * 10 / (1024 * 1024)) + "MB";
+
+	return std::to_string((bytes + 1023) / 1024) + "KB";
+}
+
+PUi64 PMemoryTracker::Register(const PEResourceType& type, const PString& name)
+{
+	PSMemoryTrackerState& state = GetState();
+	std::lock_guard lock(state.mutex);
+
+	const PUi64 handle = state.nextHandle++;
+
+	PSTrackedResource& resource = state.resources[handle];
+	resource.name = name;
+	resource.type = type;
+	++state.totals[type].count;
+
+	return handle;
+}
+
+void PMemoryTracker::Update(const PUi64& handle, const PUi64& cpuBytes, const PUi64& gpuBytes)
+{
+	if (handle == 0)
+		return;
+
+	PSMemoryTrackerState& state = GetState();
+	std::lock_guard lock(state.mutex);
+
+	const auto found = state.resources.find(handle);
+	if (found == state.resources.end())
+		return;
+
+	PSTrackedResource& resource = found->second;
+	PSResourceMemory& totals = state.totals[resource.type];
+
+	totals.cpuBytes = totals.cpuBytes - resource.cpuBytes + cpuBytes;
+	totals.gpuBytes = totals.gpuBytes - resource.gpuBytes + gpuBytes;
+	totals.peakCpuBytes = std::max(totals.peakCpuBytes, totals.cpuBytes);
+	totals.peakGpuBytes = std::max(totals.peakGpuBytes, totals.gpuBytes);
+
+	resource.cpuBytes = cpuBytes;
+	resource.gpuBytes = gpuBytes;
+}
+
+void PMemoryTracker::Rename(const PUi64& handle, const PString& name)
+{
+	PSMemoryTrackerState& state = GetState();
+	std::lock_guard lock(state.mutex);
+
+	const auto found = state.resources.find(handle);
+	if (found != state.resources.end())
+		found->second.name = name;
+}
+
+void PMemoryTracker::Unregister(const PUi64& handle)
+{
+	if (handle == 0)
+		return;
+
+	PSMemoryTrackerState& state = GetState();
+	std::lock_guard lock(state.mutex);
+
+	const auto found = state.resources.find(handle);
+	if (found == state.resources.end())
+		return;
+
+	PSResourceMemory& totals = state.totals[found->second.type];
+	totals.cpuBytes -= found->second.cpuBytes;
+	totals.gpuBytes -= found->second.gpuBytes;
+	--totals.count;
+
+	state.resources.erase(found);
+}
+
+PSResourceMemory PMemoryTracker::GetTotals(const PEResourceType& type)
+{
+	PSMemoryTrackerState& state = GetState();
+	std::lock_guard lock(state.mutex);
+
+	return type < RT_COUNT ? state.totals[type] : PSResourceMemory();
+}
+
+PSResourceMemory PMemoryTracker::GetTotals()
+{
+	PSMemoryTrackerState& state = GetState();
+	std::lock_guard lock(state.mutex);
+
+	PSResourceMemory result;
+	for (const PSResourceMemory& totals : state.totals)
+	{
+		result.cpuBytes += totals.cpuBytes;
+		result.gpuBytes += totals.gpuBytes;
+		result.peakCpuBytes += totals.peakCpuBytes;
+		result.peakGpuBytes += totals.peakGpuBytes;
+		result.count += totals.count;
+	}
+
+	return result;
+}
+
+TArray<PSAssetMemory> PMemoryTracker::GetAssets()
+{
+	TArray<PSAssetMemory> assets;
+	{
+		PSMemoryTrackerState& state = GetState();
+		std::lock_guard lock(state.mutex);
+
+		assets.reserve(state.resources.size());
+		for (const auto& [handle, resource] : state.resources)
+			assets.push_back({ resource.name, resource.type, resource.cpuBytes, resource.gpuBytes });
+	}
+
+	std::sort(assets.begin(), assets.end(), [](const PSAssetMemory& a, const PSAssetMemory& b)
+		{
+			return a.cpuBytes + a.gpuBytes > b.cpuBytes + b.gpuBytes;
+		});
+
+	return assets;
+}
+
+const char* PMemoryTracker::GetTypeName(const PEResourceType& type)
+{
+	switch (type)
+	{
+	case RT_MESH:
+		return "Meshes";
+	case RT_MESH_POOL:
+		return "Mesh pools";
+	case RT_TEXTURE:
+		return "Textures";
+	case RT_BUFFER:
+		return "Buffers";
+	default:
+		return "Unknown";
+	}
+}
+
+void PMemoryTracker::LogReport(const PUi32& maxAssets)
+{
+	for (PUi8 type = 0; type < RT_COUNT; ++type)
+	{
+		const PSResourceMemory totals = GetTotals(static_cast<PEResourceType>(type));
+		PDebug::Log(PString(GetTypeName(static_cast<PEResourceType>(type))) + ": " + std::to_string(totals.count) + " live, CPU " +
+			FormatBytes(totals.cpuBytes) + " (peak " + FormatBytes(totals.peakCpuBytes) + "), GPU " + FormatBytes(totals.gpuBytes) +
+			" (peak " + FormatBytes(totals.peakGpuBytes) + ")");
+	}
+
+	const TArray<PSAssetMemory> assets = GetAssets();
+	const size_t count = std::min<size_t>(assets.size(), maxAssets);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		PDebug::Log("  " + assets[i].name + " (" + GetTypeName(assets[i].type) + "): CPU " + FormatBytes(assets[i].cpuBytes) +
+			", GPU " + FormatBytes(assets[i].gpuBytes));
+	}
+}
@@ -0,0 +1,310 @@
+// Internal headers
+#include "Debug/PProfiler.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+
+// Frames between re-syncing the GPU clock to the CPU clock
+#define LGPU_CALIBRATION_INTERVAL 64
+
+// Structure for the zones recorded by one thread
+// Only the owning thread writes, so the only synchronisation is publishing the count
+struct PSProfilerThreadBuffer
+{
+	PSProfilerZone zones[PPROFILER_THREAD_CAPACITY];
+	std::atomic<PUi64> count = 0;
+	PString name;
+	PUi32 id = 0;
+};
+
+// Structure for a GPU zone waiting on its timestamp queries
+struct PSProfilerGPUQuery
+{
+	const char* name = nullptr;
+	PUi32 beginQuery = 0;
+	PUi32 endQuery = 0;
+};
+
+// Structure for the GPU zones issued in one frame
+struct PSProfilerGPUFrame
+{
+	TArray<PSProfilerGPUQuery> queries;
+	PUi32 used = 0;
+};
+
+// Clock every CPU time is measured from
+static const std::chrono::steady_clock::time_point s_Epoch = std::chrono::steady_clock::now();
+
+// Recording switch
+static std::atomic<bool> s_Enabled = false;
+
+// Every thread buffer ever created, kept alive after their threads exit so they can be exported
+static std::mutex s_ThreadsMutex;
+static TArray<TUnique<PSProfilerThreadBuffer>> s_Threads;
+
+// Buffer of the calling thread, created on its first zone
+static thread_local PSProfilerThreadBuffer* s_ThreadBuffer = nullptr;
+
+// GPU zone state, only touched by the GL thread
+static PSProfilerGPUFrame s_GPUFrames[PPROFILER_GPU_LATENCY];
+static TArray<PSProfilerZone> s_GPUZones;
+static PUi64 s_FrameIndex = 0;
+static long long s_GPUToCPUOffset = 0;
+static PUi64 s_GPUDropped = 0;
+static bool s_GPUReady = false;
+
+// Get the calling thread's buffer, registering it on first use
+static PSProfilerThreadBuffer& GetThreadBuffer()
+{
+	if (s_ThreadBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+		s_Threads.push_back(TMakeUnique<PSProfilerThreadBuffer>());
+		s_ThreadBuffer = s_Threads.back().get();
+		s_ThreadBuffer->id = static_cast<PUi32>(s_Threads.size());
+		s_ThreadBuffer->name = "Thread " + std::to_string(s_ThreadBuffer->id);
+	}
+
+	return *s_ThreadBuffer;
+}
+
+// Measure the difference between the GPU and CPU clocks
+static void CalibrateGPUClock()
+{
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	s_GPUToCPUOffset = static_cast<long long>(PProfiler::Now()) - static_cast<long long>(gpuTime);
+}
+
+// Write a string as a JSON string literal
+static void WriteJSONString(std::ofstream& file, const char* text)
+{
+	file << '"';
+	for (const char* c = text; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			file << '\\';
+		file << *c;
+	}
+	file << '"';
+}
+
+// Write a zone as a Chrome trace complete event, times are in microseconds
+static void WriteZone(std::ofstream& file, const PSProfilerZone& zone, const PUi32& tid, bool& first)
+{
+	file << (first ? "\n" : ",\n") << "{\"name\":";
+	WriteJSONString(file, zone.name);
+	file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+		<< ",\"ts\":" << static_cast<double>(zone.begin) / 1000.0
+		<< ",\"dur\":" << static_cast<double>(zone.end - zone.begin) / 1000.0 << "}";
+	first = false;
+}
+
+// Write the name of a thread track
+static void WriteThreadName(std::ofstream& file, const PString& name, const PUi32& tid, bool& first)
+{
+	file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+	WriteJSONString(file, name.c_str());
+	file << "}}";
+	first = false;
+}
+
+void PProfiler::SetEnabled(const bool& enabled)
+{
+	s_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool PProfiler::IsEnabled()
+{
+	return s_Enabled.load(std::memory_order_relaxed);
+}
+
+void PProfiler::SetThreadName(const PString& name)
+{
+	PSProfilerThreadBuffer& buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+	buffer.name = name;
+}
+
+void PProfiler::InitGPU()
+{
+	if (s_GPUReady)
+		return;
+
+	CalibrateGPUClock();
+	s_GPUReady = true;
+}
+
+void PProfiler::ShutdownGPU()
+{
+	for (PSProfilerGPUFrame& frame : s_GPUFrames)
+	{
+		for (const PSProfilerGPUQuery& query : frame.queries)
+		{
+			glDeleteQueries(1, &query.beginQuery);
+			glDeleteQueries(1, &query.endQuery);
+		}
+
+		frame.queries.clear();
+		frame.used = 0;
+	}
+
+	if (s_GPUDropped > 0)
+		PDebug::Log("Profiler dropped " + std::to_string(s_GPUDropped) + " GPU zones", LT_WARN);
+
+	s_GPUReady = false;
+}
+
+void PProfiler::BeginFrame()
+{
+	if (!s_GPUReady)
+		return;
+
+	++s_FrameIndex;
+
+	if (s_FrameIndex % LGPU_CALIBRATION_INTERVAL == 0)
+		CalibrateGPUClock();
+
+	// This slot was filled PPROFILER_GPU_LATENCY frames ago, so its results should be ready
+	PSProfilerGPUFrame& frame = s_GPUFrames[s_FrameIndex % PPROFILER_GPU_LATENCY];
+
+	for (PUi32 i = 0; i < frame.used; ++i)
+	{
+		const PSProfilerGPUQuery& query = frame.queries[i];
+
+		// Never wait, a zone that still isn't finished is dropped instead
+		GLint available = 0;
+		glGetQueryObjectiv(query.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available || s_GPUZones.size() >= PPROFILER_GPU_CAPACITY)
+		{
+			++s_GPUDropped;
+			continue;
+		}
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(query.beginQuery, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(query.endQuery, GL_QUERY_RESULT, &end);
+
+		PSProfilerZone zone;
+		zone.name = query.name;
+		zone.begin = static_cast<PUi64>(static_cast<long long>(begin) + s_GPUToCPUOffset);
+		zone.end = static_cast<PUi64>(static_cast<long long>(end) + s_GPUToCPUOffset);
+		s_GPUZones.push_back(zone);
+	}
+
+	frame.used = 0;
+}
+
+void PProfiler::RecordCPUZone(const char* name, const PUi64& begin, const PUi64& end)
+{
+	PSProfilerThreadBuffer& buffer = GetThreadBuffer();
+
+	// Write the zone before publishing the new count so the exporter never reads a partial zone
+	const PUi64 count = buffer.count.load(std::memory_order_relaxed);
+	PSProfilerZone& zone = buffer.zones[count % PPROFILER_THREAD_CAPACITY];
+	zone.name = name;
+	zone.begin = begin;
+	zone.end = end;
+	buffer.count.store(count + 1, std::memory_order_release);
+}
+
+int PProfiler::BeginGPUZone(const char* name)
+{
+	if (!s_GPUReady || !IsEnabled())
+		return -1;
+
+	PSProfilerGPUFrame& frame = s_GPUFrames[s_FrameIndex % PPROFILER_GPU_LATENCY];
+
+	// Grow the frame's query pool the first time it needs more zones
+	if (frame.used == frame.queries.size())
+	{
+		PSProfilerGPUQuery query;
+		glGenQueries(1, &query.beginQuery);
+		glGenQueries(1, &query.endQuery);
+		frame.queries.push_back(query);
+	}
+
+	PSProfilerGPUQuery& query = frame.queries[frame.used];
+	query.name = name;
+	glQueryCounter(query.beginQuery, GL_TIMESTAMP);
+
+	return static_cast<int>(frame.used++);
+}
+
+void PProfiler::EndGPUZone(const int& zone)
+{
+	if (zone < 0 || !s_GPUReady)
+		return;
+
+	PSProfilerGPUFrame& frame = s_GPUFrames[s_FrameIndex % PPROFILER_GPU_LATENCY];
+	if (static_cast<PUi32>(zone) >= frame.used)
+		return;
+
+	glQueryCounter(frame.queries[zone].endQuery, GL_TIMESTAMP);
+}
+
+PUi64 PProfiler::Now()
+{
+	return static_cast<PUi64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - s_Epoch).count());
+}
+
+bool PProfiler::ExportChromeTrace(const PString& path)
+{
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		PDebug::Log("Failed to open profiler trace for writing: " + path, LT_ERROR);
+		return false;
+	}
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first = true;
+	PUi64 zoneCount = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+
+		for (const TUnique<PSProfilerThreadBuffer>& buffer : s_Threads)
+		{
+			WriteThreadName(file, buffer->name, buffer->id, first);
+
+			// Only the newest zones are kept once a buffer wraps
+			const PUi64 count = buffer->count.load(std::memory_order_acquire);
+			const PUi64 start = count > PPROFILER_THREAD_CAPACITY ? count - PPROFILER_THREAD_CAPACITY : 0;
+
+			for (PUi64 i = start; i < count; ++i)
+			{
+				WriteZone(file, buffer->zones[i % PPROFILER_THREAD_CAPACITY], buffer->id, first);
+			}
+
+			zoneCount += count - start;
+		}
+	}
+
+	// GPU zones get their own track ahead of the CPU threads
+	const PUi32 gpuTid = 0;
+	WriteThreadName(file, "GPU", gpuTid, first);
+
+	for (const PSProfilerZone& zone : s_GPUZones)
+	{
+		WriteZone(file, zone, gpuTid, first);
+	}
+
+	zoneCount += s_GPUZones.size();
+
+	file << "\n]}\n";
+
+	PDebug::Log("Profiler trace written to " + path + " (" + std::to_string(zoneCount) + " zones)", LT_SUCCESS);
+
+	return true;
+}
@@ -0,0 +1,613 @@
+// Internal headers
+#include "Graphics/PCompressedTexture.h"
+#include "Core/PFileSystem.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+// Build a little-endian FourCC code
+#define LFOURCC(a, b, c, d) (static_cast<PUi32>(a) | (static_cast<PUi32>(b) << 8) | (static_cast<PUi32>(c) << 16) | (static_cast<PUi32>(d) << 24))
+
+// DDS header flags
+#define LDDSD_CAPS 0x1
+#define LDDSD_HEIGHT 0x2
+#define LDDSD_WIDTH 0x4
+#define LDDSD_PIXELFORMAT 0x1000
+#define LDDSD_MIPMAPCOUNT 0x20000
+#define LDDSD_LINEARSIZE 0x80000
+#define LDDPF_FOURCC 0x4
+#define LDDSCAPS_COMPLEX 0x8
+#define LDDSCAPS_TEXTURE 0x1000
+#define LDDSCAPS_MIPMAP 0x400000
+
+// DXGI formats used by DX10 DDS headers
+#define LDXGI_BC1_UNORM 71
+#define LDXGI_BC1_SRGB 72
+#define LDXGI_BC3_UNORM 77
+#define LDXGI_BC3_SRGB 78
+#define LDXGI_BC5_UNORM 83
+#define LDXGI_BC7_UNORM 98
+#define LDXGI_BC7_SRGB 99
+
+// Vulkan formats used by KTX2 headers
+#define LVK_BC1_RGB_UNORM 131
+#define LVK_BC1_RGB_SRGB 132
+#define LVK_BC1_RGBA_UNORM 133
+#define LVK_BC1_RGBA_SRGB 134
+#define LVK_BC3_UNORM 137
+#define LVK_BC3_SRGB 138
+#define LVK_BC5_UNORM 141
+#define LVK_BC7_UNORM 145
+#define LVK_BC7_SRGB 146
+
+// Structure matching the DDS_PIXELFORMAT layout on disk
+struct PSDDSPixelFormat
+{
+	PUi32 size, flags, fourCC, rgbBitCount, rBitMask, gBitMask, bBitMask, aBitMask;
+};
+
+// Structure matching the DDS_HEADER layout on disk
+struct PSDDSHeader
+{
+	PUi32 size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+	PUi32 reserved1[11];
+	PSDDSPixelFormat pixelFormat;
+	PUi32 caps, caps2, caps3, caps4, reserved2;
+};
+
+// Structure matching the DDS_HEADER_DXT10 layout on disk
+struct PSDDSHeaderDX10
+{
+	PUi32 dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+};
+
+// Structure matching the fixed part of the KTX2 header on disk
+struct PSKTX2Header
+{
+	PUi8 identifier[12];
+	PUi32 vkFormat, typeSize, pixelWidth, pixelHeight, pixelDepth, layerCount, faceCount, levelCount, supercompressionScheme;
+	PUi32 dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+	PUi64 sgdByteOffset, sgdByteLength;
+};
+
+// Structure matching a KTX2 level index entry on disk
+struct PSKTX2Level
+{
+	PUi64 byteOffset, byteLength, uncompressedByteLength;
+};
+
+static_assert(sizeof(PSDDSHeader) == 124, "DDS header must match the file layout");
+static_assert(sizeof(PSKTX2Header) == 80, "KTX2 header must match the file layout");
+
+// Read a whole file into memory
+static bool ReadFile(const PString& path, TArray<PUi8>& outBytes)
+{
+	PFileData file;
+	if (!PFileSystem::Get().Open(path, file))
+	{
+		PDebug::Log("Failed to open compressed texture: " + path, LT_ERROR);
+		return false;
+	}
+
+	outBytes.assign(file.GetData(), file.GetData() + file.GetSize());
+
+	return true;
+}
+
+// Fill in the mip table for a tightly packed chain starting at offset
+static bool BuildPackedMips(PSCompressedImage& image, const PUi32& levelCount, PUi64 offset, const PUi64& available)
+{
+	PUi32 width = image.width, height = image.height;
+
+	for (PUi32 level = 0; level < levelCount; ++level)
+	{
+		PSCompressedMip mip;
+		mip.offset = offset;
+		mip.width = width;
+		mip.height = height;
+		mip.size = PCompressedTexture::GetLevelSize(image.format, width, height);
+
+		if (mip.offset + mip.size > available)
+			return false;
+
+		image.mips.push_back(mip);
+		offset += mip.size;
+
+		width = std::max(width / 2, 1U);
+		height = std::max(height / 2, 1U);
+	}
+
+	return true;
+}
+
+// Get how many levels a full mip chain down to 1x1 has
+static PUi32 GetFullChainLength(PUi32 width, PUi32 height)
+{
+	PUi32 levels = 1;
+	for (; width > 1 || height > 1; ++levels)
+	{
+		width = std::max(width / 2, 1U);
+		height = std::max(height / 2, 1U);
+	}
+
+	return levels;
+}
+
+// Read bits from a block, starting at the least significant bit of the first byte
+static PUi32 ReadBits(const PUi8* block, const PUi32& position, const PUi32& count)
+{
+	PUi32 value = 0;
+	for (PUi32 i = 0; i < count; ++i)
+		value |= ((block[(position + i) >> 3] >> ((position + i) & 7)) & 1U) << i;
+
+	return value;
+}
+
+// Write bits into a block, starting at the least significant bit of the first byte
+static void WriteBits(PUi8* block, const PUi32& position, const PUi32& count, const PUi32& value)
+{
+	for (PUi32 i = 0; i < count; ++i)
+	{
+		const PUi32 bit = position + i;
+		block[bit >> 3] = static_cast<PUi8>((block[bit >> 3] & ~(1U << (bit & 7))) | (((value >> i) & 1U) << (bit & 7)));
+	}
+}
+
+// Reverse the first rows of a BC1 colour block, each row is one byte of 2-bit indices
+static void FlipBC1Block(PUi8* block, const PUi32& rows)
+{
+	std::reverse(block + 4, block + 4 + rows);
+}
+
+// Reverse the first rows of a BC4 block, each row is 12 bits of 3-bit indices after the two endpoints
+static void FlipBC4Block(PUi8* block, const PUi32& rows)
+{
+	PUi32 rowBits[4];
+	for (PUi32 row = 0; row < rows; ++row)
+		rowBits[row] = ReadBits(block, 16 + row * 12, 12);
+
+	for (PUi32 row = 0; row < rows; ++row)
+		WriteBits(block, 16 + row * 12, 12, rowBits[rows - 1 - row]);
+}
+
+// Check if a BC7 block is mode 6, the only mode without partitions or rotations that can be flipped exactly
+static bool IsBC7Mode6(const PUi8* block)
+{
+	return (block[0] & 0x7F) == 0x40;
+}
+
+// Reverse the first rows of a BC7 mode 6 block
+// The first pixel's index is stored with its top bit implied as 0, so the endpoints are swapped if the new first pixel needs it
+static void FlipBC7Block(PUi8* block, const PUi32& rows)
+{
+	// Indices start after the mode, eight 7-bit endpoint channels and two p-bits, the first one is 3 bits wide
+	PUi32 indices[16];
+	for (PUi32 i = 0; i < 16; ++i)
+		indices[i] = i == 0 ? ReadBits(block, 65, 3) : ReadBits(block, 64 + i * 4, 4);
+
+	PUi32 flipped[16];
+	for (PUi32 i = 0; i < 16; ++i)
+	{
+		const PUi32 row = i / 4;
+		flipped[i] = row < rows ? indices[(rows - 1 - row) * 4 + i % 4] : indices[i];
+	}
+
+	if (flipped[0] >= 8)
+	{
+		for (PUi32 channel = 0; channel < 4; ++channel)
+		{
+			const PUi32 position = 7 + channel * 14;
+			const PUi32 value0 = ReadBits(block, position, 7);
+			WriteBits(block, position, 7, ReadBits(block, position + 7, 7));
+			WriteBits(block, position + 7, 7, value0);
+		}
+
+		const PUi32 pBit0 = ReadBits(block, 63, 1);
+		WriteBits(block, 63, 1, ReadBits(block, 64, 1));
+		WriteBits(block, 64, 1, pBit0);
+
+		for (PUi32& index : flipped)
+			index = 15 - index;
+	}
+
+	WriteBits(block, 65, 3, flipped[0]);
+	for (PUi32 i = 1; i < 16; ++i)
+		WriteBits(block, 64 + i * 4, 4, flipped[i]);
+}
+
+// Get a path's extension in lower case, without the dot
+static PString GetLowerExtension(const PString& path)
+{
+	const size_t dot = path.find_last_of('.');
+	if (dot == PString::npos)
+		return "";
+
+	PString extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	return extension;
+}
+
+PUi32 PSCompressedImage::GetGLFormat() const
+{
+	switch (format)
+	{
+	case CF_BC1:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case CF_BC3:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case CF_BC5:
+		return GL_COMPRESSED_RG_RGTC2;
+	case CF_BC7:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default:
+		return 0;
+	}
+}
+
+bool PCompressedTexture::IsCompressedPath(const PString& path)
+{
+	const PString extension = GetLowerExtension(path);
+	return extension == "dds" || extension == "ktx2";
+}
+
+bool PCompressedTexture::Load(const PString& path, PSCompressedImage& outImage, const bool& flipVertically)
+{
+	const bool loaded = GetLowerExtension(path) == "ktx2" ? LoadKTX2(path, outImage) : LoadDDS(path, outImage);
+
+	// An image that can't be flipped exactly is still usable, it's only shown upside down
+	if (loaded && flipVertically && !FlipVertically(outImage))
+		PDebug::Log("Compressed texture is shown upside down: " + path, LT_WARN);
+
+	return loaded;
+}
+
+bool PCompressedTexture::LoadDDS(const PString& path, PSCompressedImage& outImage)
+{
+	TArray<PUi8> bytes;
+	if (!ReadFile(path, bytes))
+		return false;
+
+	if (bytes.size() < 4 + sizeof(PSDDSHeader) || std::memcmp(bytes.data(), "DDS ", 4) != 0)
+	{
+		PDebug::Log("Not a DDS file: " + path, LT_ERROR);
+		return false;
+	}
+
+	PSDDSHeader header;
+	std::memcpy(&header, bytes.data() + 4, sizeof(header));
+	PUi64 dataOffset = 4 + sizeof(PSDDSHeader);
+
+	outImage = PSCompressedImage();
+	outImage.width = header.width;
+	outImage.height = header.height;
+
+	if (!(header.pixelFormat.flags & LDDPF_FOURCC))
+	{
+		PDebug::Log("Uncompressed DDS files aren't supported: " + path, LT_ERROR);
+		return false;
+	}
+
+	switch (header.pixelFormat.fourCC)
+	{
+	case LFOURCC('D', 'X', 'T', '1'):
+		outImage.format = CF_BC1;
+		break;
+	case LFOURCC('D', 'X', 'T', '5'):
+		outImage.format = CF_BC3;
+		break;
+	case LFOURCC('A', 'T', 'I', '2'):
+	case LFOURCC('B', 'C', '5', 'U'):
+		outImage.format = CF_BC5;
+		break;
+	case LFOURCC('D', 'X', '1', '0'):
+	{
+		if (bytes.size() < dataOffset + sizeof(PSDDSHeaderDX10))
+			break;
+
+		PSDDSHeaderDX10 dx10;
+		std::memcpy(&dx10, bytes.data() + dataOffset, sizeof(dx10));
+		dataOffset += sizeof(PSDDSHeaderDX10);
+
+		if (dx10.arraySize > 1)
+		{
+			PDebug::Log("DDS texture arrays aren't supported: " + path, LT_ERROR);
+			return false;
+		}
+
+		switch (dx10.dxgiFormat)
+		{
+		case LDXGI_BC1_SRGB: outImage.srgb = true; [[fallthrough]];
+		case LDXGI_BC1_UNORM: outImage.format = CF_BC1; break;
+		case LDXGI_BC3_SRGB: outImage.srgb = true; [[fallthrough]];
+		case LDXGI_BC3_UNORM: outImage.format = CF_BC3; break;
+		case LDXGI_BC5_UNORM: outImage.format = CF_BC5; break;
+		case LDXGI_BC7_SRGB: outImage.srgb = true; [[fallthrough]];
+		case LDXGI_BC7_UNORM: outImage.format = CF_BC7; break;
+		default: break;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+
+	if (outImage.format == CF_UNKNOWN)
+	{
+		PDebug::Log("Unsupported DDS format, expected BC1/BC3/BC5/BC7: " + path, LT_ERROR);
+		return false;
+	}
+
+	// Some writers store a count past the 1x1 level, the extra levels can't be uploaded
+	const PUi32 levelCount = (header.flags & LDDSD_MIPMAPCOUNT) ?
+		std::clamp(header.mipMapCount, 1U, GetFullChainLength(header.width, header.height)) : 1U;
+	if (!BuildPackedMips(outImage, levelCount, 0, bytes.size() - dataOffset))
+	{
+		PDebug::Log("DDS file is truncated: " + path, LT_ERROR);
+		return false;
+	}
+
+	outImage.data.assign(bytes.begin() + static_cast<std::ptrdiff_t>(dataOffset), bytes.end());
+
+	return true;
+}
+
+bool PCompressedTexture::LoadKTX2(const PString& path, PSCompressedImage& outImage)
+{
+	static const PUi8 identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	TArray<PUi8> bytes;
+	if (!ReadFile(path, bytes))
+		return false;
+
+	if (bytes.size() < sizeof(PSKTX2Header) || std::memcmp(bytes.data(), identifier, sizeof(identifier)) != 0)
+	{
+		PDebug::Log("Not a KTX2 file: " + path, LT_ERROR);
+		return false;
+	}
+
+	PSKTX2Header header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	if (header.supercompressionScheme != 0)
+	{
+		PDebug::Log("Supercompressed KTX2 files aren't supported: " + path, LT_ERROR);
+		return false;
+	}
+
+	if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+	{
+		PDebug::Log("Only 2D KTX2 textures are supported: " + path, LT_ERROR);
+		return false;
+	}
+
+	outImage = PSCompressedImage();
+	outImage.width = header.pixelWidth;
+	outImage.height = header.pixelHeight;
+
+	switch (header.vkFormat)
+	{
+	case LVK_BC1_RGB_SRGB:
+	case LVK_BC1_RGBA_SRGB: outImage.srgb = true; [[fallthrough]];
+	case LVK_BC1_RGB_UNORM:
+	case LVK_BC1_RGBA_UNORM: outImage.format = CF_BC1; break;
+	case LVK_BC3_SRGB: outImage.srgb = true; [[fallthrough]];
+	case LVK_BC3_UNORM: outImage.format = CF_BC3; break;
+	case LVK_BC5_UNORM: outImage.format = CF_BC5; break;
+	case LVK_BC7_SRGB: outImage.srgb = true; [[fallthrough]];
+	case LVK_BC7_UNORM: outImage.format = CF_BC7; break;
+	default: break;
+	}
+
+	if (outImage.format == CF_UNKNOWN)
+	{
+		PDebug::Log("Unsupported KTX2 format, expected BC1/BC3/BC5/BC7: " + path, LT_ERROR);
+		return false;
+	}
+
+	// A level count of 0 asks the loader to generate mips, only the base level is stored
+	const PUi32 levelCount = std::clamp(header.levelCount, 1U, GetFullChainLength(header.pixelWidth, header.pixelHeight));
+	const PUi64 levelIndexEnd = sizeof(PSKTX2Header) + static_cast<PUi64>(levelCount) * sizeof(PSKTX2Level);
+	if (bytes.size() < levelIndexEnd)
+	{
+		PDebug::Log("KTX2 file is truncated: " + path, LT_ERROR);
+		return false;
+	}
+
+	// Levels are stored smallest first but each has its own offset, so the data is kept in place
+	PUi32 width = outImage.width, height = outImage.height;
+	for (PUi32 level = 0; level < levelCount; ++level)
+	{
+		PSKTX2Level entry;
+		std::memcpy(&entry, bytes.data() + sizeof(PSKTX2Header) + level * sizeof(PSKTX2Level), sizeof(entry));
+
+		PSCompressedMip mip;
+		mip.offset = entry.byteOffset;
+		mip.size = entry.byteLength;
+		mip.width = width;
+		mip.height = height;
+
+		if (mip.offset + mip.size > bytes.size() || mip.size < GetLevelSize(outImage.format, width, height))
+		{
+			PDebug::Log("KTX2 file is truncated: " + path, LT_ERROR);
+			return false;
+		}
+
+		outImage.mips.push_back(mip);
+
+		width = std::max(width / 2, 1U);
+		height = std::max(height / 2, 1U);
+	}
+
+	outImage.data = std::move(bytes);
+
+	return true;
+}
+
+bool PCompressedTexture::SaveDDS(const PString& path, const PSCompressedImage& image)
+{
+	if (image.mips.empty())
+	{
+		PDebug::Log("Can't save an empty compressed image: " + path, LT_ERROR);
+		return false;
+	}
+
+	PSDDSHeader header = {};
+	header.size = sizeof(PSDDSHeader);
+	header.flags = LDDSD_CAPS | LDDSD_HEIGHT | LDDSD_WIDTH | LDDSD_PIXELFORMAT | LDDSD_MIPMAPCOUNT | LDDSD_LINEARSIZE;
+	header.height = image.height;
+	header.width = image.width;
+	header.pitchOrLinearSize = static_cast<PUi32>(image.mips[0].size);
+	header.mipMapCount = static_cast<PUi32>(image.mips.size());
+	header.pixelFormat.size = sizeof(PSDDSPixelFormat);
+	header.pixelFormat.flags = LDDPF_FOURCC;
+	header.pixelFormat.fourCC = LFOURCC('D', 'X', '1', '0');
+	header.caps = LDDSCAPS_TEXTURE | (image.mips.size() > 1 ? LDDSCAPS_MIPMAP | LDDSCAPS_COMPLEX : 0);
+
+	PSDDSHeaderDX10 dx10 = {};
+	dx10.resourceDimension = 3; // Texture 2D
+	dx10.arraySize = 1;
+
+	switch (image.format)
+	{
+	case CF_BC1: dx10.dxgiFormat = image.srgb ? LDXGI_BC1_SRGB : LDXGI_BC1_UNORM; break;
+	case CF_BC3: dx10.dxgiFormat = image.srgb ? LDXGI_BC3_SRGB : LDXGI_BC3_UNORM; break;
+	case CF_BC5: dx10.dxgiFormat = LDXGI_BC5_UNORM; break;
+	case CF_BC7: dx10.dxgiFormat = image.srgb ? LDXGI_BC7_SRGB : LDXGI_BC7_UNORM; break;
+	default:
+		PDebug::Log("Can't save an unknown compressed format: " + path, LT_ERROR);
+		return false;
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		PDebug::Log("Failed to open compressed texture for writing: " + path, LT_ERROR);
+		return false;
+	}
+
+	file.write("DDS ", 4);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+
+	// DDS stores the chain largest first with no padding
+	for (const PSCompressedMip& mip : image.mips)
+	{
+		file.write(reinterpret_cast<const char*>(image.data.data() + mip.offset), static_cast<std::streamsize>(mip.size));
+	}
+
+	return static_cast<bool>(file);
+}
+
+bool PCompressedTexture::FlipVertically(PSCompressedImage& image)
+{
+	// Whole block rows are swapped, so a level only flips exactly if it has no partial block row at the bottom
+	size_t levelCount = 0;
+	while (levelCount < image.mips.size() && (image.mips[levelCount].height <= 4 || image.mips[levelCount].height % 4 == 0))
+		++levelCount;
+
+	if (levelCount == 0)
+		return false;
+
+	const PUi32 blockSize = GetBlockSize(image.format);
+
+	if (image.format == CF_BC7)
+	{
+		for (size_t level = 0; level < levelCount; ++level)
+		{
+			const PSCompressedMip& mip = image.mips[level];
+			for (PUi64 offset = 0; offset < mip.size; offset += blockSize)
+			{
+				if (!IsBC7Mode6(image.data.data() + mip.offset + offset))
+					return false;
+			}
+		}
+	}
+
+	if (levelCount < image.mips.size())
+	{
+		PDebug::Log("Dropped " + std::to_string(image.mips.size() - levelCount) +
+			" compressed mip levels whose height isn't a multiple of 4, they can't be flipped", LT_WARN);
+		image.mips.resize(levelCount);
+	}
+
+	TArray<PUi8> source;
+	for (const PSCompressedMip& mip : image.mips)
+	{
+		const PUi64 rowSize = static_cast<PUi64>(std::max((mip.width + 3) / 4, 1U)) * blockSize;
+		const PUi64 blockRows = mip.size / rowSize;
+		const PUi32 rows = std::min(mip.height, 4U);
+
+		PUi8* data = image.data.data() + mip.offset;
+		source.assign(data, data + blockRows * rowSize);
+
+		for (PUi64 blockRow = 0; blockRow < blockRows; ++blockRow)
+		{
+			PUi8* row = data + blockRow * rowSize;
+			std::memcpy(row, source.data() + (blockRows - 1 - blockRow) * rowSize, rowSize);
+
+			for (PUi8* block = row; block < row + rowSize; block += blockSize)
+			{
+				switch (image.format)
+				{
+				case CF_BC1:
+					FlipBC1Block(block, rows);
+					break;
+				case CF_BC3:
+					FlipBC4Block(block, rows);
+					FlipBC1Block(block + 8, rows);
+					break;
+				case CF_BC5:
+					FlipBC4Block(block, rows);
+					FlipBC4Block(block + 8, rows);
+					break;
+				case CF_BC7:
+					FlipBC7Block(block, rows);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+PUi32 PCompressedTexture::GetBlockSize(const PECompressedFormat& format)
+{
+	return format == CF_BC1 ? 8 : 16;
+}
+
+PUi64 PCompressedTexture::GetLevelSize(const PECompressedFormat& format, const PUi32& width, const PUi32& height)
+{
+	const PUi64 blocksX = std::max((width + 3) / 4, 1U);
+	const PUi64 blocksY = std::max((height + 3) / 4, 1U);
+
+	return blocksX * blocksY * GetBlockSize(format);
+}
+
+PECompressedFormat PCompressedTexture::FormatFromName(const PString& name)
+{
+	PString lower = name;
+	std::transform(lower.begin(), lower.end(), lower.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if (lower == "bc1")
+		return CF_BC1;
+	if (lower == "bc3")
+		return CF_BC3;
+	if (lower == "bc5")
+		return CF_BC5;
+	if (lower == "bc7")
+		return CF_BC7;
+
+	return CF_UNKNOWN;
+}
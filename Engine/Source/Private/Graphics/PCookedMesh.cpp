@@ -0,0 +1,270 @@
+// Internal headers
+#include "Graphics/PCookedMesh.h"
+#include "Graphics/PMeshImporter.h"
+#include "Graphics/PMeshOptimizer.h"
+
+// External libraries
+#include <GLM/glm.hpp>
+
+// System libraries
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// Round a byte offset up to the blob alignment
+static PUi64 AlignOffset(const PUi64& offset)
+{
+	return (offset + PCOOKED_MESH_ALIGNMENT - 1) / PCOOKED_MESH_ALIGNMENT * PCOOKED_MESH_ALIGNMENT;
+}
+
+// Write zeros until the stream reaches offset
+static void PadTo(std::ofstream& stream, const PUi64& offset)
+{
+	static const char zeros[PCOOKED_MESH_ALIGNMENT] = {};
+
+	PUi64 position = static_cast<PUi64>(stream.tellp());
+	while (position < offset)
+	{
+		const PUi64 count = std::min<PUi64>(offset - position, sizeof(zeros));
+		stream.write(zeros, static_cast<std::streamsize>(count));
+		position += count;
+	}
+}
+
+bool PCookedMesh::Open(const PString& path)
+{
+	Close();
+
+	if (!PFileSystem::Get().Open(path, m_File))
+	{
+		PDebug::Log("Failed to open cooked mesh: " + path, LT_ERROR);
+		return false;
+	}
+
+	const PUi64 size = m_File.GetSize();
+	const PUi8* data = m_File.GetData();
+
+	if (size < sizeof(PSCookedMeshHeader))
+	{
+		PDebug::Log("Failed to open cooked mesh - " + path + ": file is too small", LT_ERROR);
+		m_File.Close();
+		return false;
+	}
+
+	// Mappings are page aligned and pack entries 16 byte aligned, so the header can be read in place
+	const PSCookedMeshHeader* header = reinterpret_cast<const PSCookedMeshHeader*>(data);
+
+	PString error;
+	if (header->magic != PCOOKED_MESH_MAGIC)
+		error = "not a cooked mesh";
+	else if (header->version != PCOOKED_MESH_VERSION || header->headerSize != sizeof(PSCookedMeshHeader))
+		error = "version " + std::to_string(header->version) + " isn't supported, cook it again";
+	else if (header->vertexStride == 0 || header->attributeCount > PCOOKED_MESH_MAX_ATTRIBUTES ||
+		(header->indexSize != sizeof(PUi16) && header->indexSize != sizeof(PUi32)))
+		error = "invalid vertex layout";
+	else if (header->vertexOffset % PCOOKED_MESH_ALIGNMENT != 0 || header->indexOffset % PCOOKED_MESH_ALIGNMENT != 0 ||
+		header->submeshOffset % alignof(PSCookedSubmesh) != 0)
+		error = "misaligned data";
+	else if (header->vertexOffset + header->vertexBytes > size || header->indexOffset + header->indexBytes > size ||
+		header->submeshOffset + static_cast<PUi64>(header->submeshCount) * sizeof(PSCookedSubmesh) > size ||
+		header->vertexBytes % header->vertexStride != 0 || header->indexBytes % header->indexSize != 0)
+		error = "data runs past the end of the file";
+
+	for (PUi32 i = 0; error.empty() && i < header->attributeCount; ++i)
+	{
+		if (header->attributes[i].components == 0 || header->attributes[i].components > 4 ||
+			header->attributes[i].offset >= header->vertexStride)
+			error = "invalid vertex attribute";
+	}
+
+	// Every submesh has to stay inside the blobs, the indices themselves are trusted
+	const PSCookedSubmesh* submeshes = reinterpret_cast<const PSCookedSubmesh*>(data + header->submeshOffset);
+	const PUi64 vertexCount = error.empty() ? header->vertexBytes / header->vertexStride : 0;
+	const PUi64 indexCount = error.empty() ? header->indexBytes / header->indexSize : 0;
+
+	for (PUi32 i = 0; error.empty() && i < header->submeshCount; ++i)
+	{
+		if (static_cast<PUi64>(submeshes[i].baseVertex) + submeshes[i].vertexCount > vertexCount ||
+			static_cast<PUi64>(submeshes[i].firstIndex) + submeshes[i].indexCount > indexCount)
+			error = "submesh " + std::to_string(i) + " is out of range";
+	}
+
+	if (!error.empty())
+	{
+		PDebug::Log("Failed to open cooked mesh - " + path + ": " + error, LT_ERROR);
+		m_File.Close();
+		return false;
+	}
+
+	m_Header = header;
+	m_Submeshes = submeshes;
+
+	return true;
+}
+
+bool PCookedMesh::HasVertexLayout(const PSVertexLayoutInfo& layout) const
+{
+	if (!m_Header || m_Header->vertexStride != layout.stride || m_Header->attributeCount != layout.attributeCount)
+		return false;
+
+	for (PUi32 i = 0; i < m_Header->attributeCount; ++i)
+	{
+		const PSVertexAttribute& a = m_Header->attributes[i];
+		const PSVertexAttribute& b = layout.attributes[i];
+
+		if (a.location != b.location || a.components != b.components || a.type != b.type ||
+			(a.normalized != 0) != (b.normalized != 0) || a.offset != b.offset)
+			return false;
+	}
+
+	return true;
+}
+
+bool PCookedMesh::Write(const PString& path, const TArray<PSImportedMesh>& meshes, const PSVertexLayoutInfo& layout)
+{
+	if (layout.attributeCount > PCOOKED_MESH_MAX_ATTRIBUTES)
+	{
+		PDebug::Log("Failed to write cooked mesh - " + path + ": the vertex layout has too many attributes", LT_ERROR);
+		return false;
+	}
+
+	// Indices are relative to their submesh, so 16 bits are enough if every submesh is small enough
+	const bool shortIndices = std::all_of(meshes.begin(), meshes.end(),
+		[](const PSImportedMesh& mesh) { return PVertexLayout::FitsShortIndices(mesh.vertices.size()); });
+
+	PSCookedMeshHeader header;
+	header.headerSize = sizeof(PSCookedMeshHeader);
+	header.vertexStride = layout.stride;
+	header.indexSize = shortIndices ? sizeof(PUi16) : sizeof(PUi32);
+	header.attributeCount = layout.attributeCount;
+	header.submeshCount = static_cast<PUi32>(meshes.size());
+	std::copy(layout.attributes, layout.attributes + layout.attributeCount, header.attributes);
+
+	// Lay out the submeshes back to back in the shared blobs
+	TArray<PSCookedSubmesh> submeshes(meshes.size());
+	PUi64 vertexCount = 0, indexCount = 0;
+	glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
+
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		const PSImportedMesh& mesh = meshes[i];
+		PSCookedSubmesh& submesh = submeshes[i];
+
+		submesh.baseVertex = static_cast<PUi32>(vertexCount);
+		submesh.vertexCount = static_cast<PUi32>(mesh.vertices.size());
+		submesh.firstIndex = static_cast<PUi32>(indexCount);
+		submesh.indexCount = static_cast<PUi32>(mesh.indices.size());
+		std::strncpy(submesh.name, mesh.name.c_str(), PCOOKED_MESH_NAME_SIZE - 1);
+
+		vertexCount += mesh.vertices.size();
+		indexCount += mesh.indices.size();
+
+		if (mesh.vertices.empty())
+			continue;
+
+		// Same fit as PMesh, centered on the bounding box and grown to the furthest vertex
+		glm::vec3 meshMin = glm::vec3(mesh.vertices[0].m_Position[0], mesh.vertices[0].m_Position[1], mesh.vertices[0].m_Position[2]);
+		glm::vec3 meshMax = meshMin;
+
+		for (const PSVertexData& vertex : mesh.vertices)
+		{
+			const glm::vec3 position = glm::vec3(vertex.m_Position[0], vertex.m_Position[1], vertex.m_Position[2]);
+			meshMin = glm::min(meshMin, position);
+			meshMax = glm::max(meshMax, position);
+		}
+
+		const glm::vec3 center = (meshMin + meshMax) * 0.5f;
+		float radiusSquared = 0.0f;
+
+		for (const PSVertexData& vertex : mesh.vertices)
+		{
+			const glm::vec3 offset = glm::vec3(vertex.m_Position[0], vertex.m_Position[1], vertex.m_Position[2]) - center;
+			radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+		}
+
+		submesh.boundingSphere[0] = center.x;
+		submesh.boundingSphere[1] = center.y;
+		submesh.boundingSphere[2] = center.z;
+		submesh.boundingSphere[3] = glm::sqrt(radiusSquared);
+
+		const bool first = submesh.baseVertex == 0;
+		boundsMin = first ? meshMin : glm::min(boundsMin, meshMin);
+		boundsMax = first ? meshMax : glm::max(boundsMax, meshMax);
+	}
+
+	if (vertexCount > 0xFFFFFFFFULL || indexCount > 0xFFFFFFFFULL)
+	{
+		PDebug::Log("Failed to write cooked mesh - " + path + ": too many vertices", LT_ERROR);
+		return false;
+	}
+
+	std::memcpy(header.boundsMin, &boundsMin[0], sizeof(header.boundsMin));
+	std::memcpy(header.boundsMax, &boundsMax[0], sizeof(header.boundsMax));
+
+	header.submeshOffset = sizeof(PSCookedMeshHeader);
+	header.vertexOffset = AlignOffset(header.submeshOffset + submeshes.size() * sizeof(PSCookedSubmesh));
+	header.vertexBytes = vertexCount * layout.stride;
+	header.indexOffset = AlignOffset(header.vertexOffset + header.vertexBytes);
+	header.indexBytes = indexCount * header.indexSize;
+
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+	{
+		PDebug::Log("Failed to write cooked mesh: " + path, LT_ERROR);
+		return false;
+	}
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(submeshes.data()), static_cast<std::streamsize>(submeshes.size() * sizeof(PSCookedSubmesh)));
+
+	// Submeshes are encoded one at a time so only one of them is held in the layout at once
+	TArray<PUi8> encoded;
+
+	PadTo(stream, header.vertexOffset);
+	for (const PSImportedMesh& mesh : meshes)
+	{
+		encoded.resize(mesh.vertices.size() * layout.stride);
+		PVertexLayout::Encode(layout, mesh.vertices.data(), mesh.vertices.size(), encoded.data());
+		stream.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+	}
+
+	PadTo(stream, header.indexOffset);
+	for (const PSImportedMesh& mesh : meshes)
+	{
+		if (!shortIndices)
+		{
+			stream.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(PUi32)));
+			continue;
+		}
+
+		const TArray<PUi16> narrowed(mesh.indices.begin(), mesh.indices.end());
+		stream.write(reinterpret_cast<const char*>(narrowed.data()), static_cast<std::streamsize>(narrowed.size() * sizeof(PUi16)));
+	}
+
+	if (!stream.good())
+	{
+		PDebug::Log("Failed to write cooked mesh: " + path, LT_ERROR);
+		return false;
+	}
+
+	return true;
+}
+
+bool PCookedMesh::Cook(const PString& sourcePath, const PString& outputPath, const PSVertexLayoutInfo& layout)
+{
+	TArray<PSImportedMesh> meshes;
+	if (!PMeshImporter::Import(sourcePath, meshes))
+		return false;
+
+	// Cooked meshes are loaded as they're stored, so this is the one place their order is optimized
+	PSMeshOptimizeStats optimizeStats;
+	PMeshOptimizer::Optimize(meshes, PSMeshOptimizeSettings(), &optimizeStats);
+
+	if (!Write(outputPath, meshes, layout))
+		return false;
+
+	PDebug::Log("Cooked " + sourcePath + " to " + outputPath + " (" + std::to_string(meshes.size()) + " submeshes, " +
+		std::to_string(layout.stride) + " byte vertices, " + PMeshOptimizer::FormatStats(optimizeStats) + ")", LT_SUCCESS);
+
+	return true;
+}
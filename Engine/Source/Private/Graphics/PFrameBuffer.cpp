@@ -0,0 +1,106 @@
+// Internal headers
+#include "Graphics/PFrameBuffer.h"
+#include "Graphics/PGLState.h"
+
+// External libraries
+#include <GLEW/glew.h>
+#include <SDL/SDL.h>
+
+// System libraries
+#include <cstring>
+
+PFrameBuffer::PFrameBuffer()
+{
+	m_ID = m_ColourTexture = m_DepthBuffer = 0;
+	m_Width = m_Height = 0;
+}
+
+PFrameBuffer::~PFrameBuffer()
+{
+	if (m_ID > 0)
+		glDeleteFramebuffers(1, &m_ID);
+
+	if (m_ColourTexture > 0)
+	{
+		PGLState::OnTextureDeleted(m_ColourTexture);
+		glDeleteTextures(1, &m_ColourTexture);
+	}
+
+	if (m_DepthBuffer > 0)
+		glDeleteRenderbuffers(1, &m_DepthBuffer);
+}
+
+bool PFrameBuffer::Create(const PUi32& width, const PUi32& height)
+{
+	m_Width = width;
+	m_Height = height;
+
+	// Colour attachment
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_ColourTexture);
+	glTextureStorage2D(m_ColourTexture, 1, GL_RGBA8, width, height);
+	glTextureParameteri(m_ColourTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(m_ColourTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Depth attachment
+	glCreateRenderbuffers(1, &m_DepthBuffer);
+	glNamedRenderbufferStorage(m_DepthBuffer, GL_DEPTH_COMPONENT24, width, height);
+
+	glCreateFramebuffers(1, &m_ID);
+	glNamedFramebufferTexture(m_ID, GL_COLOR_ATTACHMENT0, m_ColourTexture, 0);
+	glNamedFramebufferRenderbuffer(m_ID, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_DepthBuffer);
+
+	const GLenum status = glCheckNamedFramebufferStatus(m_ID, GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		PDebug::Log("Framebuffer incomplete, status: " + std::to_string(status), LT_ERROR);
+		return false;
+	}
+
+	return true;
+}
+
+void PFrameBuffer::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+	glViewport(0, 0, m_Width, m_Height);
+}
+
+void PFrameBuffer::ReadPixels(TArray<PUi8>& outPixels) const
+{
+	outPixels.resize(static_cast<size_t>(m_Width) * m_Height * 4);
+
+	// Rows are tightly packed, so don't let the default 4 byte alignment pad them
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTextureImage(m_ColourTexture, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(outPixels.size()), outPixels.data());
+}
+
+bool PFrameBuffer::SaveToBMP(const PString& path) const
+{
+	TArray<PUi8> pixels;
+	ReadPixels(pixels);
+
+	// OpenGL returns the bottom row first, images are stored top row first
+	const size_t rowSize = static_cast<size_t>(m_Width) * 4;
+	TArray<PUi8> flipped(pixels.size());
+	for (PUi32 row = 0; row < m_Height; ++row)
+	{
+		std::memcpy(&flipped[row * rowSize], &pixels[(m_Height - 1 - row) * rowSize], rowSize);
+	}
+
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+		flipped.data(), m_Width, m_Height, 32, static_cast<int>(rowSize), SDL_PIXELFORMAT_RGBA32);
+
+	if (surface == nullptr)
+	{
+		PDebug::Log("Failed to create surface for frame dump: " + PString(SDL_GetError()), LT_ERROR);
+		return false;
+	}
+
+	const bool saved = SDL_SaveBMP(surface, path.c_str()) == 0;
+	SDL_FreeSurface(surface);
+
+	if (!saved)
+		PDebug::Log("Failed to save frame dump " + path + ": " + PString(SDL_GetError()), LT_ERROR);
+
+	return saved;
+}
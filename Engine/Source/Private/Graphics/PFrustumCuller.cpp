@@ -0,0 +1,139 @@
+// Internal headers
+#include "Graphics/PFrustumCuller.h"
+#include "Core/PThreadPool.h"
+
+// External libraries
+#include <immintrin.h>
+
+// Sets smaller than this are culled on the calling thread only
+#define LPARALLEL_CULL_THRESHOLD 16384
+
+void PFrustumCuller::Cull(const PSFrustum& frustum, const PSBoundingSpheres& spheres, TArray<PUi32>& outVisible)
+{
+	const PUi32 count = spheres.Size();
+	PThreadPool& threadPool = PThreadPool::Get();
+
+	if (count < LPARALLEL_CULL_THRESHOLD || threadPool.GetWorkerCount() == 0)
+	{
+		CullRange(frustum, spheres, 0, count, outVisible);
+		return;
+	}
+
+	// One chunk per thread, kept a multiple of 8 so only the last chunk has a scalar tail
+	const PUi32 chunkCount = threadPool.GetWorkerCount() + 1;
+	const PUi32 chunkSize = ((count + chunkCount - 1) / chunkCount + 7) & ~7U;
+
+	// Each chunk writes its own list so no locking is needed, then they're joined in order
+	// The lists are sized here on the calling thread, the workers only see them through the capture
+	TArray<TArray<PUi32>> chunkResults(chunkCount);
+
+	threadPool.ParallelFor(chunkCount, 1, [&](PUi32 firstChunk, PUi32 lastChunk)
+		{
+			for (PUi32 chunk = firstChunk; chunk < lastChunk; ++chunk)
+			{
+				const PUi32 begin = chunk * chunkSize < count ? chunk * chunkSize : count;
+				const PUi32 end = begin + chunkSize < count ? begin + chunkSize : count;
+
+				CullRange(frustum, spheres, begin, end, chunkResults[chunk]);
+			}
+		});
+
+	for (const TArray<PUi32>& result : chunkResults)
+	{
+		outVisible.insert(outVisible.end(), result.begin(), result.end());
+	}
+}
+
+void PFrustumCuller::CullRange(const PSFrustum& frustum, const PSBoundingSpheres& spheres,
+	const PUi32& begin, const PUi32& end, TArray<PUi32>& outVisible)
+{
+	const float* xs = spheres.x.data();
+	const float* ys = spheres.y.data();
+	const float* zs = spheres.z.data();
+	const float* radii = spheres.radius.data();
+
+	PUi32 i = begin;
+
+#if defined(__AVX__)
+	// Broadcast every plane component once
+	__m256 planeX[FP_COUNT], planeY[FP_COUNT], planeZ[FP_COUNT], planeW[FP_COUNT];
+	for (PUi32 p = 0; p < FP_COUNT; ++p)
+	{
+		planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+	}
+
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	for (; i + 8 <= end; i += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(xs + i);
+		const __m256 y = _mm256_loadu_ps(ys + i);
+		const __m256 z = _mm256_loadu_ps(zs + i);
+		const __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(radii + i), signMask);
+
+		// A sphere is visible if it isn't fully behind any plane
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (PUi32 p = 0; p < FP_COUNT; ++p)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(planeX[p], x), planeW[p]);
+			distance = _mm256_add_ps(_mm256_mul_ps(planeY[p], y), distance);
+			distance = _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), distance);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+		}
+
+		const int mask = _mm256_movemask_ps(inside);
+		for (PUi32 lane = 0; mask != 0 && lane < 8; ++lane)
+		{
+			if (mask & (1 << lane))
+				outVisible.push_back(i + lane);
+		}
+	}
+#else
+	// Broadcast every plane component once
+	__m128 planeX[FP_COUNT], planeY[FP_COUNT], planeZ[FP_COUNT], planeW[FP_COUNT];
+	for (PUi32 p = 0; p < FP_COUNT; ++p)
+	{
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(xs + i);
+		const __m128 y = _mm_loadu_ps(ys + i);
+		const __m128 z = _mm_loadu_ps(zs + i);
+		const __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(radii + i), signMask);
+
+		// A sphere is visible if it isn't fully behind any plane
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (PUi32 p = 0; p < FP_COUNT; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(planeX[p], x), planeW[p]);
+			distance = _mm_add_ps(_mm_mul_ps(planeY[p], y), distance);
+			distance = _mm_add_ps(_mm_mul_ps(planeZ[p], z), distance);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		const int mask = _mm_movemask_ps(inside);
+		for (PUi32 lane = 0; mask != 0 && lane < 4; ++lane)
+		{
+			if (mask & (1 << lane))
+				outVisible.push_back(i + lane);
+		}
+	}
+#endif
+
+	// Scalar tail
+	for (; i < end; ++i)
+	{
+		if (frustum.IntersectsSphere(glm::vec3(xs[i], ys[i], zs[i]), radii[i]))
+			outVisible.push_back(i);
+	}
+}
@@ -0,0 +1,279 @@
+// Internal headers
+#include "Graphics/PGLState.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// Value meaning the cached state isn't known and the next call must be issued
+#define LUNKNOWN_STATE 0xFFFFFFFFU
+
+// Enum of the non-indexed buffer targets tracked by the cache
+enum PEGLBufferSlot : PUi8
+{
+	BS_ARRAY = 0U,
+	BS_ELEMENT_ARRAY,
+	BS_UNIFORM,
+	BS_SHADER_STORAGE,
+	BS_DRAW_INDIRECT,
+	BS_PIXEL_UNPACK,
+	BS_COPY_READ,
+	BS_COPY_WRITE,
+	BS_COUNT,
+	BS_UNTRACKED = BS_COUNT
+};
+
+// Structure holding a cached indexed buffer binding
+struct PSGLBufferRange
+{
+	PUi32 buffer = LUNKNOWN_STATE;
+	PUi64 offset = 0;
+	PUi64 size = 0;
+};
+
+// Structure holding the cached context state
+struct PSGLStateCache
+{
+	PUi32 program = LUNKNOWN_STATE;
+	PUi32 vao = LUNKNOWN_STATE;
+	PUi32 buffers[BS_COUNT];
+	PUi32 textures[PGL_MAX_TEXTURE_UNITS];
+	PSGLBufferRange uniformRanges[PGL_MAX_BUFFER_BINDINGS];
+	PSGLBufferRange storageRanges[PGL_MAX_BUFFER_BINDINGS];
+	PUi32 depthTest = LUNKNOWN_STATE;
+	PUi32 depthWrite = LUNKNOWN_STATE;
+	PUi32 depthFunc = LUNKNOWN_STATE;
+	PUi32 blend = LUNKNOWN_STATE;
+	PUi32 blendSrc = LUNKNOWN_STATE;
+	PUi32 blendDst = LUNKNOWN_STATE;
+	PUi32 cullFace = LUNKNOWN_STATE;
+
+	PSGLStateCache()
+	{
+		for (PUi32& buffer : buffers)
+			buffer = LUNKNOWN_STATE;
+
+		for (PUi32& texture : textures)
+			texture = LUNKNOWN_STATE;
+	}
+};
+
+// The cached state of the engine's only GL context
+static PSGLStateCache s_State;
+
+// Call counters
+static PSGLStateStats s_Stats;
+
+// Update a cached value, returns true if the call has to be issued
+static bool UpdateCachedState(PUi32& cached, const PUi32& value)
+{
+	if (cached == value)
+	{
+		++s_Stats.skipped;
+		return false;
+	}
+
+	cached = value;
+	++s_Stats.issued;
+	return true;
+}
+
+// Get the cache slot of a buffer target
+static PEGLBufferSlot GetBufferSlot(const PUi32& target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER:
+		return BS_ARRAY;
+	case GL_ELEMENT_ARRAY_BUFFER:
+		return BS_ELEMENT_ARRAY;
+	case GL_UNIFORM_BUFFER:
+		return BS_UNIFORM;
+	case GL_SHADER_STORAGE_BUFFER:
+		return BS_SHADER_STORAGE;
+	case GL_DRAW_INDIRECT_BUFFER:
+		return BS_DRAW_INDIRECT;
+	case GL_PIXEL_UNPACK_BUFFER:
+		return BS_PIXEL_UNPACK;
+	case GL_COPY_READ_BUFFER:
+		return BS_COPY_READ;
+	case GL_COPY_WRITE_BUFFER:
+		return BS_COPY_WRITE;
+	default:
+		return BS_UNTRACKED;
+	}
+}
+
+void PGLState::UseProgram(const PUi32& program)
+{
+	if (UpdateCachedState(s_State.program, program))
+		glUseProgram(program);
+}
+
+void PGLState::BindVertexArray(const PUi32& vao)
+{
+	if (UpdateCachedState(s_State.vao, vao))
+	{
+		glBindVertexArray(vao);
+
+		// The element array binding is part of the VAO, so it changed with it
+		s_State.buffers[BS_ELEMENT_ARRAY] = LUNKNOWN_STATE;
+	}
+}
+
+void PGLState::BindBuffer(const PUi32& target, const PUi32& buffer)
+{
+	const PEGLBufferSlot slot = GetBufferSlot(target);
+
+	if (slot == BS_UNTRACKED)
+	{
+		++s_Stats.issued;
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (UpdateCachedState(s_State.buffers[slot], buffer))
+		glBindBuffer(target, buffer);
+}
+
+void PGLState::BindBufferRange(const PUi32& target, const PUi32& index, const PUi32& buffer,
+	const PUi64& offset, const PUi64& size)
+{
+	PSGLBufferRange* range = nullptr;
+
+	if (index < PGL_MAX_BUFFER_BINDINGS)
+	{
+		if (target == GL_UNIFORM_BUFFER)
+			range = &s_State.uniformRanges[index];
+		else if (target == GL_SHADER_STORAGE_BUFFER)
+			range = &s_State.storageRanges[index];
+	}
+
+	if (range != nullptr && range->buffer == buffer && range->offset == offset && range->size == size)
+	{
+		++s_Stats.skipped;
+		return;
+	}
+
+	if (range != nullptr)
+		*range = { buffer, offset, size };
+
+	// Indexed binds also replace the generic binding of the target
+	const PEGLBufferSlot slot = GetBufferSlot(target);
+	if (slot != BS_UNTRACKED)
+		s_State.buffers[slot] = buffer;
+
+	++s_Stats.issued;
+	glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+}
+
+void PGLState::BindTexture(const PUi32& unit, const PUi32& texture)
+{
+	if (unit >= PGL_MAX_TEXTURE_UNITS)
+	{
+		++s_Stats.issued;
+		glBindTextureUnit(unit, texture);
+		return;
+	}
+
+	// Binding by unit doesn't touch the active texture, so no glActiveTexture is needed
+	if (UpdateCachedState(s_State.textures[unit], texture))
+		glBindTextureUnit(unit, texture);
+}
+
+void PGLState::SetDepthTest(const bool& enable)
+{
+	if (UpdateCachedState(s_State.depthTest, enable))
+		enable ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+}
+
+void PGLState::SetDepthWrite(const bool& enable)
+{
+	if (UpdateCachedState(s_State.depthWrite, enable))
+		glDepthMask(enable ? GL_TRUE : GL_FALSE);
+}
+
+void PGLState::SetDepthFunc(const PUi32& func)
+{
+	if (UpdateCachedState(s_State.depthFunc, func))
+		glDepthFunc(func);
+}
+
+void PGLState::SetBlend(const bool& enable)
+{
+	if (UpdateCachedState(s_State.blend, enable))
+		enable ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+}
+
+void PGLState::SetBlendFunc(const PUi32& srcFactor, const PUi32& dstFactor)
+{
+	if (s_State.blendSrc == srcFactor && s_State.blendDst == dstFactor)
+	{
+		++s_Stats.skipped;
+		return;
+	}
+
+	s_State.blendSrc = srcFactor;
+	s_State.blendDst = dstFactor;
+	++s_Stats.issued;
+	glBlendFunc(srcFactor, dstFactor);
+}
+
+void PGLState::SetCullFace(const bool& enable)
+{
+	if (UpdateCachedState(s_State.cullFace, enable))
+		enable ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+}
+
+void PGLState::OnProgramDeleted(const PUi32& program)
+{
+	if (s_State.program == program)
+		s_State.program = LUNKNOWN_STATE;
+}
+
+void PGLState::OnVertexArrayDeleted(const PUi32& vao)
+{
+	if (s_State.vao == vao)
+		s_State.vao = LUNKNOWN_STATE;
+}
+
+void PGLState::OnBufferDeleted(const PUi32& buffer)
+{
+	for (PUi32& cached : s_State.buffers)
+	{
+		if (cached == buffer)
+			cached = LUNKNOWN_STATE;
+	}
+
+	for (PUi32 i = 0; i < PGL_MAX_BUFFER_BINDINGS; ++i)
+	{
+		if (s_State.uniformRanges[i].buffer == buffer)
+			s_State.uniformRanges[i] = PSGLBufferRange();
+
+		if (s_State.storageRanges[i].buffer == buffer)
+			s_State.storageRanges[i] = PSGLBufferRange();
+	}
+}
+
+void PGLState::OnTextureDeleted(const PUi32& texture)
+{
+	for (PUi32& cached : s_State.textures)
+	{
+		if (cached == texture)
+			cached = LUNKNOWN_STATE;
+	}
+}
+
+void PGLState::Invalidate()
+{
+	s_State = PSGLStateCache();
+}
+
+const PSGLStateStats& PGLState::GetStats()
+{
+	return s_Stats;
+}
+
+void PGLState::ResetStats()
+{
+	s_Stats = PSGLStateStats();
+}
@@ -5,17 +5,105 @@
 #include "Math/PSTransform.h"
 #include "Graphics/PTexture.h"
 #include "Graphics/PSCamera.h"
+#include "Graphics/PRenderQueue.h"
+#include "Graphics/PGLState.h"
+#include "Graphics/PRingBuffer.h"
+#include "Graphics/PMeshPool.h"
+#include "Graphics/PFrustumCuller.h"
+#include "Graphics/PHeadlessContext.h"
+#include "Graphics/PFrameBuffer.h"
+#include "Graphics/PTextureRegistry.h"
+#include "Graphics/PTextureStreamer.h"
+#include "Graphics/PMaterialTable.h"
+#include "Graphics/PMipStreamer.h"
+#include "Graphics/PShaderCache.h"
+#include "Graphics/PShaderWatcher.h"
+#include "Debug/PProfiler.h"
+#include "Debug/PMemoryTracker.h"
+#include "Core/PFileSystem.h"
 
 // External headers
 #include <GLEW/glew.h>
 #include <SDL/SDL.h>
 #include <SDL/SDL_opengl.h>
 
+// System libraries
+#include <algorithm>
+
 // Test mesh for debugging
 TUnique<PModel> m_Model;
 
+// Test instanced mesh for debugging
+TUnique<PModel> m_InstancedModel;
+
+// Test pooled meshes for debugging, each is a separate mesh drawn in one multi-draw call
+TArray<TUnique<PModel>> m_PooledModels;
+
+// World bounds of the pooled test models and the ones that passed culling
+PSBoundingSpheres m_PooledBounds;
+TArray<PUi32> m_VisibleModels;
+
+// Get the height of the window's drawable area in pixels
+static int GetDrawableHeight(SDL_Window* sdlWindow)
+{
+	int width = 0, height = 0;
+	if (sdlWindow != nullptr)
+		SDL_GL_GetDrawableSize(sdlWindow, &width, &height);
+
+	return std::max(height, 1);
+}
+
+PGraphicsEngine::PGraphicsEngine()
+{
+	m_SDLGLContext = nullptr;
+	m_Backend = GB_WINDOW;
+}
+
+// Defined here so the unique pointers can destroy their forward declared types
+PGraphicsEngine::~PGraphicsEngine()
+{
+	PProfiler::ShutdownGPU();
+
+	// Report how much redundant state the cache kept from the driver
+	const PSGLStateStats& stats = PGLState::GetStats();
+	PDebug::Log("GL state calls issued: " + std::to_string(stats.issued) + ", skipped: " + std::to_string(stats.skipped));
+
+	// Report how often the CPU had to wait for the GPU to release streamed memory
+	if (m_DynamicBuffer)
+	{
+		const PSRingBufferStats& ringStats = m_DynamicBuffer->GetStats();
+		PDebug::Log("Dynamic buffer stalls: " + std::to_string(ringStats.stalls) + " (" +
+			std::to_string(ringStats.stallMicroseconds) + "us), peak frame bytes: " + std::to_string(ringStats.peakFrameBytes));
+	}
+
+	if (m_MipStreamer)
+		m_MipStreamer->LogStats();
+
+	if (m_ShaderWatcher)
+	{
+		const PSShaderWatcherStats& watcherStats = m_ShaderWatcher->GetStats();
+		PDebug::Log("Shader reloads: " + std::to_string(watcherStats.reloads) + ", failed: " +
+			std::to_string(watcherStats.failures));
+	}
+
+	// Report how many programs skipped compiling
+	const PSShaderCacheStats& cacheStats = PShaderCache::GetStats();
+	PDebug::Log("Shader cache hits: " + std::to_string(cacheStats.hits) + ", misses: " + std::to_string(cacheStats.misses) +
+		", rejected: " + std::to_string(cacheStats.rejected) + ", saved: " + std::to_string(cacheStats.saved));
+
+	// Report where assets were read from
+	const PSFileSystemStats fileStats = PFileSystem::Get().GetStats();
+	PDebug::Log("File reads from packs: " + std::to_string(fileStats.packReads) + " (" + std::to_string(fileStats.storedBytes / 1024) +
+		"KB stored, " + std::to_string(fileStats.extractedBytes / 1024) + "KB decompressed), loose: " +
+		std::to_string(fileStats.looseReads) + ", missing: " + std::to_string(fileStats.misses));
+
+	// Report the memory resources still hold and the peaks they reached
+	PMemoryTracker::LogReport();
+}
+
 bool PGraphicsEngine::InitEngine(SDL_Window* sdlWindow, const bool& vsync)
 {
+	m_Backend = GB_WINDOW;
 
 	if (sdlWindow == nullptr)
 	{
@@ -52,16 +140,64 @@ bool PGraphicsEngine::InitEngine(SDL_Window* sdlWindow, const bool& vsync)
 		}
 	}
 
+	return InitResources();
+}
+
+bool PGraphicsEngine::InitHeadless(const PUi32& width, const PUi32& height)
+{
+	m_Backend = GB_HEADLESS;
+
+	// Create a context that doesn't need a window or display
+	m_HeadlessContext = TMakeUnique<PHeadlessContext>();
+	if (!m_HeadlessContext->Create())
+	{
+		PDebug::Log("Failed to create headless GL context", LT_ERROR);
+		PDebug::Log("Graphics engine initialization failed", LT_ERROR);
+		return false;
+	}
+
+	PDebug::Log("Headless context created with " + m_HeadlessContext->GetBackendName());
+
+	if (!InitResources())
+		return false;
+
+	// Frames are drawn into this instead of a window's back buffer
+	m_FrameBuffer = TMakeUnique<PFrameBuffer>();
+	if (!m_FrameBuffer->Create(width, height))
+	{
+		PDebug::Log("Headless framebuffer creation failed", LT_ERROR);
+		return false;
+	}
+
+	m_Camera->aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+
+	return true;
+}
+
+bool PGraphicsEngine::InitResources()
+{
+	PPROFILE_SCOPE("Graphics Init");
+
 	// Initialize GLEW
 	GLenum glewResult = glewInit();
+
+	// GLEW built for GLX reports a missing X display after loading the core entry points,
+	// which is expected when the context comes from EGL
+	if (glewResult == GLEW_ERROR_NO_GLX_DISPLAY && m_Backend == GB_HEADLESS)
+		glewResult = GLEW_OK;
+
 	if (glewResult != GLEW_OK)
 	{
 		PDebug::Log("GLEW initialization failed: " + std::string(reinterpret_cast<const char*>(glewGetErrorString(glewResult))), LT_ERROR);
 		return false;
 	}
 
-	// Enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	// GPU zones can be recorded from here on
+	PProfiler::InitGPU();
+
+	// Start from a known state, then enable depth testing
+	PGLState::Invalidate();
+	PGLState::SetDepthTest(true);
 
 	// Create and initialize the shader
 	m_Shader = TMakeShared<PShaderProgram>();
@@ -71,13 +207,87 @@ bool PGraphicsEngine::InitEngine(SDL_Window* sdlWindow, const bool& vsync)
 		return false;
 	}
 
+	// Create and initialize the instanced shader
+	m_InstancedShader = TMakeShared<PShaderProgram>();
+	if (!m_InstancedShader->InitShader("Shaders/SimpleShader/SimpleShaderInstanced.vertex", "Shaders/SimpleShader/SimpleShader.frag"))
+	{
+		PDebug::Log("Instanced shader initialization failed", LT_ERROR);
+		return false;
+	}
+
+	// Create the ring buffer for per-frame data, 4MB per frame with 3 frames in flight
+	m_DynamicBuffer = TMakeShared<PRingBuffer>();
+	if (!m_DynamicBuffer->Init(4 * 1024 * 1024, 3))
+	{
+		PDebug::Log("Dynamic buffer initialization failed, falling back to orphaned buffers", LT_WARN);
+		m_DynamicBuffer = nullptr;
+	}
+
+	// Create the render queue
+	m_RenderQueue = TMakeUnique<PRenderQueue>();
+	m_RenderQueue->SetDynamicBuffer(m_DynamicBuffer);
+
+	// Create the material table, bindless handles are used when the driver supports them
+	m_MaterialTable = TMakeShared<PMaterialTable>();
+	if (!m_MaterialTable->Init())
+	{
+		PDebug::Log("Material table initialization failed", LT_ERROR);
+		return false;
+	}
+
+	m_RenderQueue->SetMaterialTable(m_MaterialTable);
+
+	// Create and initialize the multi-draw indirect shader, it reads each draw's texture from the material table
+	const PString materialShaderPath = m_MaterialTable->GetMode() == MM_BINDLESS ?
+		"Shaders/SimpleShader/SimpleShaderBindless.frag" : "Shaders/SimpleShader/SimpleShaderArray.frag";
+
+	m_IndirectShader = TMakeShared<PShaderProgram>();
+	if (!m_IndirectShader->InitShader("Shaders/SimpleShader/SimpleShaderIndirect.vertex", materialShaderPath))
+	{
+		PDebug::Log("Indirect shader initialization failed", LT_ERROR);
+		return false;
+	}
+
+	// Watch the shader files so edits show up without restarting
+	m_ShaderWatcher = TMakeUnique<PShaderWatcher>();
+	m_ShaderWatcher->Init();
+	m_ShaderWatcher->Watch(m_Shader);
+	m_ShaderWatcher->Watch(m_InstancedShader);
+	m_ShaderWatcher->Watch(m_IndirectShader);
+
+	// Create the pool for static meshes
+	m_MeshPool = TMakeShared<PMeshPool>();
+	if (!m_MeshPool->Init(512 * 1024, 2 * 1024 * 1024))
+	{
+		PDebug::Log("Mesh pool initialization failed", LT_ERROR);
+		return false;
+	}
+
 	// Create the camera
 	m_Camera = TMakeShared<PSCamera>();
 	m_Camera->transform.position.z = -5.0f;
 
-	// Create and load the default texture
-	TShared<PTexture> defaultTexture = TMakeShared<PTexture>();
-	if (!defaultTexture->LoadTexture("Default Grid", "Textures/DefaultGrid.png"))
+	// Create the background texture loader, textures bind its placeholder until they're uploaded
+	m_TextureStreamer = TMakeShared<PTextureStreamer>();
+	if (!m_TextureStreamer->Init())
+	{
+		PDebug::Log("Texture streamer initialization failed, textures will load synchronously", LT_WARN);
+		m_TextureStreamer = nullptr;
+	}
+
+	// Create the mip streamer, the demo models only keep the levels their size on screen needs
+	m_MipStreamer = TMakeShared<PMipStreamer>();
+
+	// Create the texture registry and load the default texture through it
+	m_TextureRegistry = TMakeShared<PTextureRegistry>();
+	m_TextureRegistry->SetStreamer(m_TextureStreamer);
+	m_TextureRegistry->SetMipStreamer(m_MipStreamer);
+
+	PSTextureLoadOptions streamedOptions;
+	streamedOptions.streamMips = true;
+
+	TShared<PTexture> defaultTexture = m_TextureRegistry->LoadAsync("Textures/DefaultGrid.png", streamedOptions);
+	if (!defaultTexture)
 	{
 		PDebug::Log("Default texture loading failed", LT_ERROR);
 	}
@@ -86,6 +296,53 @@ bool PGraphicsEngine::InitEngine(SDL_Window* sdlWindow, const bool& vsync)
 	m_Model = TMakeUnique<PModel>();
 	m_Model->MakeCube(defaultTexture);
 
+	// DEBUG: Create a grid of cubes drawn with a single instanced draw call
+	m_InstancedModel = TMakeUnique<PModel>();
+	m_InstancedModel->MakeCube(defaultTexture);
+	m_InstancedModel->GetTransform().position.y = -5.0f;
+
+	for (int x = -16; x < 16; ++x)
+	{
+		for (int z = -16; z < 16; ++z)
+		{
+			PSTransform instance;
+			instance.position = glm::vec3(x * 3.0f, 0.0f, z * 3.0f);
+			instance.scale = glm::vec3(0.5f);
+			m_InstancedModel->AddInstance(instance);
+		}
+	}
+
+	// DEBUG: Create a field of separate pooled meshes drawn with a single multi-draw call
+	// Rows alternate between two textures, the material table keeps them in the same batch
+	PSTextureLoadOptions mirroredOptions;
+	mirroredOptions.flipVertically = false;
+
+	for (int x = -20; x < 20; ++x)
+	{
+		for (int z = -20; z < 20; ++z)
+		{
+			TUnique<PModel> model = TMakeUnique<PModel>();
+
+			// Every model asks for its own texture, the registry hands back the one already loaded
+			const TShared<PTexture> texture = z % 2 == 0 ?
+				m_TextureRegistry->LoadAsync("Textures/DefaultGrid.png") :
+				m_TextureRegistry->LoadAsync("Textures/DefaultGrid.png", mirroredOptions);
+
+			if ((x + z) % 2 == 0)
+				model->MakeCube(texture, m_MeshPool);
+			else
+				model->MakePoly(texture, m_MeshPool);
+
+			model->SetMaterials(m_MaterialTable);
+
+			model->GetTransform().position = glm::vec3(x * 3.0f, 5.0f, z * 3.0f);
+			model->GetTransform().scale = glm::vec3(0.5f);
+			m_PooledModels.push_back(std::move(model));
+		}
+	}
+
+	m_TextureRegistry->LogStats();
+
 	// Log successful initialization
 	PDebug::Log("Graphics engine initialized successfully", LT_SUCCESS);
 
@@ -94,21 +351,116 @@ bool PGraphicsEngine::InitEngine(SDL_Window* sdlWindow, const bool& vsync)
 
 void PGraphicsEngine::Render(SDL_Window* sdlWindow)
 {
+	PPROFILE_SCOPE("Render");
+	PPROFILE_GPU_SCOPE("Render");
+
+	// Headless frames go to the offscreen framebuffer
+	if (m_FrameBuffer)
+		m_FrameBuffer->Bind();
+
 	// Set background color
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
 	// Clear the back buffer
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Activate the shader
-	m_Shader->Activate();
+	// Swap in shaders that were edited and finished compiling
+	m_ShaderWatcher->Update();
+
+	// Upload textures that finished decoding, within this frame's budget
+	if (m_TextureStreamer)
+		m_TextureStreamer->Update();
+
+	// Point materials at the textures that just became resident
+	m_MaterialTable->Update();
 
-	// Set world transformations based on the camera
-	m_Shader->SetWorldTransform(m_Camera);
+	// Reclaim the oldest region of the ring buffer
+	if (m_DynamicBuffer)
+		m_DynamicBuffer->BeginFrame();
+
+	// Only models inside the camera's view are submitted
+	const PSFrustum frustum = m_Camera->GetFrustum();
+
+	// Collect the frame's draws
+	m_RenderQueue->Begin(m_Camera);
+
+	{
+		PPROFILE_SCOPE("Cull and Submit");
 
-	// Render the model
-	m_Model->Render(m_Shader);
+		const glm::vec4 modelBounds = m_Model->GetWorldBoundingSphere();
+		if (frustum.IntersectsSphere(glm::vec3(modelBounds), modelBounds.w))
+			m_Model->Submit(*m_RenderQueue, m_Shader);
+
+		m_InstancedModel->SubmitInstanced(*m_RenderQueue, m_InstancedShader, &frustum);
+
+		// Cull the pooled models in one batch
+		m_PooledBounds.Clear();
+		for (const auto& model : m_PooledModels)
+		{
+			const glm::vec4 bounds = model->GetWorldBoundingSphere();
+			m_PooledBounds.Add(glm::vec3(bounds), bounds.w);
+		}
+
+		m_VisibleModels.clear();
+		PFrustumCuller::Cull(frustum, m_PooledBounds, m_VisibleModels);
+
+		for (const PUi32& index : m_VisibleModels)
+		{
+			m_PooledModels[index]->Submit(*m_RenderQueue, m_IndirectShader);
+		}
+	}
+
+	// Request the mip levels of the visible models, then load or release levels before anything is bound
+	{
+		PPROFILE_SCOPE("Mip Requests");
+
+		const float viewportHeight = m_FrameBuffer ? static_cast<float>(m_FrameBuffer->GetHeight()) :
+			static_cast<float>(GetDrawableHeight(sdlWindow));
+
+		m_MipStreamer->BeginFrame(*m_Camera, viewportHeight);
+
+		const glm::vec4 modelBounds = m_Model->GetWorldBoundingSphere();
+		if (frustum.IntersectsSphere(glm::vec3(modelBounds), modelBounds.w))
+			m_Model->RequestTextureMips(*m_MipStreamer);
+
+		m_InstancedModel->RequestTextureMips(*m_MipStreamer);
+
+		m_MipStreamer->Update();
+	}
+
+	// Group draws by state and depth, then draw them
+	{
+		PPROFILE_SCOPE("Sort");
+		m_RenderQueue->Sort();
+	}
+
+	m_RenderQueue->Execute();
+
+	// Fence this frame's region so it isn't overwritten while the GPU reads it
+	if (m_DynamicBuffer)
+		m_DynamicBuffer->EndFrame();
 
 	// Swap the back buffer with the front buffer to present the frame
-	SDL_GL_SwapWindow(sdlWindow);
+	if (m_Backend == GB_WINDOW)
+	{
+		PPROFILE_SCOPE("Present");
+		SDL_GL_SwapWindow(sdlWindow);
+	}
+}
+
+void PGraphicsEngine::SetTextureBudget(const PUi64& bytes)
+{
+	if (m_MipStreamer)
+		m_MipStreamer->SetMemoryBudget(bytes);
+}
+
+bool PGraphicsEngine::DumpFrame(const PString& path) const
+{
+	if (!m_FrameBuffer)
+	{
+		PDebug::Log("Frame dumps need the headless backend", LT_WARN);
+		return false;
+	}
+
+	return m_FrameBuffer->SaveToBMP(path);
 }
@@ -0,0 +1,170 @@
+// Internal headers
+#include "Graphics/PHeadlessContext.h"
+
+// External libraries
+#include <SDL/SDL.h>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+PHeadlessContext::PHeadlessContext()
+{
+	m_EGLDisplay = m_EGLContext = nullptr;
+	m_SDLWindow = nullptr;
+	m_SDLGLContext = nullptr;
+	m_BackendName = "none";
+}
+
+PHeadlessContext::~PHeadlessContext()
+{
+	Destroy();
+}
+
+bool PHeadlessContext::Create()
+{
+	if (CreateEGLContext())
+		return true;
+
+	return CreateSDLContext();
+}
+
+void PHeadlessContext::Destroy()
+{
+#if defined(__linux__)
+	if (m_EGLContext)
+	{
+		eglMakeCurrent(m_EGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_EGLDisplay, m_EGLContext);
+		eglTerminate(m_EGLDisplay);
+		m_EGLContext = m_EGLDisplay = nullptr;
+	}
+#endif
+
+	if (m_SDLGLContext)
+	{
+		SDL_GL_DeleteContext(m_SDLGLContext);
+		m_SDLGLContext = nullptr;
+	}
+
+	if (m_SDLWindow)
+	{
+		SDL_DestroyWindow(m_SDLWindow);
+		m_SDLWindow = nullptr;
+	}
+}
+
+bool PHeadlessContext::CreateEGLContext()
+{
+#if defined(__linux__)
+	// Use the surfaceless platform so no display server or GPU device node is needed
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+		eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+	EGLDisplay display = EGL_NO_DISPLAY;
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major = 0, minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		PDebug::Log("EGL display unavailable, falling back to a hidden window", LT_WARN);
+		return false;
+	}
+
+	// Rendering goes into a framebuffer object, so no surface is created at all
+	const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+	if (extensions == nullptr || PString(extensions).find("EGL_KHR_surfaceless_context") == PString::npos)
+	{
+		PDebug::Log("EGL_KHR_surfaceless_context unsupported, falling back to a hidden window", LT_WARN);
+		eglTerminate(display);
+		return false;
+	}
+
+	const EGLint configAttribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0)
+	{
+		PDebug::Log("No desktop OpenGL EGL config found, falling back to a hidden window", LT_WARN);
+		eglTerminate(display);
+		return false;
+	}
+
+	// Ask for the same version as the windowed context, then accept 4.5 which llvmpipe provides
+	const EGLint versions[][2] = { { 4, 6 }, { 4, 5 } };
+	EGLContext context = EGL_NO_CONTEXT;
+
+	for (const auto& version : versions)
+	{
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, version[0],
+			EGL_CONTEXT_MINOR_VERSION, version[1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+			EGL_NONE
+		};
+
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+		if (context != EGL_NO_CONTEXT)
+			break;
+	}
+
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		PDebug::Log("Failed to create EGL context, falling back to a hidden window", LT_WARN);
+		if (context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		eglTerminate(display);
+		return false;
+	}
+
+	m_EGLDisplay = display;
+	m_EGLContext = context;
+	m_BackendName = "EGL surfaceless " + std::to_string(major) + "." + std::to_string(minor);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool PHeadlessContext::CreateSDLContext()
+{
+	// Video has to be initialized for a window, headless startup only initializes events and timers
+	if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0)
+	{
+		PDebug::Log("Failed to initialize SDL video for headless context: " + PString(SDL_GetError()), LT_ERROR);
+		return false;
+	}
+
+	// Attributes set before video was initialized were rejected, so ask for the same 4.6 compatibility context here
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
+
+	m_SDLWindow = SDL_CreateWindow("Headless", 0, 0, 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	if (m_SDLWindow == nullptr)
+	{
+		PDebug::Log("Failed to create hidden window: " + PString(SDL_GetError()), LT_ERROR);
+		return false;
+	}
+
+	m_SDLGLContext = SDL_GL_CreateContext(m_SDLWindow);
+	if (m_SDLGLContext == nullptr || SDL_GL_MakeCurrent(m_SDLWindow, m_SDLGLContext) != 0)
+	{
+		PDebug::Log("Failed to create hidden window GL context: " + PString(SDL_GetError()), LT_ERROR);
+		return false;
+	}
+
+	m_BackendName = "SDL hidden window";
+
+	return true;
+}
@@ -0,0 +1,316 @@
+// Internal headers
+#include "Graphics/PMaterialTable.h"
+#include "Graphics/PTexture.h"
+#include "Graphics/PGLState.h"
+#include "Debug/PMemoryTracker.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <algorithm>
+
+PMaterialTable::PMaterialTable()
+{
+	m_Mode = MM_TEXTURE_ARRAY;
+	m_Buffer = 0;
+	m_MaxMaterials = 0;
+	m_DirtyBegin = m_DirtyEnd = 0;
+	m_PendingCount = 0;
+	m_PlaceholderTexture = 0;
+	m_PlaceholderHandle = 0;
+	m_MemoryHandle = 0;
+}
+
+PMaterialTable::~PMaterialTable()
+{
+	// Handles have to be made non-resident before their textures can be deleted
+	if (m_Mode == MM_BINDLESS)
+	{
+		for (const PSMaterialData& data : m_Data)
+		{
+			if (data.handle != 0 && data.handle != m_PlaceholderHandle)
+				glMakeTextureHandleNonResidentARB(data.handle);
+		}
+
+		if (m_PlaceholderHandle != 0)
+			glMakeTextureHandleNonResidentARB(m_PlaceholderHandle);
+	}
+
+	if (m_PlaceholderTexture != 0)
+	{
+		PGLState::OnTextureDeleted(m_PlaceholderTexture);
+		glDeleteTextures(1, &m_PlaceholderTexture);
+	}
+
+	if (m_Buffer != 0)
+	{
+		PGLState::OnBufferDeleted(m_Buffer);
+		glDeleteBuffers(1, &m_Buffer);
+	}
+
+	PMemoryTracker::Unregister(m_MemoryHandle);
+}
+
+bool PMaterialTable::Init(const PUi32& maxMaterials, const bool& forceTextureArrays)
+{
+	m_MaxMaterials = maxMaterials;
+	m_Mode = GLEW_ARB_bindless_texture && !forceTextureArrays ? MM_BINDLESS : MM_TEXTURE_ARRAY;
+
+	glCreateBuffers(1, &m_Buffer);
+	if (m_Buffer == 0)
+	{
+		PDebug::Log("Failed to create material buffer", LT_ERROR);
+		return false;
+	}
+
+	glNamedBufferStorage(m_Buffer, static_cast<GLsizeiptr>(m_MaxMaterials) * sizeof(PSMaterialData), nullptr,
+		GL_DYNAMIC_STORAGE_BIT);
+
+	m_MemoryHandle = PMemoryTracker::Register(RT_BUFFER, "Material table");
+	PMemoryTracker::Update(m_MemoryHandle, 0, static_cast<PUi64>(m_MaxMaterials) * sizeof(PSMaterialData));
+
+	// Same grey checker the texture streamer shows while loading
+	const PUi8 checker[] = {
+		160, 160, 160, 255,   96,  96,  96, 255,
+		 96,  96,  96, 255,  160, 160, 160, 255
+	};
+
+	if (m_Mode == MM_BINDLESS)
+	{
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_PlaceholderTexture);
+		glTextureStorage2D(m_PlaceholderTexture, 1, GL_RGBA8, 2, 2);
+		glTextureSubImage2D(m_PlaceholderTexture, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+	}
+	else
+	{
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_PlaceholderTexture);
+		glTextureStorage3D(m_PlaceholderTexture, 1, GL_RGBA8, 2, 2, 1);
+		glTextureSubImage3D(m_PlaceholderTexture, 0, 0, 0, 0, 2, 2, 1, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+	}
+
+	glTextureParameteri(m_PlaceholderTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_PlaceholderTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_PlaceholderTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(m_PlaceholderTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// The handle locks the texture's state, so it's only taken once the parameters are final
+	if (m_Mode == MM_BINDLESS)
+	{
+		m_PlaceholderHandle = glGetTextureHandleARB(m_PlaceholderTexture);
+		glMakeTextureHandleResidentARB(m_PlaceholderHandle);
+	}
+
+	m_ArrayAllocator.SetLayersPerArray(32);
+
+	PDebug::Log(PString("Material table created using ") +
+		(m_Mode == MM_BINDLESS ? "bindless textures" : "texture arrays"), LT_SUCCESS);
+
+	return true;
+}
+
+PUi32 PMaterialTable::AddMaterial(const TShared<PTexture>& texture)
+{
+	if (texture == nullptr || m_Buffer == 0)
+		return PMATERIAL_INVALID;
+
+	// Textures shared through the registry get the same material
+	const auto found = m_Lookup.find(texture.get());
+	if (found != m_Lookup.end() && m_Materials[found->second].source.lock() == texture)
+	{
+		++m_Materials[found->second].users;
+		return found->second;
+	}
+
+	if (m_FreeMaterials.empty() && m_Materials.size() >= m_MaxMaterials)
+	{
+		PDebug::Log("Failed to add material for texture - " + texture->GetName() + ": material table is full", LT_WARN);
+		return PMATERIAL_INVALID;
+	}
+
+	PSMaterial entry;
+	entry.texture = texture;
+	entry.source = texture;
+	entry.address = texture.get();
+	entry.users = 1;
+
+	// Show the placeholder until the texture is uploaded
+	PSMaterialData data;
+	data.handle = m_PlaceholderHandle;
+
+	PUi32 material;
+	if (!m_FreeMaterials.empty())
+	{
+		material = m_FreeMaterials.back();
+		m_FreeMaterials.pop_back();
+		m_Materials[material] = entry;
+		m_Data[material] = data;
+	}
+	else
+	{
+		material = static_cast<PUi32>(m_Materials.size());
+		m_Materials.push_back(entry);
+		m_Data.push_back(data);
+	}
+
+	m_Lookup[texture.get()] = material;
+	++m_PendingCount;
+
+	if (!Resolve(material))
+		MarkDirty(material);
+
+	return material;
+}
+
+void PMaterialTable::RemoveMaterial(const PUi32& material)
+{
+	if (material >= m_Materials.size() || m_Materials[material].users == 0)
+		return;
+
+	PSMaterial& entry = m_Materials[material];
+	if (--entry.users > 0)
+		return;
+
+	if (!entry.resolved)
+		--m_PendingCount;
+
+	// The handle keeps the texture pinned in GPU memory until it's made non-resident
+	PSMaterialData& data = m_Data[material];
+	if (m_Mode == MM_BINDLESS && data.handle != 0 && data.handle != m_PlaceholderHandle)
+		glMakeTextureHandleNonResidentARB(data.handle);
+
+	if (entry.slot.IsValid())
+		m_ArrayAllocator.Free(entry.slot);
+
+	// A texture at the same address may have been added since the source expired, so only drop our own entry
+	const auto found = m_Lookup.find(entry.address);
+	if (found != m_Lookup.end() && found->second == material)
+		m_Lookup.erase(found);
+
+	// Freed entries are resolved to the placeholder so Update skips them
+	entry = PSMaterial();
+	entry.resolved = true;
+
+	data = PSMaterialData();
+	data.handle = m_PlaceholderHandle;
+	MarkDirty(material);
+
+	m_FreeMaterials.push_back(material);
+}
+
+void PMaterialTable::Update()
+{
+	// Textures loaded asynchronously become resident over several frames
+	if (m_PendingCount > 0)
+	{
+		for (PUi32 material = 0; material < m_Materials.size(); ++material)
+		{
+			if (!m_Materials[material].resolved)
+				Resolve(material);
+		}
+	}
+
+	if (m_DirtyBegin >= m_DirtyEnd)
+		return;
+
+	// Only the changed range is uploaded, entries don't move once added
+	glNamedBufferSubData(
+		m_Buffer,
+		static_cast<GLintptr>(m_DirtyBegin) * sizeof(PSMaterialData),
+		static_cast<GLsizeiptr>(m_DirtyEnd - m_DirtyBegin) * sizeof(PSMaterialData),
+		m_Data.data() + m_DirtyBegin
+	);
+
+	m_DirtyBegin = m_DirtyEnd = 0;
+}
+
+PUi32 PMaterialTable::GetBindTexture(const PUi32& material) const
+{
+	if (m_Mode == MM_BINDLESS || material >= m_Materials.size())
+		return 0;
+
+	const PSMaterial& entry = m_Materials[material];
+	return entry.slot.IsValid() ? entry.slot.arrayID : m_PlaceholderTexture;
+}
+
+void PMaterialTable::Bind(const PUi32& material) const
+{
+	PGLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, PMATERIAL_TABLE_BINDING, m_Buffer, 0,
+		static_cast<PUi32>(m_MaxMaterials * sizeof(PSMaterialData)));
+
+	if (m_Mode == MM_TEXTURE_ARRAY)
+		PGLState::BindTexture(0, GetBindTexture(material));
+}
+
+bool PMaterialTable::Resolve(const PUi32& material)
+{
+	PSMaterial& entry = m_Materials[material];
+	if (entry.resolved)
+		return true;
+
+	if (!entry.texture->IsResident())
+		return false;
+
+	// Streamed textures swap their storage as levels change, neither a handle nor an array copy would follow it
+	if (entry.texture->GetOptions().streamMips)
+	{
+		PDebug::Log("Failed to add material for texture - " + entry.texture->GetName() + ": streamed mips aren't supported",
+			LT_WARN);
+		entry.resolved = true;
+		entry.texture = nullptr;
+		--m_PendingCount;
+		return false;
+	}
+
+	if (m_Mode == MM_BINDLESS)
+	{
+		// The texture is kept alive by the material, a resident handle must never outlive it
+		const PUi64 handle = glGetTextureHandleARB(entry.texture->GetID());
+		if (handle == 0)
+		{
+			PDebug::Log("Failed to get bindless handle for texture - " + entry.texture->GetName(), LT_WARN);
+			entry.resolved = true;
+			entry.texture = nullptr;
+			--m_PendingCount;
+			return false;
+		}
+
+		glMakeTextureHandleResidentARB(handle);
+		m_Data[material].handle = handle;
+	}
+	else
+	{
+		// Textures that can't be packed keep showing the placeholder
+		if (!m_ArrayAllocator.Allocate(*entry.texture, entry.slot))
+		{
+			entry.resolved = true;
+			entry.texture = nullptr;
+			--m_PendingCount;
+			return false;
+		}
+
+		m_Data[material].layer = entry.slot.layer;
+
+		// The layer is a copy, the material doesn't need to keep the original alive
+		entry.texture = nullptr;
+	}
+
+	entry.resolved = true;
+	--m_PendingCount;
+	MarkDirty(material);
+
+	return true;
+}
+
+void PMaterialTable::MarkDirty(const PUi32& material)
+{
+	if (m_DirtyBegin >= m_DirtyEnd)
+	{
+		m_DirtyBegin = material;
+		m_DirtyEnd = material + 1;
+		return;
+	}
+
+	m_DirtyBegin = std::min(m_DirtyBegin, material);
+	m_DirtyEnd = std::max(m_DirtyEnd, material + 1);
+}
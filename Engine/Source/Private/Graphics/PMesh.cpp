@@ -2,6 +2,10 @@
 #include "Graphics/PMesh.h"
 #include "Debug/PDebug.h"
 #include "Graphics/PShaderProgram.h"
+#include "Graphics/PGLState.h"
+#include "Graphics/PMaterialTable.h"
+#include "Graphics/PCookedMesh.h"
+#include "Debug/PMemoryTracker.h"
 
 // External Headers
 #include <GLEW/glew.h>
@@ -9,23 +13,216 @@
 PMesh::PMesh()
 {
 	m_VAO = m_VBO = m_EAO = 0;
+	m_InstanceVBO = 0;
+	m_InstanceCapacity = m_InstanceCount = 0;
+	m_IndexCount = 0;
+	m_IndexType = GL_UNSIGNED_INT;
+	m_Material = PMATERIAL_INVALID;
+	m_BoundingSphere = glm::vec4(0.0f);
+	m_KeepCPUData = false;
+	m_BufferBytes = 0;
+	m_MemoryHandle = PMemoryTracker::Register(RT_MESH, "Mesh");
 	PDebug::Log("Mesh created");
 }
 
 PMesh::~PMesh()
 {
+	// Pooled meshes share the pool's VAO and buffers, the pool deletes those
+	const PUi32 buffers[] = { m_VBO, m_EAO, m_InstanceVBO };
+	for (const PUi32& buffer : buffers)
+	{
+		if (buffer > 0)
+		{
+			PGLState::OnBufferDeleted(buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+
+	if (m_VAO > 0 && !m_Pool)
+	{
+		PGLState::OnVertexArrayDeleted(m_VAO);
+		glDeleteVertexArrays(1, &m_VAO);
+	}
+
+	PMemoryTracker::Unregister(m_MemoryHandle);
 	PDebug::Log("Mesh destroyed");
 }
 
+void PMesh::SetName(const PString& name)
+{
+	PMemoryTracker::Rename(m_MemoryHandle, name);
+}
+
 bool PMesh::CreateMesh(const std::vector<PSVertexData>& vertices, const std::vector<uint32_t>& indices)
 {
+	return CreateMesh(vertices, indices, PStandardVertexLayout::GetInfo());
+}
 
+bool PMesh::CreateMesh(const std::vector<PSVertexData>& vertices, const std::vector<uint32_t>& indices,
+	const PSVertexLayoutInfo& layout)
+{
 	// Store vertex and index data
 	m_Vertices = vertices;
 	m_Indices = indices;
+	ComputeBoundingSphere();
+
+	// The standard layout is PSVertexData itself and is uploaded without a copy
+	const PUi8* vertexData = reinterpret_cast<const PUi8*>(m_Vertices.data());
+	TArray<PUi8> encodedVertices;
+
+	if (!(layout == PStandardVertexLayout::GetInfo()))
+	{
+		encodedVertices.resize(m_Vertices.size() * layout.stride);
+		PVertexLayout::Encode(layout, m_Vertices.data(), m_Vertices.size(), encodedVertices.data());
+		vertexData = encodedVertices.data();
+	}
+
+	// Halve the index buffer when every index fits in 16 bits
+	const void* indexData = m_Indices.data();
+	PUi32 indexSize = sizeof(uint32_t);
+	TArray<PUi16> shortIndices;
+
+	if (PVertexLayout::FitsShortIndices(m_Vertices.size()))
+	{
+		shortIndices.assign(m_Indices.begin(), m_Indices.end());
+		indexData = shortIndices.data();
+		indexSize = sizeof(PUi16);
+	}
+
+	if (!CreateBuffers(
+		vertexData,
+		static_cast<PUi64>(m_Vertices.size()) * layout.stride,
+		layout.stride,
+		layout.attributes,
+		layout.attributeCount,
+		indexData,
+		static_cast<PUi32>(m_Indices.size()),
+		indexSize))
+		return false;
+
+	OnUploaded();
+
+	return true;
+}
+
+bool PMesh::CreateMesh(const std::vector<PSVertexData>& vertices, const std::vector<uint32_t>& indices,
+	const TShared<PMeshPool>& pool)
+{
+	if (pool == nullptr)
+		return CreateMesh(vertices, indices);
+
+	// Store vertex and index data
+	m_Vertices = vertices;
+	m_Indices = indices;
+	ComputeBoundingSphere();
+
+	// Copy the data into the shared buffers and draw with the pool's VAO
+	if (!pool->Allocate(m_Vertices, m_Indices, m_PoolRange))
+	{
+		PDebug::Log("Failed to create pooled mesh", LT_WARN);
+		return false;
+	}
+
+	m_Pool = pool;
+	m_VAO = pool->GetVAO();
+	m_IndexCount = m_PoolRange.indexCount;
+	m_BufferBytes = static_cast<PUi64>(m_PoolRange.vertexCount) * pool->GetLayout().stride +
+		static_cast<PUi64>(m_PoolRange.indexCount) * sizeof(PUi32);
+
+	OnUploaded();
 
-	// Create a Vertex Array Object (VAO)
-	glGenVertexArrays(1, &m_VAO);
+	return true;
+}
+
+bool PMesh::CreateMesh(const PCookedMesh& cookedMesh, const PUi32& submesh, const TShared<PMeshPool>& pool)
+{
+	if (!cookedMesh.IsOpen() || submesh >= cookedMesh.GetSubmeshCount())
+	{
+		PDebug::Log("Failed to create mesh: invalid cooked submesh", LT_WARN);
+		return false;
+	}
+
+	const PSCookedMeshHeader& header = cookedMesh.GetHeader();
+	const PSCookedSubmesh& range = cookedMesh.GetSubmesh(submesh);
+
+	// The sphere was fitted when the mesh was cooked
+	m_BoundingSphere = glm::vec4(range.boundingSphere[0], range.boundingSphere[1], range.boundingSphere[2],
+		range.boundingSphere[3]);
+
+	const PUi8* vertexData = cookedMesh.GetVertexData() + static_cast<PUi64>(range.baseVertex) * header.vertexStride;
+	const PUi8* indexData = cookedMesh.GetIndexData() + static_cast<PUi64>(range.firstIndex) * header.indexSize;
+
+	// CPU copies can only be made from the standard layout, other layouts aren't decoded
+	if (m_KeepCPUData && cookedMesh.HasVertexLayout(PStandardVertexLayout::GetInfo()))
+	{
+		const PSVertexData* vertices = reinterpret_cast<const PSVertexData*>(vertexData);
+		m_Vertices.assign(vertices, vertices + range.vertexCount);
+
+		if (header.indexSize == sizeof(PUi16))
+			m_Indices.assign(reinterpret_cast<const PUi16*>(indexData), reinterpret_cast<const PUi16*>(indexData) + range.indexCount);
+		else
+			m_Indices.assign(reinterpret_cast<const PUi32*>(indexData), reinterpret_cast<const PUi32*>(indexData) + range.indexCount);
+	}
+	else if (m_KeepCPUData)
+	{
+		PDebug::Log("Cooked mesh isn't in the standard vertex layout, it has no CPU copy", LT_WARN);
+	}
+
+	// The pool stores its own vertex layout with 32-bit indices, other layouts get their own buffers
+	if (pool && cookedMesh.HasVertexLayout(pool->GetLayout()))
+	{
+		const PUi32* indices = reinterpret_cast<const PUi32*>(indexData);
+		TArray<PUi32> wideIndices;
+
+		if (header.indexSize == sizeof(PUi16))
+		{
+			const PUi16* shortIndices = reinterpret_cast<const PUi16*>(indexData);
+			wideIndices.assign(shortIndices, shortIndices + range.indexCount);
+			indices = wideIndices.data();
+		}
+
+		if (!pool->AllocateEncoded(vertexData, range.vertexCount, indices, range.indexCount, m_PoolRange))
+		{
+			PDebug::Log("Failed to create pooled mesh", LT_WARN);
+			return false;
+		}
+
+		m_Pool = pool;
+		m_VAO = pool->GetVAO();
+		m_IndexCount = m_PoolRange.indexCount;
+		m_BufferBytes = static_cast<PUi64>(m_PoolRange.vertexCount) * header.vertexStride +
+			static_cast<PUi64>(m_PoolRange.indexCount) * sizeof(PUi32);
+
+		OnUploaded();
+
+		return true;
+	}
+
+	if (pool)
+		PDebug::Log("Cooked mesh layout doesn't match the mesh pool, creating it unpooled", LT_WARN);
+
+	if (!CreateBuffers(
+		vertexData,
+		static_cast<PUi64>(range.vertexCount) * header.vertexStride,
+		header.vertexStride,
+		header.attributes,
+		header.attributeCount,
+		indexData,
+		range.indexCount,
+		header.indexSize))
+		return false;
+
+	OnUploaded();
+
+	return true;
+}
+
+bool PMesh::CreateBuffers(const void* vertexData, const PUi64& vertexBytes, const PUi32& stride,
+	const PSVertexAttribute* attributes, const PUi32& attributeCount,
+	const void* indexData, const PUi32& indexCount, const PUi32& indexSize)
+{
+	// Create the Vertex Array Object (VAO) and buffers, DSA objects are usable without binding
+	glCreateVertexArrays(1, &m_VAO);
 
 	if (m_VAO == 0)
 	{
@@ -34,81 +231,80 @@ bool PMesh::CreateMesh(const std::vector<PSVertexData>& vertices, const std::vec
 		return false;
 	}
 
-	// Bind the VAO
-	glBindVertexArray(m_VAO);
-
-	// Create and bind a Vertex Buffer Object (VBO)
-	glGenBuffers(1, &m_VBO);
+	// Create the Vertex Buffer Object (VBO)
+	glCreateBuffers(1, &m_VBO);
 	if (m_VBO == 0)
 	{
 		std::string errorMsg = reinterpret_cast<const char*>(glewGetErrorString(glGetError()));
 		PDebug::Log("Failed to create VBO: " + errorMsg, LT_WARN);
 		return false;
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
-	// Create and bind an Element Array Buffer (EAO)
-	glGenBuffers(1, &m_EAO);
+	// Create the Element Array Buffer (EAO)
+	glCreateBuffers(1, &m_EAO);
 	if (m_EAO == 0)
 	{
 		std::string errorMsg = reinterpret_cast<const char*>(glewGetErrorString(glGetError()));
 		PDebug::Log("Failed to create EAO: " + errorMsg, LT_WARN);
 		return false;
 	}
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EAO);
 
-	// Set buffer data for VBO
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		static_cast<GLsizeiptr>(m_Vertices.size() * sizeof(PSVertexData)),
-		m_Vertices.data(),
-		GL_STATIC_DRAW
+	m_IndexCount = indexCount;
+	m_IndexType = indexSize == sizeof(PUi16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	m_BufferBytes = vertexBytes + static_cast<PUi64>(indexCount) * indexSize;
+
+	// Mesh data never changes after creation, so both buffers get immutable storage
+	// with no access flags and the driver is free to keep them in VRAM
+	glNamedBufferStorage(
+		m_VBO,
+		static_cast<GLsizeiptr>(vertexBytes),
+		vertexData,
+		0
 	);
 
-	// Set buffer data for EAO
-	glBufferData(
-		GL_ELEMENT_ARRAY_BUFFER,
-		static_cast<GLsizeiptr>(m_Indices.size()) * sizeof(uint32_t),
-		m_Indices.data(),
-		GL_STATIC_DRAW
+	glNamedBufferStorage(
+		m_EAO,
+		static_cast<GLsizeiptr>(indexCount) * indexSize,
+		indexData,
+		0
 	);
 
+	// Attach the VBO to binding 0, one vertex of the given stride per vertex
+	glVertexArrayVertexBuffer(m_VAO, 0, m_VBO, 0, static_cast<GLsizei>(stride));
+	glVertexArrayElementBuffer(m_VAO, m_EAO);
+
 	// Define vertex attributes
-	// Position attribute
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(
-		0,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(PSVertexData),
-		nullptr
-	);
+	for (PUi32 i = 0; i < attributeCount; ++i)
+	{
+		const PSVertexAttribute& attribute = attributes[i];
+		glEnableVertexArrayAttrib(m_VAO, attribute.location);
+		glVertexArrayAttribFormat(m_VAO, attribute.location, static_cast<GLint>(attribute.components), attribute.type,
+			attribute.normalized ? GL_TRUE : GL_FALSE, attribute.offset);
+		glVertexArrayAttribBinding(m_VAO, attribute.location, 0);
+	}
 
-	// Color attribute
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(
-		1,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(PSVertexData),
-		(void*)(sizeof(float) * 3)
-	);
+	// Create the instance buffer, storage is allocated when instances are set
+	// It stays mutable because it's orphaned and resized as the instance count changes
+	glCreateBuffers(1, &m_InstanceVBO);
+	if (m_InstanceVBO == 0)
+	{
+		std::string errorMsg = reinterpret_cast<const char*>(glewGetErrorString(glGetError()));
+		PDebug::Log("Failed to create instance VBO: " + errorMsg, LT_WARN);
+		return false;
+	}
 
-	// Texture coordinates attribute
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(
-		2,
-		2,
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(PSVertexData),
-		(void*)(sizeof(float) * 6)
-	);
+	// Attach the instance buffer to binding 1, advanced once per instance
+	glVertexArrayVertexBuffer(m_VAO, 1, m_InstanceVBO, 0, sizeof(glm::mat4));
+	glVertexArrayBindingDivisor(m_VAO, 1, 1);
 
-	// Unbind the VAO
-	glBindVertexArray(0);
+	// Instance model matrix attribute, a mat4 takes one location per column
+	for (PUi32 column = 0; column < 4; ++column)
+	{
+		const PUi32 location = 3 + column;
+		glEnableVertexArrayAttrib(m_VAO, location);
+		glVertexArrayAttribFormat(m_VAO, location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) * column);
+		glVertexArrayAttribBinding(m_VAO, location, 1);
+	}
 
 	return true;
 }
@@ -123,15 +319,154 @@ void PMesh::Render(const std::shared_ptr<PShaderProgram>& shader, const PSTransf
 	// Update shader with model transform
 	shader->SetModelTransform(transform);
 
-	// Bind VAO and draw elements
-	glBindVertexArray(m_VAO);
+	Draw();
+}
+
+void PMesh::SetInstances(const TArray<glm::mat4>& instanceMatrices)
+{
+	m_InstanceCount = static_cast<PUi32>(instanceMatrices.size());
+
+	if (m_InstanceVBO == 0 || m_InstanceCount == 0)
+		return;
+
+	// Point the instance binding back at the mesh's own buffer
+	glVertexArrayVertexBuffer(m_VAO, 1, m_InstanceVBO, 0, sizeof(glm::mat4));
+
+	// Grow the buffer when needed, otherwise orphan the old storage so the
+	// driver doesn't have to wait for the previous frame to finish reading it
+	const bool grown = m_InstanceCount > m_InstanceCapacity;
+	if (grown)
+		m_InstanceCapacity = m_InstanceCount;
+
+	glNamedBufferData(
+		m_InstanceVBO,
+		static_cast<GLsizeiptr>(m_InstanceCapacity * sizeof(glm::mat4)),
+		nullptr,
+		GL_STREAM_DRAW
+	);
+
+	if (grown)
+		UpdateMemory();
+
+	// Upload this frame's matrices
+	glNamedBufferSubData(
+		m_InstanceVBO,
+		0,
+		static_cast<GLsizeiptr>(m_InstanceCount * sizeof(glm::mat4)),
+		instanceMatrices.data()
+	);
+}
+
+void PMesh::RenderInstanced(const std::shared_ptr<PShaderProgram>& shader)
+{
+	if (m_InstanceCount == 0)
+		return;
+
+	if (m_Texture)
+	{
+		shader->RunTexture(m_Texture, 0);
+	}
+
+	DrawInstanced();
+}
+
+void PMesh::Draw()
+{
+	// Bind VAO and draw elements, the VAO stays bound for the next draw
+	PGLState::BindVertexArray(m_VAO);
+
+	// Pooled meshes draw their range of the shared buffers
+	if (m_Pool)
+	{
+		glDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			static_cast<GLsizei>(m_PoolRange.indexCount),
+			GL_UNSIGNED_INT,
+			reinterpret_cast<void*>(static_cast<uintptr_t>(m_PoolRange.firstIndex) * sizeof(uint32_t)),
+			static_cast<GLint>(m_PoolRange.baseVertex)
+		);
+		return;
+	}
+
 	glDrawElements(
 		GL_TRIANGLES,
-		static_cast<GLsizei>(m_Indices.size()),
-		GL_UNSIGNED_INT,
+		static_cast<GLsizei>(m_IndexCount),
+		m_IndexType,
 		nullptr
 	);
+}
+
+void PMesh::DrawInstanced()
+{
+	if (m_InstanceCount == 0 || m_Pool)
+		return;
+
+	// Bind VAO and draw every instance at once
+	PGLState::BindVertexArray(m_VAO);
+	glDrawElementsInstanced(
+		GL_TRIANGLES,
+		static_cast<GLsizei>(m_IndexCount),
+		m_IndexType,
+		nullptr,
+		static_cast<GLsizei>(m_InstanceCount)
+	);
+}
+
+void PMesh::SetInstanceBuffer(const PUi32& buffer, const PUi32& offset, const PUi32& instanceCount)
+{
+	m_InstanceCount = instanceCount;
+
+	// Only the binding's source changes, the attribute formats stay the same
+	glVertexArrayVertexBuffer(m_VAO, 1, buffer, static_cast<GLintptr>(offset), sizeof(glm::mat4));
+}
+
+void PMesh::ComputeBoundingSphere()
+{
+	if (m_Vertices.empty())
+	{
+		m_BoundingSphere = glm::vec4(0.0f);
+		return;
+	}
+
+	// Center the sphere on the bounding box, then grow it to reach the furthest vertex
+	glm::vec3 boundsMin = glm::vec3(m_Vertices[0].m_Position[0], m_Vertices[0].m_Position[1], m_Vertices[0].m_Position[2]);
+	glm::vec3 boundsMax = boundsMin;
+
+	for (const PSVertexData& vertex : m_Vertices)
+	{
+		const glm::vec3 position = glm::vec3(vertex.m_Position[0], vertex.m_Position[1], vertex.m_Position[2]);
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radiusSquared = 0.0f;
+
+	for (const PSVertexData& vertex : m_Vertices)
+	{
+		const glm::vec3 offset = glm::vec3(vertex.m_Position[0], vertex.m_Position[1], vertex.m_Position[2]) - center;
+		radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+	}
+
+	m_BoundingSphere = glm::vec4(center, glm::sqrt(radiusSquared));
+}
+
+void PMesh::OnUploaded()
+{
+	// The GPU has its own copy now, only the bounding sphere is needed from the vertices
+	if (!m_KeepCPUData)
+	{
+		std::vector<PSVertexData>().swap(m_Vertices);
+		std::vector<uint32_t>().swap(m_Indices);
+	}
+
+	UpdateMemory();
+}
+
+void PMesh::UpdateMemory()
+{
+	const PUi64 cpuBytes = m_Vertices.capacity() * sizeof(PSVertexData) + m_Indices.capacity() * sizeof(uint32_t);
+	const PUi64 gpuBytes = m_BufferBytes + static_cast<PUi64>(m_InstanceCapacity) * sizeof(glm::mat4);
 
-	// Unbind the VAO
-	glBindVertexArray(0);
+	PMemoryTracker::Update(m_MemoryHandle, cpuBytes, gpuBytes);
 }
@@ -0,0 +1,1101 @@
+// Internal headers
+#include "Graphics/PMeshImporter.h"
+#include "Core/PFileSystem.h"
+#include "Core/PJson.h"
+#include "Core/PThreadPool.h"
+#include "Debug/PProfiler.h"
+
+// External libraries
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/quaternion.hpp>
+#include <GLM/gtc/type_ptr.hpp>
+
+// System libraries
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+// Bytes of OBJ text each parse task works on
+#define LOBJ_CHUNK_SIZE (4 * 1024 * 1024)
+
+// Index marking a missing texture coordinate or normal
+#define LMISSING_INDEX 0xFFFFFFFFU
+
+// Structure for the position, texture coordinate and normal indices of a face corner
+struct PSOBJVertexKey
+{
+	PUi32 position = LMISSING_INDEX;
+	PUi32 texCoord = LMISSING_INDEX;
+	PUi32 normal = LMISSING_INDEX;
+
+	bool operator==(const PSOBJVertexKey& other) const = default;
+};
+
+// Structure for an object, group or material change inside a chunk
+struct PSOBJGroupStart
+{
+	size_t corner = 0;   // First corner of the chunk that belongs to the group
+	PString name;        // Name of the group
+};
+
+// Structure for the lines of the file a parse task works on and what it read
+struct PSOBJChunk
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+
+	// Elements declared before the chunk, relative indices count back from here
+	PUi64 positionBase = 0, texCoordBase = 0, normalBase = 0;
+
+	// Elements declared inside the chunk
+	PUi64 positionCount = 0, texCoordCount = 0, normalCount = 0;
+
+	TArray<float> positions;  // xyz per position
+	TArray<float> colours;    // rgb per position, white unless the file has vertex colours
+	TArray<float> texCoords;  // uv per texture coordinate
+	TArray<float> normals;    // xyz per normal
+	TArray<PSOBJVertexKey> corners; // Three corners per triangle
+	TArray<PSOBJGroupStart> groups;
+	PString error;
+};
+
+// Structure for a run of corners of one mesh inside a chunk
+struct PSOBJCornerRange
+{
+	PUi32 chunk = 0;
+	size_t begin = 0, end = 0;
+};
+
+// Structure for a mesh made of corner runs across chunks
+struct PSOBJMeshRanges
+{
+	PString name;
+	TArray<PSOBJCornerRange> ranges;
+	size_t cornerCount = 0;
+};
+
+// Hash a face corner, the three indices are mixed so nearby corners spread across the table
+static PUi64 HashVertexKey(const PSOBJVertexKey& key)
+{
+	PUi64 hash = key.position * 0x9E3779B97F4A7C15ULL;
+	hash ^= (key.texCoord + 0x7F4A7C15ULL) * 0xC2B2AE3D27D4EB4FULL;
+	hash ^= (key.normal + 0x165667B1ULL) * 0x165667B19E3779F9ULL;
+
+	return hash ^ (hash >> 29);
+}
+
+// Find the end of the line starting at current, not including the line break
+static const char* FindLineEnd(const char* current, const char* end)
+{
+	const void* lineBreak = std::memchr(current, '\n', static_cast<size_t>(end - current));
+	return lineBreak ? static_cast<const char*>(lineBreak) : end;
+}
+
+// Skip spaces and tabs
+static const char* SkipSpaces(const char* current, const char* end)
+{
+	while (current < end && (*current == ' ' || *current == '\t' || *current == '\r'))
+		++current;
+
+	return current;
+}
+
+// Check if a line starts with a keyword such as "vt" followed by a space or tab
+// Both passes over a chunk use it, so they agree on which lines declare elements
+static bool IsOBJKeyword(const char* current, const char* lineEnd, const char* keyword)
+{
+	const size_t length = std::strlen(keyword);
+
+	return static_cast<size_t>(lineEnd - current) > length && std::memcmp(current, keyword, length) == 0 &&
+		(current[length] == ' ' || current[length] == '\t');
+}
+
+// Read up to maxCount floats from a line, returns how many were read
+static int ParseFloats(const char* current, const char* end, float* outValues, const int& maxCount)
+{
+	int count = 0;
+
+	while (count < maxCount)
+	{
+		current = SkipSpaces(current, end);
+		if (current >= end)
+			break;
+
+		// from_chars doesn't accept a leading '+'
+		if (*current == '+')
+			++current;
+
+		const std::from_chars_result result = std::from_chars(current, end, outValues[count]);
+		if (result.ec != std::errc())
+			break;
+
+		current = result.ptr;
+		++count;
+	}
+
+	return count;
+}
+
+// Resolve an OBJ index, positive ones count from 1 and negative ones count back from the last element
+static bool ResolveIndex(const long long& index, const PUi64& declared, PUi32& outIndex)
+{
+	const long long resolved = index > 0 ? index - 1 : static_cast<long long>(declared) + index;
+	if (index == 0 || resolved < 0 || resolved >= static_cast<long long>(LMISSING_INDEX))
+		return false;
+
+	outIndex = static_cast<PUi32>(resolved);
+	return true;
+}
+
+// Parse one face corner such as "1", "1/2", "1//3" or "1/2/3"
+static const char* ParseCorner(const char* current, const char* end, const PSOBJChunk& chunk, PSOBJVertexKey& outKey,
+	bool& outValid)
+{
+	outValid = false;
+	long long indices[3] = { 0, 0, 0 };
+
+	for (int part = 0; part < 3; ++part)
+	{
+		if (current < end && *current != '/' && *current != ' ' && *current != '\t' && *current != '\r')
+		{
+			const std::from_chars_result result = std::from_chars(current, end, indices[part]);
+			if (result.ec != std::errc())
+				return current;
+
+			current = result.ptr;
+		}
+
+		if (current >= end || *current != '/')
+			break;
+
+		++current;
+	}
+
+	if (!ResolveIndex(indices[0], chunk.positionBase + chunk.positionCount, outKey.position))
+		return current;
+
+	if (indices[1] != 0 && !ResolveIndex(indices[1], chunk.texCoordBase + chunk.texCoordCount, outKey.texCoord))
+		return current;
+
+	if (indices[2] != 0 && !ResolveIndex(indices[2], chunk.normalBase + chunk.normalCount, outKey.normal))
+		return current;
+
+	outValid = true;
+	return current;
+}
+
+// Count the elements declared in a chunk, so every chunk knows where its indices start
+static void CountOBJChunk(PSOBJChunk& chunk)
+{
+	for (const char* line = chunk.begin; line < chunk.end;)
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.end);
+		const char* current = SkipSpaces(line, lineEnd);
+
+		if (IsOBJKeyword(current, lineEnd, "v"))
+			++chunk.positionCount;
+		else if (IsOBJKeyword(current, lineEnd, "vt"))
+			++chunk.texCoordCount;
+		else if (IsOBJKeyword(current, lineEnd, "vn"))
+			++chunk.normalCount;
+
+		line = lineEnd + 1;
+	}
+}
+
+// Parse the lines of a chunk, the counts are reset and counted again as elements are read
+static void ParseOBJChunk(PSOBJChunk& chunk)
+{
+	const PUi64 positionCount = chunk.positionCount;
+	chunk.positions.reserve(positionCount * 3);
+	chunk.colours.reserve(positionCount * 3);
+	chunk.texCoords.reserve(chunk.texCoordCount * 2);
+	chunk.normals.reserve(chunk.normalCount * 3);
+	chunk.positionCount = chunk.texCoordCount = chunk.normalCount = 0;
+
+	TArray<PSOBJVertexKey> face;
+	PUi64 lineNumber = 0;
+
+	for (const char* line = chunk.begin; line < chunk.end; ++lineNumber)
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.end);
+		const char* current = SkipSpaces(line, lineEnd);
+		const size_t length = static_cast<size_t>(lineEnd - current);
+
+		if (IsOBJKeyword(current, lineEnd, "v"))
+		{
+			// Some exporters append an rgb colour to the position
+			float values[6] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+			const int count = ParseFloats(current + 2, lineEnd, values, 6);
+
+			if (count < 3)
+			{
+				chunk.error = "Invalid vertex position";
+				return;
+			}
+
+			chunk.positions.insert(chunk.positions.end(), values, values + 3);
+			chunk.colours.insert(chunk.colours.end(), values + 3, values + 6);
+			++chunk.positionCount;
+		}
+		else if (IsOBJKeyword(current, lineEnd, "vt"))
+		{
+			float values[2] = { 0.0f, 0.0f };
+			ParseFloats(current + 3, lineEnd, values, 2);
+
+			chunk.texCoords.insert(chunk.texCoords.end(), values, values + 2);
+			++chunk.texCoordCount;
+		}
+		else if (IsOBJKeyword(current, lineEnd, "vn"))
+		{
+			float values[3] = { 0.0f, 0.0f, 0.0f };
+			if (ParseFloats(current + 3, lineEnd, values, 3) < 3)
+			{
+				chunk.error = "Invalid vertex normal";
+				return;
+			}
+
+			chunk.normals.insert(chunk.normals.end(), values, values + 3);
+			++chunk.normalCount;
+		}
+		else if (length >= 2 && current[0] == 'f' && (current[1] == ' ' || current[1] == '\t'))
+		{
+			face.clear();
+			current += 2;
+
+			while (true)
+			{
+				// Anything after a '#' is a comment
+				current = SkipSpaces(current, lineEnd);
+				if (current >= lineEnd || *current == '#')
+					break;
+
+				PSOBJVertexKey key;
+				bool valid = false;
+				current = ParseCorner(current, lineEnd, chunk, key, valid);
+
+				if (!valid)
+				{
+					chunk.error = "Invalid face index";
+					return;
+				}
+
+				face.push_back(key);
+			}
+
+			// Polygons are split into a fan of triangles
+			for (size_t i = 2; i < face.size(); ++i)
+			{
+				chunk.corners.push_back(face[0]);
+				chunk.corners.push_back(face[i - 1]);
+				chunk.corners.push_back(face[i]);
+			}
+		}
+		else if ((length >= 2 && (current[0] == 'o' || current[0] == 'g') && (current[1] == ' ' || current[1] == '\t')) ||
+			(length >= 7 && std::memcmp(current, "usemtl", 6) == 0))
+		{
+			// Objects, groups and material changes each start a new mesh
+			const char* name = SkipSpaces(current + (current[0] == 'u' ? 6 : 1), lineEnd);
+			const char* nameEnd = lineEnd;
+			while (nameEnd > name && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+				--nameEnd;
+
+			PSOBJGroupStart group;
+			group.corner = chunk.corners.size();
+			group.name.assign(name, nameEnd);
+			chunk.groups.push_back(std::move(group));
+		}
+
+		line = lineEnd + 1;
+	}
+}
+
+// Merge the corners of a mesh into unique vertices with an open addressing hash table
+static void BuildOBJMesh(const PSOBJMeshRanges& ranges, const TArray<PSOBJChunk>& chunks, const TArray<float>& positions,
+	const TArray<float>& colours, const TArray<float>& texCoords, const TArray<float>& normals, PSImportedMesh& outMesh,
+	PString& outError)
+{
+	outMesh.name = ranges.name;
+	outMesh.indices.reserve(ranges.cornerCount);
+
+	// Keep the table under half full so probes stay short
+	size_t tableSize = 16;
+	while (tableSize < ranges.cornerCount * 2)
+		tableSize <<= 1;
+
+	TArray<PSOBJVertexKey> tableKeys(tableSize);
+	TArray<PUi32> tableValues(tableSize);
+	const size_t mask = tableSize - 1;
+
+	const PUi64 positionCount = positions.size() / 3;
+	const PUi64 texCoordCount = texCoords.size() / 2;
+	const PUi64 normalCount = normals.size() / 3;
+
+	for (const PSOBJCornerRange& range : ranges.ranges)
+	{
+		const TArray<PSOBJVertexKey>& corners = chunks[range.chunk].corners;
+
+		for (size_t corner = range.begin; corner < range.end; ++corner)
+		{
+			const PSOBJVertexKey& key = corners[corner];
+
+			size_t slot = static_cast<size_t>(HashVertexKey(key)) & mask;
+			while (tableKeys[slot].position != LMISSING_INDEX && !(tableKeys[slot] == key))
+				slot = (slot + 1) & mask;
+
+			if (tableKeys[slot].position != LMISSING_INDEX)
+			{
+				outMesh.indices.push_back(tableValues[slot]);
+				continue;
+			}
+
+			// Indices can only be checked once every chunk's elements are known
+			if (key.position >= positionCount || (key.texCoord != LMISSING_INDEX && key.texCoord >= texCoordCount) ||
+				(key.normal != LMISSING_INDEX && key.normal >= normalCount))
+			{
+				outError = "Face index out of range in " + ranges.name;
+				return;
+			}
+
+			PSVertexData vertex;
+			std::memcpy(vertex.m_Position, &positions[key.position * 3], sizeof(vertex.m_Position));
+			std::memcpy(vertex.m_Colour, &colours[key.position * 3], sizeof(vertex.m_Colour));
+
+			if (key.texCoord != LMISSING_INDEX)
+				std::memcpy(vertex.m_TexCoords, &texCoords[key.texCoord * 2], sizeof(vertex.m_TexCoords));
+
+			if (key.normal != LMISSING_INDEX)
+				std::memcpy(vertex.m_Normal, &normals[key.normal * 3], sizeof(vertex.m_Normal));
+
+			const PUi32 index = static_cast<PUi32>(outMesh.vertices.size());
+			outMesh.vertices.push_back(vertex);
+			outMesh.indices.push_back(index);
+
+			tableKeys[slot] = key;
+			tableValues[slot] = index;
+		}
+	}
+}
+
+bool PMeshImporter::Import(const PString& path, TArray<PSImportedMesh>& outMeshes, PSMeshImportStats* outStats)
+{
+	PString extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if (extension == ".obj")
+		return ImportOBJ(path, outMeshes, outStats);
+
+	if (extension == ".gltf" || extension == ".glb")
+		return ImportGLTF(path, outMeshes, outStats);
+
+	PDebug::Log("Failed to import model - " + path + ": unsupported file type " + extension, LT_ERROR);
+	return false;
+}
+
+bool PMeshImporter::ImportOBJ(const PString& path, TArray<PSImportedMesh>& outMeshes, PSMeshImportStats* outStats)
+{
+	PPROFILE_SCOPE("Import OBJ");
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	PFileData file;
+	if (!PFileSystem::Get().Open(path, file))
+	{
+		PDebug::Log("Failed to import model - " + path + ": file couldn't be opened", LT_ERROR);
+		return false;
+	}
+
+	const char* data = reinterpret_cast<const char*>(file.GetData());
+	const char* dataEnd = data + file.GetSize();
+
+	// Split the file into chunks that end on line breaks
+	TArray<PSOBJChunk> chunks;
+	for (const char* chunkBegin = data; chunkBegin < dataEnd;)
+	{
+		const char* chunkEnd = chunkBegin + std::min<PUi64>(LOBJ_CHUNK_SIZE, static_cast<PUi64>(dataEnd - chunkBegin));
+		chunkEnd = chunkEnd < dataEnd ? std::min(FindLineEnd(chunkEnd, dataEnd) + 1, dataEnd) : dataEnd;
+
+		PSOBJChunk chunk;
+		chunk.begin = chunkBegin;
+		chunk.end = chunkEnd;
+		chunks.push_back(std::move(chunk));
+
+		chunkBegin = chunkEnd;
+	}
+
+	PThreadPool& threadPool = PThreadPool::Get();
+	const PUi32 chunkCount = static_cast<PUi32>(chunks.size());
+
+	// Relative indices need to know how many elements came before each chunk
+	threadPool.ParallelFor(chunkCount, 1, [&chunks](const PUi32 begin, const PUi32 end)
+		{
+			for (PUi32 i = begin; i < end; ++i)
+				CountOBJChunk(chunks[i]);
+		});
+
+	PUi64 positionTotal = 0, texCoordTotal = 0, normalTotal = 0;
+	for (PSOBJChunk& chunk : chunks)
+	{
+		chunk.positionBase = positionTotal;
+		chunk.texCoordBase = texCoordTotal;
+		chunk.normalBase = normalTotal;
+		positionTotal += chunk.positionCount;
+		texCoordTotal += chunk.texCoordCount;
+		normalTotal += chunk.normalCount;
+	}
+
+	threadPool.ParallelFor(chunkCount, 1, [&chunks](const PUi32 begin, const PUi32 end)
+		{
+			for (PUi32 i = begin; i < end; ++i)
+				ParseOBJChunk(chunks[i]);
+		});
+
+	for (const PSOBJChunk& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			PDebug::Log("Failed to import model - " + path + ": " + chunk.error, LT_ERROR);
+			return false;
+		}
+	}
+
+	// Chunks were counted in order, so their elements join up into the file's full arrays
+	TArray<float> positions, colours, texCoords, normals;
+	positions.reserve(positionTotal * 3);
+	colours.reserve(positionTotal * 3);
+	texCoords.reserve(texCoordTotal * 2);
+	normals.reserve(normalTotal * 3);
+
+	for (PSOBJChunk& chunk : chunks)
+	{
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		colours.insert(colours.end(), chunk.colours.begin(), chunk.colours.end());
+		texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		TArray<float>().swap(chunk.positions);
+		TArray<float>().swap(chunk.colours);
+		TArray<float>().swap(chunk.texCoords);
+		TArray<float>().swap(chunk.normals);
+	}
+
+	// Split the corners into meshes at every object, group or material change
+	TArray<PSOBJMeshRanges> meshRanges;
+	PSOBJMeshRanges current;
+	current.name = std::filesystem::path(path).stem().string();
+
+	for (PUi32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+	{
+		const PSOBJChunk& chunk = chunks[chunkIndex];
+		size_t cursor = 0;
+
+		auto addRange = [&current, chunkIndex](const size_t& begin, const size_t& end)
+			{
+				if (end > begin)
+				{
+					current.ranges.push_back({ chunkIndex, begin, end });
+					current.cornerCount += end - begin;
+				}
+			};
+
+		for (const PSOBJGroupStart& group : chunk.groups)
+		{
+			addRange(cursor, group.corner);
+			cursor = group.corner;
+
+			if (current.cornerCount > 0)
+				meshRanges.push_back(std::move(current));
+
+			current = PSOBJMeshRanges();
+			current.name = group.name;
+		}
+
+		addRange(cursor, chunk.corners.size());
+	}
+
+	if (current.cornerCount > 0)
+		meshRanges.push_back(std::move(current));
+
+	// Every mesh has its own vertices, so they're merged in parallel
+	outMeshes.clear();
+	outMeshes.resize(meshRanges.size());
+	TArray<PString> errors(meshRanges.size());
+
+	threadPool.ParallelFor(static_cast<PUi32>(meshRanges.size()), 1, [&](const PUi32 begin, const PUi32 end)
+		{
+			for (PUi32 i = begin; i < end; ++i)
+				BuildOBJMesh(meshRanges[i], chunks, positions, colours, texCoords, normals, outMeshes[i], errors[i]);
+		});
+
+	for (const PString& error : errors)
+	{
+		if (!error.empty())
+		{
+			PDebug::Log("Failed to import model - " + path + ": " + error, LT_ERROR);
+			outMeshes.clear();
+			return false;
+		}
+	}
+
+	if (outStats)
+	{
+		*outStats = PSMeshImportStats();
+		outStats->fileBytes = file.GetSize();
+		outStats->threads = threadPool.GetWorkerCount() + 1;
+
+		for (const PSOBJMeshRanges& ranges : meshRanges)
+			outStats->sourceVertices += ranges.cornerCount;
+
+		for (const PSImportedMesh& mesh : outMeshes)
+		{
+			outStats->vertices += mesh.vertices.size();
+			outStats->triangles += mesh.indices.size() / 3;
+		}
+
+		outStats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	return true;
+}
+
+// Structure for a buffer a glTF file's accessors read from
+struct PSGLTFBuffer
+{
+	TUnique<PFileData> file;     // Contents of a .bin file, null for the GLB binary chunk
+	const PUi8* data = nullptr;
+	PUi64 size = 0;
+};
+
+// Structure for a primitive to build and where its node places it
+struct PSGLTFPrimitiveJob
+{
+	const PSJsonValue* primitive = nullptr;
+	PString name;
+	glm::mat4 transform = glm::mat4(1.0f);
+};
+
+// Get the number of components of an accessor type
+static int GetComponentCount(const PString& type)
+{
+	if (type == "SCALAR") return 1;
+	if (type == "VEC2") return 2;
+	if (type == "VEC3") return 3;
+	if (type == "VEC4") return 4;
+	if (type == "MAT4") return 16;
+	return 0;
+}
+
+// Get the size of an accessor component type in bytes
+static int GetComponentSize(const int& componentType)
+{
+	switch (componentType)
+	{
+	case 5120: case 5121: return 1;  // BYTE, UNSIGNED_BYTE
+	case 5122: case 5123: return 2;  // SHORT, UNSIGNED_SHORT
+	case 5125: case 5126: return 4;  // UNSIGNED_INT, FLOAT
+	default: return 0;
+	}
+}
+
+// Read one component as a float, normalised integers are mapped to 0-1 or -1-1
+static float ReadComponent(const PUi8* source, const int& componentType, const bool& normalized)
+{
+	switch (componentType)
+	{
+	case 5126:
+	{
+		float value;
+		std::memcpy(&value, source, sizeof(value));
+		return value;
+	}
+	case 5121:
+		return normalized ? source[0] / 255.0f : static_cast<float>(source[0]);
+	case 5120:
+		return normalized ? std::max(static_cast<int8_t>(source[0]) / 127.0f, -1.0f) : static_cast<float>(static_cast<int8_t>(source[0]));
+	case 5123:
+	{
+		PUi16 value;
+		std::memcpy(&value, source, sizeof(value));
+		return normalized ? value / 65535.0f : static_cast<float>(value);
+	}
+	case 5122:
+	{
+		int16_t value;
+		std::memcpy(&value, source, sizeof(value));
+		return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+	}
+	case 5125:
+	{
+		PUi32 value;
+		std::memcpy(&value, source, sizeof(value));
+		return static_cast<float>(value);
+	}
+	default:
+		return 0.0f;
+	}
+}
+
+// Find where an accessor's data starts and how far apart its elements are
+static bool LocateAccessor(const PSJsonValue& document, const TArray<PSGLTFBuffer>& buffers, const int& accessorIndex,
+	const PUi8*& outData, PUi64& outStride, PUi64& outCount, int& outComponents, int& outComponentType, bool& outNormalized)
+{
+	const PSJsonValue* accessors = document.Find("accessors");
+	const PSJsonValue* bufferViews = document.Find("bufferViews");
+	if (!accessors || accessorIndex < 0 || accessorIndex >= static_cast<int>(accessors->Size()) || !bufferViews)
+		return false;
+
+	const PSJsonValue& accessor = accessors->values[accessorIndex];
+	const int viewIndex = accessor.GetInt("bufferView", -1);
+	if (viewIndex < 0 || viewIndex >= static_cast<int>(bufferViews->Size()))
+		return false;
+
+	const PSJsonValue& view = bufferViews->values[viewIndex];
+	const int bufferIndex = view.GetInt("buffer", -1);
+	if (bufferIndex < 0 || bufferIndex >= static_cast<int>(buffers.size()))
+		return false;
+
+	outComponents = GetComponentCount(accessor.GetString("type"));
+	outComponentType = accessor.GetInt("componentType");
+	const PSJsonValue* normalized = accessor.Find("normalized");
+	outNormalized = normalized && normalized->boolean;
+	outCount = static_cast<PUi64>(accessor.GetNumber("count"));
+
+	const int componentSize = GetComponentSize(outComponentType);
+	if (outComponents == 0 || componentSize == 0)
+		return false;
+
+	const PUi64 elementSize = static_cast<PUi64>(outComponents) * componentSize;
+	const PUi64 viewStride = static_cast<PUi64>(view.GetNumber("byteStride"));
+	outStride = viewStride > 0 ? viewStride : elementSize;
+
+	const PUi64 offset = static_cast<PUi64>(view.GetNumber("byteOffset")) + static_cast<PUi64>(accessor.GetNumber("byteOffset"));
+	const PSGLTFBuffer& buffer = buffers[bufferIndex];
+
+	// The last element only needs its own size, not a full stride
+	if (outCount > 0 && offset + (outCount - 1) * outStride + elementSize > buffer.size)
+		return false;
+
+	outData = buffer.data + offset;
+
+	return true;
+}
+
+// Read an accessor into floats, padding or truncating each element to components
+static bool ReadAccessor(const PSJsonValue& document, const TArray<PSGLTFBuffer>& buffers, const int& accessorIndex,
+	const int& components, TArray<float>& outValues)
+{
+	const PUi8* data = nullptr;
+	PUi64 stride = 0, count = 0;
+	int sourceComponents = 0, componentType = 0;
+	bool normalized = false;
+
+	if (!LocateAccessor(document, buffers, accessorIndex, data, stride, count, sourceComponents, componentType, normalized))
+		return false;
+
+	const int componentSize = GetComponentSize(componentType);
+	outValues.assign(count * components, 1.0f);
+
+	for (PUi64 element = 0; element < count; ++element)
+	{
+		const PUi8* source = data + element * stride;
+
+		for (int component = 0; component < std::min(components, sourceComponents); ++component)
+			outValues[element * components + component] = ReadComponent(source + component * componentSize, componentType, normalized);
+	}
+
+	return true;
+}
+
+// Read an index accessor
+static bool ReadIndices(const PSJsonValue& document, const TArray<PSGLTFBuffer>& buffers, const int& accessorIndex,
+	TArray<PUi32>& outIndices)
+{
+	const PUi8* data = nullptr;
+	PUi64 stride = 0, count = 0;
+	int components = 0, componentType = 0;
+	bool normalized = false;
+
+	if (!LocateAccessor(document, buffers, accessorIndex, data, stride, count, components, componentType, normalized) ||
+		components != 1)
+		return false;
+
+	outIndices.resize(count);
+
+	for (PUi64 i = 0; i < count; ++i)
+	{
+		const PUi8* source = data + i * stride;
+
+		switch (componentType)
+		{
+		case 5121:
+			outIndices[i] = source[0];
+			break;
+		case 5123:
+		{
+			PUi16 value;
+			std::memcpy(&value, source, sizeof(value));
+			outIndices[i] = value;
+			break;
+		}
+		case 5125:
+			std::memcpy(&outIndices[i], source, sizeof(PUi32));
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Get the local transform of a node from its matrix or translation, rotation and scale
+static glm::mat4 GetNodeTransform(const PSJsonValue& node)
+{
+	const PSJsonValue* matrix = node.Find("matrix");
+	if (matrix && matrix->Size() == 16)
+	{
+		float values[16];
+		for (int i = 0; i < 16; ++i)
+			values[i] = static_cast<float>(matrix->values[i].number);
+
+		// glTF matrices are column-major like GLM
+		return glm::make_mat4(values);
+	}
+
+	glm::vec3 translation(0.0f), scale(1.0f);
+	glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+
+	if (const PSJsonValue* value = node.Find("translation"); value && value->Size() == 3)
+		translation = glm::vec3(value->values[0].number, value->values[1].number, value->values[2].number);
+
+	// Stored as x, y, z, w
+	if (const PSJsonValue* value = node.Find("rotation"); value && value->Size() == 4)
+		rotation = glm::quat(static_cast<float>(value->values[3].number), static_cast<float>(value->values[0].number),
+			static_cast<float>(value->values[1].number), static_cast<float>(value->values[2].number));
+
+	if (const PSJsonValue* value = node.Find("scale"); value && value->Size() == 3)
+		scale = glm::vec3(value->values[0].number, value->values[1].number, value->values[2].number);
+
+	return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+// Queue the primitives of a node and its children
+static void CollectNode(const PSJsonValue& document, const int& nodeIndex, const glm::mat4& parentTransform,
+	TArray<PSGLTFPrimitiveJob>& outJobs, const int& depth)
+{
+	const PSJsonValue* nodes = document.Find("nodes");
+	if (!nodes || nodeIndex < 0 || nodeIndex >= static_cast<int>(nodes->Size()) || depth > 64)
+		return;
+
+	const PSJsonValue& node = nodes->values[nodeIndex];
+	const glm::mat4 transform = parentTransform * GetNodeTransform(node);
+
+	const PSJsonValue* meshes = document.Find("meshes");
+	const int meshIndex = node.GetInt("mesh", -1);
+
+	if (meshes && meshIndex >= 0 && meshIndex < static_cast<int>(meshes->Size()))
+	{
+		const PSJsonValue& mesh = meshes->values[meshIndex];
+		const PString name = mesh.GetString("name", node.GetString("name", "mesh" + std::to_string(meshIndex)));
+
+		if (const PSJsonValue* primitives = mesh.Find("primitives"))
+		{
+			for (size_t i = 0; i < primitives->Size(); ++i)
+			{
+				PSGLTFPrimitiveJob job;
+				job.primitive = &primitives->values[i];
+				job.name = primitives->Size() > 1 ? name + "_" + std::to_string(i) : name;
+				job.transform = transform;
+				outJobs.push_back(std::move(job));
+			}
+		}
+	}
+
+	if (const PSJsonValue* children = node.Find("children"))
+	{
+		for (const PSJsonValue& child : children->values)
+			CollectNode(document, static_cast<int>(child.number), transform, outJobs, depth + 1);
+	}
+}
+
+// Build a mesh from a triangle primitive
+static bool BuildGLTFMesh(const PSJsonValue& document, const TArray<PSGLTFBuffer>& buffers, const PSGLTFPrimitiveJob& job,
+	PSImportedMesh& outMesh, PString& outError)
+{
+	const PSJsonValue& primitive = *job.primitive;
+	outMesh.name = job.name;
+
+	// Only triangle lists are supported, 4 is also the default mode
+	if (primitive.GetInt("mode", 4) != 4)
+	{
+		outError = job.name + " isn't a triangle list";
+		return false;
+	}
+
+	const PSJsonValue* attributes = primitive.Find("attributes");
+	if (!attributes)
+	{
+		outError = job.name + " has no attributes";
+		return false;
+	}
+
+	TArray<float> positions, normals, texCoords, colours;
+	if (!ReadAccessor(document, buffers, attributes->GetInt("POSITION", -1), 3, positions))
+	{
+		outError = job.name + " has no valid positions";
+		return false;
+	}
+
+	const size_t vertexCount = positions.size() / 3;
+	const bool hasNormals = ReadAccessor(document, buffers, attributes->GetInt("NORMAL", -1), 3, normals) &&
+		normals.size() / 3 == vertexCount;
+	const bool hasTexCoords = ReadAccessor(document, buffers, attributes->GetInt("TEXCOORD_0", -1), 2, texCoords) &&
+		texCoords.size() / 2 == vertexCount;
+	const bool hasColours = ReadAccessor(document, buffers, attributes->GetInt("COLOR_0", -1), 3, colours) &&
+		colours.size() / 3 == vertexCount;
+
+	const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(job.transform)));
+
+	outMesh.vertices.resize(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		PSVertexData& vertex = outMesh.vertices[i];
+		const glm::vec3 position = glm::vec3(job.transform * glm::vec4(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], 1.0f));
+		std::memcpy(vertex.m_Position, glm::value_ptr(position), sizeof(vertex.m_Position));
+
+		if (hasNormals)
+		{
+			const glm::vec3 normal = glm::normalize(normalMatrix * glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]));
+			std::memcpy(vertex.m_Normal, glm::value_ptr(normal), sizeof(vertex.m_Normal));
+		}
+
+		// glTF puts the texture origin at the top left, the engine's textures start at the bottom left
+		if (hasTexCoords)
+		{
+			vertex.m_TexCoords[0] = texCoords[i * 2];
+			vertex.m_TexCoords[1] = 1.0f - texCoords[i * 2 + 1];
+		}
+
+		if (hasColours)
+			std::memcpy(vertex.m_Colour, &colours[i * 3], sizeof(vertex.m_Colour));
+	}
+
+	// Primitives without indices draw their vertices in order
+	const int indicesAccessor = primitive.GetInt("indices", -1);
+	if (indicesAccessor >= 0)
+	{
+		if (!ReadIndices(document, buffers, indicesAccessor, outMesh.indices))
+		{
+			outError = job.name + " has invalid indices";
+			return false;
+		}
+
+		for (const PUi32& index : outMesh.indices)
+		{
+			if (index >= vertexCount)
+			{
+				outError = job.name + " has an index out of range";
+				return false;
+			}
+		}
+	}
+	else
+	{
+		outMesh.indices.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+			outMesh.indices[i] = static_cast<PUi32>(i);
+	}
+
+	outMesh.indices.resize(outMesh.indices.size() / 3 * 3);
+
+	return true;
+}
+
+bool PMeshImporter::ImportGLTF(const PString& path, TArray<PSImportedMesh>& outMeshes, PSMeshImportStats* outStats)
+{
+	PPROFILE_SCOPE("Import glTF");
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	PFileData file;
+	if (!PFileSystem::Get().Open(path, file))
+	{
+		PDebug::Log("Failed to import model - " + path + ": file couldn't be opened", LT_ERROR);
+		return false;
+	}
+
+	const PUi8* data = file.GetData();
+	const PUi64 size = file.GetSize();
+	PUi64 fileBytes = size;
+
+	const char* json = reinterpret_cast<const char*>(data);
+	PUi64 jsonSize = size;
+	PSGLTFBuffer binaryChunk;
+
+	// GLB files wrap the JSON and the first buffer in one container
+	PUi32 header[3] = { 0, 0, 0 };
+	if (size >= 20)
+		std::memcpy(header, data, sizeof(header));
+
+	if (header[0] == 0x46546C67U)
+	{
+		PUi32 chunkHeader[2] = { 0, 0 };
+		std::memcpy(chunkHeader, data + 12, sizeof(chunkHeader));
+
+		if (header[1] != 2 || chunkHeader[1] != 0x4E4F534AU || 20 + static_cast<PUi64>(chunkHeader[0]) > size)
+		{
+			PDebug::Log("Failed to import model - " + path + ": invalid GLB header", LT_ERROR);
+			return false;
+		}
+
+		json = reinterpret_cast<const char*>(data + 20);
+		jsonSize = chunkHeader[0];
+
+		const PUi64 binaryOffset = 20 + static_cast<PUi64>(chunkHeader[0]);
+		if (binaryOffset + 8 <= size)
+		{
+			std::memcpy(chunkHeader, data + binaryOffset, sizeof(chunkHeader));
+
+			if (chunkHeader[1] == 0x004E4942U && binaryOffset + 8 + chunkHeader[0] <= size)
+			{
+				binaryChunk.data = data + binaryOffset + 8;
+				binaryChunk.size = chunkHeader[0];
+			}
+		}
+	}
+
+	PSJsonValue document;
+	PString error;
+	if (!PJson::Parse(json, static_cast<size_t>(jsonSize), document, &error))
+	{
+		PDebug::Log("Failed to import model - " + path + ": " + error, LT_ERROR);
+		return false;
+	}
+
+	// Map every buffer, they're read in place
+	TArray<PSGLTFBuffer> buffers;
+	if (const PSJsonValue* bufferList = document.Find("buffers"))
+	{
+		const std::filesystem::path folder = std::filesystem::path(path).parent_path();
+
+		for (const PSJsonValue& bufferInfo : bufferList->values)
+		{
+			const PString uri = bufferInfo.GetString("uri");
+			PSGLTFBuffer buffer;
+
+			if (uri.empty())
+			{
+				buffer.data = binaryChunk.data;
+				buffer.size = binaryChunk.size;
+			}
+			else if (uri.rfind("data:", 0) == 0)
+			{
+				PDebug::Log("Failed to import model - " + path + ": embedded buffers aren't supported", LT_ERROR);
+				return false;
+			}
+			else
+			{
+				buffer.file = TMakeUnique<PFileData>();
+				if (!PFileSystem::Get().Open((folder / uri).string(), *buffer.file))
+				{
+					PDebug::Log("Failed to import model - " + path + ": buffer " + uri + " couldn't be opened", LT_ERROR);
+					return false;
+				}
+
+				buffer.data = buffer.file->GetData();
+				buffer.size = buffer.file->GetSize();
+				fileBytes += buffer.size;
+			}
+
+			buffers.push_back(std::move(buffer));
+		}
+	}
+
+	// Place primitives with their node transforms, files without scenes use every mesh as is
+	TArray<PSGLTFPrimitiveJob> jobs;
+	const PSJsonValue* scenes = document.Find("scenes");
+	const int sceneIndex = document.GetInt("scene", 0);
+
+	if (scenes && sceneIndex >= 0 && sceneIndex < static_cast<int>(scenes->Size()))
+	{
+		if (const PSJsonValue* roots = scenes->values[sceneIndex].Find("nodes"))
+		{
+			for (const PSJsonValue& root : roots->values)
+				CollectNode(document, static_cast<int>(root.number), glm::mat4(1.0f), jobs, 0);
+		}
+	}
+	else if (const PSJsonValue* meshes = document.Find("meshes"))
+	{
+		for (size_t meshIndex = 0; meshIndex < meshes->Size(); ++meshIndex)
+		{
+			const PSJsonValue& mesh = meshes->values[meshIndex];
+			const PSJsonValue* primitives = mesh.Find("primitives");
+
+			for (size_t i = 0; primitives && i < primitives->Size(); ++i)
+			{
+				PSGLTFPrimitiveJob job;
+				job.primitive = &primitives->values[i];
+				job.name = mesh.GetString("name", "mesh" + std::to_string(meshIndex)) + "_" + std::to_string(i);
+				jobs.push_back(std::move(job));
+			}
+		}
+	}
+
+	outMeshes.clear();
+	outMeshes.resize(jobs.size());
+	TArray<PString> errors(jobs.size());
+
+	PThreadPool& threadPool = PThreadPool::Get();
+	threadPool.ParallelFor(static_cast<PUi32>(jobs.size()), 1, [&](const PUi32 begin, const PUi32 end)
+		{
+			for (PUi32 i = begin; i < end; ++i)
+				BuildGLTFMesh(document, buffers, jobs[i], outMeshes[i], errors[i]);
+		});
+
+	for (const PString& jobError : errors)
+	{
+		if (!jobError.empty())
+		{
+			PDebug::Log("Failed to import model - " + path + ": " + jobError, LT_ERROR);
+			outMeshes.clear();
+			return false;
+		}
+	}
+
+	if (outStats)
+	{
+		*outStats = PSMeshImportStats();
+		outStats->fileBytes = fileBytes;
+		outStats->threads = threadPool.GetWorkerCount() + 1;
+
+		for (const PSImportedMesh& mesh : outMeshes)
+		{
+			outStats->sourceVertices += mesh.vertices.size();
+			outStats->vertices += mesh.vertices.size();
+			outStats->triangles += mesh.indices.size() / 3;
+		}
+
+		outStats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	return true;
+}
+
+bool PMeshImporter::Benchmark(const PString& path)
+{
+	TArray<PSImportedMesh> meshes;
+	PSMeshImportStats stats;
+
+	if (!Import(path, meshes, &stats))
+		return false;
+
+	PDebug::Log("Imported " + path + ": " + std::to_string(meshes.size()) + " meshes, " + std::to_string(stats.vertices) +
+		" vertices from " + std::to_string(stats.sourceVertices) + " corners, " + std::to_string(stats.triangles) +
+		" triangles, " + std::to_string(stats.fileBytes / (1024 * 1024)) + "MB in " +
+		std::to_string(static_cast<int>(stats.seconds * 1000.0)) + "ms on " + std::to_string(stats.threads) + " threads (" +
+		std::to_string(static_cast<int>(stats.GetMegabytesPerSecond())) + " MB/s)", LT_SUCCESS);
+
+	return true;
+}
@@ -0,0 +1,479 @@
+// Internal headers
+#include "Graphics/PMeshOptimizer.h"
+#include "Graphics/PMeshImporter.h"
+
+// External libraries
+#include <GLM/glm.hpp>
+
+// System libraries
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Marks a vertex or slot that isn't set
+#define LINVALID_INDEX 0xFFFFFFFFU
+
+// Hash every bit of a vertex, so only vertices that are identical in every attribute collide
+static PUi64 HashVertex(const PSVertexData& vertex)
+{
+	PUi32 words[sizeof(PSVertexData) / sizeof(PUi32)];
+	std::memcpy(words, &vertex, sizeof(words));
+
+	PUi64 hash = 0xCBF29CE484222325ULL;
+	for (const PUi32 word : words)
+		hash = (hash ^ word) * 0x100000001B3ULL;
+
+	return hash ^ (hash >> 29);
+}
+
+// Structure for a FIFO post-transform cache, vertices are in the cache if they went in less than size misses ago
+// Timestamps make a flush free: moving the clock past the cache size empties it
+struct PSCacheSimulation
+{
+	TArray<PUi32> insertTimes;
+	PUi32 time = 0;
+	PUi32 size = 0;
+
+	PSCacheSimulation(const PUi64& vertexCount, const PUi32& cacheSize)
+		: insertTimes(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+	bool Contains(const PUi32& vertex) const { return time - insertTimes[vertex] <= size; }
+
+	// Look a vertex up, adding it on a miss, returns true on a miss
+	bool Access(const PUi32& vertex)
+	{
+		if (Contains(vertex))
+			return false;
+
+		insertTimes[vertex] = time++;
+		return true;
+	}
+
+	void Flush() { time += size + 1; }
+};
+
+// Structure for a run of triangles the overdraw step moves as a whole
+struct PSTriangleCluster
+{
+	PUi32 firstTriangle = 0;
+	PUi32 triangleCount = 0;
+	float sortKey = 0.0f;
+};
+
+void PMeshOptimizer::Optimize(TArray<PSVertexData>& vertices, TArray<PUi32>& indices, const PSMeshOptimizeSettings& settings,
+	PSMeshOptimizeStats* outStats)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	PSMeshOptimizeStats stats;
+
+	// The steps index per-vertex tables, so out of range indices leave the mesh as it is
+	const bool valid = indices.size() % 3 == 0 &&
+		std::all_of(indices.begin(), indices.end(), [&vertices](const PUi32 index) { return index < vertices.size(); });
+
+	stats.before = AnalyzeVertexCache(indices, valid ? vertices.size() : 0, settings.cacheSize);
+
+	if (!valid)
+	{
+		PDebug::Log("Mesh not optimized: indices aren't a triangle list into its vertices", LT_WARN);
+	}
+	else if (!indices.empty())
+	{
+		if (settings.weld)
+			stats.weldedVertices = WeldVertices(vertices, indices);
+
+		if (settings.optimizeCache)
+			OptimizeVertexCache(indices, vertices.size(), settings.cacheSize);
+
+		if (settings.optimizeOverdraw)
+			stats.clusters = OptimizeOverdraw(indices, vertices, settings.cacheSize, settings.overdrawThreshold);
+
+		if (settings.optimizeFetch)
+			stats.removedVertices = OptimizeVertexFetch(vertices, indices);
+	}
+
+	stats.after = AnalyzeVertexCache(indices, valid ? vertices.size() : 0, settings.cacheSize);
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	if (outStats)
+		*outStats = stats;
+}
+
+void PMeshOptimizer::Optimize(TArray<PSImportedMesh>& meshes, const PSMeshOptimizeSettings& settings, PSMeshOptimizeStats* outStats)
+{
+	PSMeshOptimizeStats totals;
+
+	for (PSImportedMesh& mesh : meshes)
+	{
+		PSMeshOptimizeStats stats;
+		Optimize(mesh.vertices, mesh.indices, settings, &stats);
+		totals += stats;
+	}
+
+	if (outStats)
+		*outStats = totals;
+}
+
+PUi64 PMeshOptimizer::WeldVertices(TArray<PSVertexData>& vertices, TArray<PUi32>& indices)
+{
+	// Keep the table under half full so probes stay short
+	size_t tableSize = 16;
+	while (tableSize < vertices.size() * 2)
+		tableSize <<= 1;
+
+	TArray<PUi32> table(tableSize, LINVALID_INDEX);
+	const size_t mask = tableSize - 1;
+
+	TArray<PUi32> remap(vertices.size());
+	TArray<PSVertexData> unique;
+	unique.reserve(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const PSVertexData& vertex = vertices[i];
+
+		size_t slot = static_cast<size_t>(HashVertex(vertex)) & mask;
+		while (table[slot] != LINVALID_INDEX && std::memcmp(&unique[table[slot]], &vertex, sizeof(PSVertexData)) != 0)
+			slot = (slot + 1) & mask;
+
+		if (table[slot] == LINVALID_INDEX)
+		{
+			table[slot] = static_cast<PUi32>(unique.size());
+			unique.push_back(vertex);
+		}
+
+		remap[i] = table[slot];
+	}
+
+	const PUi64 welded = vertices.size() - unique.size();
+	if (welded == 0)
+		return 0;
+
+	for (PUi32& index : indices)
+		index = remap[index];
+
+	vertices.swap(unique);
+
+	return welded;
+}
+
+void PMeshOptimizer::OptimizeVertexCache(TArray<PUi32>& indices, const PUi64& vertexCount, const PUi32& cacheSize)
+{
+	const PUi32 triangleCount = static_cast<PUi32>(indices.size() / 3);
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	// Triangles around each vertex, as offsets into one array
+	TArray<PUi32> liveTriangles(vertexCount, 0);
+	for (const PUi32 index : indices)
+		++liveTriangles[index];
+
+	TArray<PUi32> adjacencyOffsets(vertexCount + 1, 0);
+	for (PUi64 vertex = 0; vertex < vertexCount; ++vertex)
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+
+	TArray<PUi32> adjacency(indices.size());
+	{
+		TArray<PUi32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (PUi32 triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			for (PUi32 corner = 0; corner < 3; ++corner)
+				adjacency[fill[indices[triangle * 3 + corner]]++] = triangle;
+		}
+	}
+
+	TArray<PUi32> result;
+	result.reserve(indices.size());
+
+	TArray<bool> emitted(triangleCount, false);
+	TArray<PUi32> deadEnds;
+	TArray<PUi32> candidates;
+	PSCacheSimulation cache(vertexCount, cacheSize);
+	PUi64 cursor = 0;
+
+	// Find a vertex to continue from when the fan's neighbours have no triangles left:
+	// the most recently used vertex that still has some, otherwise the next one in input order
+	auto skipDeadEnd = [&]() -> PUi32
+		{
+			while (!deadEnds.empty())
+			{
+				const PUi32 vertex = deadEnds.back();
+				deadEnds.pop_back();
+
+				if (liveTriangles[vertex] > 0)
+					return vertex;
+			}
+
+			for (; cursor < vertexCount; ++cursor)
+			{
+				if (liveTriangles[cursor] > 0)
+					return static_cast<PUi32>(cursor);
+			}
+
+			return LINVALID_INDEX;
+		};
+
+	PUi32 fanVertex = skipDeadEnd();
+
+	while (fanVertex != LINVALID_INDEX)
+	{
+		candidates.clear();
+
+		// Emit every remaining triangle around the fan vertex
+		for (PUi32 i = adjacencyOffsets[fanVertex]; i < adjacencyOffsets[fanVertex + 1]; ++i)
+		{
+			const PUi32 triangle = adjacency[i];
+			if (emitted[triangle])
+				continue;
+
+			for (PUi32 corner = 0; corner < 3; ++corner)
+			{
+				const PUi32 vertex = indices[triangle * 3 + corner];
+
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTriangles[vertex];
+				cache.Access(vertex);
+			}
+
+			emitted[triangle] = true;
+		}
+
+		// Fan around the neighbour that entered the cache earliest but will still be in it after its triangles are emitted,
+		// vertices that would be evicted part way through rank last
+		PUi32 nextVertex = LINVALID_INDEX;
+		PUi32 bestPriority = 0;
+
+		for (const PUi32 vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			PUi32 priority = 1;
+			const PUi32 age = cache.time - cache.insertTimes[vertex];
+			if (age + 2 * liveTriangles[vertex] <= cacheSize)
+				priority += age;
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = vertex;
+			}
+		}
+
+		fanVertex = nextVertex != LINVALID_INDEX ? nextVertex : skipDeadEnd();
+	}
+
+	indices.swap(result);
+}
+
+PUi32 PMeshOptimizer::OptimizeOverdraw(TArray<PUi32>& indices, const TArray<PSVertexData>& vertices, const PUi32& cacheSize,
+	const float& threshold)
+{
+	const PUi32 triangleCount = static_cast<PUi32>(indices.size() / 3);
+	if (triangleCount == 0)
+		return 0;
+
+	// Hard boundaries are where the order missed on all three vertices, the cache was effectively flushed there
+	// so the clusters can move without costing any reuse
+	TArray<PUi32> hardStarts;
+	PUi64 meshMisses = 0;
+	{
+		PSCacheSimulation cache(vertices.size(), cacheSize);
+		for (PUi32 triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			PUi32 misses = 0;
+			for (PUi32 corner = 0; corner < 3; ++corner)
+				misses += cache.Access(indices[triangle * 3 + corner]) ? 1 : 0;
+
+			if (triangle == 0 || misses == 3)
+				hardStarts.push_back(triangle);
+
+			meshMisses += misses;
+		}
+	}
+
+	hardStarts.push_back(triangleCount);
+
+	// Soft boundaries split a hard cluster once its own ACMR is within the threshold of the mesh's,
+	// moving the rest elsewhere then costs at most the threshold
+	const float clusterThreshold = threshold * static_cast<float>(meshMisses) / triangleCount;
+	TArray<PSTriangleCluster> clusters;
+	{
+		PSCacheSimulation cache(vertices.size(), cacheSize);
+
+		for (size_t hard = 0; hard + 1 < hardStarts.size(); ++hard)
+		{
+			PUi32 start = hardStarts[hard];
+			const PUi32 end = hardStarts[hard + 1];
+			PUi32 clusterMisses = 0;
+			cache.Flush();
+
+			for (PUi32 triangle = start; triangle < end; ++triangle)
+			{
+				for (PUi32 corner = 0; corner < 3; ++corner)
+					clusterMisses += cache.Access(indices[triangle * 3 + corner]) ? 1 : 0;
+
+				const PUi32 clusterTriangles = triangle - start + 1;
+				if (triangle + 1 < end && static_cast<float>(clusterMisses) <= clusterThreshold * clusterTriangles)
+				{
+					clusters.push_back({ start, clusterTriangles, 0.0f });
+					start = triangle + 1;
+					clusterMisses = 0;
+					cache.Flush();
+				}
+			}
+
+			clusters.push_back({ start, end - start, 0.0f });
+		}
+	}
+
+	if (clusters.size() < 2)
+		return static_cast<PUi32>(clusters.size());
+
+	auto getPosition = [&vertices](const PUi32 index)
+		{
+			return glm::vec3(vertices[index].m_Position[0], vertices[index].m_Position[1], vertices[index].m_Position[2]);
+		};
+
+	// Area weighted centres and normals of every cluster and of the whole mesh
+	TArray<glm::vec3> clusterCentres(clusters.size()), clusterNormals(clusters.size());
+	glm::vec3 meshCentre(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t i = 0; i < clusters.size(); ++i)
+	{
+		glm::vec3 centre(0.0f), normal(0.0f);
+		float area = 0.0f;
+
+		for (PUi32 triangle = clusters[i].firstTriangle; triangle < clusters[i].firstTriangle + clusters[i].triangleCount; ++triangle)
+		{
+			const glm::vec3 a = getPosition(indices[triangle * 3]);
+			const glm::vec3 b = getPosition(indices[triangle * 3 + 1]);
+			const glm::vec3 c = getPosition(indices[triangle * 3 + 2]);
+
+			const glm::vec3 cross = glm::cross(b - a, c - a);
+			const float triangleArea = glm::length(cross);
+
+			centre += (a + b + c) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+
+		meshCentre += centre;
+		meshArea += area;
+		clusterCentres[i] = area > 0.0f ? centre / area : centre;
+		clusterNormals[i] = normal;
+	}
+
+	if (meshArea > 0.0f)
+		meshCentre /= meshArea;
+
+	// Clusters whose front faces point away from the centre are the outside of the mesh and are likely to occlude
+	// the rest, so they're drawn first
+	for (size_t i = 0; i < clusters.size(); ++i)
+	{
+		const float normalLength = glm::length(clusterNormals[i]);
+		clusters[i].sortKey = normalLength > 0.0f ? glm::dot(clusterCentres[i] - meshCentre, clusterNormals[i] / normalLength) : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const PSTriangleCluster& a, const PSTriangleCluster& b)
+		{
+			return a.sortKey > b.sortKey;
+		});
+
+	TArray<PUi32> result;
+	result.reserve(indices.size());
+
+	for (const PSTriangleCluster& cluster : clusters)
+	{
+		result.insert(result.end(), indices.begin() + cluster.firstTriangle * 3,
+			indices.begin() + (cluster.firstTriangle + cluster.triangleCount) * 3);
+	}
+
+	indices.swap(result);
+
+	return static_cast<PUi32>(clusters.size());
+}
+
+PUi64 PMeshOptimizer::OptimizeVertexFetch(TArray<PSVertexData>& vertices, TArray<PUi32>& indices)
+{
+	TArray<PUi32> remap(vertices.size(), LINVALID_INDEX);
+	TArray<PSVertexData> ordered;
+	ordered.reserve(vertices.size());
+
+	for (PUi32& index : indices)
+	{
+		if (remap[index] == LINVALID_INDEX)
+		{
+			remap[index] = static_cast<PUi32>(ordered.size());
+			ordered.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	const PUi64 removed = vertices.size() - ordered.size();
+	vertices.swap(ordered);
+
+	return removed;
+}
+
+PSVertexCacheStats PMeshOptimizer::AnalyzeVertexCache(const TArray<PUi32>& indices, const PUi64& vertexCount, const PUi32& cacheSize)
+{
+	PSVertexCacheStats stats;
+	stats.triangles = indices.size() / 3;
+
+	if (vertexCount == 0)
+		return stats;
+
+	PSCacheSimulation cache(vertexCount, cacheSize);
+	TArray<bool> used(vertexCount, false);
+
+	for (const PUi32 index : indices)
+	{
+		stats.transforms += cache.Access(index) ? 1 : 0;
+
+		if (!used[index])
+		{
+			used[index] = true;
+			++stats.vertices;
+		}
+	}
+
+	return stats;
+}
+
+PString PMeshOptimizer::FormatStats(const PSMeshOptimizeStats& stats)
+{
+	char line[256];
+	std::snprintf(line, sizeof(line), "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %llu vertices welded, %llu unused removed, %u clusters, %.1fms",
+		stats.before.GetACMR(), stats.after.GetACMR(), stats.before.GetATVR(), stats.after.GetATVR(),
+		static_cast<unsigned long long>(stats.weldedVertices), static_cast<unsigned long long>(stats.removedVertices),
+		stats.clusters, stats.seconds * 1000.0);
+
+	return line;
+}
+
+bool PMeshOptimizer::Benchmark(const PString& path)
+{
+	TArray<PSImportedMesh> meshes;
+	if (!PMeshImporter::Import(path, meshes))
+		return false;
+
+	PSMeshOptimizeStats totals;
+
+	for (PSImportedMesh& mesh : meshes)
+	{
+		PSMeshOptimizeStats stats;
+		Optimize(mesh.vertices, mesh.indices, PSMeshOptimizeSettings(), &stats);
+		totals += stats;
+
+		PDebug::Log("  " + mesh.name + " (" + std::to_string(stats.after.triangles) + " triangles): " + FormatStats(stats));
+	}
+
+	PDebug::Log("Optimized " + path + ": " + FormatStats(totals), LT_SUCCESS);
+
+	return true;
+}
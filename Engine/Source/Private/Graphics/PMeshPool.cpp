@@ -0,0 +1,238 @@
+// Internal headers
+#include "Graphics/PMeshPool.h"
+#include "Graphics/PMesh.h"
+#include "Graphics/PGLState.h"
+#include "Graphics/PRingBuffer.h"
+#include "Debug/PMemoryTracker.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <cstring>
+
+PMeshPool::PMeshPool()
+{
+	m_VAO = m_VBO = m_EAO = 0;
+	m_CommandBuffer = m_DrawDataBuffer = 0;
+	m_MaxVertices = m_MaxIndices = 0;
+	m_VertexCount = m_IndexCount = 0;
+	m_BatchCount = 0;
+	m_MemoryHandle = PMemoryTracker::Register(RT_MESH_POOL, "Mesh pool");
+}
+
+PMeshPool::~PMeshPool()
+{
+	const PUi32 buffers[] = { m_VBO, m_EAO, m_CommandBuffer, m_DrawDataBuffer };
+	for (const PUi32& buffer : buffers)
+	{
+		if (buffer > 0)
+		{
+			PGLState::OnBufferDeleted(buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+
+	if (m_VAO > 0)
+	{
+		PGLState::OnVertexArrayDeleted(m_VAO);
+		glDeleteVertexArrays(1, &m_VAO);
+	}
+
+	PMemoryTracker::Unregister(m_MemoryHandle);
+}
+
+bool PMeshPool::Init(const PUi32& maxVertices, const PUi32& maxIndices, const PSVertexLayoutInfo& layout)
+{
+	m_MaxVertices = maxVertices;
+	m_MaxIndices = maxIndices;
+	m_Layout = layout;
+
+	glCreateVertexArrays(1, &m_VAO);
+	glCreateBuffers(1, &m_VBO);
+	glCreateBuffers(1, &m_EAO);
+	glCreateBuffers(1, &m_CommandBuffer);
+	glCreateBuffers(1, &m_DrawDataBuffer);
+
+	if (m_VAO == 0 || m_VBO == 0 || m_EAO == 0 || m_CommandBuffer == 0 || m_DrawDataBuffer == 0)
+	{
+		PString errorMsg = reinterpret_cast<const char*>(glewGetErrorString(glGetError()));
+		PDebug::Log("Failed to create mesh pool: " + errorMsg, LT_ERROR);
+		return false;
+	}
+
+	// Allocate the shared storage once, meshes are copied in as they're allocated
+	glNamedBufferStorage(m_VBO, static_cast<GLsizeiptr>(m_MaxVertices) * m_Layout.stride, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glNamedBufferStorage(m_EAO, static_cast<GLsizeiptr>(m_MaxIndices) * sizeof(PUi32), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	// Same attribute locations as PMesh, so the mesh shaders work on pooled meshes too
+	glVertexArrayVertexBuffer(m_VAO, 0, m_VBO, 0, static_cast<GLsizei>(m_Layout.stride));
+	glVertexArrayElementBuffer(m_VAO, m_EAO);
+
+	for (PUi32 i = 0; i < m_Layout.attributeCount; ++i)
+	{
+		const PSVertexAttribute& attribute = m_Layout.attributes[i];
+		glEnableVertexArrayAttrib(m_VAO, attribute.location);
+		glVertexArrayAttribFormat(m_VAO, attribute.location, static_cast<GLint>(attribute.components), attribute.type,
+			attribute.normalized ? GL_TRUE : GL_FALSE, attribute.offset);
+		glVertexArrayAttribBinding(m_VAO, attribute.location, 0);
+	}
+
+	UpdateMemory();
+
+	PDebug::Log("Mesh pool created with room for " + std::to_string(m_MaxVertices) + " vertices and " +
+		std::to_string(m_MaxIndices) + " indices");
+
+	return true;
+}
+
+bool PMeshPool::Allocate(const TArray<PSVertexData>& vertices, const TArray<PUi32>& indices, PSMeshPoolRange& outRange)
+{
+	return Allocate(vertices.data(), static_cast<PUi32>(vertices.size()), indices.data(), static_cast<PUi32>(indices.size()),
+		outRange);
+}
+
+bool PMeshPool::Allocate(const PSVertexData* vertices, const PUi32& vertexCount, const PUi32* indices, const PUi32& indexCount,
+	PSMeshPoolRange& outRange)
+{
+	if (m_Layout == PStandardVertexLayout::GetInfo())
+		return AllocateEncoded(vertices, vertexCount, indices, indexCount, outRange);
+
+	m_EncodeBuffer.resize(static_cast<size_t>(vertexCount) * m_Layout.stride);
+	PVertexLayout::Encode(m_Layout, vertices, vertexCount, m_EncodeBuffer.data());
+
+	return AllocateEncoded(m_EncodeBuffer.data(), vertexCount, indices, indexCount, outRange);
+}
+
+bool PMeshPool::AllocateEncoded(const void* vertexData, const PUi32& vertexCount, const PUi32* indices, const PUi32& indexCount,
+	PSMeshPoolRange& outRange)
+{
+	if (m_VBO == 0)
+	{
+		PDebug::Log("Failed to allocate pooled mesh: pool isn't initialized", LT_WARN);
+		return false;
+	}
+
+	if (static_cast<PUi64>(m_VertexCount) + vertexCount > m_MaxVertices ||
+		static_cast<PUi64>(m_IndexCount) + indexCount > m_MaxIndices)
+	{
+		PDebug::Log("Failed to allocate pooled mesh: pool is full", LT_WARN);
+		return false;
+	}
+
+	outRange.baseVertex = m_VertexCount;
+	outRange.vertexCount = vertexCount;
+	outRange.firstIndex = m_IndexCount;
+	outRange.indexCount = indexCount;
+
+	// Indices stay relative to the mesh, baseVertex offsets them when drawing
+	glNamedBufferSubData(
+		m_VBO,
+		static_cast<GLintptr>(outRange.baseVertex) * m_Layout.stride,
+		static_cast<GLsizeiptr>(vertexCount) * m_Layout.stride,
+		vertexData
+	);
+
+	glNamedBufferSubData(
+		m_EAO,
+		static_cast<GLintptr>(outRange.firstIndex) * sizeof(PUi32),
+		static_cast<GLsizeiptr>(indexCount) * sizeof(PUi32),
+		indices
+	);
+
+	m_VertexCount += outRange.vertexCount;
+	m_IndexCount += outRange.indexCount;
+
+	UpdateMemory();
+
+	return true;
+}
+
+void PMeshPool::DrawBatch(const TArray<PSMeshPoolDraw>& draws, PRingBuffer* dynamicBuffer)
+{
+	if (draws.empty() || m_VAO == 0)
+		return;
+
+	const PUi32 drawCount = static_cast<PUi32>(draws.size());
+	const PUi32 commandBytes = drawCount * sizeof(PSDrawElementsIndirectCommand);
+	const PUi32 dataBytes = drawCount * sizeof(PSIndirectDrawData);
+
+	// The per-draw data and the commands share one block, so the frame's region is never left holding
+	// half a batch when only one of them would fit
+	const PUi32 commandStart = (dataBytes + 15U) / 16U * 16U;
+
+	PSRingAllocation batchAlloc;
+	if (dynamicBuffer)
+		batchAlloc = dynamicBuffer->Allocate(commandStart + commandBytes, dynamicBuffer->GetStorageAlignment());
+
+	const bool useRing = batchAlloc.IsValid();
+
+	// Write straight into mapped memory, or into the staging arrays for the fallback buffers
+	if (!useRing)
+	{
+		m_Commands.resize(drawCount);
+		m_DrawData.resize(drawCount);
+	}
+
+	PSDrawElementsIndirectCommand* commands = useRing
+		? reinterpret_cast<PSDrawElementsIndirectCommand*>(static_cast<PUi8*>(batchAlloc.data) + commandStart)
+		: m_Commands.data();
+	PSIndirectDrawData* drawData = useRing
+		? static_cast<PSIndirectDrawData*>(batchAlloc.data) : m_DrawData.data();
+
+	for (PUi32 i = 0; i < drawCount; ++i)
+	{
+		const PSMeshPoolDraw& draw = draws[i];
+
+		commands[i].count = draw.range.indexCount;
+		commands[i].instanceCount = 1;
+		commands[i].firstIndex = draw.range.firstIndex;
+		commands[i].baseVertex = static_cast<int>(draw.range.baseVertex);
+		commands[i].baseInstance = 0;
+
+		drawData[i] = draw.data;
+	}
+
+	PUi32 commandBuffer = m_CommandBuffer, commandOffset = 0;
+	PUi32 dataBuffer = m_DrawDataBuffer, dataOffset = 0;
+
+	if (useRing)
+	{
+		commandBuffer = batchAlloc.buffer;
+		commandOffset = batchAlloc.offset + commandStart;
+		dataBuffer = batchAlloc.buffer;
+		dataOffset = batchAlloc.offset;
+	}
+	else
+	{
+		// Orphan and refill the pool's own buffers
+		glNamedBufferData(m_CommandBuffer, commandBytes, m_Commands.data(), GL_STREAM_DRAW);
+		glNamedBufferData(m_DrawDataBuffer, dataBytes, m_DrawData.data(), GL_STREAM_DRAW);
+	}
+
+	// The shader indexes the per-draw data with gl_DrawID
+	PGLState::BindVertexArray(m_VAO);
+	PGLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	PGLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, PMESHPOOL_DRAW_DATA_BINDING, dataBuffer, dataOffset, dataBytes);
+
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		GL_UNSIGNED_INT,
+		reinterpret_cast<const void*>(static_cast<uintptr_t>(commandOffset)),
+		static_cast<GLsizei>(drawCount),
+		0
+	);
+
+	++m_BatchCount;
+}
+
+void PMeshPool::UpdateMemory()
+{
+	const PUi64 freeBytes = static_cast<PUi64>(m_MaxVertices - m_VertexCount) * m_Layout.stride +
+		static_cast<PUi64>(m_MaxIndices - m_IndexCount) * sizeof(PUi32);
+
+	const PUi64 stagingBytes = m_EncodeBuffer.capacity() + m_Commands.capacity() * sizeof(PSDrawElementsIndirectCommand) +
+		m_DrawData.capacity() * sizeof(PSIndirectDrawData);
+
+	PMemoryTracker::Update(m_MemoryHandle, stagingBytes, freeBytes);
+}
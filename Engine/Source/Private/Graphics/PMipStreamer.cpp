@@ -0,0 +1,637 @@
+// Internal headers
+#include "Graphics/PMipStreamer.h"
+#include "Graphics/PSCamera.h"
+#include "Graphics/PGLState.h"
+#include "Core/PThreadPool.h"
+#include "Core/PFileSystem.h"
+#include "Debug/PProfiler.h"
+
+// External libraries
+#include <GLEW/glew.h>
+#include <STB_IMAGE/stb_image.h>
+
+// System libraries
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Get the first level of a chain no larger than PMIP_STREAMER_INITIAL_SIZE
+static int GetInitialLevel(const int& width, const int& height, const int& levelCount)
+{
+	int level = 0;
+	while (level < levelCount - 1 && std::max(width >> level, height >> level) > PMIP_STREAMER_INITIAL_SIZE)
+	{
+		++level;
+	}
+
+	return level;
+}
+
+// Halve an image with a box filter, odd edges reuse their last row or column
+static void DownsampleLevel(const TArray<PUi8>& source, const int& width, const int& height, const int& channels,
+	TArray<PUi8>& outLevel)
+{
+	const int levelWidth = std::max(width / 2, 1);
+	const int levelHeight = std::max(height / 2, 1);
+	outLevel.resize(static_cast<size_t>(levelWidth) * levelHeight * channels);
+
+	for (int y = 0; y < levelHeight; ++y)
+	{
+		const int y0 = std::min(y * 2, height - 1);
+		const int y1 = std::min(y * 2 + 1, height - 1);
+
+		for (int x = 0; x < levelWidth; ++x)
+		{
+			const int x0 = std::min(x * 2, width - 1);
+			const int x1 = std::min(x * 2 + 1, width - 1);
+
+			for (int c = 0; c < channels; ++c)
+			{
+				const PUi32 sum =
+					source[(static_cast<size_t>(y0) * width + x0) * channels + c] +
+					source[(static_cast<size_t>(y0) * width + x1) * channels + c] +
+					source[(static_cast<size_t>(y1) * width + x0) * channels + c] +
+					source[(static_cast<size_t>(y1) * width + x1) * channels + c];
+
+				outLevel[(static_cast<size_t>(y) * levelWidth + x) * channels + c] = static_cast<PUi8>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+// Set the wrap and filter state of new storage, streamed textures always sample their mip chain
+static void ApplySamplerState(const PUi32& textureID, const PSTextureLoadOptions& options, const int& levels)
+{
+	const GLint wrap = options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	const bool hasMips = levels > 1;
+
+	glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, wrap);
+	glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, wrap);
+	glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, options.linearFilter ?
+		(hasMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR) : (hasMips ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST));
+	glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, options.linearFilter ? GL_LINEAR : GL_NEAREST);
+}
+
+PMipStreamer::PMipStreamer()
+{
+	m_Loaded = TMakeShared<PSMipLoadQueue>();
+	m_Pending = 0;
+	m_CameraPosition = glm::vec3(0.0f);
+	m_ProjectionScale = 1.0f;
+	m_MemoryBudget = 256ULL * 1024 * 1024;
+	m_FrameBudget = 8ULL * 1024 * 1024;
+}
+
+void PMipStreamer::Register(const TShared<PTexture>& texture, const PString& fileName, const PString& path,
+	const PSTextureLoadOptions& options)
+{
+	if (texture == nullptr)
+		return;
+
+	// An entry at the same address can belong to a destroyed texture that Update hasn't purged yet
+	const auto found = m_Lookup.find(texture.get());
+	if (found != m_Lookup.end() && !m_Textures[found->second].texture.expired())
+		return;
+
+	texture->m_FileName = fileName;
+	texture->m_Path = path;
+	texture->m_Options = options;
+
+	PSStreamedTexture streamed;
+	streamed.texture = texture;
+	streamed.key = texture.get();
+	streamed.path = path;
+	streamed.options = options;
+
+	// Reuse the stale entry's slot, loads still in flight for it are dropped once their texture fails to lock
+	if (found != m_Lookup.end())
+	{
+		m_Textures[found->second] = streamed;
+		StartLoad(m_Textures[found->second], -1);
+		return;
+	}
+
+	m_Lookup[texture.get()] = static_cast<PUi32>(m_Textures.size());
+	m_Textures.push_back(streamed);
+
+	StartLoad(m_Textures.back(), -1);
+}
+
+void PMipStreamer::BeginFrame(const PSCamera& camera, const float& viewportHeight)
+{
+	m_CameraPosition = camera.transform.position;
+	m_ProjectionScale = viewportHeight / (2.0f * std::tan(glm::radians(camera.fov) * 0.5f));
+
+	// Textures nobody draws this frame fall back to their idle level
+	for (PSStreamedTexture& streamed : m_Textures)
+	{
+		streamed.wantedLevel = GetIdleLevel(streamed);
+	}
+}
+
+void PMipStreamer::Request(const PTexture* texture, const glm::vec4& worldSphere)
+{
+	const auto found = m_Lookup.find(texture);
+	if (found == m_Lookup.end())
+		return;
+
+	PSStreamedTexture& streamed = m_Textures[found->second];
+	if (streamed.levelCount == 0)
+		return;
+
+	const float level = EstimateMipLevel(std::max(streamed.fullWidth, streamed.fullHeight), worldSphere,
+		m_CameraPosition, m_ProjectionScale);
+
+	// The finest request of the frame wins
+	streamed.wantedLevel = std::min(streamed.wantedLevel, std::clamp(static_cast<int>(level), 0, streamed.levelCount - 1));
+}
+
+void PMipStreamer::Update()
+{
+	PPROFILE_SCOPE("Mip Streaming");
+
+	ApplyLoads();
+
+	// Forget textures that were destroyed, their storage went with them
+	for (size_t i = 0; i < m_Textures.size();)
+	{
+		if (!m_Textures[i].texture.expired())
+		{
+			++i;
+			continue;
+		}
+
+		m_Lookup.erase(m_Textures[i].key);
+
+		if (i + 1 < m_Textures.size())
+		{
+			m_Textures[i] = std::move(m_Textures.back());
+			m_Lookup[m_Textures[i].key] = static_cast<PUi32>(i);
+		}
+
+		m_Textures.pop_back();
+	}
+
+	// Start every texture at the level its draws want
+	PUi64 targetBytes = 0;
+	for (PSStreamedTexture& streamed : m_Textures)
+	{
+		if (streamed.levelCount == 0)
+			continue;
+
+		streamed.targetLevel = std::clamp(streamed.wantedLevel, 0, streamed.levelCount - 1);
+		targetBytes += GetLevelBytes(streamed, streamed.targetLevel);
+	}
+
+	m_Stats.wantedBytes = targetBytes;
+
+	// Drop a level from the texture using the most memory until everything fits
+	// Each step removes the largest level left, so detail is taken from big textures first
+	while (targetBytes > m_MemoryBudget)
+	{
+		PSStreamedTexture* largest = nullptr;
+		PUi64 largestBytes = 0;
+
+		for (PSStreamedTexture& streamed : m_Textures)
+		{
+			if (streamed.levelCount == 0 || streamed.targetLevel >= streamed.levelCount - 1)
+				continue;
+
+			const PUi64 bytes = GetLevelBytes(streamed, streamed.targetLevel);
+			if (bytes > largestBytes)
+			{
+				largest = &streamed;
+				largestBytes = bytes;
+			}
+		}
+
+		if (largest == nullptr)
+			break;
+
+		targetBytes -= largestBytes - GetLevelBytes(*largest, largest->targetLevel + 1);
+		++largest->targetLevel;
+	}
+
+	// Move every texture towards its target
+	PUi64 residentBytes = 0;
+	m_Stats.budgetLimitedTextures = 0;
+
+	for (PSStreamedTexture& streamed : m_Textures)
+	{
+		if (streamed.levelCount == 0)
+			continue;
+
+		if (streamed.targetLevel > streamed.wantedLevel)
+			++m_Stats.budgetLimitedTextures;
+
+		const TShared<PTexture> texture = streamed.texture.lock();
+		if (!texture || streamed.storageLevel < 0)
+			continue;
+
+		if (streamed.targetLevel < streamed.storageLevel)
+		{
+			// Finer levels have to be decoded, show everything that's resident until they arrive
+			if (streamed.loadingLevel < 0)
+				StartLoad(streamed, streamed.targetLevel);
+
+			if (streamed.baseLevel != streamed.storageLevel)
+				SetBaseLevel(streamed, *texture, streamed.storageLevel);
+		}
+		else if (streamed.baseLevel != streamed.targetLevel)
+		{
+			// The levels are resident, so hiding or showing them is only a clamp
+			SetBaseLevel(streamed, *texture, streamed.targetLevel);
+		}
+
+		residentBytes += GetLevelBytes(streamed, streamed.storageLevel);
+	}
+
+	// Release hidden levels only when the budget needs their memory, the most wasteful texture first
+	while (residentBytes > m_MemoryBudget)
+	{
+		PSStreamedTexture* wasteful = nullptr;
+		PUi64 wastedBytes = 0;
+
+		for (PSStreamedTexture& streamed : m_Textures)
+		{
+			if (streamed.storageLevel < 0 || streamed.baseLevel <= streamed.storageLevel)
+				continue;
+
+			const PUi64 bytes = GetLevelBytes(streamed, streamed.storageLevel) - GetLevelBytes(streamed, streamed.baseLevel);
+			if (bytes > wastedBytes)
+			{
+				wasteful = &streamed;
+				wastedBytes = bytes;
+			}
+		}
+
+		if (wasteful == nullptr)
+			break;
+
+		const TShared<PTexture> texture = wasteful->texture.lock();
+		if (!texture)
+			break;
+
+		Release(*wasteful, *texture, wasteful->baseLevel);
+		residentBytes -= wastedBytes;
+	}
+}
+
+float PMipStreamer::EstimateMipLevel(const int& textureSize, const glm::vec4& worldSphere,
+	const glm::vec3& cameraPosition, const float& projectionScale)
+{
+	// Inside the bounds the surface can fill the screen
+	const float distance = glm::length(glm::vec3(worldSphere) - cameraPosition) - worldSphere.w;
+	if (distance <= 0.0f)
+		return 0.0f;
+
+	// Pixels covered by the sphere's diameter, one texel per pixel is all the detail that can be seen
+	const float projectedSize = 2.0f * worldSphere.w / distance * projectionScale;
+	if (projectedSize <= 1.0f)
+		return std::log2(static_cast<float>(textureSize));
+
+	return std::max(std::log2(static_cast<float>(textureSize) / projectedSize), 0.0f);
+}
+
+PSMipStreamerStats PMipStreamer::GetStats() const
+{
+	PSMipStreamerStats stats = m_Stats;
+	stats.streamedTextures = static_cast<PUi32>(m_Textures.size());
+	stats.pendingRequests = m_Pending.load(std::memory_order_relaxed);
+	stats.budgetBytes = m_MemoryBudget;
+
+	for (const PSStreamedTexture& streamed : m_Textures)
+	{
+		if (streamed.storageLevel < 0)
+			continue;
+
+		++stats.residentTextures;
+		stats.residentBytes += GetLevelBytes(streamed, streamed.storageLevel);
+	}
+
+	return stats;
+}
+
+void PMipStreamer::LogStats() const
+{
+	const PSMipStreamerStats stats = GetStats();
+
+	PDebug::Log("Mip streamer: " + std::to_string(stats.residentTextures) + "/" + std::to_string(stats.streamedTextures) +
+		" textures resident using " + std::to_string(stats.residentBytes / 1024) + "KB of " +
+		std::to_string(stats.budgetBytes / 1024) + "KB, " + std::to_string(stats.wantedBytes / 1024) + "KB wanted, " +
+		std::to_string(stats.budgetLimitedTextures) + " limited by budget, " + std::to_string(stats.pendingRequests) +
+		" pending, " + std::to_string(stats.loads) + " loads, " + std::to_string(stats.evictions) + " evictions");
+}
+
+void PMipStreamer::StartLoad(PSStreamedTexture& streamed, const int& level)
+{
+	streamed.loadingLevel = std::max(level, 0);
+	m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+	const TWeak<PTexture> weakTexture = streamed.texture;
+	const TShared<PSMipLoadQueue> loaded = m_Loaded;
+	const PString path = streamed.path;
+	const bool flipVertically = streamed.options.flipVertically;
+
+	PThreadPool::Get().Enqueue([weakTexture, loaded, path, flipVertically, level]()
+		{
+			PPROFILE_SCOPE("Mip Decode");
+
+			PSMipLoad load;
+			load.texture = weakTexture;
+
+			if (weakTexture.expired())
+			{
+				load.error = "Texture released before decoding";
+			}
+			else if (PCompressedTexture::IsCompressedPath(path))
+			{
+				// Compressed files carry every level, the wanted ones are picked when uploading
+				load.compressed = TMakeShared<PSCompressedImage>();
+				if (PCompressedTexture::Load(path, *load.compressed, flipVertically))
+				{
+					load.fullWidth = static_cast<int>(load.compressed->width);
+					load.fullHeight = static_cast<int>(load.compressed->height);
+					load.levelCount = static_cast<int>(load.compressed->mips.size());
+					load.channels = 4;
+				}
+				else
+				{
+					load.compressed = nullptr;
+					load.error = "Invalid compressed texture file";
+				}
+			}
+			else
+			{
+				// The whole image has to be decoded, then it's reduced to the requested level
+				stbi_set_flip_vertically_on_load_thread(flipVertically);
+
+				PFileData file;
+				const bool found = PFileSystem::Get().Open(path, file);
+				unsigned char* pixels = found ? stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()),
+					&load.fullWidth, &load.fullHeight, &load.channels, 0) : nullptr;
+
+				if (pixels == nullptr)
+				{
+					load.error = found ? stbi_failure_reason() : "file not found";
+				}
+				else if (load.channels > 4 || load.channels < 3)
+				{
+					load.error = "Incorrect number of channels, must have 3 or 4 channels";
+					stbi_image_free(pixels);
+				}
+				else
+				{
+					load.levelCount = static_cast<int>(std::floor(std::log2(std::max(load.fullWidth, load.fullHeight)))) + 1;
+					load.pixels.assign(pixels, pixels + static_cast<size_t>(load.fullWidth) * load.fullHeight * load.channels);
+					stbi_image_free(pixels);
+				}
+			}
+
+			if (load.error.empty())
+			{
+				load.level = level < 0 ? GetInitialLevel(load.fullWidth, load.fullHeight, load.levelCount) :
+					std::min(level, load.levelCount - 1);
+
+				// Halve the image until it reaches the level
+				TArray<PUi8> halved;
+				for (int current = 0; current < load.level && load.compressed == nullptr; ++current)
+				{
+					DownsampleLevel(load.pixels, std::max(load.fullWidth >> current, 1), std::max(load.fullHeight >> current, 1),
+						load.channels, halved);
+					load.pixels.swap(halved);
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(loaded->mutex);
+			loaded->loads.push_back(std::move(load));
+		});
+}
+
+void PMipStreamer::ApplyLoads()
+{
+	PUi64 frameBytes = 0;
+
+	while (true)
+	{
+		PSMipLoad load;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Loaded->mutex);
+			if (m_Loaded->loads.empty())
+				break;
+
+			// Leave the rest for the next frame once the budget is spent
+			if (frameBytes >= m_FrameBudget)
+				break;
+
+			load = std::move(m_Loaded->loads.front());
+			m_Loaded->loads.pop_front();
+		}
+
+		m_Pending.fetch_sub(1, std::memory_order_relaxed);
+
+		const TShared<PTexture> texture = load.texture.lock();
+		if (!texture)
+			continue;
+
+		const auto found = m_Lookup.find(texture.get());
+		if (found == m_Lookup.end())
+			continue;
+
+		PSStreamedTexture& streamed = m_Textures[found->second];
+		streamed.loadingLevel = -1;
+
+		if (!load.error.empty())
+		{
+			PDebug::Log("Failed to stream texture - " + texture->GetName() + ": " + load.error, LT_ERROR);
+			continue;
+		}
+
+		// The first load tells the streamer what the full chain looks like
+		if (streamed.levelCount == 0)
+		{
+			streamed.fullWidth = load.fullWidth;
+			streamed.fullHeight = load.fullHeight;
+			streamed.levelCount = load.levelCount;
+			streamed.channels = load.channels;
+			streamed.format = load.compressed ? load.compressed->format : CF_UNKNOWN;
+			streamed.wantedLevel = streamed.targetLevel = load.level;
+		}
+
+		// Skip loads that no longer add detail, or add more than the budget allows now
+		if (streamed.storageLevel >= 0 && (load.level >= streamed.storageLevel || load.level < streamed.targetLevel))
+			continue;
+
+		if (Upload(streamed, *texture, load))
+		{
+			frameBytes += GetLevelBytes(streamed, load.level);
+			++m_Stats.loads;
+		}
+	}
+}
+
+bool PMipStreamer::Upload(PSStreamedTexture& streamed, PTexture& texture, PSMipLoad& load)
+{
+	const int levels = streamed.levelCount - load.level;
+	const int width = std::max(streamed.fullWidth >> load.level, 1);
+	const int height = std::max(streamed.fullHeight >> load.level, 1);
+	const GLenum internalFormat = load.compressed ? load.compressed->GetGLFormat() :
+		(load.channels == 4 ? GL_RGBA8 : GL_RGB8);
+
+	if (internalFormat == 0)
+	{
+		PDebug::Log("Failed to stream texture - " + texture.GetName() + ": unsupported compressed format", LT_ERROR);
+		return false;
+	}
+
+	PUi32 textureID = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+	if (textureID == 0)
+	{
+		PDebug::Log("Failed to create streamed texture storage - " + texture.GetName(), LT_ERROR);
+		return false;
+	}
+
+	glTextureStorage2D(textureID, levels, internalFormat, width, height);
+	ApplySamplerState(textureID, streamed.options, levels);
+
+	if (load.compressed)
+	{
+		// The file has every level, so nothing needs to be copied or generated
+		for (int level = 0; level < levels; ++level)
+		{
+			const PSCompressedMip& mip = load.compressed->mips[load.level + level];
+			glCompressedTextureSubImage2D(textureID, level, 0, 0, mip.width, mip.height, internalFormat,
+				static_cast<GLsizei>(mip.size), load.compressed->data.data() + mip.offset);
+		}
+	}
+	else
+	{
+		// Rows of 3 channel images aren't 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTextureSubImage2D(textureID, 0, 0, 0, width, height, load.channels == 4 ? GL_RGBA : GL_RGB,
+			GL_UNSIGNED_BYTE, load.pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		// Levels that are already resident are copied on the GPU, only the gap between them is generated
+		int lastGenerated = levels - 1;
+		if (streamed.storageLevel >= 0 && texture.IsResident())
+		{
+			const int firstCopied = streamed.storageLevel - load.level;
+
+			for (int level = firstCopied; level < levels; ++level)
+			{
+				const int fullLevel = load.level + level;
+				glCopyImageSubData(
+					texture.GetID(), GL_TEXTURE_2D, level - firstCopied, 0, 0, 0,
+					textureID, GL_TEXTURE_2D, level, 0, 0, 0,
+					std::max(streamed.fullWidth >> fullLevel, 1), std::max(streamed.fullHeight >> fullLevel, 1), 1
+				);
+			}
+
+			lastGenerated = firstCopied - 1;
+		}
+
+		// Clamp MAX_LEVEL so generating mips stops before the copied levels
+		if (lastGenerated >= 1)
+		{
+			glTextureParameteri(textureID, GL_TEXTURE_MAX_LEVEL, lastGenerated);
+			glGenerateTextureMipmap(textureID);
+			glTextureParameteri(textureID, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		}
+	}
+
+	if (texture.m_ID > 0)
+	{
+		PGLState::OnTextureDeleted(texture.m_ID);
+		glDeleteTextures(1, &texture.m_ID);
+	}
+
+	texture.m_ID = textureID;
+	texture.m_Width = width;
+	texture.m_Height = height;
+	texture.m_Channels = load.channels;
+
+	streamed.storageLevel = streamed.baseLevel = load.level;
+	texture.m_CompressedBytes = load.compressed ? GetLevelBytes(streamed, load.level) : 0;
+	texture.UpdateMemory();
+
+	return true;
+}
+
+void PMipStreamer::Release(PSStreamedTexture& streamed, PTexture& texture, const int& level)
+{
+	const int levels = streamed.levelCount - level;
+	const int width = std::max(streamed.fullWidth >> level, 1);
+	const int height = std::max(streamed.fullHeight >> level, 1);
+
+	GLint internalFormat = 0;
+	glGetTextureLevelParameteriv(texture.GetID(), 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+
+	PUi32 textureID = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+	if (textureID == 0)
+		return;
+
+	glTextureStorage2D(textureID, levels, static_cast<GLenum>(internalFormat), width, height);
+	ApplySamplerState(textureID, streamed.options, levels);
+
+	// Keep the levels from the new first level down, the ones above it are freed with the old storage
+	const int skipped = level - streamed.storageLevel;
+	for (int newLevel = 0; newLevel < levels; ++newLevel)
+	{
+		const int fullLevel = level + newLevel;
+		glCopyImageSubData(
+			texture.GetID(), GL_TEXTURE_2D, newLevel + skipped, 0, 0, 0,
+			textureID, GL_TEXTURE_2D, newLevel, 0, 0, 0,
+			std::max(streamed.fullWidth >> fullLevel, 1), std::max(streamed.fullHeight >> fullLevel, 1), 1
+		);
+	}
+
+	PGLState::OnTextureDeleted(texture.m_ID);
+	glDeleteTextures(1, &texture.m_ID);
+
+	texture.m_ID = textureID;
+	texture.m_Width = width;
+	texture.m_Height = height;
+
+	streamed.storageLevel = streamed.baseLevel = level;
+	if (texture.m_CompressedBytes > 0)
+		texture.m_CompressedBytes = GetLevelBytes(streamed, level);
+	texture.UpdateMemory();
+
+	++m_Stats.evictions;
+}
+
+void PMipStreamer::SetBaseLevel(PSStreamedTexture& streamed, PTexture& texture, const int& level)
+{
+	// The base level is relative to the storage, which may already start below level 0
+	glTextureParameteri(texture.GetID(), GL_TEXTURE_BASE_LEVEL, level - streamed.storageLevel);
+	streamed.baseLevel = level;
+	++m_Stats.clampChanges;
+}
+
+PUi64 PMipStreamer::GetLevelBytes(const PSStreamedTexture& streamed, const int& level) const
+{
+	PUi64 bytes = 0;
+
+	for (int current = std::max(level, 0); current < streamed.levelCount; ++current)
+	{
+		const PUi32 width = static_cast<PUi32>(std::max(streamed.fullWidth >> current, 1));
+		const PUi32 height = static_cast<PUi32>(std::max(streamed.fullHeight >> current, 1));
+
+		bytes += streamed.format != CF_UNKNOWN ? PCompressedTexture::GetLevelSize(streamed.format, width, height) :
+			static_cast<PUi64>(width) * height * streamed.channels;
+	}
+
+	return bytes;
+}
+
+int PMipStreamer::GetIdleLevel(const PSStreamedTexture& streamed)
+{
+	if (streamed.levelCount == 0)
+		return 0;
+
+	return GetInitialLevel(streamed.fullWidth, streamed.fullHeight, streamed.levelCount);
+}
@@ -1,5 +1,12 @@
 // Internal headers
 #include "Graphics/PModel.h"
+#include "Graphics/PRenderQueue.h"
+#include "Graphics/PRingBuffer.h"
+#include "Graphics/PMaterialTable.h"
+#include "Graphics/PMipStreamer.h"
+#include "Graphics/PMeshImporter.h"
+#include "Graphics/PCookedMesh.h"
+#include "Graphics/PMeshOptimizer.h"
 
 // Vertex data for a polygon
 const std::vector<PSVertexData> polyVData = {
@@ -75,12 +82,19 @@ const std::vector<PSVertexData> cubeVData = {
 };
 
 
-void PModel::MakePoly(const TShared<PTexture>& texture)
+PModel::~PModel()
+{
+	ReleaseMaterials();
+}
+
+void PModel::MakePoly(const TShared<PTexture>& texture, const TShared<PMeshPool>& pool)
 {
 	// Create a polygon mesh
 	TUnique<PMesh> mesh = TMakeUnique<PMesh>();
+	mesh->SetName("Polygon");
+	mesh->SetCPUAccess(m_CPUAccess);
 
-	if (!mesh->CreateMesh(polyVData, polyIData))
+	if (!mesh->CreateMesh(polyVData, polyIData, pool))
 	{
 		PDebug::Log("Failed to create polygon mesh");
 	}
@@ -90,12 +104,14 @@ void PModel::MakePoly(const TShared<PTexture>& texture)
 	m_MeshStack.push_back(std::move(mesh));
 }
 
-void PModel::MakeCube(const TShared<PTexture>& texture)
+void PModel::MakeCube(const TShared<PTexture>& texture, const TShared<PMeshPool>& pool)
 {
 	// Create a cube mesh
 	TUnique<PMesh> mesh = TMakeUnique<PMesh>();
+	mesh->SetName("Cube");
+	mesh->SetCPUAccess(m_CPUAccess);
 
-	if (!mesh->CreateMesh(cubeVData, cubeIData))
+	if (!mesh->CreateMesh(cubeVData, cubeIData, pool))
 	{
 		PDebug::Log("Failed to create cube mesh");
 	}
@@ -105,6 +121,99 @@ void PModel::MakeCube(const TShared<PTexture>& texture)
 	m_MeshStack.push_back(std::move(mesh));
 }
 
+bool PModel::LoadModel(const PString& path, const TShared<PTexture>& texture, const TShared<PMeshPool>& pool)
+{
+	// Load the cooker's .pmesh file instead of parsing the source when it exists
+	const PString cookedPath = PFileSystem::Get().ResolveCooked(path);
+	if (cookedPath != path)
+		return LoadCookedModel(cookedPath, texture, pool);
+
+	TArray<PSImportedMesh> meshes;
+	PSMeshImportStats stats;
+
+	if (!PMeshImporter::Import(path, meshes, &stats))
+		return false;
+
+	// Cooked models were optimized by the cooker, sources get the same order here
+	PSMeshOptimizeStats optimizeStats;
+	PMeshOptimizer::Optimize(meshes, PSMeshOptimizeSettings(), &optimizeStats);
+
+	for (const PSImportedMesh& imported : meshes)
+	{
+		TUnique<PMesh> mesh = TMakeUnique<PMesh>();
+		mesh->SetName(path + ":" + imported.name);
+		mesh->SetCPUAccess(m_CPUAccess);
+
+		if (!mesh->CreateMesh(imported.vertices, imported.indices, pool))
+		{
+			PDebug::Log("Failed to create mesh " + imported.name + " of model " + path, LT_ERROR);
+			continue;
+		}
+
+		mesh->SetTexture(texture);
+		m_MeshStack.push_back(std::move(mesh));
+	}
+
+	PDebug::Log("Model loaded: " + path + " (" + std::to_string(meshes.size()) + " meshes, " +
+		std::to_string(stats.triangles) + " triangles, " + std::to_string(static_cast<int>(stats.GetMegabytesPerSecond())) +
+		" MB/s, " + PMeshOptimizer::FormatStats(optimizeStats) + ")", LT_SUCCESS);
+
+	return true;
+}
+
+bool PModel::LoadCookedModel(const PString& path, const TShared<PTexture>& texture, const TShared<PMeshPool>& pool)
+{
+	// The mapping only has to live until the blobs are uploaded
+	PCookedMesh cookedMesh;
+	if (!cookedMesh.Open(path))
+		return false;
+
+	for (PUi32 i = 0; i < cookedMesh.GetSubmeshCount(); ++i)
+	{
+		TUnique<PMesh> mesh = TMakeUnique<PMesh>();
+		mesh->SetName(path + ":" + cookedMesh.GetSubmesh(i).name);
+		mesh->SetCPUAccess(m_CPUAccess);
+
+		if (!mesh->CreateMesh(cookedMesh, i, pool))
+		{
+			PDebug::Log("Failed to create submesh " + PString(cookedMesh.GetSubmesh(i).name) + " of model " + path, LT_ERROR);
+			continue;
+		}
+
+		mesh->SetTexture(texture);
+		m_MeshStack.push_back(std::move(mesh));
+	}
+
+	return true;
+}
+
+void PModel::SetMaterials(const TShared<PMaterialTable>& materialTable)
+{
+	ReleaseMaterials();
+	m_MaterialTable = materialTable;
+
+	for (const auto& mesh : m_MeshStack)
+	{
+		mesh->SetMaterial(materialTable->AddMaterial(mesh->GetTexture()));
+	}
+}
+
+void PModel::ReleaseMaterials()
+{
+	// The table may already be gone when the engine shuts down, its destructor frees everything
+	const TShared<PMaterialTable> materialTable = m_MaterialTable.lock();
+	if (materialTable == nullptr)
+		return;
+
+	for (const auto& mesh : m_MeshStack)
+	{
+		materialTable->RemoveMaterial(mesh->GetMaterial());
+		mesh->SetMaterial(PMATERIAL_INVALID);
+	}
+
+	m_MaterialTable.reset();
+}
+
 void PModel::Render(const TShared<PShaderProgram>& shader)
 {
 	for (const auto& mesh : m_MeshStack)
@@ -112,3 +221,205 @@ void PModel::Render(const TShared<PShaderProgram>& shader)
 		mesh->Render(shader, m_Transform);
 	}
 }
+
+void PModel::RenderInstanced(const TShared<PShaderProgram>& shader)
+{
+	if (m_Instances.empty())
+		return;
+
+	// Build the model matrix of every instance relative to the model transform
+	const glm::mat4 modelMatrix = m_Transform.GetMatrix();
+	m_InstanceMatrices.resize(m_Instances.size());
+
+	for (size_t i = 0; i < m_Instances.size(); ++i)
+	{
+		m_InstanceMatrices[i] = modelMatrix * m_Instances[i].GetMatrix();
+	}
+
+	for (const auto& mesh : m_MeshStack)
+	{
+		mesh->SetInstances(m_InstanceMatrices);
+		mesh->RenderInstanced(shader);
+	}
+}
+
+void PModel::Submit(PRenderQueue& queue, const TShared<PShaderProgram>& shader)
+{
+	PSDrawPacket packet;
+	packet.shader = shader.get();
+	packet.transform = m_Transform.GetMatrix();
+
+	for (const auto& mesh : m_MeshStack)
+	{
+		packet.mesh = mesh.get();
+
+		// Meshes with a material leave the texture to the material table
+		if (mesh->GetMaterial() != PMATERIAL_INVALID)
+		{
+			packet.texture = nullptr;
+			packet.materialIndex = mesh->GetMaterial();
+		}
+		else
+		{
+			packet.texture = mesh->GetTexture().get();
+			packet.materialIndex = 0;
+		}
+
+		queue.Submit(packet);
+	}
+}
+
+// Get the largest axis scale of a matrix, used to scale bounding sphere radii
+static float GetMaxScale(const glm::mat4& matrix)
+{
+	const float scaleX = glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0]));
+	const float scaleY = glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1]));
+	const float scaleZ = glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]));
+
+	return glm::sqrt(glm::max(scaleX, glm::max(scaleY, scaleZ)));
+}
+
+void PModel::SubmitInstanced(PRenderQueue& queue, const TShared<PShaderProgram>& shader, const PSFrustum* frustum)
+{
+	if (m_Instances.empty())
+		return;
+
+	const glm::mat4 modelMatrix = m_Transform.GetMatrix();
+	const glm::vec4 localSphere = GetLocalBoundingSphere();
+	const PUi32 totalCount = static_cast<PUi32>(m_Instances.size());
+
+	m_InstanceMatrices.resize(totalCount);
+	m_InstanceBounds.Clear();
+
+	// Build the model matrix of every instance relative to the model transform
+	for (PUi32 i = 0; i < totalCount; ++i)
+	{
+		const glm::mat4 instanceMatrix = modelMatrix * m_Instances[i].GetMatrix();
+		m_InstanceMatrices[i] = instanceMatrix;
+
+		if (frustum)
+		{
+			const glm::vec3 center = glm::vec3(instanceMatrix * glm::vec4(glm::vec3(localSphere), 1.0f));
+			m_InstanceBounds.Add(center, localSphere.w * GetMaxScale(instanceMatrix));
+		}
+	}
+
+	// Keep only the instances inside the view
+	m_VisibleInstances.clear();
+	if (frustum)
+		PFrustumCuller::Cull(*frustum, m_InstanceBounds, m_VisibleInstances);
+
+	const PUi32 instanceCount = frustum ? static_cast<PUi32>(m_VisibleInstances.size()) : totalCount;
+	if (instanceCount == 0)
+		return;
+
+	PSDrawPacket packet;
+	packet.shader = shader.get();
+	packet.transform = modelMatrix;
+	packet.instanceCount = instanceCount;
+
+	// Write the matrices straight into this frame's region of the ring buffer,
+	// all meshes of the model share the same allocation
+	const PSRingAllocation allocation = queue.AllocateDynamic(instanceCount * sizeof(glm::mat4), sizeof(glm::mat4));
+
+	if (allocation.IsValid())
+	{
+		glm::mat4* instanceMatrices = static_cast<glm::mat4*>(allocation.data);
+		for (PUi32 i = 0; i < instanceCount; ++i)
+		{
+			instanceMatrices[i] = m_InstanceMatrices[frustum ? m_VisibleInstances[i] : i];
+		}
+
+		packet.instanceBuffer = allocation.buffer;
+		packet.instanceOffset = allocation.offset;
+	}
+	else if (frustum)
+	{
+		// Compact the visible matrices in place, the indices are ascending so nothing is overwritten early
+		for (PUi32 i = 0; i < instanceCount; ++i)
+		{
+			m_InstanceMatrices[i] = m_InstanceMatrices[m_VisibleInstances[i]];
+		}
+
+		m_InstanceMatrices.resize(instanceCount);
+	}
+
+	for (const auto& mesh : m_MeshStack)
+	{
+		// No ring buffer space, fall back to each mesh's own streamed buffer
+		if (!allocation.IsValid())
+			mesh->SetInstances(m_InstanceMatrices);
+
+		packet.mesh = mesh.get();
+		packet.texture = mesh->GetTexture().get();
+		queue.Submit(packet);
+	}
+}
+
+void PModel::RequestTextureMips(PMipStreamer& mipStreamer) const
+{
+	// Culled instances have their world bounds, otherwise the whole model is used
+	const bool hasInstanceBounds = !m_Instances.empty() && !m_InstanceBounds.radius.empty();
+	const glm::vec4 worldSphere = GetWorldBoundingSphere();
+
+	for (const auto& mesh : m_MeshStack)
+	{
+		const PTexture* texture = mesh->GetTexture().get();
+		if (texture == nullptr)
+			continue;
+
+		if (!hasInstanceBounds)
+		{
+			mipStreamer.Request(texture, worldSphere);
+			continue;
+		}
+
+		for (const PUi32 instance : m_VisibleInstances)
+		{
+			mipStreamer.Request(texture, glm::vec4(m_InstanceBounds.x[instance], m_InstanceBounds.y[instance],
+				m_InstanceBounds.z[instance], m_InstanceBounds.radius[instance]));
+		}
+	}
+}
+
+glm::vec4 PModel::GetLocalBoundingSphere() const
+{
+	if (m_MeshStack.empty())
+		return glm::vec4(0.0f);
+
+	// Grow the first mesh's sphere until it contains every other mesh's sphere
+	glm::vec4 bounds = m_MeshStack[0]->GetBoundingSphere();
+
+	for (size_t i = 1; i < m_MeshStack.size(); ++i)
+	{
+		const glm::vec4 sphere = m_MeshStack[i]->GetBoundingSphere();
+		const glm::vec3 offset = glm::vec3(sphere) - glm::vec3(bounds);
+		const float distance = glm::length(offset);
+
+		// Already inside
+		if (distance + sphere.w <= bounds.w)
+			continue;
+
+		// The other sphere contains this one
+		if (distance + bounds.w <= sphere.w)
+		{
+			bounds = sphere;
+			continue;
+		}
+
+		const float radius = (distance + bounds.w + sphere.w) * 0.5f;
+		const glm::vec3 center = glm::vec3(bounds) + offset * ((radius - bounds.w) / distance);
+		bounds = glm::vec4(center, radius);
+	}
+
+	return bounds;
+}
+
+glm::vec4 PModel::GetWorldBoundingSphere() const
+{
+	const glm::mat4 modelMatrix = m_Transform.GetMatrix();
+	const glm::vec4 localSphere = GetLocalBoundingSphere();
+	const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(localSphere), 1.0f));
+
+	return glm::vec4(center, localSphere.w * GetMaxScale(modelMatrix));
+}
@@ -0,0 +1,236 @@
+// Internal headers
+#include "Graphics/PRenderQueue.h"
+#include "Graphics/PShaderProgram.h"
+#include "Graphics/PMesh.h"
+#include "Graphics/PTexture.h"
+#include "Graphics/PSCamera.h"
+#include "Graphics/PGLState.h"
+#include "Graphics/PRingBuffer.h"
+#include "Graphics/PMaterialTable.h"
+#include "Debug/PProfiler.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// Number of bits per sort key field
+#define LKEY_PROGRAM_BITS 10
+#define LKEY_TEXTURE_BITS 12
+#define LKEY_VAO_BITS 16
+#define LKEY_DEPTH_BITS 24
+
+PUi64 PRenderQueue::MakeSortKey(const PERenderPass& pass, const PUi32& programID,
+	const PUi32& textureID, const PUi32& vaoID, const float& depth)
+{
+	// Quantize the normalized depth into the lowest bits
+	const PUi64 depthMax = (1ULL << LKEY_DEPTH_BITS) - 1;
+	PUi64 depthBits = static_cast<PUi64>(glm::clamp(depth, 0.0f, 1.0f) * static_cast<float>(depthMax));
+
+	// Transparent geometry has to blend over what's behind it, so invert to sort back to front
+	if (pass == RP_TRANSPARENT)
+		depthBits = depthMax - depthBits;
+
+	PUi64 key = static_cast<PUi64>(pass) & 0x3;
+	key = (key << LKEY_PROGRAM_BITS) | (programID & ((1ULL << LKEY_PROGRAM_BITS) - 1));
+	key = (key << LKEY_TEXTURE_BITS) | (textureID & ((1ULL << LKEY_TEXTURE_BITS) - 1));
+	key = (key << LKEY_VAO_BITS) | (vaoID & ((1ULL << LKEY_VAO_BITS) - 1));
+	key = (key << LKEY_DEPTH_BITS) | depthBits;
+
+	return key;
+}
+
+PSRingAllocation PRenderQueue::AllocateDynamic(const PUi32& size, const PUi32& alignment)
+{
+	if (m_DynamicBuffer == nullptr)
+		return PSRingAllocation();
+
+	return m_DynamicBuffer->Allocate(size, alignment);
+}
+
+void PRenderQueue::Begin(const TShared<PSCamera>& camera)
+{
+	m_Camera = camera;
+	m_Packets.clear();
+	m_Order.clear();
+}
+
+void PRenderQueue::Submit(PSDrawPacket packet, const PERenderPass& pass)
+{
+	if (packet.shader == nullptr || packet.mesh == nullptr)
+		return;
+
+	// Distance along the camera's view direction, normalized against the far plane
+	float depth = 0.0f;
+	if (m_Camera)
+	{
+		const glm::vec3 toObject = glm::vec3(packet.transform[3]) - m_Camera->transform.position;
+		depth = glm::dot(toObject, m_Camera->transform.Forward()) / m_Camera->farClip;
+	}
+
+	// Material draws are grouped by the texture the table binds for them, which is the
+	// same texture array for many materials, or none at all with bindless textures
+	PUi32 textureID = 0;
+	if (packet.texture)
+		textureID = packet.texture->GetID();
+	else if (m_MaterialTable)
+		textureID = m_MaterialTable->GetBindTexture(packet.materialIndex);
+
+	packet.sortKey = MakeSortKey(
+		pass,
+		packet.shader->GetID(),
+		textureID,
+		packet.mesh->GetVAO(),
+		depth
+	);
+
+	m_Order.push_back({ packet.sortKey, static_cast<PUi32>(m_Packets.size()) });
+	m_Packets.push_back(packet);
+}
+
+void PRenderQueue::Sort()
+{
+	const size_t count = m_Order.size();
+	if (count < 2)
+		return;
+
+	m_Scratch.resize(count);
+
+	// Build the histogram of all 8 digits in one pass over the keys
+	PUi32 histograms[8][256] = {};
+	for (const PSSortEntry& entry : m_Order)
+	{
+		for (PUi32 digit = 0; digit < 8; ++digit)
+		{
+			++histograms[digit][(entry.key >> (digit * 8)) & 0xFF];
+		}
+	}
+
+	// LSD radix sort, one stable counting pass per byte
+	for (PUi32 digit = 0; digit < 8; ++digit)
+	{
+		PUi32* histogram = histograms[digit];
+		const PUi32 shift = digit * 8;
+
+		// Skip the pass if every key has the same value for this byte
+		if (histogram[(m_Order[0].key >> shift) & 0xFF] == count)
+			continue;
+
+		// Convert the counts into starting offsets
+		PUi32 offset = 0;
+		for (PUi32 bucket = 0; bucket < 256; ++bucket)
+		{
+			const PUi32 bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (const PSSortEntry& entry : m_Order)
+		{
+			m_Scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+		}
+
+		m_Order.swap(m_Scratch);
+	}
+}
+
+void PRenderQueue::Execute()
+{
+	PPROFILE_SCOPE("Draw");
+	PPROFILE_GPU_SCOPE("Draw");
+
+	PShaderProgram* currentShader = nullptr;
+	PTexture* currentTexture = nullptr;
+	PUi64 currentPass = RP_OPAQUE;
+
+	// Opaque state
+	PGLState::SetDepthWrite(true);
+	PGLState::SetBlend(false);
+
+	for (size_t i = 0; i < m_Order.size(); ++i)
+	{
+		const PSSortEntry& entry = m_Order[i];
+		const PSDrawPacket& packet = m_Packets[entry.index];
+
+		// Blend and stop writing depth once the sorted packets reach the transparent passes
+		const PUi64 pass = entry.key >> 62;
+		if (pass != currentPass)
+		{
+			currentPass = pass;
+			PGLState::SetDepthWrite(pass == RP_OPAQUE);
+			PGLState::SetBlend(pass != RP_OPAQUE);
+			PGLState::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		}
+
+		// Switch program only when it changes, the camera is uploaded once per switch
+		if (packet.shader != currentShader)
+		{
+			currentShader = packet.shader;
+			currentShader->Activate();
+			currentShader->SetWorldTransform(m_Camera);
+			currentTexture = nullptr;
+		}
+
+		// Switch texture only when it changes
+		if (packet.texture != nullptr && packet.texture != currentTexture)
+		{
+			currentTexture = packet.texture;
+			currentShader->RunTexture(*currentTexture, 0);
+		}
+
+		PMeshPool* pool = packet.mesh->GetPool();
+
+		if (pool != nullptr && packet.instanceCount == 0 && currentShader->HasDrawDataBlock())
+		{
+			// Packets without a texture read it from the material table, any material that binds
+			// the same texture can join the batch
+			const bool useMaterials = packet.texture == nullptr && m_MaterialTable != nullptr;
+			PUi32 materialTexture = 0;
+
+			if (useMaterials)
+			{
+				materialTexture = m_MaterialTable->GetBindTexture(packet.materialIndex);
+				m_MaterialTable->Bind(packet.materialIndex);
+				currentTexture = nullptr;
+			}
+
+			// Gather the run of pooled draws that share pass, program, texture and pool
+			m_Batch.clear();
+			size_t end = i;
+
+			for (; end < m_Order.size(); ++end)
+			{
+				const PSDrawPacket& next = m_Packets[m_Order[end].index];
+
+				if ((m_Order[end].key >> 62) != pass || next.shader != currentShader || next.instanceCount > 0 ||
+					next.mesh->GetPool() != pool || (next.texture != nullptr && next.texture != currentTexture))
+					break;
+
+				// Material and texture draws use different shaders, so they never share a batch
+				const bool nextUsesMaterials = next.texture == nullptr && m_MaterialTable != nullptr;
+				if (nextUsesMaterials != useMaterials ||
+					(useMaterials && m_MaterialTable->GetBindTexture(next.materialIndex) != materialTexture))
+					break;
+
+				PSMeshPoolDraw draw;
+				draw.range = next.mesh->GetPoolRange();
+				draw.data.model = next.transform;
+				draw.data.materialIndex = next.materialIndex;
+				m_Batch.push_back(draw);
+			}
+
+			pool->DrawBatch(m_Batch, m_DynamicBuffer.get());
+			i = end - 1;
+		}
+		else if (packet.instanceCount > 0)
+		{
+			if (packet.instanceBuffer != 0)
+				packet.mesh->SetInstanceBuffer(packet.instanceBuffer, packet.instanceOffset, packet.instanceCount);
+
+			packet.mesh->DrawInstanced();
+		}
+		else
+		{
+			currentShader->SetModelMatrix(packet.transform);
+			packet.mesh->Draw();
+		}
+	}
+}
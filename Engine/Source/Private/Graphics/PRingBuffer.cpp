@@ -0,0 +1,175 @@
+// Internal headers
+#include "Graphics/PRingBuffer.h"
+#include "Graphics/PGLState.h"
+#include "Debug/PMemoryTracker.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <chrono>
+
+PRingBuffer::PRingBuffer()
+{
+	m_ID = 0;
+	m_MappedData = nullptr;
+	m_FrameSize = m_FrameIndex = m_FrameOffset = 0;
+	m_UniformAlignment = m_StorageAlignment = 256;
+	m_MemoryHandle = 0;
+}
+
+PRingBuffer::~PRingBuffer()
+{
+	for (GLsync& fence : m_Fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+	}
+
+	if (m_ID > 0)
+	{
+		if (m_MappedData)
+			glUnmapNamedBuffer(m_ID);
+
+		PGLState::OnBufferDeleted(m_ID);
+		glDeleteBuffers(1, &m_ID);
+	}
+
+	PMemoryTracker::Unregister(m_MemoryHandle);
+}
+
+bool PRingBuffer::Init(const PUi32& frameSize, const PUi32& framesInFlight)
+{
+	if (frameSize == 0 || framesInFlight == 0)
+	{
+		PDebug::Log("Failed to create ring buffer: size and frame count must be above 0", LT_ERROR);
+		return false;
+	}
+
+	// Query the offset alignments so blocks can be bound as uniform or storage buffers
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+		m_UniformAlignment = static_cast<PUi32>(alignment);
+
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+		m_StorageAlignment = static_cast<PUi32>(alignment);
+
+	// Round the region size so every region starts aligned
+	const PUi32 regionAlignment = m_UniformAlignment > m_StorageAlignment ? m_UniformAlignment : m_StorageAlignment;
+	m_FrameSize = (frameSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+	const GLsizeiptr totalSize = static_cast<GLsizeiptr>(m_FrameSize) * framesInFlight;
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	// Create immutable storage that stays mapped for the lifetime of the buffer
+	glCreateBuffers(1, &m_ID);
+	if (m_ID == 0)
+	{
+		PString errorMsg = reinterpret_cast<const char*>(glewGetErrorString(glGetError()));
+		PDebug::Log("Failed to create ring buffer: " + errorMsg, LT_ERROR);
+		return false;
+	}
+
+	glNamedBufferStorage(m_ID, totalSize, nullptr, flags);
+	m_MappedData = static_cast<PUi8*>(glMapNamedBufferRange(m_ID, 0, totalSize, flags));
+
+	if (m_MappedData == nullptr)
+	{
+		PDebug::Log("Failed to persistently map ring buffer", LT_ERROR);
+
+		// Nothing was mapped, so the destructor must not unmap the buffer
+		glDeleteBuffers(1, &m_ID);
+		m_ID = 0;
+		return false;
+	}
+
+	m_Fences.assign(framesInFlight, nullptr);
+	m_FrameIndex = 0;
+	m_FrameOffset = 0;
+
+	// The mapping is the buffer itself, so only the GPU storage is counted
+	if (m_MemoryHandle == 0)
+		m_MemoryHandle = PMemoryTracker::Register(RT_BUFFER, "Ring buffer");
+	PMemoryTracker::Update(m_MemoryHandle, 0, static_cast<PUi64>(totalSize));
+
+	PDebug::Log("Ring buffer created: " + std::to_string(framesInFlight) + " frames of " +
+		std::to_string(m_FrameSize) + " bytes");
+
+	return true;
+}
+
+void PRingBuffer::BeginFrame()
+{
+	if (m_Fences.empty())
+		return;
+
+	m_FrameIndex = (m_FrameIndex + 1) % static_cast<PUi32>(m_Fences.size());
+	m_FrameOffset = 0;
+	m_Stats.frameBytes = 0;
+
+	GLsync& fence = m_Fences[m_FrameIndex];
+	if (fence == nullptr)
+		return;
+
+	// Check without waiting first, a signaled fence is the common case
+	GLenum result = glClientWaitSync(fence, 0, 0);
+
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		// The GPU is still reading this region, count the stall and wait for it
+		++m_Stats.stalls;
+		const auto waitStart = std::chrono::high_resolution_clock::now();
+
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+
+		const auto waitTime = std::chrono::high_resolution_clock::now() - waitStart;
+		m_Stats.stallMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(waitTime).count();
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+PSRingAllocation PRingBuffer::Allocate(const PUi32& size, const PUi32& alignment)
+{
+	PSRingAllocation allocation;
+
+	if (m_MappedData == nullptr || size == 0)
+		return allocation;
+
+	const PUi32 alignedOffset = alignment > 1
+		? (m_FrameOffset + alignment - 1) / alignment * alignment
+		: m_FrameOffset;
+
+	if (alignedOffset + size > m_FrameSize)
+	{
+		++m_Stats.failedAllocations;
+		return allocation;
+	}
+
+	m_FrameOffset = alignedOffset + size;
+	m_Stats.frameBytes = m_FrameOffset;
+	if (m_Stats.frameBytes > m_Stats.peakFrameBytes)
+		m_Stats.peakFrameBytes = m_Stats.frameBytes;
+
+	allocation.buffer = m_ID;
+	allocation.offset = m_FrameIndex * m_FrameSize + alignedOffset;
+	allocation.size = size;
+	allocation.data = m_MappedData + allocation.offset;
+
+	return allocation;
+}
+
+void PRingBuffer::EndFrame()
+{
+	if (m_Fences.empty() || m_FrameOffset == 0)
+		return;
+
+	// The region is free again once every command issued so far has completed
+	m_Fences[m_FrameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,199 @@
+// Internal headers
+#include "Graphics/PShaderCache.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+
+// Identifies an entry file, "PSHC" in little endian
+#define LCACHE_MAGIC 0x43485350U
+
+// Bumped whenever the entry layout changes
+#define LCACHE_VERSION 1U
+
+// Header written in front of every cached binary
+struct PSShaderCacheHeader
+{
+	PUi32 magic = LCACHE_MAGIC;
+	PUi32 version = LCACHE_VERSION;
+	PUi64 key = 0;          // Key the entry was saved for, guards against renamed files
+	PUi32 binaryFormat = 0; // Driver specific format returned by glGetProgramBinary
+	PUi32 binarySize = 0;   // Bytes of binary following the header
+	PUi64 checksum = 0;     // Hash of the binary, catches truncated or damaged files
+};
+
+bool PShaderCache::s_Enabled = true;
+PSShaderCacheStats PShaderCache::s_Stats;
+
+// Hash bytes with 64-bit FNV-1a, continuing from a previous hash
+static PUi64 HashBytes(const void* data, const size_t& size, PUi64 hash = 14695981039346656037ULL)
+{
+	const PUi8* bytes = static_cast<const PUi8*>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+// Hash a string including its terminator, so "ab" + "c" and "a" + "bc" differ
+static PUi64 HashString(const PString& string, const PUi64& hash)
+{
+	return HashBytes(string.c_str(), string.size() + 1, hash);
+}
+
+// Read a GL string, empty if the driver doesn't report it
+static PString GetGLString(const GLenum& name)
+{
+	const GLubyte* value = glGetString(name);
+	return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+bool PShaderCache::IsSupported()
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+	return formatCount > 0;
+}
+
+PUi64 PShaderCache::MakeKey(const PString& vertexSource, const PString& fragmentSource)
+{
+	// Binaries are only valid for the driver that produced them
+	static const PString driver = GetGLString(GL_VENDOR) + "|" + GetGLString(GL_RENDERER) + "|" + GetGLString(GL_VERSION);
+
+	PUi64 hash = HashString(driver, 14695981039346656037ULL);
+	hash = HashString(vertexSource, hash);
+	hash = HashString(fragmentSource, hash);
+
+	return hash;
+}
+
+bool PShaderCache::Load(const PUi32& program, const PUi64& key)
+{
+	if (!s_Enabled)
+		return false;
+
+	std::ifstream file(GetEntryPath(key), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	PSShaderCacheHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	// Anything wrong with the entry falls back to compiling, the next save replaces it
+	if (!file || header.magic != LCACHE_MAGIC || header.version != LCACHE_VERSION || header.key != key ||
+		header.binarySize == 0)
+	{
+		PDebug::Log("Shader cache entry is invalid, compiling from source", LT_WARN);
+		++s_Stats.rejected;
+		return false;
+	}
+
+	TArray<PUi8> binary(header.binarySize);
+	file.read(reinterpret_cast<char*>(binary.data()), header.binarySize);
+
+	if (!file || HashBytes(binary.data(), binary.size()) != header.checksum)
+	{
+		PDebug::Log("Shader cache entry is corrupt, compiling from source", LT_WARN);
+		++s_Stats.rejected;
+		return false;
+	}
+
+	glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+	// Drivers refuse binaries from other versions even when the strings match, which only shows in the link status
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+	if (!success)
+	{
+		PDebug::Log("Shader cache entry was rejected by the driver, compiling from source", LT_WARN);
+		++s_Stats.rejected;
+		return false;
+	}
+
+	++s_Stats.hits;
+
+	return true;
+}
+
+bool PShaderCache::Save(const PUi32& program, const PUi64& key)
+{
+	if (!s_Enabled)
+		return false;
+
+	GLint binarySize = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+
+	if (binarySize <= 0)
+		return false;
+
+	PSShaderCacheHeader header;
+	header.key = key;
+
+	TArray<PUi8> binary(static_cast<size_t>(binarySize));
+	GLenum binaryFormat = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, binarySize, &written, &binaryFormat, binary.data());
+
+	if (written <= 0)
+		return false;
+
+	binary.resize(static_cast<size_t>(written));
+	header.binaryFormat = binaryFormat;
+	header.binarySize = static_cast<PUi32>(written);
+	header.checksum = HashBytes(binary.data(), binary.size());
+
+	std::error_code error;
+	std::filesystem::create_directories(PSHADER_CACHE_DIRECTORY, error);
+
+	// Write next to the entry and rename it into place, so a crash never leaves half an entry
+	const PString path = GetEntryPath(key);
+	const PString tempPath = path + ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			PDebug::Log("Failed to write shader cache entry: " + tempPath, LT_WARN);
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+
+		if (!file)
+		{
+			PDebug::Log("Failed to write shader cache entry: " + tempPath, LT_WARN);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		PDebug::Log("Failed to write shader cache entry: " + path, LT_WARN);
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	++s_Stats.saved;
+
+	return true;
+}
+
+PString PShaderCache::GetEntryPath(const PUi64& key)
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+	return PString(PSHADER_CACHE_DIRECTORY) + "/" + name + ".bin";
+}
@@ -4,14 +4,18 @@
 #include "Math/PSTransform.h"
 #include "Graphics/PTexture.h"
 #include "Graphics/PSCamera.h"
+#include "Graphics/PGLState.h"
+#include "Graphics/PRingBuffer.h"
+#include "Graphics/PShaderCache.h"
+#include "Debug/PProfiler.h"
+#include "Core/PFileSystem.h"
 
 // External libraries
 #include <GLEW/glew.h>
 #include <GLM/gtc/type_ptr.hpp>
 
 // System libraries
-#include <fstream>
-#include <sstream>
+#include <cstring>
 
 // Macro for getting GLEW error string
 #define LGET_GLEW_ERROR reinterpret_cast<const char*>(glewGetErrorString(glGetError()));
@@ -19,112 +23,139 @@
 PShaderProgram::PShaderProgram()
 {
 	m_ProgramID = 0;
+	m_PendingProgram = 0;
+	m_PendingLinked = false;
+	m_PendingCacheKey = 0;
+	m_HasDrawDataBlock = false;
 }
 
 PShaderProgram::~PShaderProgram()
 {
+	CancelReload();
+
 	PDebug::Log("Shader program " + std::to_string(m_ProgramID) + " destroyed");
 }
 
-bool PShaderProgram::InitShader(const PString& vShaderPath, const PString& fShaderPath)
+bool PShaderProgram::InitShader(const PString& vSourcePath, const PString& fSourcePath)
 {
-	// Create the shader program
-	m_ProgramID = glCreateProgram();
+	PPROFILE_SCOPE("Shader Init");
 
-	if (m_ProgramID == 0)
+	// The sources are kept so hot reload watches the files that are edited, the cooker's validated copies
+	// are read in their place until a source is saved after it was cooked
+	m_FilePath[ST_VERTEX] = vSourcePath;
+	m_FilePath[ST_FRAGMENT] = fSourcePath;
+
+	// Convert the shader files to strings
+	const PString vShaderStr = ConvertFileToString(PFileSystem::Get().ResolveCooked(vSourcePath));
+	const PString fShaderStr = ConvertFileToString(PFileSystem::Get().ResolveCooked(fSourcePath));
+
+	if (vShaderStr.empty() || fShaderStr.empty())
 	{
-		const std::string errorMessage = LGET_GLEW_ERROR;
-		PDebug::Log("Failed to initialize shader, couldn't create program: " + errorMessage);
+		PDebug::Log("Failed to initialize shader program, couldn't import shaders");
 		return false;
 	}
 
+	if (!CreateProgram())
+		return false;
+
+	// Skip compiling when the driver already produced a binary for these sources
+	const bool useCache = PShaderCache::IsSupported();
+	const PUi64 cacheKey = useCache ? PShaderCache::MakeKey(vShaderStr, fShaderStr) : 0;
+
+	if (useCache)
+	{
+		if (PShaderCache::Load(m_ProgramID, cacheKey))
+		{
+			ReflectProgram();
+			PDebug::Log("Shader loaded from cache with ID: " + std::to_string(m_ProgramID));
+			return true;
+		}
+
+		// A refused binary can leave the program in a failed state, start again from a clean one
+		PGLState::OnProgramDeleted(m_ProgramID);
+		glDeleteProgram(m_ProgramID);
+
+		if (!CreateProgram())
+			return false;
+
+		PShaderCache::RecordMiss();
+	}
+
 	// Import and compile vertex and fragment shaders
-	if (!ImportShaderByType(vShaderPath, ST_VERTEX) || !ImportShaderByType(fShaderPath, ST_FRAGMENT))
+	if (!ImportShaderByType(vShaderStr, ST_VERTEX) || !ImportShaderByType(fShaderStr, ST_FRAGMENT))
 	{
 		PDebug::Log("Failed to initialize shader program, couldn't import shaders");
 		return false;
 	}
 
-	return LinkToGPU();
+	// Binaries can only be read back from programs linked with the hint set
+	if (useCache)
+		glProgramParameteri(m_ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	if (!LinkToGPU())
+		return false;
+
+	if (useCache)
+		PShaderCache::Save(m_ProgramID, cacheKey);
+
+	return true;
 }
 
 void PShaderProgram::Activate()
 {
-	glUseProgram(m_ProgramID);
+	PPROFILE_SCOPE("Shader Activate");
+
+	PGLState::UseProgram(m_ProgramID);
 }
 
 void PShaderProgram::SetModelTransform(const PSTransform& transform)
 {
-	// Initialize a default matrix transform
-	glm::mat4 matrixT = glm::mat4(1.0f);
-
-	// Apply transformations: translate, rotate, then scale
-	matrixT = glm::translate(matrixT, transform.position);
-	matrixT = glm::rotate(matrixT, glm::radians(transform.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-	matrixT = glm::rotate(matrixT, glm::radians(transform.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-	matrixT = glm::rotate(matrixT, glm::radians(transform.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-	matrixT = glm::scale(matrixT, transform.scale);
-
-	// Get the location of the "model" uniform variable in the shader
-	const int varID = glGetUniformLocation(m_ProgramID, "model");
+	// Build the model matrix from the transform
+	const glm::mat4 matrixT = transform.GetMatrix();
 
 	// Update the "model" uniform with the transformation matrix
-	glUniformMatrix4fv(varID, 1, GL_FALSE, glm::value_ptr(matrixT));
+	SetUniform(m_ModelUniform, matrixT);
+}
+
+void PShaderProgram::SetModelMatrix(const glm::mat4& matrix)
+{
+	SetUniform(m_ModelUniform, matrix);
 }
 
 void PShaderProgram::SetWorldTransform(const TShared<PSCamera>& camera)
 {
 	// Initialize view matrix
-	glm::mat4 viewMatrix = glm::lookAt(
-		camera->transform.position,
-		camera->transform.position + camera->transform.Forward(),
-		camera->transform.Up()
-	);
+	const glm::mat4 viewMatrix = camera->GetViewMatrix();
 
-	// Get the location of the "view" uniform variable in the shader and update it
-	int viewVarID = glGetUniformLocation(m_ProgramID, "view");
-	glUniformMatrix4fv(viewVarID, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+	// Update the "view" uniform
+	SetUniform(m_ViewUniform, viewMatrix);
 
 	// Initialize projection matrix
-	glm::mat4 projectionMatrix = glm::perspective(
-		glm::radians(camera->fov),
-		camera->aspectRatio,
-		camera->nearClip,
-		camera->farClip
-	);
+	const glm::mat4 projectionMatrix = camera->GetProjectionMatrix();
 
-	// Get the location of the "projection" uniform variable in the shader and update it
-	int projectionVarID = glGetUniformLocation(m_ProgramID, "projection");
-	glUniformMatrix4fv(projectionVarID, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+	// Update the "projection" uniform
+	SetUniform(m_ProjectionUniform, projectionMatrix);
 }
 
 void PShaderProgram::RunTexture(const TShared<PTexture>& texture, const PUi32& slot)
+{
+	RunTexture(*texture, slot);
+}
+
+void PShaderProgram::RunTexture(PTexture& texture, const PUi32& slot)
 {
 	// Bind the texture
-	texture->BindTexture(slot);
+	texture.BindTexture(slot);
 
-	// Get the uniform variable location for the texture slot
-	int varID = 0;
+	// Update the shader with the texture slot
 	if (slot == 0)
 	{
-		varID = glGetUniformLocation(m_ProgramID, "colourMap");
+		SetUniform(m_ColourMapUniform, slot);
 	}
-
-	// Update the shader with the texture slot
-	glUniform1i(varID, slot);
 }
 
-bool PShaderProgram::ImportShaderByType(const PString& filePath, PEShaderType shaderType)
+bool PShaderProgram::ImportShaderByType(const PString& shaderStr, PEShaderType shaderType)
 {
-	// Convert the shader file to a string
-	const PString shaderStr = ConvertFileToString(filePath);
-
-	if (shaderStr.empty())
-	{
-		PDebug::Log("Failed to import shader", LT_ERROR);
-		return false;
-	}
-
 	// Create the shader based on its type
 	switch (shaderType)
 	{
@@ -170,21 +201,30 @@ bool PShaderProgram::ImportShaderByType(const PString& filePath, PEShaderType sh
 
 PString PShaderProgram::ConvertFileToString(const PString& filePath)
 {
-	// Open the file
-	std::ifstream shaderSource(filePath);
+	// Read the file from disk or a mounted pack
+	PString shaderSource;
 
-	if (!shaderSource.is_open())
+	if (!PFileSystem::Get().ReadText(filePath, shaderSource))
 	{
 		PDebug::Log("Failed to open file: " + filePath, LT_ERROR);
 		return "";
 	}
 
-	// Convert the file contents to a string
-	std::stringstream shaderStream;
-	shaderStream << shaderSource.rdbuf();
-	shaderSource.close();
+	return shaderSource;
+}
 
-	return shaderStream.str();
+bool PShaderProgram::CreateProgram()
+{
+	m_ProgramID = glCreateProgram();
+
+	if (m_ProgramID == 0)
+	{
+		const std::string errorMessage = LGET_GLEW_ERROR;
+		PDebug::Log("Failed to initialize shader, couldn't create program: " + errorMessage);
+		return false;
+	}
+
+	return true;
 }
 
 bool PShaderProgram::LinkToGPU()
@@ -199,12 +239,522 @@ bool PShaderProgram::LinkToGPU()
 	if (!success)
 	{
 		char infoLog[512];
-		glGetShaderInfoLog(m_ProgramID, 512, nullptr, infoLog);
+		glGetProgramInfoLog(m_ProgramID, 512, nullptr, infoLog);
 		PDebug::Log("Shader link error: " + PString(infoLog), LT_ERROR);
 		return false;
 	}
 
+	// Build the uniform tables and resolve the built-in handles once
+	ReflectProgram();
+
 	PDebug::Log("Shader successfully initialized and linked with ID: " + std::to_string(m_ProgramID));
 
 	return true;
 }
+
+void PShaderProgram::SetUniform(const PUniformInt& handle, const int& value)
+{
+	if (handle.IsValid() && UpdateShadow(handle.index, &value, sizeof(value)))
+		glProgramUniform1i(m_ProgramID, m_Uniforms[handle.index].location, value);
+}
+
+void PShaderProgram::SetUniform(const PUniformFloat& handle, const float& value)
+{
+	if (handle.IsValid() && UpdateShadow(handle.index, &value, sizeof(value)))
+		glProgramUniform1f(m_ProgramID, m_Uniforms[handle.index].location, value);
+}
+
+void PShaderProgram::SetUniform(const PUniformVec2& handle, const glm::vec2& value)
+{
+	if (handle.IsValid() && UpdateShadow(handle.index, &value, sizeof(value)))
+		glProgramUniform2fv(m_ProgramID, m_Uniforms[handle.index].location, 1, glm::value_ptr(value));
+}
+
+void PShaderProgram::SetUniform(const PUniformVec3& handle, const glm::vec3& value)
+{
+	if (handle.IsValid() && UpdateShadow(handle.index, &value, sizeof(value)))
+		glProgramUniform3fv(m_ProgramID, m_Uniforms[handle.index].location, 1, glm::value_ptr(value));
+}
+
+void PShaderProgram::SetUniform(const PUniformVec4& handle, const glm::vec4& value)
+{
+	if (handle.IsValid() && UpdateShadow(handle.index, &value, sizeof(value)))
+		glProgramUniform4fv(m_ProgramID, m_Uniforms[handle.index].location, 1, glm::value_ptr(value));
+}
+
+void PShaderProgram::SetUniform(const PUniformMat4& handle, const glm::mat4& value)
+{
+	if (handle.IsValid() && UpdateShadow(handle.index, &value, sizeof(value)))
+		glProgramUniformMatrix4fv(m_ProgramID, m_Uniforms[handle.index].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void PShaderProgram::SetUniform(const PUniformSampler& handle, const PUi32& slot)
+{
+	const int value = static_cast<int>(slot);
+
+	if (handle.IsValid() && UpdateShadow(handle.index, &value, sizeof(value)))
+		glProgramUniform1i(m_ProgramID, m_Uniforms[handle.index].location, value);
+}
+
+int PShaderProgram::FindUniformBlock(const PString& name) const
+{
+	for (size_t i = 0; i < m_UniformBlocks.size(); ++i)
+	{
+		if (m_UniformBlocks[i].name == name)
+			return static_cast<int>(i);
+	}
+
+	return -1;
+}
+
+void PShaderProgram::SetUniformBlockBinding(const int& blockIndex, const PUi32& binding)
+{
+	if (blockIndex < 0 || blockIndex >= static_cast<int>(m_UniformBlocks.size()))
+		return;
+
+	PSShaderUniformBlock& block = m_UniformBlocks[blockIndex];
+
+	if (block.binding == binding)
+		return;
+
+	glUniformBlockBinding(m_ProgramID, block.index, binding);
+	block.binding = binding;
+}
+
+void PShaderProgram::BindUniformBlock(const int& blockIndex, const PSRingAllocation& allocation)
+{
+	if (blockIndex < 0 || blockIndex >= static_cast<int>(m_UniformBlocks.size()) || !allocation.IsValid())
+		return;
+
+	PGLState::BindBufferRange(GL_UNIFORM_BUFFER, m_UniformBlocks[blockIndex].binding,
+		allocation.buffer, allocation.offset, allocation.size);
+}
+
+// Convert an OpenGL uniform type into a handle type
+static PEUniformType ConvertUniformType(const GLenum& glType)
+{
+	switch (glType)
+	{
+	case GL_INT:
+	case GL_BOOL:
+		return UT_INT;
+	case GL_FLOAT:
+		return UT_FLOAT;
+	case GL_FLOAT_VEC2:
+		return UT_VEC2;
+	case GL_FLOAT_VEC3:
+		return UT_VEC3;
+	case GL_FLOAT_VEC4:
+		return UT_VEC4;
+	case GL_FLOAT_MAT4:
+		return UT_MAT4;
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_2D_ARRAY_SHADOW:
+	case GL_SAMPLER_CUBE_SHADOW:
+	case GL_SAMPLER_BUFFER:
+	case GL_INT_SAMPLER_2D:
+	case GL_UNSIGNED_INT_SAMPLER_2D:
+		return UT_SAMPLER;
+	default:
+		return UT_UNKNOWN;
+	}
+}
+
+void PShaderProgram::ReflectProgram()
+{
+	m_Uniforms.clear();
+	m_UniformBlocks.clear();
+	m_StorageBlocks.clear();
+
+	// Uniforms
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramInterfaceiv(m_ProgramID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+	glGetProgramInterfaceiv(m_ProgramID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	TArray<char> nameBuffer(static_cast<size_t>(maxNameLength) + 1, '\0');
+	const GLenum uniformProps[] = { GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+
+	for (GLint i = 0; i < uniformCount; ++i)
+	{
+		GLint values[4] = { 0, -1, 1, -1 };
+		glGetProgramResourceiv(m_ProgramID, GL_UNIFORM, i, 4, uniformProps, 4, nullptr, values);
+
+		// Uniforms inside blocks are set through buffers, not locations
+		if (values[3] != -1 || values[1] < 0)
+			continue;
+
+		glGetProgramResourceName(m_ProgramID, GL_UNIFORM, i, maxNameLength + 1, nullptr, nameBuffer.data());
+
+		PSShaderUniform uniform;
+		uniform.name = nameBuffer.data();
+		uniform.glType = static_cast<PUi32>(values[0]);
+		uniform.type = ConvertUniformType(uniform.glType);
+		uniform.location = values[1];
+		uniform.arraySize = values[2];
+
+		// Arrays are reported as "name[0]", store the plain name
+		const size_t bracket = uniform.name.find('[');
+		if (bracket != PString::npos)
+			uniform.name.resize(bracket);
+
+		m_Uniforms.push_back(uniform);
+	}
+
+	// Uniform blocks
+	GLint blockCount = 0;
+	maxNameLength = 0;
+	glGetProgramInterfaceiv(m_ProgramID, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+	glGetProgramInterfaceiv(m_ProgramID, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	nameBuffer.assign(static_cast<size_t>(maxNameLength) + 1, '\0');
+	const GLenum blockProps[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+
+	for (GLint i = 0; i < blockCount; ++i)
+	{
+		GLint values[2] = { 0, 0 };
+		glGetProgramResourceiv(m_ProgramID, GL_UNIFORM_BLOCK, i, 2, blockProps, 2, nullptr, values);
+		glGetProgramResourceName(m_ProgramID, GL_UNIFORM_BLOCK, i, maxNameLength + 1, nullptr, nameBuffer.data());
+
+		PSShaderUniformBlock block;
+		block.name = nameBuffer.data();
+		block.index = static_cast<PUi32>(i);
+		block.binding = static_cast<PUi32>(values[0]);
+		block.dataSize = values[1];
+
+		m_UniformBlocks.push_back(block);
+	}
+
+	// Shader storage blocks
+	blockCount = 0;
+	maxNameLength = 0;
+	glGetProgramInterfaceiv(m_ProgramID, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+	glGetProgramInterfaceiv(m_ProgramID, GL_SHADER_STORAGE_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	nameBuffer.assign(static_cast<size_t>(maxNameLength) + 1, '\0');
+	m_HasDrawDataBlock = false;
+
+	for (GLint i = 0; i < blockCount; ++i)
+	{
+		GLint values[2] = { 0, 0 };
+		glGetProgramResourceiv(m_ProgramID, GL_SHADER_STORAGE_BLOCK, i, 2, blockProps, 2, nullptr, values);
+		glGetProgramResourceName(m_ProgramID, GL_SHADER_STORAGE_BLOCK, i, maxNameLength + 1, nullptr, nameBuffer.data());
+
+		PSShaderUniformBlock block;
+		block.name = nameBuffer.data();
+		block.index = static_cast<PUi32>(i);
+		block.binding = static_cast<PUi32>(values[0]);
+		block.dataSize = values[1];
+
+		if (block.name == "PerDrawData")
+			m_HasDrawDataBlock = true;
+
+		m_StorageBlocks.push_back(block);
+	}
+
+	ResolveBuiltInUniforms();
+
+	PDebug::Log("Shader " + std::to_string(m_ProgramID) + " reflected " + std::to_string(m_Uniforms.size()) +
+		" uniforms, " + std::to_string(m_UniformBlocks.size()) + " uniform blocks and " +
+		std::to_string(m_StorageBlocks.size()) + " storage blocks");
+}
+
+void PShaderProgram::ResolveBuiltInUniforms()
+{
+	// Missing uniforms stay invalid and are skipped
+	m_ModelUniform = GetUniform<UT_MAT4>("model");
+	m_ViewUniform = GetUniform<UT_MAT4>("view");
+	m_ProjectionUniform = GetUniform<UT_MAT4>("projection");
+	m_ColourMapUniform = GetUniform<UT_SAMPLER>("colourMap");
+}
+
+int PShaderProgram::FindUniform(const PString& name, const PEUniformType& type) const
+{
+	for (size_t i = 0; i < m_Uniforms.size(); ++i)
+	{
+		// Uniforms a reload removed keep their slot for old handles but can't be found again
+		if (m_Uniforms[i].name != name || m_Uniforms[i].location < 0)
+			continue;
+
+		if (m_Uniforms[i].type != type)
+		{
+			PDebug::Log("Uniform " + name + " requested with the wrong type", LT_WARN);
+			return -1;
+		}
+
+		return static_cast<int>(i);
+	}
+
+	return -1;
+}
+
+bool PShaderProgram::UpdateShadow(const int& index, const void* data, const size_t& size)
+{
+	PSShaderUniform& uniform = m_Uniforms[index];
+
+	// Skip the upload if the program already holds this value
+	if (uniform.hasValue && std::memcmp(uniform.value, data, size) == 0)
+		return false;
+
+	std::memcpy(uniform.value, data, size);
+	uniform.hasValue = true;
+
+	return true;
+}
+
+// Check if the driver compiles and links on its own threads, so status can be polled without blocking
+static bool HasParallelCompile()
+{
+	return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+// Create a shader object and start compiling it, the status is checked later
+static PUi32 StartCompile(const PString& shaderStr, const PEShaderType& shaderType)
+{
+	const PUi32 shaderID = glCreateShader(shaderType == ST_VERTEX ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
+	if (shaderID == 0)
+		return 0;
+
+	const char* shaderCStr = shaderStr.c_str();
+	glShaderSource(shaderID, 1, &shaderCStr, nullptr);
+	glCompileShader(shaderID);
+
+	return shaderID;
+}
+
+bool PShaderProgram::BeginReload()
+{
+	if (IsReloading() || m_FilePath[ST_VERTEX].empty() || m_FilePath[ST_FRAGMENT].empty())
+		return false;
+
+	// An edited source is newer than its cooked copy, so it's the file that's read
+	const PString vShaderStr = ConvertFileToString(PFileSystem::Get().ResolveCooked(m_FilePath[ST_VERTEX]));
+	const PString fShaderStr = ConvertFileToString(PFileSystem::Get().ResolveCooked(m_FilePath[ST_FRAGMENT]));
+
+	// Editors can save an empty file for a moment before writing it
+	if (vShaderStr.empty() || fShaderStr.empty())
+		return false;
+
+	m_PendingProgram = glCreateProgram();
+	if (m_PendingProgram == 0)
+		return false;
+
+	m_PendingShaderIDs[ST_VERTEX] = StartCompile(vShaderStr, ST_VERTEX);
+	m_PendingShaderIDs[ST_FRAGMENT] = StartCompile(fShaderStr, ST_FRAGMENT);
+	m_PendingLinked = false;
+	m_PendingCacheKey = PShaderCache::IsSupported() ? PShaderCache::MakeKey(vShaderStr, fShaderStr) : 0;
+
+	if (m_PendingShaderIDs[ST_VERTEX] == 0 || m_PendingShaderIDs[ST_FRAGMENT] == 0)
+	{
+		CancelReload();
+		return false;
+	}
+
+	return true;
+}
+
+PEShaderReloadState PShaderProgram::UpdateReload()
+{
+	if (!IsReloading())
+		return RS_IDLE;
+
+	const bool parallel = HasParallelCompile();
+
+	if (!m_PendingLinked)
+	{
+		// Come back next frame while the driver is still compiling
+		for (const PUi32& shaderID : m_PendingShaderIDs)
+		{
+			GLint complete = GL_TRUE;
+			if (parallel)
+				glGetShaderiv(shaderID, GL_COMPLETION_STATUS_KHR, &complete);
+
+			if (!complete)
+				return RS_PENDING;
+		}
+
+		for (const PUi32& shaderID : m_PendingShaderIDs)
+		{
+			GLint success = GL_FALSE;
+			glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+
+			if (!success)
+			{
+				char infoLog[512];
+				glGetShaderInfoLog(shaderID, 512, nullptr, infoLog);
+				PDebug::Log("Shader reload compilation error: " + PString(infoLog), LT_ERROR);
+				CancelReload();
+				return RS_FAILED;
+			}
+		}
+
+		glAttachShader(m_PendingProgram, m_PendingShaderIDs[ST_VERTEX]);
+		glAttachShader(m_PendingProgram, m_PendingShaderIDs[ST_FRAGMENT]);
+
+		if (m_PendingCacheKey != 0)
+			glProgramParameteri(m_PendingProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		glLinkProgram(m_PendingProgram);
+		m_PendingLinked = true;
+
+		return RS_PENDING;
+	}
+
+	GLint complete = GL_TRUE;
+	if (parallel)
+		glGetProgramiv(m_PendingProgram, GL_COMPLETION_STATUS_KHR, &complete);
+
+	if (!complete)
+		return RS_PENDING;
+
+	GLint success = GL_FALSE;
+	glGetProgramiv(m_PendingProgram, GL_LINK_STATUS, &success);
+
+	if (!success)
+	{
+		char infoLog[512];
+		glGetProgramInfoLog(m_PendingProgram, 512, nullptr, infoLog);
+		PDebug::Log("Shader reload link error: " + PString(infoLog), LT_ERROR);
+		CancelReload();
+		return RS_FAILED;
+	}
+
+	SwapProgram();
+
+	return RS_SWAPPED;
+}
+
+void PShaderProgram::SwapProgram()
+{
+	const PUi32 oldProgram = m_ProgramID;
+	const PUi32 oldShaderIDs[2] = { m_ShaderIDs[ST_VERTEX], m_ShaderIDs[ST_FRAGMENT] };
+	TArray<PSShaderUniform> oldUniforms = std::move(m_Uniforms);
+	const TArray<PSShaderUniformBlock> oldBlocks = std::move(m_UniformBlocks);
+
+	m_ProgramID = m_PendingProgram;
+	m_ShaderIDs[ST_VERTEX] = m_PendingShaderIDs[ST_VERTEX];
+	m_ShaderIDs[ST_FRAGMENT] = m_PendingShaderIDs[ST_FRAGMENT];
+	m_PendingProgram = m_PendingShaderIDs[ST_VERTEX] = m_PendingShaderIDs[ST_FRAGMENT] = 0;
+
+	ReflectProgram();
+
+	// Handles are indices into the uniform table, so existing uniforms keep their index
+	// Removed uniforms stay behind without a location, so setting them does nothing
+	TArray<PSShaderUniform> reflected = std::move(m_Uniforms);
+	TArray<bool> matched(reflected.size(), false);
+
+	for (PSShaderUniform& uniform : oldUniforms)
+	{
+		uniform.location = -1;
+
+		for (size_t i = 0; i < reflected.size(); ++i)
+		{
+			if (matched[i] || reflected[i].name != uniform.name || reflected[i].type != uniform.type)
+				continue;
+
+			uniform.location = reflected[i].location;
+			uniform.glType = reflected[i].glType;
+			uniform.arraySize = reflected[i].arraySize;
+			matched[i] = true;
+			break;
+		}
+	}
+
+	m_Uniforms = std::move(oldUniforms);
+	for (size_t i = 0; i < reflected.size(); ++i)
+	{
+		if (!matched[i])
+			m_Uniforms.push_back(reflected[i]);
+	}
+
+	ResolveBuiltInUniforms();
+
+	// The new program starts with default values, give it the ones users last set
+	for (size_t i = 0; i < m_Uniforms.size(); ++i)
+	{
+		if (m_Uniforms[i].hasValue && m_Uniforms[i].location >= 0)
+			UploadShadow(static_cast<int>(i));
+	}
+
+	// Keep the binding points assigned to the old program's blocks
+	for (PSShaderUniformBlock& block : m_UniformBlocks)
+	{
+		for (const PSShaderUniformBlock& oldBlock : oldBlocks)
+		{
+			if (oldBlock.name == block.name && oldBlock.binding != block.binding)
+			{
+				glUniformBlockBinding(m_ProgramID, block.index, oldBlock.binding);
+				block.binding = oldBlock.binding;
+			}
+		}
+	}
+
+	if (m_PendingCacheKey != 0)
+		PShaderCache::Save(m_ProgramID, m_PendingCacheKey);
+
+	PGLState::OnProgramDeleted(oldProgram);
+	glDeleteProgram(oldProgram);
+
+	for (const PUi32& shaderID : oldShaderIDs)
+	{
+		if (shaderID != 0)
+			glDeleteShader(shaderID);
+	}
+
+	PDebug::Log("Shader reloaded, program " + std::to_string(oldProgram) + " replaced by " + std::to_string(m_ProgramID),
+		LT_SUCCESS);
+}
+
+void PShaderProgram::CancelReload()
+{
+	for (PUi32& shaderID : m_PendingShaderIDs)
+	{
+		if (shaderID != 0)
+			glDeleteShader(shaderID);
+
+		shaderID = 0;
+	}
+
+	if (m_PendingProgram != 0)
+		glDeleteProgram(m_PendingProgram);
+
+	m_PendingProgram = 0;
+	m_PendingLinked = false;
+}
+
+void PShaderProgram::UploadShadow(const int& index)
+{
+	const PSShaderUniform& uniform = m_Uniforms[index];
+	const float* floats = reinterpret_cast<const float*>(uniform.value);
+	const int* ints = reinterpret_cast<const int*>(uniform.value);
+
+	switch (uniform.type)
+	{
+	case UT_INT:
+	case UT_SAMPLER:
+		glProgramUniform1i(m_ProgramID, uniform.location, ints[0]);
+		break;
+	case UT_FLOAT:
+		glProgramUniform1f(m_ProgramID, uniform.location, floats[0]);
+		break;
+	case UT_VEC2:
+		glProgramUniform2fv(m_ProgramID, uniform.location, 1, floats);
+		break;
+	case UT_VEC3:
+		glProgramUniform3fv(m_ProgramID, uniform.location, 1, floats);
+		break;
+	case UT_VEC4:
+		glProgramUniform4fv(m_ProgramID, uniform.location, 1, floats);
+		break;
+	case UT_MAT4:
+		glProgramUniformMatrix4fv(m_ProgramID, uniform.location, 1, GL_FALSE, floats);
+		break;
+	default:
+		break;
+	}
+}
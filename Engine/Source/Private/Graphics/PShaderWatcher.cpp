@@ -0,0 +1,222 @@
+// Internal headers
+#include "Graphics/PShaderWatcher.h"
+#include "Graphics/PShaderProgram.h"
+#include "Debug/PProfiler.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+PShaderWatcher::PShaderWatcher()
+{
+	m_NotifyFD = -1;
+	m_LastPoll = std::chrono::steady_clock::now();
+}
+
+PShaderWatcher::~PShaderWatcher()
+{
+#if defined(__linux__)
+	if (m_NotifyFD >= 0)
+		close(m_NotifyFD);
+#endif
+}
+
+bool PShaderWatcher::Init()
+{
+	// Let the driver compile on as many threads as it likes, so status queries never block
+	if (GLEW_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFU);
+	else if (GLEW_ARB_parallel_shader_compile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFFU);
+	else
+		PDebug::Log("Parallel shader compile unavailable, reloads compile on the render thread", LT_WARN);
+
+#if defined(__linux__)
+	m_NotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_NotifyFD < 0)
+		PDebug::Log("inotify unavailable, polling shader files instead", LT_WARN);
+#endif
+
+	PDebug::Log(PString("Shader watcher started using ") + (m_NotifyFD >= 0 ? "inotify" : "file time polling"));
+
+	return true;
+}
+
+void PShaderWatcher::Watch(const TShared<PShaderProgram>& program)
+{
+	if (program == nullptr)
+		return;
+
+	PSWatchedProgram watched;
+	watched.program = program;
+
+	for (int type = ST_VERTEX; type <= ST_FRAGMENT; ++type)
+	{
+		watched.paths[type] = NormalisePath(program->GetFilePath(static_cast<PEShaderType>(type)));
+
+		std::error_code error;
+		watched.writeTimes[type] = std::filesystem::last_write_time(watched.paths[type], error);
+
+#if defined(__linux__)
+		// Editors often save by writing a new file and renaming it over the old one,
+		// so the folder is watched rather than the file itself
+		if (m_NotifyFD >= 0)
+		{
+			const PString folder = std::filesystem::path(watched.paths[type]).parent_path().generic_string();
+
+			bool alreadyWatched = false;
+			for (const auto& entry : m_WatchedFolders)
+				alreadyWatched |= entry.second == folder;
+
+			if (!alreadyWatched)
+			{
+				const int watch = inotify_add_watch(m_NotifyFD, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+				if (watch >= 0)
+					m_WatchedFolders.emplace_back(watch, folder);
+				else
+					PDebug::Log("Failed to watch shader folder: " + folder, LT_WARN);
+			}
+		}
+#endif
+	}
+
+	m_Programs.push_back(watched);
+}
+
+void PShaderWatcher::Update()
+{
+	PPROFILE_SCOPE("Shader Watcher");
+
+	if (m_NotifyFD >= 0)
+	{
+		ReadEvents();
+	}
+	else
+	{
+		const auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<double>(now - m_LastPoll).count() >= PSHADER_WATCHER_POLL_INTERVAL)
+		{
+			m_LastPoll = now;
+			PollFiles();
+		}
+	}
+
+	for (size_t i = 0; i < m_Programs.size();)
+	{
+		PSWatchedProgram& watched = m_Programs[i];
+		const TShared<PShaderProgram> program = watched.program.lock();
+
+		// Forget programs that were destroyed
+		if (!program)
+		{
+			if (i + 1 < m_Programs.size())
+				m_Programs[i] = std::move(m_Programs.back());
+
+			m_Programs.pop_back();
+			continue;
+		}
+
+		++i;
+
+		// A file saved again while compiling starts another reload once this one finishes
+		if (watched.changed && !program->IsReloading())
+		{
+			if (program->BeginReload())
+			{
+				watched.changed = false;
+				PDebug::Log("Reloading shader: " + watched.paths[ST_VERTEX] + ", " + watched.paths[ST_FRAGMENT]);
+			}
+		}
+
+		switch (program->UpdateReload())
+		{
+		case RS_SWAPPED:
+			++m_Stats.reloads;
+			break;
+		case RS_FAILED:
+			++m_Stats.failures;
+			PDebug::Log("Shader reload failed, keeping the previous program", LT_WARN);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void PShaderWatcher::OnFileChanged(const PString& path)
+{
+	for (PSWatchedProgram& watched : m_Programs)
+	{
+		if (watched.paths[ST_VERTEX] == path || watched.paths[ST_FRAGMENT] == path)
+			watched.changed = true;
+	}
+}
+
+void PShaderWatcher::ReadEvents()
+{
+#if defined(__linux__)
+	alignas(inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		const ssize_t length = read(m_NotifyFD, buffer, sizeof(buffer));
+
+		// EAGAIN means every event has been read
+		if (length <= 0)
+		{
+			if (length < 0 && errno != EAGAIN)
+				PDebug::Log("Failed to read shader file events", LT_WARN);
+
+			break;
+		}
+
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if (event->len == 0)
+				continue;
+
+			for (const auto& entry : m_WatchedFolders)
+			{
+				if (entry.first == event->wd)
+				{
+					OnFileChanged(NormalisePath(entry.second + "/" + event->name));
+					break;
+				}
+			}
+		}
+	}
+#endif
+}
+
+void PShaderWatcher::PollFiles()
+{
+	for (PSWatchedProgram& watched : m_Programs)
+	{
+		for (int type = ST_VERTEX; type <= ST_FRAGMENT; ++type)
+		{
+			// Files that can't be read mid-save are checked again on the next poll
+			std::error_code error;
+			const auto writeTime = std::filesystem::last_write_time(watched.paths[type], error);
+
+			if (!error && writeTime != watched.writeTimes[type])
+			{
+				watched.writeTimes[type] = writeTime;
+				watched.changed = true;
+			}
+		}
+	}
+}
+
+PString PShaderWatcher::NormalisePath(const PString& path)
+{
+	std::error_code error;
+	return std::filesystem::absolute(path, error).lexically_normal().generic_string();
+}
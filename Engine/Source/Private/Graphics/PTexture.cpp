@@ -1,38 +1,78 @@
 // Internal headers
 #include "Graphics/PTexture.h"
+#include "Graphics/PGLState.h"
+#include "Graphics/PCompressedTexture.h"
+#include "Core/PFileSystem.h"
+#include "Debug/PMemoryTracker.h"
 
 // External libraries
 #include <GLEW/glew.h>
 #include <STB_IMAGE/stb_image.h>
 
+// System libraries
+#include <algorithm>
+#include <cmath>
+
+PUi32 PTexture::s_PlaceholderID = 0U;
+
 PTexture::PTexture()
 {
     m_Path = m_FileName = "";
     m_ID = 0U;
     m_Width = m_Height = m_Channels = 0;
+    m_CompressedBytes = 0;
+    m_MemoryHandle = 0;
 }
 
 PTexture::~PTexture()
 {
     // Delete the texture if an ID was generated
     if (m_ID > 0)
+    {
+        PGLState::OnTextureDeleted(m_ID);
         glDeleteTextures(1, &m_ID);
+    }
+
+    PMemoryTracker::Unregister(m_MemoryHandle);
 
     PDebug::Log("Texture destroyed: " + m_FileName);
 }
 
-bool PTexture::LoadTexture(const PString& fileName, const PString& path)
+bool PTexture::LoadTexture(const PString& fileName, const PString& path, const PSTextureLoadOptions& options)
 {
-    // Assign the file name and path
+    // Assign the file name, path and options
     m_FileName = fileName;
     m_Path = path;
+    m_Options = options;
+
+    // Pre-compressed files skip decoding and keep their own mip chain
+    if (PCompressedTexture::IsCompressedPath(m_Path))
+    {
+        PSCompressedImage image;
+        if (!PCompressedTexture::Load(m_Path, image, m_Options.flipVertically))
+        {
+            PDebug::Log("Failed to load compressed texture - " + m_FileName, LT_ERROR);
+            return false;
+        }
+
+        return LoadCompressed(image);
+    }
 
     // stb_image loads images upside down, OpenGL reads them bottom-left (x:0, y:0)
-    stbi_set_flip_vertically_on_load(true);
+    // The flip is per thread so it can't leak into decodes running on worker threads
+    stbi_set_flip_vertically_on_load_thread(m_Options.flipVertically);
+
+    // Read the file from disk or a mounted pack, then decode it from memory
+    PFileData file;
+    if (!PFileSystem::Get().Open(m_Path, file))
+    {
+        PDebug::Log("Failed to load texture - " + m_FileName + ": file not found", LT_ERROR);
+        return false;
+    }
 
     // Load the image
-    unsigned char* data = stbi_load(
-        m_Path.c_str(), // Path to the image
+    unsigned char* data = stbi_load_from_memory(
+        file.GetData(), static_cast<int>(file.GetSize()), // Encoded image
         &m_Width, &m_Height, // Width and height of the image
         &m_Channels, // Number of channels in the image (RGBA)
         0 // We don't require a specific number of channels
@@ -52,8 +92,8 @@ bool PTexture::LoadTexture(const PString& fileName, const PString& path)
         return false;
     }
 
-    // Generate the texture ID in OpenGL
-    glGenTextures(1, &m_ID);
+    // Create the texture, DSA textures are edited by ID so nothing is bound while loading
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_ID);
 
     if (m_ID == 0)
     {
@@ -64,42 +104,48 @@ bool PTexture::LoadTexture(const PString& fileName, const PString& path)
         return false;
     }
 
-    // Bind the texture
-    glBindTexture(GL_TEXTURE_2D, m_ID);
+    // Allocate immutable storage for the whole mip chain up front with a sized format
+    // The driver knows the final size and layout, so it never has to reallocate or revalidate
+    const GLsizei levels = m_Options.generateMipmaps ?
+        static_cast<GLsizei>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1 : 1;
+    glTextureStorage2D(m_ID, levels, m_Channels == 4 ? GL_RGBA8 : GL_RGB8, m_Width, m_Height);
 
     // Set texture parameters
     // Repeat the texture if it doesn't fit the model
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    const GLint wrap = m_Options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    glTextureParameteri(m_ID, GL_TEXTURE_WRAP_S, wrap);
+    glTextureParameteri(m_ID, GL_TEXTURE_WRAP_T, wrap);
 
     // Set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const GLint filter = m_Options.linearFilter ? GL_LINEAR : GL_NEAREST;
+    glTextureParameteri(m_ID, GL_TEXTURE_MIN_FILTER, filter);
+    glTextureParameteri(m_ID, GL_TEXTURE_MAG_FILTER, filter);
 
-    // Determine internal format based on the number of channels
-    GLint intFormat = (m_Channels == 4) ? GL_RGBA : GL_RGB;
+    // Rows of 3 channel images aren't 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    // Load image data into the texture
-    glTexImage2D(
-        GL_TEXTURE_2D,
+    // Load image data into the base level
+    glTextureSubImage2D(
+        m_ID,
         0,
-        intFormat,
+        0, 0,
         m_Width, m_Height,
-        0,
-        intFormat,
+        m_Channels == 4 ? GL_RGBA : GL_RGB,
         GL_UNSIGNED_BYTE,
         data
     );
 
-    // Generate mipmaps for the texture
-    glGenerateMipmap(GL_TEXTURE_2D);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    // Unbind the texture
-    Unbind();
+    // Generate mipmaps for the texture
+    if (m_Options.generateMipmaps)
+        glGenerateTextureMipmap(m_ID);
 
     // Free the image data
     stbi_image_free(data);
 
+    UpdateMemory();
+
     PDebug::Log("Successfully imported texture - " + m_FileName, LT_SUCCESS);
 
     return true;
@@ -107,14 +153,98 @@ bool PTexture::LoadTexture(const PString& fileName, const PString& path)
 
 void PTexture::BindTexture(const PUi32& textureNumber)
 {
-    // Make the texture active for the shader in the specified slot
-    glActiveTexture(GL_TEXTURE0 + textureNumber);
+    // Bind the texture to the specified slot, skipped if it's already bound there
+    PGLState::BindTexture(textureNumber, m_ID > 0 ? m_ID : s_PlaceholderID);
+}
 
-    glBindTexture(GL_TEXTURE_2D, m_ID);
+void PTexture::SetPlaceholder(const PUi32& placeholderID)
+{
+    s_PlaceholderID = placeholderID;
 }
 
 void PTexture::Unbind()
 {
     // Unbind the texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    PGLState::BindTexture(0, 0);
+}
+
+bool PTexture::LoadCompressed(const PSCompressedImage& image)
+{
+    if (image.mips.empty() || image.GetGLFormat() == 0)
+    {
+        PDebug::Log("Failed to import compressed texture - " + m_FileName + ": no supported image data", LT_ERROR);
+        return false;
+    }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_ID);
+
+    if (m_ID == 0)
+    {
+        PDebug::Log("Failed to generate texture ID - " + m_FileName, LT_ERROR);
+        return false;
+    }
+
+    // Files may stop before the 1x1 level, so the storage only holds the levels they carry
+    const GLsizei levels = static_cast<GLsizei>(image.mips.size());
+    glTextureStorage2D(m_ID, levels, image.GetGLFormat(), image.width, image.height);
+
+    const GLint wrap = m_Options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    glTextureParameteri(m_ID, GL_TEXTURE_WRAP_S, wrap);
+    glTextureParameteri(m_ID, GL_TEXTURE_WRAP_T, wrap);
+
+    // The file carries its mip chain, so sample it when there is one
+    const bool hasMips = levels > 1;
+    const GLint minFilter = m_Options.linearFilter ?
+        (hasMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR) : (hasMips ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+    glTextureParameteri(m_ID, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTextureParameteri(m_ID, GL_TEXTURE_MAG_FILTER, m_Options.linearFilter ? GL_LINEAR : GL_NEAREST);
+
+    m_CompressedBytes = 0;
+    for (GLsizei level = 0; level < levels; ++level)
+    {
+        const PSCompressedMip& mip = image.mips[level];
+
+        glCompressedTextureSubImage2D(
+            m_ID,
+            level,
+            0, 0,
+            mip.width, mip.height,
+            image.GetGLFormat(),
+            static_cast<GLsizei>(mip.size),
+            image.data.data() + mip.offset
+        );
+
+        m_CompressedBytes += mip.size;
+    }
+
+    m_Width = static_cast<int>(image.width);
+    m_Height = static_cast<int>(image.height);
+    m_Channels = 4;
+
+    UpdateMemory();
+
+    PDebug::Log("Successfully imported compressed texture - " + m_FileName, LT_SUCCESS);
+
+    return true;
+}
+
+PUi64 PTexture::GetResidentBytes() const
+{
+    if (m_CompressedBytes > 0)
+        return m_CompressedBytes;
+
+    const PUi64 baseBytes = static_cast<PUi64>(m_Width) * m_Height * m_Channels;
+
+    // A full mip chain adds a third on top of the base level
+    return m_Options.generateMipmaps ? baseBytes + baseBytes / 3 : baseBytes;
+}
+
+void PTexture::UpdateMemory()
+{
+    // Registered on the first upload, so textures that never became resident aren't counted
+    if (m_MemoryHandle == 0)
+        m_MemoryHandle = PMemoryTracker::Register(RT_TEXTURE, m_FileName.empty() ? m_Path : m_FileName);
+
+    // The decoded image is freed after the upload, so only the GPU storage is held
+    PMemoryTracker::Update(m_MemoryHandle, 0, m_ID > 0 ? GetResidentBytes() : 0);
 }
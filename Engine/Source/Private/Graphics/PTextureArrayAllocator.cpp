@@ -0,0 +1,184 @@
+// Internal headers
+#include "Graphics/PTextureArrayAllocator.h"
+#include "Graphics/PTexture.h"
+#include "Graphics/PGLState.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <algorithm>
+
+PTextureArrayAllocator::PTextureArrayAllocator()
+{
+	m_LayersPerArray = 32;
+}
+
+PTextureArrayAllocator::~PTextureArrayAllocator()
+{
+	for (const PSTextureArray& array : m_Arrays)
+	{
+		PGLState::OnTextureDeleted(array.id);
+		glDeleteTextures(1, &array.id);
+	}
+}
+
+void PTextureArrayAllocator::SetLayersPerArray(const PUi32& layers)
+{
+	GLint maxLayers = 256;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+	m_LayersPerArray = std::clamp<PUi32>(layers, 1, static_cast<PUi32>(maxLayers));
+}
+
+bool PTextureArrayAllocator::Allocate(const PTexture& texture, PSTextureArraySlot& outSlot)
+{
+	PSTextureArrayFormat format;
+	if (!QueryFormat(texture, format))
+	{
+		PDebug::Log("Failed to pack texture into an array - " + texture.GetName() + ": texture isn't resident", LT_WARN);
+		return false;
+	}
+
+	// Reuse a free layer of a matching array before creating a new one
+	int arrayIndex = -1;
+	for (size_t i = 0; i < m_Arrays.size(); ++i)
+	{
+		if (m_Arrays[i].format == format && !m_Arrays[i].freeLayers.empty())
+		{
+			arrayIndex = static_cast<int>(i);
+			break;
+		}
+	}
+
+	if (arrayIndex < 0)
+		arrayIndex = CreateArray(format, texture.GetResidentBytes());
+
+	if (arrayIndex < 0)
+	{
+		PDebug::Log("Failed to create texture array for texture - " + texture.GetName(), LT_ERROR);
+		return false;
+	}
+
+	PSTextureArray& array = m_Arrays[arrayIndex];
+	const PUi32 layer = array.freeLayers.back();
+	array.freeLayers.pop_back();
+
+	// Copy every level on the GPU, the data never comes back to the CPU
+	for (int level = 0; level < format.levels; ++level)
+	{
+		const GLsizei levelWidth = std::max(format.width >> level, 1);
+		const GLsizei levelHeight = std::max(format.height >> level, 1);
+
+		glCopyImageSubData(
+			texture.GetID(), GL_TEXTURE_2D, level, 0, 0, 0,
+			array.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, static_cast<GLint>(layer),
+			levelWidth, levelHeight, 1
+		);
+	}
+
+	outSlot.arrayID = array.id;
+	outSlot.layer = layer;
+
+	return true;
+}
+
+void PTextureArrayAllocator::Free(const PSTextureArraySlot& slot)
+{
+	if (!slot.IsValid())
+		return;
+
+	for (PSTextureArray& array : m_Arrays)
+	{
+		if (array.id == slot.arrayID)
+		{
+			array.freeLayers.push_back(slot.layer);
+			return;
+		}
+	}
+}
+
+PUi32 PTextureArrayAllocator::GetUsedLayerCount() const
+{
+	PUi32 usedLayers = 0;
+	for (const PSTextureArray& array : m_Arrays)
+	{
+		usedLayers += array.layerCount - static_cast<PUi32>(array.freeLayers.size());
+	}
+
+	return usedLayers;
+}
+
+PUi64 PTextureArrayAllocator::GetResidentBytes() const
+{
+	PUi64 bytes = 0;
+	for (const PSTextureArray& array : m_Arrays)
+	{
+		bytes += array.layerBytes * array.layerCount;
+	}
+
+	return bytes;
+}
+
+bool PTextureArrayAllocator::QueryFormat(const PTexture& texture, PSTextureArrayFormat& outFormat)
+{
+	if (!texture.IsResident())
+		return false;
+
+	// Textures are created with immutable storage, so the level count is fixed and can be read back
+	GLint internalFormat = 0, width = 0, height = 0, levels = 0;
+	glGetTextureLevelParameteriv(texture.GetID(), 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+	glGetTextureLevelParameteriv(texture.GetID(), 0, GL_TEXTURE_WIDTH, &width);
+	glGetTextureLevelParameteriv(texture.GetID(), 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTextureParameteriv(texture.GetID(), GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+
+	if (internalFormat == 0 || width <= 0 || height <= 0)
+		return false;
+
+	outFormat.internalFormat = static_cast<PUi32>(internalFormat);
+	outFormat.width = width;
+	outFormat.height = height;
+	outFormat.levels = std::max(levels, 1);
+	outFormat.repeat = texture.GetOptions().repeat;
+	outFormat.linearFilter = texture.GetOptions().linearFilter;
+
+	return true;
+}
+
+int PTextureArrayAllocator::CreateArray(const PSTextureArrayFormat& format, const PUi64& layerBytes)
+{
+	PSTextureArray array;
+	array.format = format;
+	array.layerCount = m_LayersPerArray;
+	array.layerBytes = layerBytes;
+
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &array.id);
+	if (array.id == 0)
+		return -1;
+
+	glTextureStorage3D(array.id, format.levels, format.internalFormat, format.width, format.height,
+		static_cast<GLsizei>(array.layerCount));
+
+	// Every layer shares the array's sampler state, which comes from the load options of the textures it holds
+	const bool hasMips = format.levels > 1;
+	const GLint wrap = format.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	const GLint minFilter = format.linearFilter ?
+		(hasMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR) : (hasMips ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+	glTextureParameteri(array.id, GL_TEXTURE_WRAP_S, wrap);
+	glTextureParameteri(array.id, GL_TEXTURE_WRAP_T, wrap);
+	glTextureParameteri(array.id, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTextureParameteri(array.id, GL_TEXTURE_MAG_FILTER, format.linearFilter ? GL_LINEAR : GL_NEAREST);
+
+	// Hand out the lowest layers first
+	for (PUi32 layer = array.layerCount; layer > 0; --layer)
+	{
+		array.freeLayers.push_back(layer - 1);
+	}
+
+	PDebug::Log("Texture array created for " + std::to_string(format.width) + "x" + std::to_string(format.height) +
+		" textures with " + std::to_string(array.layerCount) + " layers");
+
+	m_Arrays.push_back(std::move(array));
+
+	return static_cast<int>(m_Arrays.size()) - 1;
+}
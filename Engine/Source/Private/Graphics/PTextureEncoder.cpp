@@ -0,0 +1,583 @@
+// Internal headers
+#include "Graphics/PTextureEncoder.h"
+#include "Core/PThreadPool.h"
+#include "Core/PFileSystem.h"
+
+// External libraries
+#include <immintrin.h>
+#include <GLM/glm.hpp>
+#include <STB_IMAGE/stb_image.h>
+
+// System libraries
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Power iterations used to find the principal axis of a block's colours
+#define LPCA_ITERATIONS 8
+
+// BC7 4-bit index interpolation weights out of 64
+static const int s_BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Structure for a block's pixels split by channel so four pixels fit in one SSE register
+struct alignas(16) PSEncoderBlock
+{
+	float r[16], g[16], b[16], a[16];
+};
+
+// Structure writing bits into a block from the least significant bit up
+struct PSBitWriter
+{
+	PUi8* data;
+	PUi32 position = 0;
+
+	void Write(PUi32 value, const PUi32& bits)
+	{
+		for (PUi32 i = 0; i < bits; ++i, ++position, value >>= 1)
+		{
+			if (value & 1)
+				data[position >> 3] |= static_cast<PUi8>(1 << (position & 7));
+		}
+	}
+};
+
+// Split 16 RGBA8 pixels into per channel floats
+static void LoadBlock(const PUi8* pixels, PSEncoderBlock& outBlock)
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		outBlock.r[i] = pixels[i * 4 + 0];
+		outBlock.g[i] = pixels[i * 4 + 1];
+		outBlock.b[i] = pixels[i * 4 + 2];
+		outBlock.a[i] = pixels[i * 4 + 3];
+	}
+}
+
+// Find the nearest palette entry for each pixel, four pixels at a time, and return the total weighted error
+static float FindIndices(const PSEncoderBlock& block, const glm::vec4* palette, const int& paletteSize,
+	const glm::vec4& weights, PUi8* outIndices)
+{
+	const __m128 weightR = _mm_set1_ps(weights.r);
+	const __m128 weightG = _mm_set1_ps(weights.g);
+	const __m128 weightB = _mm_set1_ps(weights.b);
+	const __m128 weightA = _mm_set1_ps(weights.a);
+
+	__m128 totalError = _mm_setzero_ps();
+
+	for (int group = 0; group < 16; group += 4)
+	{
+		const __m128 r = _mm_load_ps(block.r + group);
+		const __m128 g = _mm_load_ps(block.g + group);
+		const __m128 b = _mm_load_ps(block.b + group);
+		const __m128 a = _mm_load_ps(block.a + group);
+
+		__m128 bestError = _mm_set1_ps(1e30f);
+		__m128 bestIndex = _mm_setzero_ps();
+
+		for (int entry = 0; entry < paletteSize; ++entry)
+		{
+			const __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[entry].r));
+			const __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[entry].g));
+			const __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[entry].b));
+			const __m128 da = _mm_sub_ps(a, _mm_set1_ps(palette[entry].a));
+
+			__m128 error = _mm_mul_ps(_mm_mul_ps(dr, dr), weightR);
+			error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(dg, dg), weightG));
+			error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(db, db), weightB));
+			error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(da, da), weightA));
+
+			// Keep the first entry on ties so results match a scalar search
+			const __m128 better = _mm_cmplt_ps(error, bestError);
+			bestError = _mm_min_ps(error, bestError);
+			bestIndex = _mm_or_ps(_mm_and_ps(better, _mm_set1_ps(static_cast<float>(entry))), _mm_andnot_ps(better, bestIndex));
+		}
+
+		alignas(16) float indices[4];
+		_mm_store_ps(indices, bestIndex);
+		for (int i = 0; i < 4; ++i)
+			outIndices[group + i] = static_cast<PUi8>(indices[i]);
+
+		totalError = _mm_add_ps(totalError, bestError);
+	}
+
+	alignas(16) float errors[4];
+	_mm_store_ps(errors, totalError);
+
+	return errors[0] + errors[1] + errors[2] + errors[3];
+}
+
+// Find the two ends of the line that best fits the block's colours, channels with a 0 weight are ignored
+static void FitEndpoints(const PSEncoderBlock& block, const glm::vec4& weights, glm::vec4& outStart, glm::vec4& outEnd)
+{
+	glm::vec4 mean(0.0f);
+	for (int i = 0; i < 16; ++i)
+		mean += glm::vec4(block.r[i], block.g[i], block.b[i], block.a[i]);
+	mean /= 16.0f;
+
+	// Covariance of the weighted channels
+	glm::mat4 covariance(0.0f);
+	for (int i = 0; i < 16; ++i)
+	{
+		const glm::vec4 d = (glm::vec4(block.r[i], block.g[i], block.b[i], block.a[i]) - mean) * weights;
+		covariance += glm::outerProduct(d, d);
+	}
+
+	// Power iteration from the channel with the widest spread
+	glm::vec4 axis(covariance[0][0], covariance[1][1], covariance[2][2], covariance[3][3]);
+	for (int i = 0; i < LPCA_ITERATIONS; ++i)
+	{
+		axis = covariance * axis;
+		const float length = glm::length(axis);
+		if (length < 1e-6f)
+			break;
+		axis /= length;
+	}
+
+	if (glm::length(axis) < 1e-6f)
+	{
+		outStart = outEnd = mean;
+		return;
+	}
+
+	float minT = 1e30f, maxT = -1e30f;
+	for (int i = 0; i < 16; ++i)
+	{
+		const float t = glm::dot((glm::vec4(block.r[i], block.g[i], block.b[i], block.a[i]) - mean) * weights, axis);
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	outStart = glm::clamp(mean + axis * maxT, glm::vec4(0.0f), glm::vec4(255.0f));
+	outEnd = glm::clamp(mean + axis * minT, glm::vec4(0.0f), glm::vec4(255.0f));
+}
+
+// Solve for the endpoints that best reproduce the block with its current indices
+// factors[i] is how much of the start endpoint palette entry i uses
+static bool RefineEndpoints(const PSEncoderBlock& block, const PUi8* indices, const float* factors,
+	glm::vec4& outStart, glm::vec4& outEnd)
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	glm::vec4 ax(0.0f), bx(0.0f);
+
+	for (int i = 0; i < 16; ++i)
+	{
+		const float alpha = factors[indices[i]];
+		const float beta = 1.0f - alpha;
+		const glm::vec4 x(block.r[i], block.g[i], block.b[i], block.a[i]);
+
+		aa += alpha * alpha;
+		ab += alpha * beta;
+		bb += beta * beta;
+		ax += alpha * x;
+		bx += beta * x;
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+
+	outStart = glm::clamp((ax * bb - bx * ab) / determinant, glm::vec4(0.0f), glm::vec4(255.0f));
+	outEnd = glm::clamp((bx * aa - ax * ab) / determinant, glm::vec4(0.0f), glm::vec4(255.0f));
+
+	return true;
+}
+
+// Quantize a colour to 5:6:5
+static PUi16 PackColour565(const glm::vec4& colour)
+{
+	const PUi16 r = static_cast<PUi16>(std::lround(colour.r * 31.0f / 255.0f));
+	const PUi16 g = static_cast<PUi16>(std::lround(colour.g * 63.0f / 255.0f));
+	const PUi16 b = static_cast<PUi16>(std::lround(colour.b * 31.0f / 255.0f));
+
+	return static_cast<PUi16>((r << 11) | (g << 5) | b);
+}
+
+// Expand a 5:6:5 colour back to 8 bits per channel
+static glm::vec4 UnpackColour565(const PUi16& colour)
+{
+	const int r = (colour >> 11) & 31;
+	const int g = (colour >> 5) & 63;
+	const int b = colour & 31;
+
+	return glm::vec4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255.0f);
+}
+
+// Build the 4 colour BC1 palette and fit indices, returns the error
+static float EvaluateBC1(const PSEncoderBlock& block, const PUi16& colour0, const PUi16& colour1, PUi8* outIndices)
+{
+	const glm::vec4 c0 = UnpackColour565(colour0);
+	const glm::vec4 c1 = UnpackColour565(colour1);
+
+	const glm::vec4 palette[4] = {
+		c0, c1,
+		glm::floor((2.0f * c0 + c1) / 3.0f),
+		glm::floor((c0 + 2.0f * c1) / 3.0f)
+	};
+
+	return FindIndices(block, palette, 4, glm::vec4(1.0f, 1.0f, 1.0f, 0.0f), outIndices);
+}
+
+// Encode the colour of a block as an 8 byte BC1 block, always in 4 colour mode
+static void EncodeBC1(const PSEncoderBlock& block, PUi8* outBlock)
+{
+	static const float factors[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	const glm::vec4 colourWeights(1.0f, 1.0f, 1.0f, 0.0f);
+
+	glm::vec4 start, end;
+	FitEndpoints(block, colourWeights, start, end);
+
+	PUi16 colour0 = PackColour565(start);
+	PUi16 colour1 = PackColour565(end);
+	PUi8 indices[16];
+	float error = EvaluateBC1(block, colour0, colour1, indices);
+
+	// One least squares pass usually recovers what the bounding line misses
+	if (RefineEndpoints(block, indices, factors, start, end))
+	{
+		const PUi16 refined0 = PackColour565(start);
+		const PUi16 refined1 = PackColour565(end);
+		PUi8 refinedIndices[16];
+		const float refinedError = EvaluateBC1(block, refined0, refined1, refinedIndices);
+
+		if (refinedError < error)
+		{
+			colour0 = refined0;
+			colour1 = refined1;
+			error = refinedError;
+			std::memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	// The first colour has to be the larger one for 4 colour mode, swapping them swaps the palette pairs
+	if (colour0 < colour1)
+	{
+		std::swap(colour0, colour1);
+		for (PUi8& index : indices)
+			index ^= 1;
+	}
+	else if (colour0 == colour1)
+	{
+		// Equal colours select 3 colour mode where index 3 is transparent, so only use index 0
+		std::memset(indices, 0, sizeof(indices));
+	}
+
+	PUi32 packedIndices = 0;
+	for (int i = 0; i < 16; ++i)
+		packedIndices |= static_cast<PUi32>(indices[i]) << (i * 2);
+
+	std::memcpy(outBlock, &colour0, 2);
+	std::memcpy(outBlock + 2, &colour1, 2);
+	std::memcpy(outBlock + 4, &packedIndices, 4);
+}
+
+// Encode one channel of a block as an 8 byte BC4 block
+static void EncodeBC4(const float* values, PUi8* outBlock)
+{
+	float minValue = 255.0f, maxValue = 0.0f;
+	for (int i = 0; i < 16; ++i)
+	{
+		minValue = std::min(minValue, values[i]);
+		maxValue = std::max(maxValue, values[i]);
+	}
+
+	const PUi8 value0 = static_cast<PUi8>(std::lround(maxValue));
+	const PUi8 value1 = static_cast<PUi8>(std::lround(minValue));
+
+	std::memset(outBlock, 0, 8);
+	outBlock[0] = value0;
+	outBlock[1] = value1;
+
+	// A flat block only needs index 0
+	if (value0 == value1)
+		return;
+
+	// With the first value larger there are 6 interpolated steps between them
+	glm::vec4 palette[8];
+	palette[0] = glm::vec4(value0, 0.0f, 0.0f, 0.0f);
+	palette[1] = glm::vec4(value1, 0.0f, 0.0f, 0.0f);
+	for (int i = 2; i < 8; ++i)
+		palette[i] = glm::vec4(static_cast<float>(((8 - i) * value0 + (i - 1) * value1) / 7), 0.0f, 0.0f, 0.0f);
+
+	PSEncoderBlock channel = {};
+	std::memcpy(channel.r, values, sizeof(channel.r));
+
+	PUi8 indices[16];
+	FindIndices(channel, palette, 8, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), indices);
+
+	PSBitWriter writer{ outBlock + 2 };
+	for (int i = 0; i < 16; ++i)
+		writer.Write(indices[i], 3);
+}
+
+// Quantize a BC7 mode 6 endpoint to 7 bits per channel plus a shared p-bit, picking the p-bit with less error
+static glm::vec4 QuantizeBC7Endpoint(const glm::vec4& endpoint, glm::uvec4& outQuantized, PUi32& outPBit)
+{
+	float bestError = 1e30f;
+	glm::vec4 bestValue(0.0f);
+
+	for (PUi32 pBit = 0; pBit < 2; ++pBit)
+	{
+		glm::uvec4 quantized;
+		glm::vec4 value;
+		for (int c = 0; c < 4; ++c)
+		{
+			quantized[c] = static_cast<PUi32>(glm::clamp(std::lround((endpoint[c] - pBit) / 2.0f), 0L, 127L));
+			value[c] = static_cast<float>(quantized[c] * 2 + pBit);
+		}
+
+		const glm::vec4 d = value - endpoint;
+		const float error = glm::dot(d, d);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestValue = value;
+			outQuantized = quantized;
+			outPBit = pBit;
+		}
+	}
+
+	return bestValue;
+}
+
+// Build the 16 entry BC7 palette from quantized endpoints and fit indices, returns the error
+static float EvaluateBC7(const PSEncoderBlock& block, const glm::vec4& value0, const glm::vec4& value1, PUi8* outIndices)
+{
+	glm::vec4 palette[16];
+	for (int i = 0; i < 16; ++i)
+		palette[i] = glm::floor(((64.0f - s_BC7Weights[i]) * value0 + static_cast<float>(s_BC7Weights[i]) * value1 + 32.0f) / 64.0f);
+
+	return FindIndices(block, palette, 16, glm::vec4(1.0f), outIndices);
+}
+
+// Encode a block as a 16 byte BC7 mode 6 block: one subset, RGBA endpoints with p-bits and 4-bit indices
+static void EncodeBC7(const PSEncoderBlock& block, PUi8* outBlock)
+{
+	float factors[16];
+	for (int i = 0; i < 16; ++i)
+		factors[i] = 1.0f - s_BC7Weights[i] / 64.0f;
+
+	glm::vec4 start, end;
+	FitEndpoints(block, glm::vec4(1.0f), start, end);
+
+	glm::uvec4 quantized0, quantized1;
+	PUi32 pBit0, pBit1;
+	glm::vec4 value0 = QuantizeBC7Endpoint(start, quantized0, pBit0);
+	glm::vec4 value1 = QuantizeBC7Endpoint(end, quantized1, pBit1);
+
+	PUi8 indices[16];
+	float error = EvaluateBC7(block, value0, value1, indices);
+
+	if (RefineEndpoints(block, indices, factors, start, end))
+	{
+		glm::uvec4 refinedQuantized0, refinedQuantized1;
+		PUi32 refinedPBit0, refinedPBit1;
+		const glm::vec4 refinedValue0 = QuantizeBC7Endpoint(start, refinedQuantized0, refinedPBit0);
+		const glm::vec4 refinedValue1 = QuantizeBC7Endpoint(end, refinedQuantized1, refinedPBit1);
+
+		PUi8 refinedIndices[16];
+		const float refinedError = EvaluateBC7(block, refinedValue0, refinedValue1, refinedIndices);
+
+		if (refinedError < error)
+		{
+			quantized0 = refinedQuantized0;
+			quantized1 = refinedQuantized1;
+			pBit0 = refinedPBit0;
+			pBit1 = refinedPBit1;
+			error = refinedError;
+			std::memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	// The first pixel's index is stored with its top bit implied as 0, so flip the line if it's set
+	if (indices[0] >= 8)
+	{
+		std::swap(quantized0, quantized1);
+		std::swap(pBit0, pBit1);
+		for (PUi8& index : indices)
+			index = static_cast<PUi8>(15 - index);
+	}
+
+	std::memset(outBlock, 0, 16);
+	PSBitWriter writer{ outBlock };
+
+	// Mode 6 is written as six 0 bits followed by a 1
+	writer.Write(1 << 6, 7);
+
+	for (int c = 0; c < 4; ++c)
+	{
+		writer.Write(quantized0[c], 7);
+		writer.Write(quantized1[c], 7);
+	}
+
+	writer.Write(pBit0, 1);
+	writer.Write(pBit1, 1);
+
+	writer.Write(indices[0], 3);
+	for (int i = 1; i < 16; ++i)
+		writer.Write(indices[i], 4);
+}
+
+// Halve an image with a box filter, odd edges reuse their last row or column
+static void Downsample(const TArray<PUi8>& source, const PUi32& width, const PUi32& height,
+	TArray<PUi8>& outPixels, PUi32& outWidth, PUi32& outHeight)
+{
+	outWidth = std::max(width / 2, 1U);
+	outHeight = std::max(height / 2, 1U);
+	outPixels.resize(static_cast<size_t>(outWidth) * outHeight * 4);
+
+	for (PUi32 y = 0; y < outHeight; ++y)
+	{
+		const PUi32 y0 = std::min(y * 2, height - 1);
+		const PUi32 y1 = std::min(y * 2 + 1, height - 1);
+
+		for (PUi32 x = 0; x < outWidth; ++x)
+		{
+			const PUi32 x0 = std::min(x * 2, width - 1);
+			const PUi32 x1 = std::min(x * 2 + 1, width - 1);
+
+			for (PUi32 c = 0; c < 4; ++c)
+			{
+				const PUi32 sum =
+					source[(static_cast<size_t>(y0) * width + x0) * 4 + c] + source[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+					source[(static_cast<size_t>(y1) * width + x0) * 4 + c] + source[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+
+				outPixels[(static_cast<size_t>(y) * outWidth + x) * 4 + c] = static_cast<PUi8>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+void PTextureEncoder::EncodeBlock(const PUi8* blockPixels, const PECompressedFormat& format, PUi8* outBlock)
+{
+	PSEncoderBlock block;
+	LoadBlock(blockPixels, block);
+
+	switch (format)
+	{
+	case CF_BC1:
+		EncodeBC1(block, outBlock);
+		break;
+	case CF_BC3:
+		EncodeBC4(block.a, outBlock);
+		EncodeBC1(block, outBlock + 8);
+		break;
+	case CF_BC5:
+		EncodeBC4(block.r, outBlock);
+		EncodeBC4(block.g, outBlock + 8);
+		break;
+	case CF_BC7:
+		EncodeBC7(block, outBlock);
+		break;
+	default:
+		break;
+	}
+}
+
+bool PTextureEncoder::Encode(const PUi8* pixels, const PUi32& width, const PUi32& height, const PECompressedFormat& format,
+	const bool& generateMips, const bool& srgb, PSCompressedImage& outImage)
+{
+	if (format == CF_UNKNOWN || width == 0 || height == 0)
+	{
+		PDebug::Log("Invalid texture encode request", LT_ERROR);
+		return false;
+	}
+
+	outImage = PSCompressedImage();
+	outImage.format = format;
+	outImage.srgb = srgb;
+	outImage.width = width;
+	outImage.height = height;
+
+	const PUi32 blockSize = PCompressedTexture::GetBlockSize(format);
+
+	TArray<PUi8> level(pixels, pixels + static_cast<size_t>(width) * height * 4);
+	PUi32 levelWidth = width, levelHeight = height;
+
+	while (true)
+	{
+		PSCompressedMip mip;
+		mip.offset = outImage.data.size();
+		mip.size = PCompressedTexture::GetLevelSize(format, levelWidth, levelHeight);
+		mip.width = levelWidth;
+		mip.height = levelHeight;
+		outImage.mips.push_back(mip);
+		outImage.data.resize(static_cast<size_t>(mip.offset + mip.size));
+
+		const PUi32 blocksX = std::max((levelWidth + 3) / 4, 1U);
+		const PUi32 blocksY = std::max((levelHeight + 3) / 4, 1U);
+		PUi8* levelData = outImage.data.data() + mip.offset;
+
+		// Every block writes to its own slot, so rows can be encoded on any thread
+		PThreadPool::Get().ParallelFor(blocksY, 1, [&](PUi32 firstRow, PUi32 lastRow)
+			{
+				PUi8 blockPixels[64];
+
+				for (PUi32 by = firstRow; by < lastRow; ++by)
+				{
+					for (PUi32 bx = 0; bx < blocksX; ++bx)
+					{
+						// Blocks past the edge repeat the last row and column
+						for (PUi32 y = 0; y < 4; ++y)
+						{
+							const PUi32 sourceY = std::min(by * 4 + y, levelHeight - 1);
+							for (PUi32 x = 0; x < 4; ++x)
+							{
+								const PUi32 sourceX = std::min(bx * 4 + x, levelWidth - 1);
+								std::memcpy(blockPixels + (y * 4 + x) * 4,
+									level.data() + (static_cast<size_t>(sourceY) * levelWidth + sourceX) * 4, 4);
+							}
+						}
+
+						EncodeBlock(blockPixels, format, levelData + (static_cast<size_t>(by) * blocksX + bx) * blockSize);
+					}
+				}
+			});
+
+		if (!generateMips || (levelWidth == 1 && levelHeight == 1))
+			break;
+
+		TArray<PUi8> nextLevel;
+		Downsample(level, levelWidth, levelHeight, nextLevel, levelWidth, levelHeight);
+		level = std::move(nextLevel);
+	}
+
+	return true;
+}
+
+bool PTextureEncoder::EncodeFile(const PString& sourcePath, const PString& outputPath, const PECompressedFormat& format,
+	const bool& srgb)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	// DDS files store the top row first, loaders flip them the same way they flip decoded images
+	stbi_set_flip_vertically_on_load_thread(false);
+
+	PFileData file;
+	const bool found = PFileSystem::Get().Open(sourcePath, file);
+
+	int width = 0, height = 0, channels = 0;
+	unsigned char* pixels = found ?
+		stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &channels, 4) : nullptr;
+	if (pixels == nullptr)
+	{
+		PDebug::Log("Failed to load image for encoding - " + sourcePath + ": " + (found ? stbi_failure_reason() : "file not found"),
+			LT_ERROR);
+		return false;
+	}
+
+	PSCompressedImage image;
+	const bool encoded = Encode(pixels, width, height, format, true, srgb, image);
+	stbi_image_free(pixels);
+
+	if (!encoded || !PCompressedTexture::SaveDDS(outputPath, image))
+		return false;
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double megapixels = static_cast<double>(width) * height / 1000000.0;
+
+	PDebug::Log("Encoded " + sourcePath + " to " + outputPath + " (" + std::to_string(image.mips.size()) + " mips, " +
+		std::to_string(megapixels / seconds) + " MP/s)", LT_SUCCESS);
+
+	return true;
+}
@@ -0,0 +1,153 @@
+// Internal headers
+#include "Graphics/PTextureRegistry.h"
+#include "Core/PFileSystem.h"
+#include "Graphics/PTextureStreamer.h"
+#include "Graphics/PMipStreamer.h"
+
+// System libraries
+#include <cctype>
+#include <filesystem>
+
+TShared<PTexture> PTextureRegistry::Load(const PString& sourcePath, const PSTextureLoadOptions& options)
+{
+	// The cooker's DDS file is loaded in place of the source image when it exists
+	const PString path = PFileSystem::Get().ResolveCooked(sourcePath);
+
+	// Streamed mips are always loaded in the background
+	if (options.streamMips && !m_MipStreamer.expired())
+		return LoadAsync(path, options);
+
+	const PString key = MakeKey(path, options);
+
+	if (TShared<PTexture> texture = FindLive(key))
+		return texture;
+
+	// Name the texture after its file so logs stay readable
+	TShared<PTexture> texture = TMakeShared<PTexture>();
+	if (!texture->LoadTexture(std::filesystem::path(path).stem().string(), path, options))
+	{
+		++m_Stats.failures;
+		return nullptr;
+	}
+
+	m_Textures.emplace(key, texture);
+
+	return texture;
+}
+
+TShared<PTexture> PTextureRegistry::LoadAsync(const PString& sourcePath, const PSTextureLoadOptions& options)
+{
+	// The cooker's DDS file is loaded in place of the source image when it exists
+	const PString path = PFileSystem::Get().ResolveCooked(sourcePath);
+
+	const TShared<PTextureStreamer> streamer = m_Streamer.lock();
+	const TShared<PMipStreamer> mipStreamer = options.streamMips ? m_MipStreamer.lock() : nullptr;
+	if (!streamer && !mipStreamer)
+		return Load(path, options);
+
+	const PString key = MakeKey(path, options);
+
+	if (TShared<PTexture> texture = FindLive(key))
+		return texture;
+
+	// Registered straight away so later requests share it while it's still decoding
+	TShared<PTexture> texture = TMakeShared<PTexture>();
+	if (mipStreamer)
+		mipStreamer->Register(texture, std::filesystem::path(path).stem().string(), path, options);
+	else
+		streamer->LoadAsync(texture, std::filesystem::path(path).stem().string(), path, options);
+	m_Textures.emplace(key, texture);
+
+	return texture;
+}
+
+void PTextureRegistry::PurgeExpired()
+{
+	for (auto it = m_Textures.begin(); it != m_Textures.end();)
+	{
+		if (it->second.expired())
+		{
+			it = m_Textures.erase(it);
+			++m_Stats.evictions;
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+PSTextureRegistryStats PTextureRegistry::GetStats()
+{
+	PurgeExpired();
+
+	m_Stats.liveTextures = 0;
+	m_Stats.residentBytes = 0;
+
+	for (const auto& entry : m_Textures)
+	{
+		if (const TShared<PTexture> texture = entry.second.lock())
+		{
+			++m_Stats.liveTextures;
+			m_Stats.residentBytes += texture->GetResidentBytes();
+		}
+	}
+
+	return m_Stats;
+}
+
+void PTextureRegistry::LogStats()
+{
+	const PSTextureRegistryStats stats = GetStats();
+
+	PDebug::Log("Texture registry: " + std::to_string(stats.hits) + " hits, " + std::to_string(stats.misses) + " misses, " +
+		std::to_string(stats.failures) + " failures, " + std::to_string(stats.liveTextures) + " live textures using " +
+		std::to_string(stats.residentBytes / 1024) + "KB");
+}
+
+TShared<PTexture> PTextureRegistry::FindLive(const PString& key)
+{
+	auto it = m_Textures.find(key);
+	if (it != m_Textures.end())
+	{
+		if (TShared<PTexture> texture = it->second.lock())
+		{
+			++m_Stats.hits;
+			return texture;
+		}
+
+		// The texture was released since it was last requested
+		m_Textures.erase(it);
+		++m_Stats.evictions;
+	}
+
+	++m_Stats.misses;
+
+	return nullptr;
+}
+
+PString PTextureRegistry::MakeKey(const PString& path, const PSTextureLoadOptions& options)
+{
+	// Resolve relative segments and separators so different spellings of one file share an entry
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+	if (error)
+		canonical = std::filesystem::absolute(path, error).lexically_normal();
+
+	PString key = canonical.generic_string();
+
+#if defined(_WIN32)
+	// Windows paths are case insensitive
+	for (char& c : key)
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+#endif
+
+	key += '|';
+	key += options.flipVertically ? 'f' : '-';
+	key += options.generateMipmaps ? 'm' : '-';
+	key += options.repeat ? 'r' : '-';
+	key += options.linearFilter ? 'l' : '-';
+	key += options.streamMips ? 's' : '-';
+
+	return key;
+}
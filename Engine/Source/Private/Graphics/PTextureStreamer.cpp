@@ -0,0 +1,342 @@
+// Internal headers
+#include "Graphics/PTextureStreamer.h"
+#include "Graphics/PGLState.h"
+#include "Core/PThreadPool.h"
+#include "Core/PFileSystem.h"
+#include "Debug/PProfiler.h"
+
+// External libraries
+#include <GLEW/glew.h>
+#include <STB_IMAGE/stb_image.h>
+
+// System libraries
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+PSDecodedImageQueue::~PSDecodedImageQueue()
+{
+	// Free anything decoded after the streamer stopped uploading
+	for (PSDecodedImage& image : images)
+	{
+		if (image.pixels)
+			stbi_image_free(image.pixels);
+	}
+}
+
+PUi64 PSDecodedImage::GetUploadBytes() const
+{
+	if (compressed)
+		return compressed->data.size();
+
+	return static_cast<PUi64>(width) * height * channels;
+}
+
+PTextureStreamer::PTextureStreamer()
+{
+	m_Decoded = TMakeShared<PSDecodedImageQueue>();
+	m_Pending = 0;
+	std::fill(std::begin(m_PixelBuffers), std::end(m_PixelBuffers), 0U);
+	m_NextPixelBuffer = 0;
+	m_Placeholder = 0;
+	m_FrameBudget = 0;
+}
+
+PTextureStreamer::~PTextureStreamer()
+{
+	if (m_Placeholder > 0)
+	{
+		PTexture::SetPlaceholder(0);
+		PGLState::OnTextureDeleted(m_Placeholder);
+		glDeleteTextures(1, &m_Placeholder);
+	}
+
+	for (const PUi32& buffer : m_PixelBuffers)
+	{
+		if (buffer > 0)
+		{
+			PGLState::OnBufferDeleted(buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+}
+
+bool PTextureStreamer::Init(const PUi64& frameBudget)
+{
+	m_FrameBudget = frameBudget;
+
+	// A small grey checker makes loading surfaces obvious without being distracting
+	const PUi8 checker[] = {
+		160, 160, 160, 255,   96,  96,  96, 255,
+		 96,  96,  96, 255,  160, 160, 160, 255
+	};
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_Placeholder);
+	if (m_Placeholder == 0)
+	{
+		PDebug::Log("Failed to create placeholder texture", LT_ERROR);
+		return false;
+	}
+
+	glTextureStorage2D(m_Placeholder, 1, GL_RGBA8, 2, 2);
+	glTextureSubImage2D(m_Placeholder, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+	glTextureParameteri(m_Placeholder, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_Placeholder, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_Placeholder, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(m_Placeholder, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	PTexture::SetPlaceholder(m_Placeholder);
+
+	glCreateBuffers(PTEXTURE_STREAMER_PIXEL_BUFFERS, m_PixelBuffers);
+
+	return true;
+}
+
+void PTextureStreamer::LoadAsync(const TShared<PTexture>& texture, const PString& fileName, const PString& path,
+	const PSTextureLoadOptions& options)
+{
+	texture->m_FileName = fileName;
+	texture->m_Path = path;
+	texture->m_Options = options;
+
+	m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+	TWeak<PTexture> weakTexture = texture;
+	TShared<PSDecodedImageQueue> decoded = m_Decoded;
+
+	PThreadPool::Get().Enqueue([weakTexture, decoded, path, options]()
+		{
+			PPROFILE_SCOPE("Texture Decode");
+
+			PSDecodedImage image;
+			image.texture = weakTexture;
+
+			// Skip the decode if nobody wants the texture any more
+			if (weakTexture.expired())
+			{
+				image.error = "Texture released before decoding";
+			}
+			else if (PCompressedTexture::IsCompressedPath(path))
+			{
+				// Compressed files are uploaded as they are, so reading and flipping them is the whole decode
+				image.compressed = TMakeShared<PSCompressedImage>();
+				if (!PCompressedTexture::Load(path, *image.compressed, options.flipVertically))
+				{
+					image.compressed = nullptr;
+					image.error = "Invalid compressed texture file";
+				}
+			}
+			else
+			{
+				// The flip setting is per thread, so concurrent decodes can't change each other's
+				stbi_set_flip_vertically_on_load_thread(options.flipVertically);
+
+				PFileData file;
+				const bool found = PFileSystem::Get().Open(path, file);
+				image.pixels = found ? stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()),
+					&image.width, &image.height, &image.channels, 0) : nullptr;
+
+				if (image.pixels == nullptr)
+				{
+					image.error = found ? stbi_failure_reason() : "file not found";
+				}
+				else if (image.channels > 4 || image.channels < 3)
+				{
+					image.error = "Incorrect number of channels, must have 3 or 4 channels";
+					stbi_image_free(image.pixels);
+					image.pixels = nullptr;
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(decoded->mutex);
+			decoded->images.push_back(std::move(image));
+		});
+}
+
+void PTextureStreamer::Update()
+{
+	PPROFILE_SCOPE("Texture Upload");
+
+	PUi64 frameBytes = 0;
+
+	while (true)
+	{
+		PSDecodedImage image;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Decoded->mutex);
+			if (m_Decoded->images.empty())
+				break;
+
+			// Leave the rest for the next frame once the budget is spent
+			const PUi64 bytes = m_Decoded->images.front().GetUploadBytes();
+			if (frameBytes > 0 && frameBytes + bytes > m_FrameBudget)
+			{
+				++m_Stats.deferredFrames;
+				break;
+			}
+
+			image = std::move(m_Decoded->images.front());
+			m_Decoded->images.pop_front();
+		}
+
+		m_Pending.fetch_sub(1, std::memory_order_relaxed);
+
+		const TShared<PTexture> texture = image.texture.lock();
+
+		if (image.pixels == nullptr && image.compressed == nullptr)
+		{
+			if (texture)
+			{
+				++m_Stats.failed;
+				PDebug::Log("Failed to load texture - " + texture->GetName() + ": " + image.error, LT_ERROR);
+			}
+
+			continue;
+		}
+
+		++m_Stats.decoded;
+
+		// The texture was released while it was decoding
+		if (!texture)
+		{
+			if (image.pixels)
+				stbi_image_free(image.pixels);
+			continue;
+		}
+
+		const PUi64 bytes = image.GetUploadBytes();
+		const bool uploaded = image.compressed ? UploadCompressed(*image.compressed, *texture) : Upload(image, *texture);
+
+		if (uploaded)
+		{
+			frameBytes += bytes;
+			++m_Stats.uploaded;
+			m_Stats.uploadedBytes += bytes;
+			PDebug::Log("Successfully streamed texture - " + texture->GetName(), LT_SUCCESS);
+		}
+
+		if (image.pixels)
+			stbi_image_free(image.pixels);
+	}
+}
+
+bool PTextureStreamer::Upload(PSDecodedImage& image, PTexture& texture)
+{
+	const PSTextureLoadOptions& options = texture.GetOptions();
+
+	const PUi32 pixelBuffer = FillPixelBuffer(image.pixels, image.GetUploadBytes());
+	if (pixelBuffer == 0)
+	{
+		PDebug::Log("Failed to map pixel buffer for texture - " + texture.GetName(), LT_ERROR);
+		return false;
+	}
+
+	// Immutable storage sized for the full mip chain
+	const GLsizei levels = options.generateMipmaps ?
+		static_cast<GLsizei>(std::floor(std::log2(std::max(image.width, image.height)))) + 1 : 1;
+
+	PUi32 textureID = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+	glTextureStorage2D(textureID, levels, image.channels == 4 ? GL_RGBA8 : GL_RGB8, image.width, image.height);
+
+	const GLint wrap = options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	const GLint filter = options.linearFilter ? GL_LINEAR : GL_NEAREST;
+	glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, wrap);
+	glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, wrap);
+	glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, filter);
+	glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, filter);
+
+	// Rows of 3 channel images aren't 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// The source is the bound unpack buffer, so the pointer is an offset into it
+	PGLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	glTextureSubImage2D(textureID, 0, 0, 0, image.width, image.height,
+		image.channels == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+	PGLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (options.generateMipmaps)
+		glGenerateTextureMipmap(textureID);
+
+	texture.m_ID = textureID;
+	texture.m_Width = image.width;
+	texture.m_Height = image.height;
+	texture.m_Channels = image.channels;
+	texture.UpdateMemory();
+
+	return true;
+}
+
+bool PTextureStreamer::UploadCompressed(const PSCompressedImage& image, PTexture& texture)
+{
+	const PSTextureLoadOptions& options = texture.GetOptions();
+
+	if (image.mips.empty() || image.GetGLFormat() == 0)
+	{
+		PDebug::Log("No supported image data in compressed texture - " + texture.GetName(), LT_ERROR);
+		return false;
+	}
+
+	const PUi32 pixelBuffer = FillPixelBuffer(image.data.data(), image.data.size());
+	if (pixelBuffer == 0)
+	{
+		PDebug::Log("Failed to map pixel buffer for texture - " + texture.GetName(), LT_ERROR);
+		return false;
+	}
+
+	const GLsizei levels = static_cast<GLsizei>(image.mips.size());
+
+	PUi32 textureID = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+	glTextureStorage2D(textureID, levels, image.GetGLFormat(), image.width, image.height);
+
+	const GLint wrap = options.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, wrap);
+	glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, wrap);
+	glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, options.linearFilter ?
+		(levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR) : (levels > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST));
+	glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, options.linearFilter ? GL_LINEAR : GL_NEAREST);
+
+	// Each level is read from its offset in the bound unpack buffer
+	PGLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	for (GLsizei level = 0; level < levels; ++level)
+	{
+		const PSCompressedMip& mip = image.mips[level];
+		glCompressedTextureSubImage2D(textureID, level, 0, 0, mip.width, mip.height, image.GetGLFormat(),
+			static_cast<GLsizei>(mip.size), reinterpret_cast<const void*>(static_cast<uintptr_t>(mip.offset)));
+	}
+	PGLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	texture.m_ID = textureID;
+	texture.m_Width = static_cast<int>(image.width);
+	texture.m_Height = static_cast<int>(image.height);
+	texture.m_Channels = 4;
+	texture.m_CompressedBytes = 0;
+	for (const PSCompressedMip& mip : image.mips)
+		texture.m_CompressedBytes += mip.size;
+	texture.UpdateMemory();
+
+	return true;
+}
+
+PUi32 PTextureStreamer::FillPixelBuffer(const void* data, const PUi64& size)
+{
+	// Orphan the next buffer so the copy never waits on an upload still reading it
+	// The new store also sizes the buffer for this image, so the map doesn't need to invalidate it again
+	const PUi32 pixelBuffer = m_PixelBuffers[m_NextPixelBuffer];
+	m_NextPixelBuffer = (m_NextPixelBuffer + 1) % PTEXTURE_STREAMER_PIXEL_BUFFERS;
+
+	glNamedBufferData(pixelBuffer, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+	void* mapped = glMapNamedBufferRange(pixelBuffer, 0, static_cast<GLsizeiptr>(size), GL_MAP_WRITE_BIT);
+
+	if (mapped == nullptr)
+		return 0;
+
+	std::memcpy(mapped, data, static_cast<size_t>(size));
+	glUnmapNamedBuffer(pixelBuffer);
+
+	return pixelBuffer;
+}
@@ -0,0 +1,85 @@
+// Internal headers
+#include "Graphics/PVertexLayout.h"
+
+// External libraries
+#include <GLEW/glew.h>
+
+// System libraries
+#include <cmath>
+
+static_assert(VC_UNSIGNED_BYTE == GL_UNSIGNED_BYTE && VC_SHORT == GL_SHORT && VC_FLOAT == GL_FLOAT &&
+	VC_HALF_FLOAT == GL_HALF_FLOAT, "PEVertexComponentType has to match the GL enums");
+
+PUi16 PVertexLayout::FloatToHalf(const float& value)
+{
+	PUi32 bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	const PUi16 sign = static_cast<PUi16>((bits >> 16) & 0x8000U);
+	const PUi32 magnitude = bits & 0x7FFFFFFFU;
+
+	// NaN stays NaN, anything at or past the rounding point of 65520 becomes the largest half
+	if (magnitude > 0x7F800000U)
+		return sign | 0x7E00U;
+	if (magnitude >= 0x477FF000U)
+		return sign | 0x7BFFU;
+
+	// Below the smallest normal half, shift the mantissa into a denormal with round to nearest even
+	if (magnitude < 0x38800000U)
+	{
+		const PUi32 shift = 126 - (magnitude >> 23);
+		if (shift > 25)
+			return sign;
+
+		const PUi32 mantissa = (magnitude & 0x007FFFFFU) | 0x00800000U;
+		const PUi32 half = mantissa >> shift;
+		const PUi32 remainder = mantissa & ((1U << shift) - 1);
+		const PUi32 midpoint = 1U << (shift - 1);
+
+		return sign | static_cast<PUi16>(half + (remainder > midpoint || (remainder == midpoint && (half & 1U))));
+	}
+
+	// Rebias the exponent and round the mantissa to 10 bits, a carry correctly bumps the exponent
+	const PUi32 rebiased = magnitude - 0x38000000U;
+	const PUi32 rounded = rebiased + 0x0FFFU + ((rebiased >> 13) & 1U);
+
+	return sign | static_cast<PUi16>(rounded >> 13);
+}
+
+void PVertexLayout::EncodeOctahedral(const float normal[3], int16_t outEncoded[2])
+{
+	const float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+	if (length <= 0.0f)
+	{
+		outEncoded[0] = outEncoded[1] = 0;
+		return;
+	}
+
+	// Project onto the octahedron, then fold the lower half over the upper one
+	float x = normal[0] / length;
+	float y = normal[1] / length;
+
+	if (normal[2] < 0.0f)
+	{
+		const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	outEncoded[0] = static_cast<int16_t>(std::lround(std::fmax(-1.0f, std::fmin(1.0f, x)) * 32767.0f));
+	outEncoded[1] = static_cast<int16_t>(std::lround(std::fmax(-1.0f, std::fmin(1.0f, y)) * 32767.0f));
+}
+
+void PVertexLayout::Encode(const PSVertexLayoutInfo& layout, const PSVertexData* vertices, const PUi64& count, PUi8* outVertices)
+{
+	// PSVertexData is already in the standard layout
+	if (layout == PStandardVertexLayout::GetInfo())
+	{
+		std::memcpy(outVertices, vertices, count * sizeof(PSVertexData));
+		return;
+	}
+
+	for (PUi64 i = 0; i < count; ++i)
+		layout.encode(vertices[i], outVertices + i * layout.stride);
+}
@@ -4,6 +4,7 @@
 #include "Debug/PDebug.h"
 #include "Listeners/PInput.h"
 #include "Graphics/PSCamera.h"
+#include "Debug/PProfiler.h"
 
 // External libraries
 #include <SDL/SDL.h>
@@ -16,6 +17,7 @@ PWindow::PWindow()
 	m_CameraRotation = glm::vec3(0.0f);
 	m_CanZoom = false;
 	m_InputMode = false;
+	m_FrameIndex = 0;
 
 	std::cout << "Window created" << std::endl;
 }
@@ -31,12 +33,31 @@ PWindow::~PWindow()
 
 bool PWindow::CreateWindow(const PSWindowParams& params)
 {
-	// Enable OpenGL in the SDL window
-	unsigned int windowFlags = SDL_WINDOW_OPENGL;
-
 	// Store window parameters
 	m_Params = params;
 
+	// Headless mode renders offscreen, so no SDL window is created
+	if (m_Params.headless)
+	{
+		m_GraphicsEngine = std::make_unique<PGraphicsEngine>();
+		if (!m_GraphicsEngine->InitHeadless(m_Params.w, m_Params.h))
+		{
+			PDebug::Log("Failed to initialize headless graphics engine", LT_ERROR);
+			m_GraphicsEngine = nullptr;
+			return false;
+		}
+
+		m_GraphicsEngine->SetTextureBudget(static_cast<PUi64>(m_Params.textureBudgetMB) * 1024 * 1024);
+
+		if (const auto& camRef = m_GraphicsEngine->GetCamera().lock())
+			m_CameraState = m_PrevCameraState = camRef->transform;
+
+		return true;
+	}
+
+	// Enable OpenGL in the SDL window
+	unsigned int windowFlags = SDL_WINDOW_OPENGL;
+
 	// Add high DPI flag if vsync is enabled
 	if (m_Params.vsync)
 		windowFlags += SDL_WINDOW_ALLOW_HIGHDPI;
@@ -74,6 +95,12 @@ bool PWindow::CreateWindow(const PSWindowParams& params)
 		return false;
 	}
 
+	m_GraphicsEngine->SetTextureBudget(static_cast<PUi64>(m_Params.textureBudgetMB) * 1024 * 1024);
+
+	// Start the simulation from the camera's initial transform
+	if (const auto& camRef = m_GraphicsEngine->GetCamera().lock())
+		m_CameraState = m_PrevCameraState = camRef->transform;
+
 	return true;
 }
 
@@ -133,8 +160,9 @@ void PWindow::RegisterInput(const TShared<PInput>& m_Input)
 	m_Input->OnMouseMove->Bind([this](const float& x, const float& y,
 		const float& xrel, const float& yrel)
 		{
-			m_CameraRotation.y = -xrel;
-			m_CameraRotation.x = -yrel;
+			// Mouse movement is a distance rather than a rate, so it adds up until the next tick uses it
+			m_CameraRotation.y += -xrel;
+			m_CameraRotation.x += -yrel;
 		});
 
 	// Bind mouse scroll events for zooming
@@ -172,21 +200,56 @@ void PWindow::RegisterInput(const TShared<PInput>& m_Input)
 		});
 }
 
-void PWindow::Render()
+void PWindow::Update(const float& deltaTime)
+{
+	if (!m_GraphicsEngine)
+		return;
+
+	if (const auto& camRef = m_GraphicsEngine->GetCamera().lock())
+	{
+		PPROFILE_SCOPE("Camera Update");
+
+		// Simulate from the last tick's state rather than the interpolated one that was rendered
+		camRef->transform = m_CameraState;
+		m_PrevCameraState = m_CameraState;
+
+		if (!m_InputMode)
+		{
+			// Translate and rotate the camera based on input
+			camRef->Translate(m_CameraDirection, deltaTime);
+			camRef->Rotate(m_CameraRotation, glm::abs(m_CameraRotation));
+		}
+
+		m_CameraRotation = glm::vec3(0.0f);
+		m_CameraState = camRef->transform;
+	}
+}
+
+void PWindow::Render(const float& alpha)
 {
 	// Render using the graphics engine if available
 	if (m_GraphicsEngine)
 	{
-		// Update the camera if available
+		// Draw the camera part way between the last two ticks so motion is smooth at any frame rate
 		if (const auto& camRef = m_GraphicsEngine->GetCamera().lock())
+			camRef->transform = PSTransform::Lerp(m_PrevCameraState, m_CameraState, alpha);
+
+		m_GraphicsEngine->Render(m_SDLWindow);
+
+		++m_FrameIndex;
+
+		if (m_Params.headless)
 		{
-			if (!m_InputMode)
+			// Save the frame if dumps are enabled
+			if (m_Params.dumpInterval > 0 && m_FrameIndex % m_Params.dumpInterval == 0)
 			{
-				// Translate and rotate the camera based on input
-				camRef->Translate(m_CameraDirection);
-				camRef->Rotate(m_CameraRotation, glm::abs(m_CameraRotation));
+				const PString path = m_Params.dumpDirectory + "/Frame_" + std::to_string(m_FrameIndex) + ".bmp";
+				m_GraphicsEngine->DumpFrame(path);
 			}
+
+			// Close once the requested number of frames has been rendered
+			if (m_Params.headlessFrames > 0 && m_FrameIndex >= m_Params.headlessFrames)
+				CloseWindow();
 		}
-		m_GraphicsEngine->Render(m_SDLWindow);
 	}
 }
@@ -0,0 +1,131 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Core/PMappedFile.h"
+
+// System libraries
+#include <atomic>
+#include <shared_mutex>
+
+class PPackFile;
+
+// Folder the asset cooker writes to, relative to the working directory
+#define PCOOKED_DIRECTORY "Cooked"
+
+// Class for the contents of a file opened through the file system
+// Loose files and raw pack entries are read in place from their mapping, compressed entries are decompressed into memory
+class PFileData
+{
+public:
+	PFileData() = default;
+	~PFileData() = default;
+
+	PFileData(const PFileData&) = delete;
+	PFileData& operator=(const PFileData&) = delete;
+
+	// Release the contents
+	void Close();
+
+	// Check if a file is open
+	bool IsOpen() const { return m_Open; }
+
+	// Get the file's bytes, null for empty files
+	const PUi8* GetData() const { return m_Data; }
+
+	// Get the size of the file in bytes
+	PUi64 GetSize() const { return m_Size; }
+
+private:
+	friend class PFileSystem;
+
+	// Mapping of a loose file
+	PMappedFile m_Mapping;
+
+	// Decompressed pack entry
+	TArray<PUi8> m_Buffer;
+
+	// Where the contents are, inside the mapping, a mounted pack or the buffer
+	const PUi8* m_Data = nullptr;
+	PUi64 m_Size = 0;
+
+	// True while a file is open
+	bool m_Open = false;
+};
+
+// Structure counting where the file system's reads came from
+struct PSFileSystemStats
+{
+	PUi64 looseReads = 0;       // Files read from disk
+	PUi64 packReads = 0;        // Files read from a mounted pack
+	PUi64 misses = 0;           // Files that weren't found anywhere
+	PUi64 storedBytes = 0;      // Bytes read from packs as they're stored
+	PUi64 extractedBytes = 0;   // Bytes the pack reads decompressed to
+};
+
+// Class for the virtual file system every engine asset is read through
+// Pack archives are mounted on the working directory, so a pack built from "Textures" answers "Textures/X.png".
+// Loose files on disk override packed ones while development overrides are on, so edited assets are
+// picked up without rebuilding the packs. Safe to read from any thread
+class PFileSystem
+{
+public:
+	// Get the engine's file system
+	static PFileSystem& Get();
+
+	// Mount a pack archive, packs mounted later take priority over earlier ones
+	bool Mount(const PString& packPath);
+
+	// Let loose files on disk override packed ones, on by default
+	void SetLooseFilesEnabled(const bool& enabled) { m_LooseFiles = enabled; }
+
+	// Check if loose files override packed ones
+	bool AreLooseFilesEnabled() const { return m_LooseFiles; }
+
+	// Open a file from disk or a mounted pack, false if it isn't found or can't be read
+	bool Open(const PString& path, PFileData& outFile);
+
+	// Read a whole file into a string
+	bool ReadText(const PString& path, PString& outText);
+
+	// Check if a file exists on disk or in a mounted pack
+	bool Exists(const PString& path);
+
+	// Load cooked assets in place of their sources when they exist, on by default
+	void SetCookedDataEnabled(const bool& enabled) { m_CookedData = enabled; }
+
+	// Get the cooked version of a source asset if cooked data is enabled and it exists, otherwise the path itself
+	// A loose source that's newer than its loose cooked file is returned instead, so stale cooked data is never loaded
+	PString ResolveCooked(const PString& path);
+
+	// Get where the cooker writes a source asset: images become DDS files and models become .pmesh files
+	// under PCOOKED_DIRECTORY, everything else keeps its name
+	static PString GetCookedPath(const PString& sourcePath);
+
+	// Get the read counters
+	PSFileSystemStats GetStats() const;
+
+	// Normalise a path the way packs name their entries: relative to the working directory,
+	// lower case and with forward slashes
+	static PString NormalisePath(const PString& path);
+
+private:
+	PFileSystem();
+	~PFileSystem();
+
+	// Mounted packs, in mount order
+	TArray<TUnique<PPackFile>> m_Packs;
+
+	// Guards the packs against a mount while reads are running
+	mutable std::shared_mutex m_Mutex;
+
+	// Loose files override packed ones
+	std::atomic<bool> m_LooseFiles;
+
+	// Cooked assets replace their sources
+	std::atomic<bool> m_CookedData;
+
+	// Read counters
+	std::atomic<PUi64> m_LooseReads, m_PackReads, m_Misses, m_StoredBytes, m_ExtractedBytes;
+
+	// Make a path relative to the working directory with forward slashes, keeping its case
+	static PString MakeRelative(const PString& path);
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include "EngineTypes.h"
+
+// System libraries
+#include <chrono>
+
+// Class that drives the main loop: fixed-step simulation ticks, render interpolation and an optional frame cap
+// Each frame call BeginFrame, run a tick while ShouldTick returns true, render with GetAlpha, then call LimitFrame
+class PFrameTimer
+{
+public:
+	PFrameTimer();
+
+	// Set how many simulation ticks run per second
+	void SetTickRate(const double& ticksPerSecond);
+
+	// Set the maximum frames per second, 0 removes the cap
+	void SetFrameCap(const double& framesPerSecond);
+
+	// Measure the time since the last frame and add it to the simulation backlog
+	void BeginFrame();
+
+	// Consume one tick from the backlog, returns false once the simulation has caught up
+	bool ShouldTick();
+
+	// Wait until the frame cap's target frame time has passed, sleeping first then spinning
+	void LimitFrame();
+
+	// Get the length of a simulation tick in seconds
+	float GetTickDelta() const { return static_cast<float>(m_TickDelta); }
+
+	// Get the measured length of the last frame in seconds
+	float GetFrameDelta() const { return static_cast<float>(m_FrameDelta); }
+
+	// Get how far the render falls between the last two ticks, from 0 to 1
+	float GetAlpha() const { return static_cast<float>(m_Accumulator / m_TickDelta); }
+
+	// Get the number of frames begun so far
+	PUi64 GetFrameCount() const { return m_FrameCount; }
+
+private:
+	typedef std::chrono::steady_clock PClock;
+
+	// Length of a simulation tick in seconds
+	double m_TickDelta;
+
+	// Target frame length in seconds, 0 when uncapped
+	double m_FrameCapDelta;
+
+	// Length of the last frame in seconds
+	double m_FrameDelta;
+
+	// Time not yet consumed by simulation ticks
+	double m_Accumulator;
+
+	// Start of the current frame
+	PClock::time_point m_FrameStart;
+
+	// Number of frames begun so far
+	PUi64 m_FrameCount;
+
+	// Running estimate of how long a 1ms sleep really takes, used to decide when to stop sleeping and spin
+	double m_SleepEstimate;
+	double m_SleepMean;
+	double m_SleepM2;
+	PUi64 m_SleepCount;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Enum for the type of a JSON value
+enum PEJsonType : PUi8
+{
+	JT_NULL = 0U,
+	JT_BOOL,
+	JT_NUMBER,
+	JT_STRING,
+	JT_ARRAY,
+	JT_OBJECT
+};
+
+// Structure for a parsed JSON value
+// Arrays keep their elements in values, objects keep their member names in keys with the matching values
+struct PSJsonValue
+{
+	PEJsonType type = JT_NULL;
+	bool boolean = false;
+	double number = 0.0;
+	PString string;
+	TArray<PString> keys;
+	TArray<PSJsonValue> values;
+
+	// Find a member of an object, null if it's missing or this isn't an object
+	const PSJsonValue* Find(const PString& key) const;
+
+	// Get the number of elements or members
+	size_t Size() const { return values.size(); }
+
+	// Get a member's value converted, or the fallback if it's missing or has another type
+	double GetNumber(const PString& key, const double& fallback = 0.0) const;
+	int GetInt(const PString& key, const int& fallback = 0) const;
+	PString GetString(const PString& key, const PString& fallback = "") const;
+};
+
+// Class for parsing JSON documents such as glTF files
+class PJson
+{
+public:
+	// Parse a whole document, error describes the first problem found
+	static bool Parse(const char* data, const size_t& size, PSJsonValue& outValue, PString* error = nullptr);
+};
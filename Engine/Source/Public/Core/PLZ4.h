@@ -0,0 +1,19 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Class for compressing data in the LZ4 block format
+// Blocks are compatible with LZ4_compress_default and LZ4_decompress_safe, without the frame header
+// Compression is a single greedy pass, decompression is fast enough to run on every asset read
+class PLZ4
+{
+public:
+	// Get the largest size compressing size bytes can produce
+	static PUi64 GetMaxCompressedSize(const PUi64& size);
+
+	// Compress a block, returns the compressed size or 0 if it didn't fit in destinationCapacity
+	static PUi64 Compress(const PUi8* source, const PUi64& sourceSize, PUi8* destination, const PUi64& destinationCapacity);
+
+	// Decompress a block that expands to exactly destinationSize bytes
+	// Corrupt input is rejected, it never reads or writes out of bounds
+	static bool Decompress(const PUi8* source, const PUi64& sourceSize, PUi8* destination, const PUi64& destinationSize);
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Class that maps a file into memory read-only, so it can be parsed or uploaded without copying it first
+// The mapping stays valid until the object is destroyed or Close is called
+class PMappedFile
+{
+public:
+	PMappedFile();
+	~PMappedFile();
+
+	PMappedFile(const PMappedFile&) = delete;
+	PMappedFile& operator=(const PMappedFile&) = delete;
+
+	// Map a whole file, false if it can't be opened
+	// Empty files open successfully with no data
+	bool Open(const PString& path);
+
+	// Unmap the file
+	void Close();
+
+	// Check if a file is mapped
+	bool IsOpen() const { return m_Open; }
+
+	// Get the mapped bytes, null for empty files
+	const PUi8* GetData() const { return m_Data; }
+
+	// Get the size of the file in bytes
+	PUi64 GetSize() const { return m_Size; }
+
+	// Get the path of the mapped file
+	const PString& GetPath() const { return m_Path; }
+
+private:
+	// Path of the mapped file
+	PString m_Path;
+
+	// Start and size of the mapping
+	const PUi8* m_Data;
+	PUi64 m_Size;
+
+	// True while a file is mapped
+	bool m_Open;
+
+	// Native file and mapping handles on Windows
+	void* m_FileHandle;
+	void* m_MappingHandle;
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Core/PMappedFile.h"
+
+// "PPAK" read as a little-endian integer
+#define PPACK_MAGIC 0x4B415050U
+
+// Bump whenever the layout of the file changes, older packs are rejected
+#define PPACK_VERSION 1
+
+// Alignment of every entry's data inside the pack, so stored files can be read in place
+#define PPACK_ALIGNMENT 16
+
+// Enum for how an entry's data is stored
+enum PEPackCompression : PUi32
+{
+	PC_NONE = 0U,
+	PC_LZ4
+};
+
+// Structure at the start of a pack file
+struct PSPackHeader
+{
+	PUi32 magic = PPACK_MAGIC;
+	PUi32 version = PPACK_VERSION;
+	PUi32 entryCount = 0;    // Entries in the table of contents
+	PUi32 reserved = 0;
+	PUi64 tocOffset = 0;     // Byte offset of the table of contents
+	PUi64 namesOffset = 0;   // Byte offset of the entry names
+	PUi64 namesBytes = 0;    // Size of the entry names
+};
+
+// Structure for one file in the table of contents, which is sorted by hash
+struct PSPackEntry
+{
+	PUi64 hash = 0;          // Hash of the normalised path
+	PUi64 offset = 0;        // Byte offset of the data, aligned to PPACK_ALIGNMENT
+	PUi64 storedSize = 0;    // Bytes stored in the pack
+	PUi64 size = 0;          // Bytes once decompressed
+	PUi32 nameOffset = 0;    // Offset of the path inside the names
+	PUi32 nameLength = 0;    // Length of the path
+	PUi32 compression = PC_NONE;
+	PUi32 reserved = 0;
+};
+
+static_assert(sizeof(PSPackHeader) == 40, "Pack header layout changed, bump PPACK_VERSION");
+static_assert(sizeof(PSPackEntry) == 48, "Pack entry layout changed, bump PPACK_VERSION");
+
+// Class for a memory-mapped pack archive
+// Entries are found by binary searching the hash of their normalised path in the table of contents
+class PPackFile
+{
+public:
+	PPackFile() = default;
+	~PPackFile() = default;
+
+	// Map a pack and validate its table of contents
+	bool Open(const PString& path);
+
+	// Find an entry by normalised path, null if the pack doesn't have it
+	const PSPackEntry* Find(const PString& normalisedPath) const;
+
+	// Get the bytes an entry stores, compressed or not
+	const PUi8* GetStoredData(const PSPackEntry& entry) const { return m_File.GetData() + entry.offset; }
+
+	// Decompress an entry into a buffer of entry.size bytes
+	bool Extract(const PSPackEntry& entry, PUi8* outData) const;
+
+	// Get the number of entries
+	PUi32 GetEntryCount() const { return m_Header ? m_Header->entryCount : 0; }
+
+	// Get the path the pack was mapped from
+	const PString& GetPath() const { return m_File.GetPath(); }
+
+	// Pack every file under a folder, entries are named by their path relative to the working directory
+	// Files are compressed with LZ4 across the thread pool and stored raw when that doesn't make them smaller
+	static bool Write(const PString& outputPath, const PString& folder, const bool& compress = true);
+
+	// Hash a normalised path the way the table of contents is sorted
+	static PUi64 HashPath(const PString& normalisedPath);
+
+private:
+	// Mapping of the pack
+	PMappedFile m_File;
+
+	// Header and table of contents inside the mapping, null if no pack is open
+	const PSPackHeader* m_Header = nullptr;
+	const PSPackEntry* m_Entries = nullptr;
+	const char* m_Names = nullptr;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include "EngineTypes.h"
+
+// System libraries
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+
+// Class that runs tasks on a fixed set of worker threads
+class PThreadPool
+{
+public:
+	// Create the pool with the given number of worker threads, 0 runs everything on the caller
+	explicit PThreadPool(const PUi32& workerCount);
+	~PThreadPool();
+
+	// Get the engine's shared pool, created on first use with one worker per spare core
+	static PThreadPool& Get();
+
+	// Get the number of worker threads
+	PUi32 GetWorkerCount() const { return static_cast<PUi32>(m_Workers.size()); }
+
+	// Queue a task to run on a worker thread
+	void Enqueue(std::function<void()> task);
+
+	// Run func(begin, end) over [0, count) split into batches of at least minBatchSize
+	// The calling thread works on batches too and the call returns once every batch is done
+	void ParallelFor(const PUi32& count, const PUi32& minBatchSize, const std::function<void(PUi32, PUi32)>& func);
+
+private:
+	// Loop run by every worker thread, pulling tasks until the pool is destroyed
+	void WorkerLoop();
+
+	// Worker threads
+	TArray<std::thread> m_Workers;
+
+	// Tasks waiting for a worker
+	std::queue<std::function<void()>> m_Tasks;
+
+	// Lock and signal guarding the task queue
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+
+	// Set when the pool is being destroyed
+	bool m_Stopping;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Enum for the kinds of resources memory is accounted for
+enum PEResourceType : PUi8
+{
+	RT_MESH = 0U,   // Mesh buffers and CPU copies, pooled meshes count their range of the pool
+	RT_MESH_POOL,   // Shared vertex and index buffers of mesh pools
+	RT_TEXTURE,     // Texture storage including mips
+	RT_BUFFER,      // Streaming and table buffers such as the ring buffer
+	RT_COUNT
+};
+
+// Structure for the memory held by every resource of a type
+struct PSResourceMemory
+{
+	PUi64 cpuBytes = 0;         // Bytes held in system memory
+	PUi64 gpuBytes = 0;         // Bytes of GPU storage allocated
+	PUi64 peakCpuBytes = 0;     // Highest cpuBytes since startup
+	PUi64 peakGpuBytes = 0;     // Highest gpuBytes since startup
+	PUi32 count = 0;            // Live resources
+};
+
+// Structure for the memory held by a single resource
+struct PSAssetMemory
+{
+	PString name;
+	PEResourceType type = RT_MESH;
+	PUi64 cpuBytes = 0;
+	PUi64 gpuBytes = 0;
+};
+
+// Class keeping a running account of the CPU and GPU memory engine resources hold
+// Resources register once, report their sizes whenever they change and unregister when destroyed,
+// so totals are always current and can be queried at any time. Safe to use from any thread
+class PMemoryTracker
+{
+public:
+	// Register a resource, the handle is used to report its sizes and is never 0
+	static PUi64 Register(const PEResourceType& type, const PString& name);
+
+	// Report the current sizes of a resource, ignored for handle 0
+	static void Update(const PUi64& handle, const PUi64& cpuBytes, const PUi64& gpuBytes);
+
+	// Rename a resource, such as a mesh named by the model that owns it
+	static void Rename(const PUi64& handle, const PString& name);
+
+	// Remove a resource and its sizes from the totals, ignored for handle 0
+	static void Unregister(const PUi64& handle);
+
+	// Get the totals of a type of resource
+	static PSResourceMemory GetTotals(const PEResourceType& type);
+
+	// Get the totals of every resource, peaks are the sums of the types' peaks
+	static PSResourceMemory GetTotals();
+
+	// Get every live resource, largest first
+	static TArray<PSAssetMemory> GetAssets();
+
+	// Get a readable name of a resource type
+	static const char* GetTypeName(const PEResourceType& type);
+
+	// Log the totals of every type and the largest resources
+	static void LogReport(const PUi32& maxAssets = 10);
+};
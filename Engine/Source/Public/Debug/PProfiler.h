@@ -0,0 +1,114 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Set to 0 to compile every profiler zone out of the engine
+#ifndef PPROFILER_ENABLED
+#define PPROFILER_ENABLED 1
+#endif
+
+// Maximum number of CPU zones kept per thread, older zones are overwritten
+#define PPROFILER_THREAD_CAPACITY 65536
+
+// Maximum number of GPU zones kept, newer zones are dropped once full
+#define PPROFILER_GPU_CAPACITY 65536
+
+// Frames between issuing a GPU timestamp and reading it back
+// Reading later than the GPU can possibly lag means the read never waits
+#define PPROFILER_GPU_LATENCY 4
+
+// Structure for a finished zone, times are nanoseconds since the profiler started
+struct PSProfilerZone
+{
+	const char* name = nullptr; // Name of the zone, must outlive the profiler
+	PUi64 begin = 0;            // Start time
+	PUi64 end = 0;              // End time
+};
+
+// Frame profiler recording CPU and GPU zones and exporting them as a Chrome trace
+// CPU zones can be recorded from any thread, each thread writes to its own buffer without locking
+// GPU zones use timestamp queries and are only valid on the thread that owns the GL context
+class PProfiler
+{
+public:
+	// Turn recording on or off, zones opened while disabled are ignored
+	static void SetEnabled(const bool& enabled);
+	static bool IsEnabled();
+
+	// Name the calling thread in the exported trace
+	static void SetThreadName(const PString& name);
+
+	// Create the GPU timestamp queries, needs a current GL context
+	static void InitGPU();
+
+	// Delete the GPU timestamp queries
+	static void ShutdownGPU();
+
+	// Mark the start of a frame and collect GPU zones from frames old enough to be finished
+	static void BeginFrame();
+
+	// Record a finished CPU zone on the calling thread
+	static void RecordCPUZone(const char* name, const PUi64& begin, const PUi64& end);
+
+	// Open a GPU zone, returns the zone's index or -1 if it isn't recorded
+	static int BeginGPUZone(const char* name);
+
+	// Close a GPU zone opened with BeginGPUZone
+	static void EndGPUZone(const int& zone);
+
+	// Get the current CPU time in nanoseconds since the profiler started
+	static PUi64 Now();
+
+	// Write every recorded zone to a Chrome/Perfetto trace JSON file
+	static bool ExportChromeTrace(const PString& path);
+};
+
+// Scoped CPU zone, records from construction to destruction
+class PProfileScope
+{
+public:
+	explicit PProfileScope(const char* name)
+		: m_Name(name), m_Active(PProfiler::IsEnabled()), m_Begin(m_Active ? PProfiler::Now() : 0) {}
+
+	~PProfileScope()
+	{
+		if (m_Active)
+			PProfiler::RecordCPUZone(m_Name, m_Begin, PProfiler::Now());
+	}
+
+private:
+	// Name of the zone
+	const char* m_Name;
+
+	// Set if the profiler was enabled when the zone opened
+	bool m_Active;
+
+	// Start time
+	PUi64 m_Begin;
+};
+
+// Scoped GPU zone, times the GL commands issued from construction to destruction
+class PProfileGPUScope
+{
+public:
+	explicit PProfileGPUScope(const char* name)
+		: m_Zone(PProfiler::BeginGPUZone(name)) {}
+
+	~PProfileGPUScope() { PProfiler::EndGPUZone(m_Zone); }
+
+private:
+	// Index of the zone
+	int m_Zone;
+};
+
+#define PPROFILE_CONCAT_INNER(a, b) a##b
+#define PPROFILE_CONCAT(a, b) PPROFILE_CONCAT_INNER(a, b)
+
+#if PPROFILER_ENABLED
+// Profile the rest of the enclosing scope on the CPU
+#define PPROFILE_SCOPE(name) PProfileScope PPROFILE_CONCAT(profileScope, __LINE__)(name)
+// Profile the GL commands issued in the rest of the enclosing scope
+#define PPROFILE_GPU_SCOPE(name) PProfileGPUScope PPROFILE_CONCAT(profileGPUScope, __LINE__)(name)
+#else
+#define PPROFILE_SCOPE(name)
+#define PPROFILE_GPU_SCOPE(name)
+#endif
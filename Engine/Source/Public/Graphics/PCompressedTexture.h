@@ -0,0 +1,68 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Enum for the block-compressed formats the engine can load and encode
+enum PECompressedFormat : PUi8
+{
+	CF_BC1 = 0U, // RGB, 8 bytes per 4x4 block
+	CF_BC3,      // RGBA, BC1 colour plus a BC4 alpha block, 16 bytes per block
+	CF_BC5,      // Two channels such as normal map XY, two BC4 blocks, 16 bytes per block
+	CF_BC7,      // High quality RGBA, 16 bytes per block
+	CF_UNKNOWN
+};
+
+// Structure for one mip level inside a compressed image's data
+struct PSCompressedMip
+{
+	PUi64 offset = 0;   // Byte offset into the image data
+	PUi64 size = 0;     // Size of the level in bytes
+	PUi32 width = 0;    // Width of the level in pixels
+	PUi32 height = 0;   // Height of the level in pixels
+};
+
+// Structure for a block-compressed image with its mip chain, ready to upload as is
+struct PSCompressedImage
+{
+	PECompressedFormat format = CF_UNKNOWN;
+	bool srgb = false;
+	PUi32 width = 0, height = 0;
+	TArray<PSCompressedMip> mips;
+	TArray<PUi8> data;
+
+	// Get the OpenGL internal format for the image
+	PUi32 GetGLFormat() const;
+};
+
+// Class for reading and writing pre-compressed KTX2 and DDS texture files
+class PCompressedTexture
+{
+public:
+	// Check if a path has a compressed texture extension (.dds or .ktx2)
+	static bool IsCompressedPath(const PString& path);
+
+	// Load a .dds or .ktx2 file based on its extension, optionally flipping it so the first row is the bottom
+	static bool Load(const PString& path, PSCompressedImage& outImage, const bool& flipVertically);
+
+	// Load a DDS file with a BC1/BC3/BC5/BC7 format, legacy FourCC and DX10 headers are both supported
+	static bool LoadDDS(const PString& path, PSCompressedImage& outImage);
+
+	// Load a KTX2 file with a BC1/BC3/BC5/BC7 format, supercompressed files aren't supported
+	static bool LoadKTX2(const PString& path, PSCompressedImage& outImage);
+
+	// Flip an image so its first row is the bottom, which is what OpenGL expects, files store the top row first
+	// Levels with a partial block row at the bottom are dropped, returns false and leaves the image as it is
+	// if nothing can be flipped exactly, which includes BC7 blocks in any mode but 6
+	static bool FlipVertically(PSCompressedImage& image);
+
+	// Save an image as a DDS file with a DX10 header
+	static bool SaveDDS(const PString& path, const PSCompressedImage& image);
+
+	// Get the bytes per 4x4 block of a format
+	static PUi32 GetBlockSize(const PECompressedFormat& format);
+
+	// Get the size of a level of a format in bytes
+	static PUi64 GetLevelSize(const PECompressedFormat& format, const PUi32& width, const PUi32& height);
+
+	// Read a format name such as "bc7", returns CF_UNKNOWN if it isn't recognised
+	static PECompressedFormat FormatFromName(const PString& name);
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Core/PFileSystem.h"
+#include "Graphics/PVertexLayout.h"
+
+struct PSImportedMesh;
+
+// "PMSH" read as a little-endian integer
+#define PCOOKED_MESH_MAGIC 0x48534D50U
+
+// Bump whenever the layout of the file changes, older files are rejected
+#define PCOOKED_MESH_VERSION 1
+
+// Alignment of the vertex and index blobs inside the file
+#define PCOOKED_MESH_ALIGNMENT 256
+
+// Most vertex attributes a cooked mesh can describe
+#define PCOOKED_MESH_MAX_ATTRIBUTES 8
+
+// Longest submesh name, including the terminator
+#define PCOOKED_MESH_NAME_SIZE 32
+
+// Structure at the start of a .pmesh file
+// Every field is fixed size and little-endian so the file is read in place
+struct PSCookedMeshHeader
+{
+	PUi32 magic = PCOOKED_MESH_MAGIC;
+	PUi32 version = PCOOKED_MESH_VERSION;
+	PUi32 headerSize = 0;       // sizeof(PSCookedMeshHeader) when written
+	PUi32 vertexStride = 0;     // Bytes per vertex
+	PUi32 indexSize = 0;        // Bytes per index, 2 or 4
+	PUi32 attributeCount = 0;   // Used entries of attributes
+	PUi32 submeshCount = 0;     // Entries in the submesh table
+	PUi32 reserved = 0;
+	PUi64 submeshOffset = 0;    // Byte offset of the submesh table
+	PUi64 vertexOffset = 0;     // Byte offset of the vertex blob, aligned to PCOOKED_MESH_ALIGNMENT
+	PUi64 vertexBytes = 0;      // Size of the vertex blob
+	PUi64 indexOffset = 0;      // Byte offset of the index blob, aligned to PCOOKED_MESH_ALIGNMENT
+	PUi64 indexBytes = 0;       // Size of the index blob
+	float boundsMin[3] = { 0.0f, 0.0f, 0.0f };  // Bounding box of every submesh
+	float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+	PSVertexAttribute attributes[PCOOKED_MESH_MAX_ATTRIBUTES];
+};
+
+// Structure for one entry of the submesh table
+// Submeshes share the vertex and index blobs, their indices are relative to baseVertex
+struct PSCookedSubmesh
+{
+	PUi32 firstIndex = 0;       // First index of the submesh in the index blob
+	PUi32 indexCount = 0;       // Number of indices of the submesh
+	PUi32 baseVertex = 0;       // First vertex of the submesh in the vertex blob
+	PUi32 vertexCount = 0;      // Number of vertices of the submesh
+	float boundingSphere[4] = { 0.0f, 0.0f, 0.0f, 0.0f };  // Local space (center.xyz, radius)
+	char name[PCOOKED_MESH_NAME_SIZE] = {};
+};
+
+static_assert(sizeof(PSCookedMeshHeader) == 256, "Cooked mesh header layout changed, bump PCOOKED_MESH_VERSION");
+static_assert(sizeof(PSCookedSubmesh) == 64, "Cooked submesh layout changed, bump PCOOKED_MESH_VERSION");
+
+// Class for the cooked binary mesh format (.pmesh)
+// Cooked files hold GPU-ready vertex and index blobs, so loading is a memory map and a validation of the header
+// and the blobs are handed to the GPU straight from the mapping. Models are cooked offline from OBJ or glTF
+class PCookedMesh
+{
+public:
+	PCookedMesh() = default;
+	~PCookedMesh() = default;
+
+	// Open a cooked mesh file through the file system and validate its header and submesh table
+	bool Open(const PString& path);
+
+	// Unmap the file
+	void Close() { m_File.Close(); m_Header = nullptr; m_Submeshes = nullptr; }
+
+	// Check if a valid file is open
+	bool IsOpen() const { return m_Header != nullptr; }
+
+	// Get the header of the open file
+	const PSCookedMeshHeader& GetHeader() const { return *m_Header; }
+
+	// Get the number of submeshes
+	PUi32 GetSubmeshCount() const { return m_Header ? m_Header->submeshCount : 0; }
+
+	// Get a submesh table entry
+	const PSCookedSubmesh& GetSubmesh(const PUi32& index) const { return m_Submeshes[index]; }
+
+	// Get the mapped vertex blob
+	const PUi8* GetVertexData() const { return m_File.GetData() + m_Header->vertexOffset; }
+
+	// Get the mapped index blob
+	const PUi8* GetIndexData() const { return m_File.GetData() + m_Header->indexOffset; }
+
+	// Check if the file's vertices are stored in the given layout
+	bool HasVertexLayout(const PSVertexLayoutInfo& layout) const;
+
+	// Write meshes as a cooked file with the vertices encoded in the given layout
+	// Indices are written in 16 bits if every submesh has few enough vertices, otherwise 32
+	static bool Write(const PString& path, const TArray<PSImportedMesh>& meshes,
+		const PSVertexLayoutInfo& layout = PStandardVertexLayout::GetInfo());
+
+	// Import an OBJ or glTF model, optimize its meshes with PMeshOptimizer and write it as a cooked file
+	static bool Cook(const PString& sourcePath, const PString& outputPath,
+		const PSVertexLayoutInfo& layout = PStandardVertexLayout::GetInfo());
+
+private:
+	// Contents of the open file, mapped from disk or read from a pack
+	PFileData m_File;
+
+	// Header and submesh table inside the mapping, null if no file is open
+	const PSCookedMeshHeader* m_Header = nullptr;
+	const PSCookedSubmesh* m_Submeshes = nullptr;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Class for an offscreen render target with a colour texture and a depth buffer
+class PFrameBuffer
+{
+public:
+	PFrameBuffer();
+	~PFrameBuffer();
+
+	// Create the framebuffer and its attachments
+	bool Create(const PUi32& width, const PUi32& height);
+
+	// Bind the framebuffer for drawing and set the viewport to its size
+	void Bind();
+
+	// Read the colour attachment as tightly packed RGBA8 rows, bottom row first
+	void ReadPixels(TArray<PUi8>& outPixels) const;
+
+	// Save the colour attachment as a BMP image
+	bool SaveToBMP(const PString& path) const;
+
+	// Get the width of the framebuffer
+	PUi32 GetWidth() const { return m_Width; }
+
+	// Get the height of the framebuffer
+	PUi32 GetHeight() const { return m_Height; }
+
+private:
+	// OpenGL IDs for the framebuffer, colour texture and depth renderbuffer
+	PUi32 m_ID;
+	PUi32 m_ColourTexture;
+	PUi32 m_DepthBuffer;
+
+	// Size of the attachments
+	PUi32 m_Width, m_Height;
+};
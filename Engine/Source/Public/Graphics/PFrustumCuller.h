@@ -0,0 +1,54 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Math/PSFrustum.h"
+
+// Structure holding bounding spheres in structure-of-arrays layout so they can be tested in SIMD batches
+struct PSBoundingSpheres
+{
+	// Add a sphere
+	void Add(const glm::vec3& center, const float& sphereRadius)
+	{
+		x.push_back(center.x);
+		y.push_back(center.y);
+		z.push_back(center.z);
+		radius.push_back(sphereRadius);
+	}
+
+	// Remove every sphere, keeping the memory
+	void Clear()
+	{
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	// Reserve memory for a number of spheres
+	void Reserve(const size_t& count)
+	{
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+		radius.reserve(count);
+	}
+
+	// Get the number of spheres
+	PUi32 Size() const { return static_cast<PUi32>(radius.size()); }
+
+	TArray<float> x, y, z;  // Sphere centers
+	TArray<float> radius;   // Sphere radii
+};
+
+// Class for testing bounding volumes against a camera frustum
+class PFrustumCuller
+{
+public:
+	// Append the indices of the spheres that intersect the frustum to outVisible, in ascending order
+	// Spheres are tested 8 (AVX) or 4 (SSE) at a time and large sets are split across the thread pool
+	static void Cull(const PSFrustum& frustum, const PSBoundingSpheres& spheres, TArray<PUi32>& outVisible);
+
+private:
+	// Test the spheres in [begin, end) on the calling thread
+	static void CullRange(const PSFrustum& frustum, const PSBoundingSpheres& spheres,
+		const PUi32& begin, const PUi32& end, TArray<PUi32>& outVisible);
+};
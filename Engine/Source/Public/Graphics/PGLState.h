@@ -0,0 +1,71 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Maximum number of texture units tracked by the state cache
+#define PGL_MAX_TEXTURE_UNITS 32
+
+// Maximum number of uniform and storage buffer binding points tracked by the state cache
+#define PGL_MAX_BUFFER_BINDINGS 16
+
+// Structure counting the state calls that reached OpenGL and the ones that were skipped
+struct PSGLStateStats
+{
+	PUi64 issued = 0;   // Calls forwarded to OpenGL
+	PUi64 skipped = 0;  // Calls dropped because the state was already set
+};
+
+// Central tracker of the bound OpenGL state
+// Every graphics class binds through here so redundant calls never reach the driver
+// Only valid on the thread that owns the GL context
+class PGLState
+{
+public:
+	// Bind a shader program
+	static void UseProgram(const PUi32& program);
+
+	// Bind a vertex array object
+	static void BindVertexArray(const PUi32& vao);
+
+	// Bind a buffer to a non-indexed target such as GL_ARRAY_BUFFER
+	static void BindBuffer(const PUi32& target, const PUi32& buffer);
+
+	// Bind a range of a buffer to an indexed target such as GL_UNIFORM_BUFFER
+	static void BindBufferRange(const PUi32& target, const PUi32& index, const PUi32& buffer,
+		const PUi64& offset, const PUi64& size);
+
+	// Bind a texture to a texture unit
+	static void BindTexture(const PUi32& unit, const PUi32& texture);
+
+	// Enable or disable depth testing
+	static void SetDepthTest(const bool& enable);
+
+	// Enable or disable writing to the depth buffer
+	static void SetDepthWrite(const bool& enable);
+
+	// Set the depth comparison function
+	static void SetDepthFunc(const PUi32& func);
+
+	// Enable or disable blending
+	static void SetBlend(const bool& enable);
+
+	// Set the source and destination blend factors
+	static void SetBlendFunc(const PUi32& srcFactor, const PUi32& dstFactor);
+
+	// Enable or disable back face culling
+	static void SetCullFace(const bool& enable);
+
+	// Forget a deleted object so a new object reusing the ID is bound again
+	static void OnProgramDeleted(const PUi32& program);
+	static void OnVertexArrayDeleted(const PUi32& vao);
+	static void OnBufferDeleted(const PUi32& buffer);
+	static void OnTextureDeleted(const PUi32& texture);
+
+	// Forget all cached state, call after OpenGL was used without going through the cache
+	static void Invalidate();
+
+	// Get the number of calls issued and skipped since the last reset
+	static const PSGLStateStats& GetStats();
+
+	// Reset the call counters
+	static void ResetStats();
+};
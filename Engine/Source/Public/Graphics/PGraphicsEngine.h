@@ -4,30 +4,104 @@
 typedef void* SDL_GLContext;
 struct SDL_Window;
 class PShaderProgram;
+class PRenderQueue;
+class PRingBuffer;
+class PMeshPool;
+class PHeadlessContext;
+class PFrameBuffer;
+class PTextureRegistry;
+class PTextureStreamer;
+class PMaterialTable;
+class PMipStreamer;
+class PShaderWatcher;
 struct PSCamera;
 
+// Enum for where the graphics engine presents its frames
+enum PEGraphicsBackend : PUi8
+{
+	GB_WINDOW = 0U, // Draw to the SDL window's back buffer and swap
+	GB_HEADLESS     // Draw to an offscreen framebuffer without a window
+};
+
 class PGraphicsEngine
 {
 public:
-	PGraphicsEngine() = default;
-	~PGraphicsEngine() = default;
+	PGraphicsEngine();
+	~PGraphicsEngine();
 
 	// Initialize the graphics engine with an SDL window and vsync option
 	bool InitEngine(SDL_Window* sdlWindow, const bool& vsync);
 
+	// Initialize the graphics engine without a window, rendering into an offscreen framebuffer
+	bool InitHeadless(const PUi32& width, const PUi32& height);
+
 	// Render the current frame
 	void Render(SDL_Window* sdlWindow);
 
+	// Save the last rendered frame as a BMP image, only supported by the headless backend
+	bool DumpFrame(const PString& path) const;
+
+	// Get the backend the engine was initialized with
+	PEGraphicsBackend GetBackend() const { return m_Backend; }
+
 	// Get a weak pointer to the camera
 	TWeak<PSCamera> GetCamera() { return m_Camera; }
 
+	// Get the registry textures should be loaded through
+	TWeak<PTextureRegistry> GetTextureRegistry() { return m_TextureRegistry; }
+
+	// Set the GPU memory streamed texture mips are kept under
+	void SetTextureBudget(const PUi64& bytes);
+
 private:
 	// OpenGL context for the SDL window
 	SDL_GLContext m_SDLGLContext;
 
+	// Backend the engine was initialized with
+	PEGraphicsBackend m_Backend;
+
+	// Windowless OpenGL context used by the headless backend
+	TUnique<PHeadlessContext> m_HeadlessContext;
+
+	// Offscreen render target used by the headless backend
+	TUnique<PFrameBuffer> m_FrameBuffer;
+
 	// Shader program used by the engine
 	TShared<PShaderProgram> m_Shader;
 
+	// Shader program used for hardware-instanced models
+	TShared<PShaderProgram> m_InstancedShader;
+
+	// Shader program used for pooled meshes drawn with multi-draw indirect
+	TShared<PShaderProgram> m_IndirectShader;
+
+	// Shared vertex/index storage for static meshes
+	TShared<PMeshPool> m_MeshPool;
+
+	// Queue the frame's draws are submitted to and sorted in
+	TUnique<PRenderQueue> m_RenderQueue;
+
+	// Ring buffer for data streamed to the GPU every frame
+	TShared<PRingBuffer> m_DynamicBuffer;
+
 	// Camera used by the engine
 	TShared<PSCamera> m_Camera;
+
+	// Shared textures by path, so each image is only loaded once
+	TShared<PTextureRegistry> m_TextureRegistry;
+
+	// Background texture loader, uploads a limited amount each frame
+	TShared<PTextureStreamer> m_TextureStreamer;
+
+	// Texture of every material, read by the shader so draws aren't split by texture
+	TShared<PMaterialTable> m_MaterialTable;
+
+	// Keeps only the mip levels visible textures need resident, under a memory budget
+	TShared<PMipStreamer> m_MipStreamer;
+
+	// Recompiles the engine's shaders when their files are saved
+	TUnique<PShaderWatcher> m_ShaderWatcher;
+
+	// Initialize GLEW and create the engine's resources once a context is current
+	bool InitResources();
 };
@@ -0,0 +1,42 @@
+#pragma once
+#include "EngineTypes.h"
+
+typedef void* SDL_GLContext;
+struct SDL_Window;
+
+// Class that creates an OpenGL context without a visible window
+// On Linux this is an EGL surfaceless context, so it works on machines with no display,
+// such as build boxes running Mesa llvmpipe. Elsewhere it falls back to a hidden SDL window
+class PHeadlessContext
+{
+public:
+	PHeadlessContext();
+	~PHeadlessContext();
+
+	// Create the context and make it current
+	bool Create();
+
+	// Destroy the context
+	void Destroy();
+
+	// Get a readable name of the API the context was created with
+	PString GetBackendName() const { return m_BackendName; }
+
+private:
+	// EGL display, context and the native handles as opaque pointers
+	void* m_EGLDisplay;
+	void* m_EGLContext;
+
+	// Hidden SDL window and context used when EGL isn't available
+	SDL_Window* m_SDLWindow;
+	SDL_GLContext m_SDLGLContext;
+
+	// Readable name of the backend that created the context
+	PString m_BackendName;
+
+	// Try to create an EGL surfaceless context
+	bool CreateEGLContext();
+
+	// Create a context on a hidden SDL window
+	bool CreateSDLContext();
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PTextureArrayAllocator.h"
+
+// System libraries
+#include <unordered_map>
+
+class PTexture;
+
+// Shader storage binding point the material table is bound to
+#define PMATERIAL_TABLE_BINDING 1
+
+// Index returned when a material can't be added
+#define PMATERIAL_INVALID 0xFFFFFFFFU
+
+// Enum for how materials reach the shader
+enum PEMaterialMode : PUi8
+{
+	MM_TEXTURE_ARRAY = 0U, // Textures are packed into arrays, draws sharing an array can be batched
+	MM_BINDLESS            // Every texture is a resident bindless handle, any draws can be batched
+};
+
+// Structure matching the std430 material entry read by the shader
+struct PSMaterialData
+{
+	PUi64 handle = 0;    // Bindless texture handle, 0 in texture array mode
+	PUi32 layer = 0;     // Layer of the bound texture array, unused in bindless mode
+	PUi32 padding = 0;   // Pad to the std430 struct alignment
+};
+
+// Class that gives every texture a material index the shader can look up per draw,
+// so meshes with different textures no longer have to be split into separate draws
+// With ARB_bindless_texture each entry holds a texture handle, otherwise textures are packed
+// into texture arrays and the entry holds the layer
+class PMaterialTable
+{
+public:
+	PMaterialTable();
+	~PMaterialTable();
+
+	// Create the material buffer with room for maxMaterials entries
+	// Bindless handles are used when the driver supports them, unless forceTextureArrays is set
+	bool Init(const PUi32& maxMaterials = 4096, const bool& forceTextureArrays = false);
+
+	// Get the material index of a texture, adding it if it's new
+	// Textures that aren't resident yet show the placeholder until Update finds them uploaded
+	// Every call must be paired with a RemoveMaterial once the material isn't drawn anymore
+	PUi32 AddMaterial(const TShared<PTexture>& texture);
+
+	// Release a material added with AddMaterial, the last release frees its array layer or bindless handle
+	// and the index can be handed out again
+	void RemoveMaterial(const PUi32& material);
+
+	// Resolve materials whose textures became resident and upload the changed entries, call once per frame
+	void Update();
+
+	// Get the texture a draw of the material needs bound on unit 0, 0 in bindless mode
+	// Draws can only be batched together when this matches
+	PUi32 GetBindTexture(const PUi32& material) const;
+
+	// Bind the material buffer and the texture the material needs
+	void Bind(const PUi32& material) const;
+
+	// Get how materials reach the shader
+	PEMaterialMode GetMode() const { return m_Mode; }
+
+	// Get the number of materials in use
+	PUi32 GetMaterialCount() const { return static_cast<PUi32>(m_Materials.size() - m_FreeMaterials.size()); }
+
+	// Get the number of materials still waiting for their texture
+	PUi32 GetPendingCount() const { return m_PendingCount; }
+
+	// Get the texture arrays materials are packed into
+	const PTextureArrayAllocator& GetArrayAllocator() const { return m_ArrayAllocator; }
+
+private:
+	// Structure for a material and the texture it was created from
+	struct PSMaterial
+	{
+		TShared<PTexture> texture;           // Kept until the material is resolved, and for its lifetime when bindless
+		TWeak<PTexture> source;              // Texture the material was added for, to detect a reused address
+		const PTexture* address = nullptr;   // Key of the material in m_Lookup
+		PSTextureArraySlot slot;             // Array layer holding the texture in texture array mode
+		PUi32 users = 0;                     // AddMaterial calls not yet matched by RemoveMaterial
+		bool resolved = false;               // True once the entry points at the real texture
+	};
+
+	// How materials reach the shader
+	PEMaterialMode m_Mode;
+
+	// Materials in index order and their GPU entries
+	TArray<PSMaterial> m_Materials;
+	TArray<PSMaterialData> m_Data;
+
+	// Material index of each texture added
+	std::unordered_map<const PTexture*, PUi32> m_Lookup;
+
+	// Indices of removed materials, reused before the table grows
+	TArray<PUi32> m_FreeMaterials;
+
+	// Storage buffer holding the entries
+	PUi32 m_Buffer;
+
+	// Capacity of the storage buffer
+	PUi32 m_MaxMaterials;
+
+	// Range of entries changed since the last upload
+	PUi32 m_DirtyBegin;
+	PUi32 m_DirtyEnd;
+
+	// Number of materials waiting for their texture
+	PUi32 m_PendingCount;
+
+	// Packs textures into arrays in texture array mode
+	PTextureArrayAllocator m_ArrayAllocator;
+
+	// Texture shown by materials that aren't resolved yet
+	// A single layer array in texture array mode, a 2D texture with a resident handle in bindless mode
+	PUi32 m_PlaceholderTexture;
+	PUi64 m_PlaceholderHandle;
+
+	// Handle of the storage buffer in the memory tracker
+	PUi64 m_MemoryHandle;
+
+	// Point a material's entry at its texture, false if the texture isn't resident yet
+	bool Resolve(const PUi32& material);
+
+	// Mark an entry to be uploaded by the next Update
+	void MarkDirty(const PUi32& material);
+};
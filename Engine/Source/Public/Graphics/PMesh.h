@@ -1,18 +1,15 @@
 #pragma once
 #include "EngineTypes.h"
+#include "Graphics/PMeshPool.h"
+#include "Graphics/PVertexLayout.h"
+
+// External libraries
+#include <GLM/glm.hpp>
 
 class PShaderProgram;
 struct PSTransform;
 class PTexture;
-
-// Structure for storing vertex data
-struct PSVertexData
-{
-	float m_Position[3] = { 0.0f, 0.0f, 0.0f }; // Position of the vertex
-	float m_Colour[3] = { 1.0f, 1.0f, 1.0f };   // Colour of the vertex
-	float m_TexCoords[2] = { 0.0f, 0.0f };      // Texture coordinates
-	float m_Normal[3] = { 0.0f, 0.0f, 0.0f };   // Normal vector for lighting
-};
+class PCookedMesh;
 
 // Class for managing a mesh
 class PMesh
@@ -24,19 +21,117 @@ public:
 	// Create a mesh using vertex and index data
 	bool CreateMesh(const std::vector<PSVertexData>& vertices, const std::vector<uint32_t>& indices);
 
+	// Create a mesh with its vertices encoded in a layout such as PCompactVertexLayout
+	// Indices are stored in 16 bits when the mesh has few enough vertices
+	bool CreateMesh(const std::vector<PSVertexData>& vertices, const std::vector<uint32_t>& indices,
+		const PSVertexLayoutInfo& layout);
+
+	// Create a static mesh inside a shared mesh pool so it can be drawn with other pooled meshes
+	// in one multi-draw call. Pooled meshes have no instance buffer
+	bool CreateMesh(const std::vector<PSVertexData>& vertices, const std::vector<uint32_t>& indices,
+		const TShared<PMeshPool>& pool);
+
+	// Create a mesh from a submesh of a cooked mesh file
+	// The mapped vertex and index ranges are uploaded straight from the file without copying them first
+	// If a pool is given and the file uses the pool's vertex layout, the mesh is stored in the pool
+	bool CreateMesh(const PCookedMesh& cookedMesh, const PUi32& submesh, const TShared<PMeshPool>& pool = nullptr);
+
 	// Render the mesh with a given shader and transform
 	void Render(const std::shared_ptr<PShaderProgram>& shader, const PSTransform& transform);
 
+	// Stream the per-instance model matrices used by RenderInstanced
+	void SetInstances(const TArray<glm::mat4>& instanceMatrices);
+
+	// Read the instance matrices from memory owned elsewhere, such as a ring buffer allocation
+	// The buffer must hold instanceCount tightly packed mat4s starting at offset
+	void SetInstanceBuffer(const PUi32& buffer, const PUi32& offset, const PUi32& instanceCount);
+
+	// Render every registered instance of the mesh in a single draw call
+	// The shader must read the model matrix from the instance attribute
+	void RenderInstanced(const std::shared_ptr<PShaderProgram>& shader);
+
+	// Bind the VAO and draw the mesh, the caller sets up shader and texture state
+	void Draw();
+
+	// Bind the VAO and draw every registered instance
+	void DrawInstanced();
+
+	// Get the number of instances registered for the mesh
+	PUi32 GetInstanceCount() const { return m_InstanceCount; }
+
 	// Set the texture for the mesh
 	void SetTexture(const TShared<PTexture>& texture) { m_Texture = texture; }
 
+	// Get the texture for the mesh
+	const TShared<PTexture>& GetTexture() const { return m_Texture; }
+
+	// Set the material table entry of the mesh's texture, batched draws select the texture with it
+	void SetMaterial(const PUi32& material) { m_Material = material; }
+
+	// Get the material table entry of the mesh's texture, PMATERIAL_INVALID if it has none
+	PUi32 GetMaterial() const { return m_Material; }
+
+	// Get the ID of the Vertex Array Object
+	uint32_t GetVAO() const { return m_VAO; }
+
+	// Get the local space bounding sphere of the mesh as (center.xyz, radius)
+	glm::vec4 GetBoundingSphere() const { return m_BoundingSphere; }
+
+	// Get the pool the mesh lives in, null if it owns its buffers
+	PMeshPool* GetPool() const { return m_Pool.get(); }
+
+	// Get the location of the mesh inside its pool
+	const PSMeshPoolRange& GetPoolRange() const { return m_PoolRange; }
+
+	// Keep the vertices and indices in memory after upload for CPU access such as picking or physics
+	// Off by default, the copies are released once the GPU has them. Set before creating the mesh
+	void SetCPUAccess(const bool& keepCPUData) { m_KeepCPUData = keepCPUData; }
+
+	// Check if the CPU copies of the vertices and indices are kept
+	bool HasCPUData() const { return m_KeepCPUData; }
+
+	// Get the CPU copy of the vertices, empty unless CPU access was set
+	const std::vector<PSVertexData>& GetVertices() const { return m_Vertices; }
+
+	// Get the CPU copy of the indices, empty unless CPU access was set
+	const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+
+	// Name the mesh in the memory report
+	void SetName(const PString& name);
+
 private:
-	// Store the vertices of the mesh
+	// CPU copy of the vertices, released after upload unless m_KeepCPUData is set
 	std::vector<PSVertexData> m_Vertices;
 
-	// Store the indices for the mesh
+	// CPU copy of the indices, released after upload unless m_KeepCPUData is set
 	std::vector<uint32_t> m_Indices;
 
+	// Keep the CPU copies after upload
+	bool m_KeepCPUData;
+
+	// Handle of the mesh in the memory tracker
+	PUi64 m_MemoryHandle;
+
+	// Bytes of the mesh's own vertex and index buffers, or its range of the pool's
+	PUi64 m_BufferBytes;
+
+	// Release the CPU copies unless they're kept, then report the mesh's memory
+	void OnUploaded();
+
+	// Report the CPU copies, buffers and instance buffer to the memory tracker
+	void UpdateMemory();
+
+	// Local space bounding sphere as (center.xyz, radius)
+	glm::vec4 m_BoundingSphere;
+
+	// Fit the bounding sphere around the stored vertices
+	void ComputeBoundingSphere();
+
+	// Create the VAO, immutable vertex and index buffers and the instance buffer from raw data
+	bool CreateBuffers(const void* vertexData, const PUi64& vertexBytes, const PUi32& stride,
+		const PSVertexAttribute* attributes, const PUi32& attributeCount,
+		const void* indexData, const PUi32& indexCount, const PUi32& indexSize);
+
 	// ID for the Vertex Array Object
 	uint32_t m_VAO;
 
@@ -46,6 +141,28 @@ private:
 	// ID for the Element Array Object
 	uint32_t m_EAO;
 
+	// ID for the streamed per-instance matrix buffer
+	uint32_t m_InstanceVBO;
+
+	// Number of matrices the instance buffer can currently hold
+	PUi32 m_InstanceCapacity;
+
+	// Number of instances to draw
+	PUi32 m_InstanceCount;
+
+	// Number of indices and the GL type they're stored as
+	PUi32 m_IndexCount;
+	PUi32 m_IndexType;
+
 	// Texture for the mesh
 	TShared<PTexture> m_Texture;
+
+	// Material table entry of the texture
+	PUi32 m_Material;
+
+	// Pool holding the mesh data when the mesh is pooled
+	TShared<PMeshPool> m_Pool;
+
+	// Location of the mesh data inside the pool
+	PSMeshPoolRange m_PoolRange;
 };
@@ -0,0 +1,45 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PVertexLayout.h"
+
+// Structure for one mesh read from a model file, ready for PMesh::CreateMesh
+struct PSImportedMesh
+{
+	PString name;                  // Object, group or glTF mesh name
+	TArray<PSVertexData> vertices; // Unique vertices
+	TArray<PUi32> indices;         // Triangle list indices into vertices
+};
+
+// Structure describing how much an import read and how fast
+struct PSMeshImportStats
+{
+	PUi64 fileBytes = 0;        // Bytes read, including glTF buffers
+	PUi64 sourceVertices = 0;   // Face corners before deduplication
+	PUi64 vertices = 0;         // Vertices after deduplication
+	PUi64 triangles = 0;        // Triangles across every mesh
+	PUi32 threads = 0;          // Threads that parsed the file
+	double seconds = 0.0;       // Time from mapping the file to the finished meshes
+
+	// Get the read throughput in megabytes per second
+	double GetMegabytesPerSecond() const { return seconds > 0.0 ? fileBytes / (1024.0 * 1024.0) / seconds : 0.0; }
+};
+
+// Class for importing Wavefront OBJ and glTF 2.0 models into meshes
+// Files are read through PFileSystem without copying and parsed on the thread pool. OBJ files are split into chunks of lines
+// and the face corners are merged into unique vertices with a hash map, one mesh per object or group.
+// glTF files (.gltf with .bin buffers, or .glb) give one mesh per triangle primitive, placed by their node transforms
+class PMeshImporter
+{
+public:
+	// Import a model, the format is picked from the extension
+	static bool Import(const PString& path, TArray<PSImportedMesh>& outMeshes, PSMeshImportStats* outStats = nullptr);
+
+	// Import a Wavefront OBJ file, materials are ignored
+	static bool ImportOBJ(const PString& path, TArray<PSImportedMesh>& outMeshes, PSMeshImportStats* outStats = nullptr);
+
+	// Import a glTF 2.0 file, embedded base64 buffers aren't supported
+	static bool ImportGLTF(const PString& path, TArray<PSImportedMesh>& outMeshes, PSMeshImportStats* outStats = nullptr);
+
+	// Import a model and log its throughput without creating any GPU resources
+	static bool Benchmark(const PString& path);
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PVertexLayout.h"
+
+struct PSImportedMesh;
+
+// Size of the FIFO post-transform cache meshes are ordered for and measured with
+#define PMESH_OPTIMIZER_CACHE_SIZE 16
+
+// Structure for the steps the optimizer runs
+struct PSMeshOptimizeSettings
+{
+	bool weld = true;                               // Merge vertices that are identical in every attribute
+	bool optimizeCache = true;                      // Reorder triangles for post-transform cache reuse with Tipsify
+	bool optimizeOverdraw = true;                   // Sort clusters of triangles so outward facing ones are drawn first
+	bool optimizeFetch = true;                      // Reorder vertices in the order the indices first use them
+	PUi32 cacheSize = PMESH_OPTIMIZER_CACHE_SIZE;   // Vertices the cache holds
+	float overdrawThreshold = 1.05f;                // How much the overdraw step may raise the ACMR, 1.05 allows 5%
+};
+
+// Structure for how well an index order reuses a FIFO post-transform cache
+struct PSVertexCacheStats
+{
+	PUi64 triangles = 0;    // Triangles drawn
+	PUi64 vertices = 0;     // Vertices the indices reference
+	PUi64 transforms = 0;   // Cache misses, each one runs the vertex shader
+
+	// Get the average cache miss ratio, vertex shader runs per triangle: 3 without reuse, 0.5 at best on a regular grid
+	float GetACMR() const { return triangles > 0 ? static_cast<float>(transforms) / triangles : 0.0f; }
+
+	// Get the average transform to vertex ratio, 1 when every vertex is transformed once
+	float GetATVR() const { return vertices > 0 ? static_cast<float>(transforms) / vertices : 0.0f; }
+
+	PSVertexCacheStats& operator+=(const PSVertexCacheStats& other)
+	{
+		triangles += other.triangles;
+		vertices += other.vertices;
+		transforms += other.transforms;
+		return *this;
+	}
+};
+
+// Structure for what an optimization changed
+struct PSMeshOptimizeStats
+{
+	PSVertexCacheStats before;  // Cache reuse of the indices as they arrived
+	PSVertexCacheStats after;   // Cache reuse of the optimized indices
+	PUi64 weldedVertices = 0;   // Duplicate vertices merged
+	PUi64 removedVertices = 0;  // Vertices no triangle used
+	PUi32 clusters = 0;         // Clusters the overdraw step sorted
+	double seconds = 0.0;       // Time spent optimizing
+
+	PSMeshOptimizeStats& operator+=(const PSMeshOptimizeStats& other)
+	{
+		before += other.before;
+		after += other.after;
+		weldedVertices += other.weldedVertices;
+		removedVertices += other.removedVertices;
+		clusters += other.clusters;
+		seconds += other.seconds;
+		return *this;
+	}
+};
+
+// Class for reordering mesh data so the GPU does less work drawing it
+// Meshes are welded, their triangles are ordered for the post-transform vertex cache with Tipsify (Sander et al. 2007),
+// clusters of triangles are sorted so outward facing ones are drawn first to reduce overdraw, and finally the vertices
+// are ordered by first use so vertex fetches walk memory forwards. Triangle lists only, the mesh draws the same afterwards
+class PMeshOptimizer
+{
+public:
+	// Run the enabled steps on a triangle list
+	static void Optimize(TArray<PSVertexData>& vertices, TArray<PUi32>& indices,
+		const PSMeshOptimizeSettings& settings = PSMeshOptimizeSettings(), PSMeshOptimizeStats* outStats = nullptr);
+
+	// Optimize every imported mesh, the stats are summed over all of them
+	static void Optimize(TArray<PSImportedMesh>& meshes, const PSMeshOptimizeSettings& settings = PSMeshOptimizeSettings(),
+		PSMeshOptimizeStats* outStats = nullptr);
+
+	// Merge vertices that are identical in every attribute, returns how many were merged
+	// Unused vertices are kept, the fetch step removes them
+	static PUi64 WeldVertices(TArray<PSVertexData>& vertices, TArray<PUi32>& indices);
+
+	// Reorder triangles for a FIFO post-transform cache of cacheSize vertices using Tipsify
+	static void OptimizeVertexCache(TArray<PUi32>& indices, const PUi64& vertexCount, const PUi32& cacheSize = PMESH_OPTIMIZER_CACHE_SIZE);
+
+	// Split cache ordered triangles into clusters and draw the clusters facing away from the mesh centre first
+	// Clusters only split where the cache was flushed or where the ACMR stays within threshold, returns the cluster count
+	static PUi32 OptimizeOverdraw(TArray<PUi32>& indices, const TArray<PSVertexData>& vertices,
+		const PUi32& cacheSize = PMESH_OPTIMIZER_CACHE_SIZE, const float& threshold = 1.05f);
+
+	// Reorder vertices in the order the indices first use them and remove unused ones, returns how many were removed
+	static PUi64 OptimizeVertexFetch(TArray<PSVertexData>& vertices, TArray<PUi32>& indices);
+
+	// Simulate a FIFO post-transform cache over a triangle list
+	static PSVertexCacheStats AnalyzeVertexCache(const TArray<PUi32>& indices, const PUi64& vertexCount,
+		const PUi32& cacheSize = PMESH_OPTIMIZER_CACHE_SIZE);
+
+	// Get a line describing an optimization for the log
+	static PString FormatStats(const PSMeshOptimizeStats& stats);
+
+	// Import a model, optimize it and log the cache statistics of every mesh without creating any GPU resources
+	static bool Benchmark(const PString& path);
+};
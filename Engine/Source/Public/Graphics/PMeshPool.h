@@ -0,0 +1,120 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PVertexLayout.h"
+
+// External libraries
+#include <GLM/glm.hpp>
+
+class PRingBuffer;
+
+// Shader storage binding point the per-draw data is bound to
+#define PMESHPOOL_DRAW_DATA_BINDING 0
+
+// Structure describing where a mesh's data lives in a mesh pool
+struct PSMeshPoolRange
+{
+	PUi32 firstIndex = 0;   // First index of the mesh in the shared index buffer
+	PUi32 indexCount = 0;   // Number of indices of the mesh
+	PUi32 baseVertex = 0;   // First vertex of the mesh in the shared vertex buffer
+	PUi32 vertexCount = 0;  // Number of vertices of the mesh
+};
+
+// Structure matching the layout glMultiDrawElementsIndirect reads a command with
+struct PSDrawElementsIndirectCommand
+{
+	PUi32 count;
+	PUi32 instanceCount;
+	PUi32 firstIndex;
+	int baseVertex;
+	PUi32 baseInstance;
+};
+
+// Structure matching the std430 per-draw data read by the shader with gl_DrawID
+struct PSIndirectDrawData
+{
+	glm::mat4 model = glm::mat4(1.0f);   // Model matrix of the draw
+	PUi32 materialIndex = 0;             // Material of the draw
+	PUi32 padding[3] = { 0, 0, 0 };      // Pad to the std430 struct alignment
+};
+
+// Structure for a single draw of a pooled mesh
+struct PSMeshPoolDraw
+{
+	PSMeshPoolRange range;               // Mesh to draw
+	PSIndirectDrawData data;             // Transform and material of the draw
+};
+
+// Class that stores many static meshes in one shared vertex/index layout
+// so any number of them can be drawn with a single glMultiDrawElementsIndirect call
+class PMeshPool
+{
+public:
+	PMeshPool();
+	~PMeshPool();
+
+	// Create the shared buffers with room for the given number of vertices and indices
+	// Every mesh in the pool is stored in the given vertex layout with 32-bit indices
+	bool Init(const PUi32& maxVertices, const PUi32& maxIndices,
+		const PSVertexLayoutInfo& layout = PStandardVertexLayout::GetInfo());
+
+	// Upload a mesh into the shared buffers, returns false if the pool is full
+	bool Allocate(const TArray<PSVertexData>& vertices, const TArray<PUi32>& indices, PSMeshPoolRange& outRange);
+
+	// Upload a mesh from memory owned elsewhere, encoding the vertices into the pool's layout
+	bool Allocate(const PSVertexData* vertices, const PUi32& vertexCount, const PUi32* indices, const PUi32& indexCount,
+		PSMeshPoolRange& outRange);
+
+	// Upload vertices that are already in the pool's layout, such as the blob of a mapped cooked mesh file
+	bool AllocateEncoded(const void* vertexData, const PUi32& vertexCount, const PUi32* indices, const PUi32& indexCount,
+		PSMeshPoolRange& outRange);
+
+	// Get the vertex layout meshes are stored in
+	const PSVertexLayoutInfo& GetLayout() const { return m_Layout; }
+
+	// Draw every mesh in the batch with one indirect call
+	// Commands and per-draw data are streamed into the ring buffer if one is given and has room
+	void DrawBatch(const TArray<PSMeshPoolDraw>& draws, PRingBuffer* dynamicBuffer);
+
+	// Get the ID of the shared Vertex Array Object
+	PUi32 GetVAO() const { return m_VAO; }
+
+	// Get the number of multi-draw calls issued since the pool was created
+	PUi64 GetBatchCount() const { return m_BatchCount; }
+
+private:
+	// IDs for the shared Vertex Array Object and its vertex and index buffers
+	PUi32 m_VAO;
+	PUi32 m_VBO;
+	PUi32 m_EAO;
+
+	// Buffers used for the commands and draw data when the ring buffer can't be used
+	PUi32 m_CommandBuffer;
+	PUi32 m_DrawDataBuffer;
+
+	// Layout of the shared vertex buffer
+	PSVertexLayoutInfo m_Layout;
+
+	// Scratch space vertices are encoded into before they're uploaded
+	TArray<PUi8> m_EncodeBuffer;
+
+	// Capacity of the shared buffers
+	PUi32 m_MaxVertices;
+	PUi32 m_MaxIndices;
+
+	// Number of vertices and indices already allocated
+	PUi32 m_VertexCount;
+	PUi32 m_IndexCount;
+
+	// CPU staging for the fallback buffers
+	TArray<PSDrawElementsIndirectCommand> m_Commands;
+	TArray<PSIndirectDrawData> m_DrawData;
+
+	// Number of multi-draw calls issued
+	PUi64 m_BatchCount;
+
+	// Handle of the pool in the memory tracker
+	PUi64 m_MemoryHandle;
+
+	// Report the staging memory and the capacity no mesh has been given yet, allocated ranges are counted by their meshes
+	void UpdateMemory();
+};
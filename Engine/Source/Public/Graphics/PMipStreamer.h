@@ -0,0 +1,168 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PTexture.h"
+#include "Graphics/PCompressedTexture.h"
+
+// External libraries
+#include <GLM/glm.hpp>
+
+// System libraries
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+struct PSCamera;
+
+// Largest size a texture is first made resident at, before any draw asks for more detail
+#define PMIP_STREAMER_INITIAL_SIZE 64
+
+// Structure for mip levels decoded on a worker, waiting for the GL thread to upload them
+struct PSMipLoad
+{
+	TWeak<PTexture> texture;                // Texture the levels belong to
+	int level = 0;                          // Level of the full mip chain the data starts at
+	int fullWidth = 0, fullHeight = 0;      // Size of level 0 of the full chain
+	int levelCount = 0;                     // Number of levels in the full chain
+	int channels = 0;                       // Channels of the decoded pixels
+	TArray<PUi8> pixels;                    // Decoded image downsampled to level
+	TShared<PSCompressedImage> compressed;  // Block-compressed file, the levels from level onward are uploaded
+	PString error;                          // Reason decoding failed
+};
+
+// Structure for the loads handed between the workers and the GL thread
+// Shared with the decode tasks so it outlives the streamer if a decode finishes late
+struct PSMipLoadQueue
+{
+	std::mutex mutex;
+	std::deque<PSMipLoad> loads;
+};
+
+// Structure describing the streamer's residency and budget pressure
+struct PSMipStreamerStats
+{
+	PUi32 streamedTextures = 0;       // Textures managed by the streamer
+	PUi32 residentTextures = 0;       // Textures with at least one level uploaded
+	PUi32 pendingRequests = 0;        // Level loads decoding or waiting to upload
+	PUi32 budgetLimitedTextures = 0;  // Textures kept coarser than their draws asked for to stay in budget
+	PUi64 residentBytes = 0;          // GPU memory allocated for the resident levels
+	PUi64 wantedBytes = 0;            // GPU memory every texture at its wanted level would need
+	PUi64 budgetBytes = 0;            // Memory the resident levels are kept under
+	PUi64 loads = 0;                  // Loads that added detail to a texture
+	PUi64 evictions = 0;              // Times levels were released to get back under budget
+	PUi64 clampChanges = 0;           // Times the sampled level was moved within the resident levels
+};
+
+// Class that keeps only the mip levels each texture needs resident, under a memory budget
+// Every frame draws request the level their screen size needs, the streamer then picks a level per texture
+// that fits the budget, preferring to drop detail from the textures using the most memory.
+// Levels that stop being needed are hidden at once with GL_TEXTURE_BASE_LEVEL and only released when the
+// budget needs the memory, so detail that comes back into view doesn't have to be loaded again.
+// Finer levels are decoded on the thread pool and uploaded into new storage, reusing the resident levels.
+// Streamed textures change their OpenGL ID when levels are loaded or released, so they can't be used
+// through bindless handles
+class PMipStreamer
+{
+public:
+	PMipStreamer();
+	~PMipStreamer() = default;
+
+	// Set the GPU memory the streamed textures are kept under
+	void SetMemoryBudget(const PUi64& bytes) { m_MemoryBudget = bytes; }
+
+	// Set the bytes uploaded per frame, at least one load is always uploaded
+	void SetFrameBudget(const PUi64& bytes) { m_FrameBudget = bytes; }
+
+	// Start streaming the image into the texture, it's first made resident at a coarse level
+	// and gets finer levels as draws request them
+	void Register(const TShared<PTexture>& texture, const PString& fileName, const PString& path,
+		const PSTextureLoadOptions& options);
+
+	// Start collecting the frame's requests for the camera, viewportHeight is in pixels
+	void BeginFrame(const PSCamera& camera, const float& viewportHeight);
+
+	// Request the level needed to draw the texture on the sphere, as (center.xyz, radius) in world space
+	// Textures that aren't streamed are ignored
+	void Request(const PTexture* texture, const glm::vec4& worldSphere);
+
+	// Upload finished loads, then pick the resident levels for the frame's requests and start new loads
+	// Call once per frame on the GL thread, after the frame's requests
+	void Update();
+
+	// Estimate the finest mip level worth sampling for a texture stretched once over the sphere
+	// projectionScale is the viewport height in pixels divided by 2 * tan(fov / 2)
+	static float EstimateMipLevel(const int& textureSize, const glm::vec4& worldSphere,
+		const glm::vec3& cameraPosition, const float& projectionScale);
+
+	// Get the current residency, pending requests and budget pressure
+	PSMipStreamerStats GetStats() const;
+
+	// Write the stats to the log
+	void LogStats() const;
+
+private:
+	// Structure for a texture managed by the streamer
+	struct PSStreamedTexture
+	{
+		TWeak<PTexture> texture;      // Texture the levels are uploaded into
+		const PTexture* key = nullptr; // Lookup key, kept so the entry can be removed after the texture is gone
+		PString path;                 // Image the levels are decoded from
+		PSTextureLoadOptions options; // Options the image is decoded with
+
+		int fullWidth = 0;            // Size of level 0, 0 until the first load arrives
+		int fullHeight = 0;
+		int levelCount = 0;           // Levels in the full chain
+		int channels = 0;             // Channels of uncompressed images
+		PECompressedFormat format = CF_UNKNOWN; // Format of block-compressed images
+
+		int storageLevel = -1;        // First level of the full chain held in the texture's storage, -1 if none
+		int baseLevel = -1;           // First level sampled, the levels above it are hidden by GL_TEXTURE_BASE_LEVEL
+		int wantedLevel = 0;          // Finest level requested this frame
+		int targetLevel = 0;          // Level picked for the budget
+		int loadingLevel = -1;        // Level being decoded, -1 if nothing is loading
+	};
+
+	// Streamed textures and their index by texture
+	TArray<PSStreamedTexture> m_Textures;
+	std::unordered_map<const PTexture*, PUi32> m_Lookup;
+
+	// Loads decoded by workers
+	TShared<PSMipLoadQueue> m_Loaded;
+
+	// Number of loads still decoding or waiting to upload
+	std::atomic<PUi32> m_Pending;
+
+	// Camera state of the frame's requests
+	glm::vec3 m_CameraPosition;
+	float m_ProjectionScale;
+
+	// GPU memory the resident levels are kept under
+	PUi64 m_MemoryBudget;
+
+	// Bytes that can be uploaded per frame
+	PUi64 m_FrameBudget;
+
+	// Counters
+	PSMipStreamerStats m_Stats;
+
+	// Decode a load on a worker, level -1 picks the first level no larger than PMIP_STREAMER_INITIAL_SIZE
+	void StartLoad(PSStreamedTexture& streamed, const int& level);
+
+	// Upload finished loads within the frame budget
+	void ApplyLoads();
+
+	// Create the texture's storage from the load's level, keeping the resident levels below it
+	bool Upload(PSStreamedTexture& streamed, PTexture& texture, PSMipLoad& load);
+
+	// Reallocate the texture's storage to start at level, releasing the levels above it
+	void Release(PSStreamedTexture& streamed, PTexture& texture, const int& level);
+
+	// Move the first sampled level within the resident levels
+	void SetBaseLevel(PSStreamedTexture& streamed, PTexture& texture, const int& level);
+
+	// Get the memory used by the texture's levels from level to the end of the chain
+	PUi64 GetLevelBytes(const PSStreamedTexture& streamed, const int& level) const;
+
+	// Get the coarsest level a texture is kept at while nothing requests it
+	static int GetIdleLevel(const PSStreamedTexture& streamed);
+};
@@ -2,26 +2,80 @@
 #include "EngineTypes.h"
 #include "Graphics/PMesh.h"
 #include "Math/PSTransform.h"
+#include "Graphics/PFrustumCuller.h"
 
 class PTexture;
 class PShaderProgram;
+class PRenderQueue;
+class PMeshPool;
+class PMaterialTable;
+class PMipStreamer;
 
 // Class for managing a 3D model composed of multiple meshes
 class PModel
 {
 public:
 	PModel() = default;
-	~PModel() = default;
+	~PModel();
 
 	// Create a polygon model and add a texture to it
-	void MakePoly(const TShared<PTexture>& texture);
+	// If a pool is given the mesh is stored in it and can be batched into multi-draw calls
+	void MakePoly(const TShared<PTexture>& texture, const TShared<PMeshPool>& pool = nullptr);
 
 	// Create a cube model and add a texture to it
-	void MakeCube(const TShared<PTexture>& texture);
+	// If a pool is given the mesh is stored in it and can be batched into multi-draw calls
+	void MakeCube(const TShared<PTexture>& texture, const TShared<PMeshPool>& pool = nullptr);
+
+	// Import an OBJ or glTF file, adding one mesh per object, group or primitive with the texture
+	// If a pool is given the meshes are stored in it and can be batched into multi-draw calls
+	// The cooked .pmesh file is loaded instead when the cooker has built one, otherwise the meshes are optimized on load
+	bool LoadModel(const PString& path, const TShared<PTexture>& texture, const TShared<PMeshPool>& pool = nullptr);
+
+	// Load a cooked .pmesh file, adding one mesh per submesh with the texture
+	// The file is memory-mapped and its blobs are uploaded without being parsed or copied
+	bool LoadCookedModel(const PString& path, const TShared<PTexture>& texture, const TShared<PMeshPool>& pool = nullptr);
+
+	// Keep the vertices and indices of meshes created after this call in memory, for picking or physics
+	// Off by default, meshes release their copies once they're uploaded
+	void SetCPUAccess(const bool& keepCPUData) { m_CPUAccess = keepCPUData; }
+
+	// Register the texture of every mesh with the material table, the materials are released with the model
+	// Pooled meshes with a material are batched with meshes of other textures
+	void SetMaterials(const TShared<PMaterialTable>& materialTable);
 
 	// Render all the meshes within the model
 	void Render(const TShared<PShaderProgram>& shader);
 
+	// Render every instance of the model with one draw call per mesh
+	// The shader must read the model matrix from the instance attribute
+	void RenderInstanced(const TShared<PShaderProgram>& shader);
+
+	// Submit a draw packet for every mesh to the render queue
+	void Submit(PRenderQueue& queue, const TShared<PShaderProgram>& shader);
+
+	// Upload the instance matrices and submit one instanced packet per mesh
+	// If a frustum is given, instances outside of it are skipped
+	void SubmitInstanced(PRenderQueue& queue, const TShared<PShaderProgram>& shader, const PSFrustum* frustum = nullptr);
+
+	// Request the mip levels every mesh's texture needs at its size on screen
+	// Instances use the bounds of the ones that passed culling in the last SubmitInstanced with a frustum
+	void RequestTextureMips(PMipStreamer& mipStreamer) const;
+
+	// Get the bounding sphere of all meshes in model space as (center.xyz, radius)
+	glm::vec4 GetLocalBoundingSphere() const;
+
+	// Get the bounding sphere of the model in world space as (center.xyz, radius)
+	glm::vec4 GetWorldBoundingSphere() const;
+
+	// Register another copy of the model to be drawn by RenderInstanced
+	void AddInstance(const PSTransform& transform) { m_Instances.push_back(transform); }
+
+	// Remove all registered instances
+	void ClearInstances() { m_Instances.clear(); }
+
+	// Get the transforms of the registered instances
+	TArray<PSTransform>& GetInstances() { return m_Instances; }
+
 	// Get the transform of the model
 	PSTransform& GetTransform() { return m_Transform; }
 
@@ -31,4 +85,25 @@ private:
 
 	// Transform for the model in 3D space
 	PSTransform m_Transform;
+
+	// Transforms for each instance of the model
+	TArray<PSTransform> m_Instances;
+
+	// Model matrices built from the instances, reused every frame
+	TArray<glm::mat4> m_InstanceMatrices;
+
+	// World space bounds of the instances, reused every frame
+	PSBoundingSpheres m_InstanceBounds;
+
+	// Indices of the instances that passed culling
+	TArray<PUi32> m_VisibleInstances;
+
+	// Meshes keep their CPU copies after upload
+	bool m_CPUAccess = false;
+
+	// Table the meshes' materials were added to
+	TWeak<PMaterialTable> m_MaterialTable;
+
+	// Return every mesh's material to the table
+	void ReleaseMaterials();
 };
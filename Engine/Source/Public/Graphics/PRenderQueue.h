@@ -0,0 +1,104 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PMeshPool.h"
+
+// External libraries
+#include <GLM/glm.hpp>
+
+class PShaderProgram;
+class PMesh;
+class PTexture;
+class PRingBuffer;
+class PMaterialTable;
+struct PSCamera;
+struct PSRingAllocation;
+
+// Enum to determine the render pass of a draw, passes are drawn in this order
+enum PERenderPass : PUi8
+{
+	RP_OPAQUE = 0U,   // Solid geometry, drawn front to back
+	RP_TRANSPARENT,   // Blended geometry, drawn back to front
+	RP_OVERLAY        // Drawn last, on top of everything
+};
+
+// Structure for a single draw submitted to the render queue
+struct PSDrawPacket
+{
+	PUi64 sortKey = 0;                        // Key the queue is sorted by
+	PShaderProgram* shader = nullptr;         // Program used for the draw
+	PMesh* mesh = nullptr;                    // Mesh to draw
+	PTexture* texture = nullptr;              // Texture bound to slot 0, optional
+	glm::mat4 transform = glm::mat4(1.0f);    // Model matrix, or instance origin when instanced
+	PUi32 instanceCount = 0;                  // Draw the mesh's instance buffer if above 0
+	PUi32 instanceBuffer = 0;                 // Buffer holding the instance matrices, 0 for the mesh's own
+	PUi32 instanceOffset = 0;                 // Byte offset of the instance matrices in instanceBuffer
+	PUi32 materialIndex = 0;                  // Material passed to the shader in pooled mesh batches
+	                                          // Packets without a texture bind it through the material table
+};
+
+// Class that collects draw packets for a frame, sorts them by state and depth, then draws them
+class PRenderQueue
+{
+public:
+	PRenderQueue() = default;
+	~PRenderQueue() = default;
+
+	// Sort key layout, most significant bits first:
+	// [63:62] pass | [61:52] program | [51:40] texture | [39:24] VAO | [23:0] depth
+	static PUi64 MakeSortKey(const PERenderPass& pass, const PUi32& programID,
+		const PUi32& textureID, const PUi32& vaoID, const float& depth);
+
+	// Set the ring buffer that per-frame data of submitted draws is streamed into
+	void SetDynamicBuffer(const TShared<PRingBuffer>& dynamicBuffer) { m_DynamicBuffer = dynamicBuffer; }
+
+	// Set the material table that packets without a texture are drawn with
+	void SetMaterialTable(const TShared<PMaterialTable>& materialTable) { m_MaterialTable = materialTable; }
+
+	// Allocate per-frame memory for a draw, invalid if there is no dynamic buffer or it's full
+	PSRingAllocation AllocateDynamic(const PUi32& size, const PUi32& alignment = 16);
+
+	// Clear the queue and set the camera used to draw the next frame
+	void Begin(const TShared<PSCamera>& camera);
+
+	// Add a draw to the queue, building its sort key from its state and depth
+	void Submit(PSDrawPacket packet, const PERenderPass& pass = RP_OPAQUE);
+
+	// Radix sort the submitted packets by their sort key
+	void Sort();
+
+	// Draw the sorted packets, only changing program and texture when they differ
+	// Consecutive pooled meshes drawn with a program that reads per-draw data are batched
+	// into one multi-draw indirect call, meshes with materials stay in the batch across textures
+	// as long as the material table binds the same texture for them
+	void Execute();
+
+	// Get the number of packets submitted this frame
+	PUi32 GetPacketCount() const { return static_cast<PUi32>(m_Packets.size()); }
+
+private:
+	// Structure pairing a sort key with its packet index
+	struct PSSortEntry
+	{
+		PUi64 key;
+		PUi32 index;
+	};
+
+	// Camera the frame is drawn with
+	TShared<PSCamera> m_Camera;
+
+	// Ring buffer for per-frame draw data
+	TShared<PRingBuffer> m_DynamicBuffer;
+
+	// Materials of packets without a texture
+	TShared<PMaterialTable> m_MaterialTable;
+
+	// Packets submitted this frame
+	TArray<PSDrawPacket> m_Packets;
+
+	// Sorted draw order and the scratch buffer used by the radix sort
+	TArray<PSSortEntry> m_Order;
+	TArray<PSSortEntry> m_Scratch;
+
+	// Draws of the pooled mesh batch being built
+	TArray<PSMeshPoolDraw> m_Batch;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include "EngineTypes.h"
+
+typedef struct __GLsync* GLsync;
+
+// Structure describing a block of memory allocated from a ring buffer for this frame
+struct PSRingAllocation
+{
+	void* data = nullptr;  // Persistently mapped CPU pointer to write to
+	PUi32 buffer = 0;      // OpenGL ID of the buffer the memory lives in
+	PUi32 offset = 0;      // Byte offset of the block in the buffer
+	PUi32 size = 0;        // Size of the block in bytes
+
+	// Check if the allocation succeeded
+	bool IsValid() const { return data != nullptr; }
+};
+
+// Structure for the ring buffer statistics
+struct PSRingBufferStats
+{
+	PUi64 stalls = 0;           // Number of times the CPU waited on a fence
+	PUi64 stallMicroseconds = 0; // Total time spent waiting on fences
+	PUi64 failedAllocations = 0; // Allocations that didn't fit in the frame's region
+	PUi32 frameBytes = 0;       // Bytes allocated in the current frame
+	PUi32 peakFrameBytes = 0;   // Most bytes allocated in a single frame
+};
+
+// Class for streaming per-frame dynamic data without implicit driver synchronization
+// The buffer is split into one region per frame in flight, mapped persistently and
+// coherently, and each region is fenced so it's only rewritten once the GPU is done with it
+class PRingBuffer
+{
+public:
+	PRingBuffer();
+	~PRingBuffer();
+
+	// Create the buffer with a region of frameSize bytes for each frame in flight
+	bool Init(const PUi32& frameSize, const PUi32& framesInFlight = 3);
+
+	// Move to the next region, waiting for the GPU if it's still reading it
+	void BeginFrame();
+
+	// Allocate a block from the current frame's region, invalid if the region is full
+	PSRingAllocation Allocate(const PUi32& size, const PUi32& alignment = 16);
+
+	// Fence the current frame's region after its draws were submitted
+	void EndFrame();
+
+	// Get the OpenGL ID of the buffer
+	PUi32 GetID() const { return m_ID; }
+
+	// Get the offset alignment required to bind a block as a uniform buffer
+	PUi32 GetUniformAlignment() const { return m_UniformAlignment; }
+
+	// Get the offset alignment required to bind a block as a shader storage buffer
+	PUi32 GetStorageAlignment() const { return m_StorageAlignment; }
+
+	// Get the allocator statistics
+	const PSRingBufferStats& GetStats() const { return m_Stats; }
+
+private:
+	// OpenGL ID of the buffer
+	PUi32 m_ID;
+
+	// Persistent CPU mapping of the whole buffer
+	PUi8* m_MappedData;
+
+	// Size of a single frame's region
+	PUi32 m_FrameSize;
+
+	// Index of the region used by the current frame
+	PUi32 m_FrameIndex;
+
+	// Next free byte in the current region
+	PUi32 m_FrameOffset;
+
+	// Required uniform and storage buffer offset alignments
+	PUi32 m_UniformAlignment;
+	PUi32 m_StorageAlignment;
+
+	// Fence for each region, null if the region isn't in use by the GPU
+	TArray<GLsync> m_Fences;
+
+	// Allocator statistics
+	PSRingBufferStats m_Stats;
+
+	// Handle of the buffer in the memory tracker
+	PUi64 m_MemoryHandle;
+};
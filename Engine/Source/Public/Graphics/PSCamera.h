@@ -1,5 +1,6 @@
 #pragma once
 #include "Math/PSTransform.h"
+#include "Math/PSFrustum.h"
 
 // Structure representing a camera in the 3D space
 struct PSCamera
@@ -11,7 +12,7 @@ struct PSCamera
 		aspectRatio = 1.0f;
 		nearClip = 0.01f;
 		farClip = 10000.0f;
-		moveSpeed = 0.1f;
+		moveSpeed = 6.0f;
 		rotationSpeed = 1.0f;
 	}
 
@@ -31,8 +32,8 @@ struct PSCamera
 			transform.rotation.x = 89.9f;
 	}
 
-	// Translate the camera based on the given translation vector
-	void Translate(glm::vec3 translation, glm::vec3 scale = glm::vec3(1.0f))
+	// Translate the camera based on the given translation vector over deltaTime seconds
+	void Translate(glm::vec3 translation, const float& deltaTime, glm::vec3 scale = glm::vec3(1.0f))
 	{
 		glm::vec3 moveDir = transform.Forward() * translation.z;
 		moveDir += transform.Right() * translation.x;
@@ -41,7 +42,7 @@ struct PSCamera
 		if (glm::length(moveDir) != 0.0f)
 			moveDir = glm::normalize(moveDir);
 
-		transform.position += moveDir * scale * moveSpeed;
+		transform.position += moveDir * scale * moveSpeed * deltaTime;
 	}
 
 	// Zoom the camera's field of view (FOV) by the given amount
@@ -63,6 +64,33 @@ struct PSCamera
 		defaultFov = newFov;
 	}
 
+	// Get the view matrix looking down the camera's forward vector
+	glm::mat4 GetViewMatrix() const
+	{
+		return glm::lookAt(
+			transform.position,
+			transform.position + transform.Forward(),
+			transform.Up()
+		);
+	}
+
+	// Get the perspective projection matrix
+	glm::mat4 GetProjectionMatrix() const
+	{
+		return glm::perspective(
+			glm::radians(fov),
+			aspectRatio,
+			nearClip,
+			farClip
+		);
+	}
+
+	// Get the six planes of the camera's view volume
+	PSFrustum GetFrustum() const
+	{
+		return PSFrustum::FromMatrix(GetProjectionMatrix() * GetViewMatrix());
+	}
+
 	// Transform representing the camera's position and orientation
 	PSTransform transform;
 
@@ -72,6 +100,6 @@ struct PSCamera
 	float aspectRatio;      // Aspect ratio
 	float nearClip;         // Near clipping plane
 	float farClip;          // Far clipping plane
-	float moveSpeed;        // Speed of movement
+	float moveSpeed;        // Speed of movement in units per second
 	float rotationSpeed;    // Speed of rotation
 };
@@ -0,0 +1,55 @@
+#pragma once
+#include "EngineTypes.h"
+
+// Folder linked program binaries are cached in, relative to the working directory
+#define PSHADER_CACHE_DIRECTORY "ShaderCache"
+
+// Structure counting how programs were created
+struct PSShaderCacheStats
+{
+	PUi64 hits = 0;       // Programs created from a cached binary
+	PUi64 misses = 0;     // Programs compiled because no binary was cached
+	PUi64 rejected = 0;   // Cached binaries that were corrupt or refused by the driver
+	PUi64 saved = 0;      // Binaries written after a full compile
+};
+
+// Cache of linked program binaries on disk, so shaders are only compiled once per driver
+// Entries are keyed by a hash of the shader sources and the GL vendor, renderer and version,
+// so editing a shader or updating the driver compiles it again
+// Only valid on the thread that owns the GL context
+class PShaderCache
+{
+public:
+	// Check if the driver can save and load program binaries
+	static bool IsSupported();
+
+	// Enable or disable the cache, programs are always compiled while it's disabled
+	static void SetEnabled(const bool& enabled) { s_Enabled = enabled; }
+
+	// Build the key for a program from its shader sources
+	static PUi64 MakeKey(const PString& vertexSource, const PString& fragmentSource);
+
+	// Load the cached binary for the key into a program, false if there's no valid entry
+	// A program that fails has to be recreated before it's compiled from source
+	static bool Load(const PUi32& program, const PUi64& key);
+
+	// Save the binary of a linked program, the program must have been linked with
+	// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	static bool Save(const PUi32& program, const PUi64& key);
+
+	// Count a program that had to be compiled
+	static void RecordMiss() { ++s_Stats.misses; }
+
+	// Get the cache counters
+	static const PSShaderCacheStats& GetStats() { return s_Stats; }
+
+private:
+	// False to always compile from source
+	static bool s_Enabled;
+
+	// Cache counters
+	static PSShaderCacheStats s_Stats;
+
+	// Get the path of the entry for a key
+	static PString GetEntryPath(const PUi64& key);
+};
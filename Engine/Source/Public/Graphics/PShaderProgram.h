@@ -1,8 +1,12 @@
 #pragma once
 #include "EngineTypes.h"
 
+// External libraries
+#include <GLM/glm.hpp>
+
 class PTexture;
 struct PSCamera;
+struct PSRingAllocation;
 
 // Enum to determine the type of shader
 enum PEShaderType : PUi8
@@ -11,6 +15,70 @@ enum PEShaderType : PUi8
 	ST_FRAGMENT      // Fragment shader
 };
 
+// Enum to determine the type of a reflected uniform
+enum PEUniformType : PUi8
+{
+	UT_UNKNOWN = 0U, // Type that can't be set through a handle
+	UT_INT,          // int or bool
+	UT_FLOAT,        // float
+	UT_VEC2,         // vec2
+	UT_VEC3,         // vec3
+	UT_VEC4,         // vec4
+	UT_MAT4,         // mat4
+	UT_SAMPLER       // Any sampler, set with a texture slot
+};
+
+// Enum for the progress of a hot reload
+enum PEShaderReloadState : PUi8
+{
+	RS_IDLE = 0U,   // No reload in flight
+	RS_PENDING,     // Still compiling or linking on the driver
+	RS_SWAPPED,     // The new program replaced the old one
+	RS_FAILED       // Compiling or linking failed, the old program is kept
+};
+
+// Typed handle to an active uniform, resolved once after linking
+template <PEUniformType Type>
+struct TUniformHandle
+{
+	// Index into the program's uniform table, -1 if the uniform isn't active
+	int index = -1;
+
+	// Check if the handle refers to an active uniform
+	bool IsValid() const { return index >= 0; }
+};
+
+typedef TUniformHandle<UT_INT> PUniformInt;
+typedef TUniformHandle<UT_FLOAT> PUniformFloat;
+typedef TUniformHandle<UT_VEC2> PUniformVec2;
+typedef TUniformHandle<UT_VEC3> PUniformVec3;
+typedef TUniformHandle<UT_VEC4> PUniformVec4;
+typedef TUniformHandle<UT_MAT4> PUniformMat4;
+typedef TUniformHandle<UT_SAMPLER> PUniformSampler;
+
+// Structure describing an active uniform in the default block
+struct PSShaderUniform
+{
+	PString name;         // Name without any array suffix
+	int location = -1;    // Location in the program
+	PUi32 glType = 0;     // OpenGL type enum
+	PEUniformType type = UT_UNKNOWN; // Handle type
+	int arraySize = 1;    // Number of array elements
+
+	// Shadow copy of the last value uploaded to the program
+	alignas(16) PUi8 value[sizeof(glm::mat4)] = {};
+	bool hasValue = false;
+};
+
+// Structure describing an active uniform block
+struct PSShaderUniformBlock
+{
+	PString name;         // Name of the block
+	PUi32 index = 0;      // Block index in the program
+	PUi32 binding = 0;    // Uniform buffer binding point
+	int dataSize = 0;     // Minimum buffer size in bytes
+};
+
 struct PSTransform;
 
 class PShaderProgram
@@ -20,6 +88,7 @@ public:
 	~PShaderProgram();
 
 	// Initialize the shader program using vertex and fragment shader files
+	// The linked program is loaded from the shader cache when the sources and driver match a saved entry
 	bool InitShader(const PString& vShaderPath, const PString& fShaderPath);
 
 	// Activate the shader program for use
@@ -28,11 +97,69 @@ public:
 	// Set the model transformation matrix in the shader
 	void SetModelTransform(const PSTransform& transform);
 
+	// Set an already built model matrix in the shader
+	void SetModelMatrix(const glm::mat4& matrix);
+
 	// Set the world transformation matrices (view and projection) in the shader
 	void SetWorldTransform(const TShared<PSCamera>& camera);
 
 	// Bind a texture to a specific slot in the shader
 	void RunTexture(const TShared<PTexture>& texture, const PUi32& slot);
+	void RunTexture(PTexture& texture, const PUi32& slot);
+
+	// Get a typed handle to an active uniform, invalid if not found or the type differs
+	template <PEUniformType Type>
+	TUniformHandle<Type> GetUniform(const PString& name) const
+	{
+		return TUniformHandle<Type>{ FindUniform(name, Type) };
+	}
+
+	// Set a uniform value, skipped if the handle is invalid or the value is unchanged
+	void SetUniform(const PUniformInt& handle, const int& value);
+	void SetUniform(const PUniformFloat& handle, const float& value);
+	void SetUniform(const PUniformVec2& handle, const glm::vec2& value);
+	void SetUniform(const PUniformVec3& handle, const glm::vec3& value);
+	void SetUniform(const PUniformVec4& handle, const glm::vec4& value);
+	void SetUniform(const PUniformMat4& handle, const glm::mat4& value);
+	void SetUniform(const PUniformSampler& handle, const PUi32& slot);
+
+	// Find an active uniform block by name, -1 if not found
+	int FindUniformBlock(const PString& name) const;
+
+	// Assign a uniform buffer binding point to a uniform block
+	void SetUniformBlockBinding(const int& blockIndex, const PUi32& binding);
+
+	// Bind a block of buffer memory, such as a ring buffer allocation, as a uniform block's data
+	void BindUniformBlock(const int& blockIndex, const PSRingAllocation& allocation);
+
+	// Get the reflected uniforms of the default block
+	const TArray<PSShaderUniform>& GetUniforms() const { return m_Uniforms; }
+
+	// Get the reflected uniform blocks
+	const TArray<PSShaderUniformBlock>& GetUniformBlocks() const { return m_UniformBlocks; }
+
+	// Get the reflected shader storage blocks
+	const TArray<PSShaderUniformBlock>& GetStorageBlocks() const { return m_StorageBlocks; }
+
+	// Check if the program reads per-draw data through gl_DrawID and can draw pooled mesh batches
+	bool HasDrawDataBlock() const { return m_HasDrawDataBlock; }
+
+	// Get the OpenGL ID of the program, it changes when a reload is swapped in
+	PUi32 GetID() const { return m_ProgramID; }
+
+	// Get the source file of a shader, the file hot reload watches even when a cooked copy was loaded
+	const PString& GetFilePath(const PEShaderType& shaderType) const { return m_FilePath[shaderType]; }
+
+	// Start compiling the shader files again into a new program, the current one keeps drawing meanwhile
+	// Returns false if the files can't be read or a reload is already in flight
+	bool BeginReload();
+
+	// Advance the reload without waiting on the driver when KHR_parallel_shader_compile is supported
+	// Once the new program links it replaces the old one, uniform handles and their last values carry over
+	PEShaderReloadState UpdateReload();
+
+	// Check if a reload is in flight
+	bool IsReloading() const { return m_PendingProgram != 0; }
 
 private:
 	// Store the file paths for the vertex and fragment shaders
@@ -44,12 +171,64 @@ private:
 	// Store the ID for the shader program
 	PUi32 m_ProgramID;
 
-	// Import a shader from a file based on its type (vertex or fragment)
-	bool ImportShaderByType(const PString& filePath, PEShaderType shaderType);
+	// Program and shaders being compiled by a reload, 0 when none is in flight
+	PUi32 m_PendingProgram;
+	PUi32 m_PendingShaderIDs[2] = { 0, 0 };
+
+	// True once the reload's shaders compiled and the program is linking
+	bool m_PendingLinked;
+
+	// Shader cache key of the reload's sources
+	PUi64 m_PendingCacheKey;
+
+	// Compile a shader from its source based on its type (vertex or fragment) and attach it to the program
+	bool ImportShaderByType(const PString& shaderStr, PEShaderType shaderType);
 
 	// Convert the contents of a file to a string
 	PString ConvertFileToString(const PString& filePath);
 
+	// Reflected uniforms of the default block
+	TArray<PSShaderUniform> m_Uniforms;
+
+	// Reflected uniform blocks
+	TArray<PSShaderUniformBlock> m_UniformBlocks;
+
+	// Reflected shader storage blocks
+	TArray<PSShaderUniformBlock> m_StorageBlocks;
+
+	// True if the program has the "PerDrawData" storage block
+	bool m_HasDrawDataBlock;
+
+	// Cached handles for the engine's built-in uniforms
+	PUniformMat4 m_ModelUniform;
+	PUniformMat4 m_ViewUniform;
+	PUniformMat4 m_ProjectionUniform;
+	PUniformSampler m_ColourMapUniform;
+
+	// Create an empty program
+	bool CreateProgram();
+
 	// Link the shader program to the GPU
 	bool LinkToGPU();
+
+	// Enumerate the active uniforms and uniform blocks of the linked program
+	void ReflectProgram();
+
+	// Resolve the handles of the engine's built-in uniforms
+	void ResolveBuiltInUniforms();
+
+	// Replace the program with the reload's, keeping handle indices, shadow values and block bindings
+	void SwapProgram();
+
+	// Delete the reload's objects
+	void CancelReload();
+
+	// Upload a uniform's shadow value to the program
+	void UploadShadow(const int& index);
+
+	// Find a uniform table index by name and type, -1 if not found
+	int FindUniform(const PString& name, const PEUniformType& type) const;
+
+	// Copy a value into the uniform's shadow, returns false if it was unchanged
+	bool UpdateShadow(const int& index, const void* data, const size_t& size);
 };
@@ -0,0 +1,77 @@
+#pragma once
+#include "EngineTypes.h"
+
+// System libraries
+#include <chrono>
+#include <filesystem>
+
+class PShaderProgram;
+
+// Seconds between checks of the file times when inotify isn't available
+#define PSHADER_WATCHER_POLL_INTERVAL 0.5
+
+// Structure counting the reloads the watcher ran
+struct PSShaderWatcherStats
+{
+	PUi64 reloads = 0;    // Programs swapped for a recompiled version
+	PUi64 failures = 0;   // Reloads that failed to compile or link, the old program was kept
+};
+
+// Class that recompiles shader programs when their files change, without restarting the engine
+// On Linux the shader folders are watched with inotify, elsewhere the file times are polled
+// Programs compile and link in the background when the driver supports KHR_parallel_shader_compile
+// and are swapped in once they link, so drawing never waits on the compiler
+// Only valid on the thread that owns the GL context
+class PShaderWatcher
+{
+public:
+	PShaderWatcher();
+	~PShaderWatcher();
+
+	// Start watching, asks the driver for as many compiler threads as it can use
+	bool Init();
+
+	// Reload the program whenever one of its shader files changes
+	void Watch(const TShared<PShaderProgram>& program);
+
+	// Start reloads for changed files and swap in the ones that finished, call once per frame
+	void Update();
+
+	// Get the reload counters
+	const PSShaderWatcherStats& GetStats() const { return m_Stats; }
+
+private:
+	// Structure for a watched program and the files it was built from
+	struct PSWatchedProgram
+	{
+		TWeak<PShaderProgram> program;                 // Program to reload
+		PString paths[2];                              // Normalised vertex and fragment paths
+		std::filesystem::file_time_type writeTimes[2]; // Last seen write times when polling
+		bool changed = false;                          // A file changed since the last reload started
+	};
+
+	// Watched programs
+	TArray<PSWatchedProgram> m_Programs;
+
+	// inotify descriptor and the folder of every watch, -1 if polling
+	int m_NotifyFD;
+	TArray<std::pair<int, PString>> m_WatchedFolders;
+
+	// Time of the last poll
+	std::chrono::steady_clock::time_point m_LastPoll;
+
+	// Reload counters
+	PSShaderWatcherStats m_Stats;
+
+	// Mark the programs using a file as changed
+	void OnFileChanged(const PString& path);
+
+	// Read the pending inotify events
+	void ReadEvents();
+
+	// Compare the file times with the last ones seen
+	void PollFiles();
+
+	// Normalise a path so the same file always compares equal
+	static PString NormalisePath(const PString& path);
+};
@@ -1,6 +1,20 @@
 #pragma once
 #include "EngineTypes.h"
 
+struct PSCompressedImage;
+
+// Structure for the settings an image is imported with
+struct PSTextureLoadOptions
+{
+	bool flipVertically = true;   // Flip rows so the first row is the bottom, which is what OpenGL expects
+	bool generateMipmaps = true;  // Build the mip chain after uploading
+	bool repeat = true;           // Repeat the texture outside 0-1, otherwise clamp to the edge
+	bool linearFilter = true;     // Filter linearly, otherwise use nearest neighbour
+	bool streamMips = false;      // Keep only the mip levels draws need resident, through the mip streamer
+
+	bool operator==(const PSTextureLoadOptions& other) const = default;
+};
+
 class PTexture
 {
 public:
@@ -8,9 +22,14 @@ public:
 	~PTexture();
 
 	// Load an image file and convert it to a texture
-	bool LoadTexture(const PString& fileName, const PString& path);
+	// .dds and .ktx2 files are uploaded block-compressed with their own mip chain, other images are decoded first
+	bool LoadTexture(const PString& fileName, const PString& path,
+		const PSTextureLoadOptions& options = PSTextureLoadOptions());
 
-	// Bind the texture for use in OpenGL
+	// Upload a block-compressed image and all of its mips
+	bool LoadCompressed(const PSCompressedImage& image);
+
+	// Bind the texture for use in OpenGL, the placeholder is bound instead until the image is resident
 	void BindTexture(const PUi32& textureNumber);
 
 	// Unbind the texture in OpenGL
@@ -25,6 +44,18 @@ public:
 	// Get the OpenGL ID of the texture
 	PUi32 GetID() const { return m_ID; }
 
+	// Check if the image has been uploaded, asynchronous loads are not resident until the streamer uploads them
+	bool IsResident() const { return m_ID > 0; }
+
+	// Set the texture bound in place of textures that aren't resident yet
+	static void SetPlaceholder(const PUi32& placeholderID);
+
+	// Get the options the texture was imported with
+	const PSTextureLoadOptions& GetOptions() const { return m_Options; }
+
+	// Get the estimated GPU memory used by the texture, including mipmaps
+	PUi64 GetResidentBytes() const;
+
 private:
 	// Import path of the image
 	PString m_Path;
@@ -35,6 +66,27 @@ private:
 	// OpenGL ID for the texture
 	PUi32 m_ID;
 
+	// Options the texture was imported with
+	PSTextureLoadOptions m_Options;
+
+	// Size of the uploaded data for block-compressed textures, 0 for uncompressed ones
+	PUi64 m_CompressedBytes;
+
 	// Texture parameters: width, height, and number of channels
 	int m_Width, m_Height, m_Channels;
+
+	// Handle of the texture in the memory tracker, registered on the first upload
+	PUi64 m_MemoryHandle;
+
+	// Report the texture's storage to the memory tracker, called whenever the storage changes
+	void UpdateMemory();
+
+	// OpenGL ID bound for textures that aren't resident yet
+	static PUi32 s_PlaceholderID;
+
+	// The streamer fills in the image once an asynchronous load is uploaded
+	friend class PTextureStreamer;
+
+	// The mip streamer replaces the storage as levels are loaded and released
+	friend class PMipStreamer;
 };
@@ -0,0 +1,81 @@
+#pragma once
+#include "EngineTypes.h"
+
+class PTexture;
+
+// Structure for the place a texture was packed into
+struct PSTextureArraySlot
+{
+	PUi32 arrayID = 0;   // OpenGL ID of the GL_TEXTURE_2D_ARRAY, 0 if not allocated
+	PUi32 layer = 0;     // Layer of the array holding the texture
+
+	// Check if the slot refers to an array layer
+	bool IsValid() const { return arrayID != 0; }
+};
+
+// Structure describing the textures an array can hold, textures must match it exactly to share the array
+// The sampler state is part of it because every layer is sampled with the array's parameters
+struct PSTextureArrayFormat
+{
+	PUi32 internalFormat = 0; // Sized internal format, the same class is required for copies
+	int width = 0;            // Width of the base level
+	int height = 0;           // Height of the base level
+	int levels = 1;           // Number of mip levels
+	bool repeat = true;       // Repeat outside 0-1, otherwise clamp to the edge, from PSTextureLoadOptions
+	bool linearFilter = true; // Filter linearly, otherwise use nearest neighbour, from PSTextureLoadOptions
+
+	bool operator==(const PSTextureArrayFormat& other) const = default;
+};
+
+// Class that packs same-sized textures into the layers of GL_TEXTURE_2D_ARRAY textures
+// Textures are copied on the GPU with glCopyImageSubData, so any resident texture can be packed,
+// including block-compressed ones. Meshes sampling the same array can then be drawn together,
+// selecting their layer in the shader instead of rebinding textures between draws
+class PTextureArrayAllocator
+{
+public:
+	PTextureArrayAllocator();
+	~PTextureArrayAllocator();
+
+	// Set the number of layers new arrays are created with, clamped to the driver limit
+	void SetLayersPerArray(const PUi32& layers);
+
+	// Copy a resident texture into a free layer of an array with the same format
+	// A new array is created when every matching array is full
+	bool Allocate(const PTexture& texture, PSTextureArraySlot& outSlot);
+
+	// Return a layer to its array so a later texture can reuse it
+	void Free(const PSTextureArraySlot& slot);
+
+	// Get the number of arrays created
+	PUi32 GetArrayCount() const { return static_cast<PUi32>(m_Arrays.size()); }
+
+	// Get the number of layers in use across every array
+	PUi32 GetUsedLayerCount() const;
+
+	// Get the GPU memory reserved by every array, including unused layers
+	PUi64 GetResidentBytes() const;
+
+private:
+	// Structure for an array and its free layers
+	struct PSTextureArray
+	{
+		PSTextureArrayFormat format;
+		PUi32 id = 0;
+		PUi32 layerCount = 0;
+		PUi64 layerBytes = 0;
+		TArray<PUi32> freeLayers;
+	};
+
+	// Every array created, in creation order
+	TArray<PSTextureArray> m_Arrays;
+
+	// Layers new arrays are created with
+	PUi32 m_LayersPerArray;
+
+	// Read the storage format of a texture, false if it can't be packed
+	static bool QueryFormat(const PTexture& texture, PSTextureArrayFormat& outFormat);
+
+	// Create a new array for the format, returns its index in m_Arrays or -1 on failure
+	int CreateArray(const PSTextureArrayFormat& format, const PUi64& layerBytes);
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PCompressedTexture.h"
+
+// Offline encoder that block-compresses images for PCompressedTexture
+// Blocks are fitted with SSE and levels are split across the thread pool, one block row per task
+// BC1 stores opaque colour, BC3 adds alpha, BC5 stores the red and green channels, BC7 uses mode 6 for RGBA
+class PTextureEncoder
+{
+public:
+	// Encode tightly packed RGBA8 pixels, top row first, optionally building the full mip chain
+	static bool Encode(const PUi8* pixels, const PUi32& width, const PUi32& height, const PECompressedFormat& format,
+		const bool& generateMips, const bool& srgb, PSCompressedImage& outImage);
+
+	// Load an image, encode it with a full mip chain and save it as a DDS file
+	// Rows are stored top first like other DDS files, PCompressedTexture::Load flips them when the texture asks for it
+	static bool EncodeFile(const PString& sourcePath, const PString& outputPath, const PECompressedFormat& format,
+		const bool& srgb = false);
+
+	// Encode a single 4x4 block of RGBA8 pixels, row by row, into outBlock
+	static void EncodeBlock(const PUi8* blockPixels, const PECompressedFormat& format, PUi8* outBlock);
+};
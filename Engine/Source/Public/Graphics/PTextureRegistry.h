@@ -0,0 +1,71 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PTexture.h"
+
+class PTextureStreamer;
+class PMipStreamer;
+
+// System libraries
+#include <unordered_map>
+
+// Structure counting how the registry served requests and what it keeps alive
+struct PSTextureRegistryStats
+{
+	PUi64 hits = 0;           // Requests served by a texture that was already loaded
+	PUi64 misses = 0;         // Requests that had to decode and upload an image
+	PUi64 failures = 0;       // Misses where the image couldn't be loaded
+	PUi64 evictions = 0;      // Entries dropped after every user released their texture
+	PUi64 liveTextures = 0;   // Textures currently held by at least one user
+	PUi64 residentBytes = 0;  // Estimated GPU memory used by the live textures
+};
+
+// Registry handing out shared textures so each image is decoded and uploaded once
+// Entries are keyed by canonical path and load options and only hold weak references,
+// so a texture is destroyed as soon as the last model using it lets go
+// Only valid on the thread that owns the GL context
+class PTextureRegistry
+{
+public:
+	// Get the texture for an image, loading it if no live texture matches the path and options
+	// Returns nullptr if the image couldn't be loaded
+	TShared<PTexture> Load(const PString& path, const PSTextureLoadOptions& options = PSTextureLoadOptions());
+
+	// Get the texture for an image, decoding it in the background if no live texture matches
+	// The texture binds a placeholder until it's uploaded, falls back to Load without a streamer
+	// Options with streamMips go to the mip streamer when one is set, from Load as well
+	TShared<PTexture> LoadAsync(const PString& path, const PSTextureLoadOptions& options = PSTextureLoadOptions());
+
+	// Set the streamer used by LoadAsync
+	void SetStreamer(const TShared<PTextureStreamer>& streamer) { m_Streamer = streamer; }
+
+	// Set the streamer used for textures loaded with streamMips
+	void SetMipStreamer(const TShared<PMipStreamer>& mipStreamer) { m_MipStreamer = mipStreamer; }
+
+	// Drop entries whose textures have been destroyed
+	void PurgeExpired();
+
+	// Get the request counters and current residency
+	PSTextureRegistryStats GetStats();
+
+	// Write the stats to the log
+	void LogStats();
+
+private:
+	// Build the lookup key for a path and its options
+	static PString MakeKey(const PString& path, const PSTextureLoadOptions& options);
+
+	// Get a live texture for the key, counting the hit or miss
+	TShared<PTexture> FindLive(const PString& key);
+
+	// Textures by key
+	std::unordered_map<PString, TWeak<PTexture>> m_Textures;
+
+	// Request counters
+	PSTextureRegistryStats m_Stats;
+
+	// Streamer used for asynchronous loads
+	TWeak<PTextureStreamer> m_Streamer;
+
+	// Streamer used for textures that stream their mip levels
+	TWeak<PMipStreamer> m_MipStreamer;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include "EngineTypes.h"
+#include "Graphics/PTexture.h"
+#include "Graphics/PCompressedTexture.h"
+
+// System libraries
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+// Number of pixel unpack buffers uploads rotate through
+#define PTEXTURE_STREAMER_PIXEL_BUFFERS 3
+
+// Structure for an image decoded on a worker, waiting for the GL thread to upload it
+struct PSDecodedImage
+{
+	TWeak<PTexture> texture;        // Texture the image belongs to
+	unsigned char* pixels = nullptr; // Pixel data from stb_image, null if decoding failed
+	int width = 0, height = 0, channels = 0;
+	TShared<PSCompressedImage> compressed; // Block-compressed data read from a .dds or .ktx2 file instead of pixels
+	PString error;                  // Reason decoding failed
+
+	// Get the number of bytes the upload copies
+	PUi64 GetUploadBytes() const;
+};
+
+// Structure for the images handed between the workers and the GL thread
+// Shared with the decode tasks so it outlives the streamer if a decode finishes late
+struct PSDecodedImageQueue
+{
+	~PSDecodedImageQueue();
+
+	std::mutex mutex;
+	std::deque<PSDecodedImage> images;
+};
+
+// Structure counting the streamer's work
+struct PSTextureStreamerStats
+{
+	PUi64 decoded = 0;            // Images decoded by workers
+	PUi64 uploaded = 0;           // Images uploaded to the GPU
+	PUi64 failed = 0;             // Images that couldn't be decoded
+	PUi64 uploadedBytes = 0;      // Total bytes uploaded
+	PUi64 deferredFrames = 0;     // Frames that left images waiting because the budget ran out
+};
+
+// Class that loads textures without blocking the render thread
+// Images are decoded on the thread pool and uploaded through pixel unpack buffers on the GL thread,
+// limited to a byte budget per frame. Textures bind a placeholder until their image is resident
+class PTextureStreamer
+{
+public:
+	PTextureStreamer();
+	~PTextureStreamer();
+
+	// Create the placeholder texture and pixel buffers, frameBudget is the bytes uploaded per frame
+	bool Init(const PUi64& frameBudget = 8 * 1024 * 1024);
+
+	// Start decoding an image for the texture, the texture keeps showing the placeholder until Update uploads it
+	void LoadAsync(const TShared<PTexture>& texture, const PString& fileName, const PString& path,
+		const PSTextureLoadOptions& options = PSTextureLoadOptions());
+
+	// Upload decoded images until the frame's budget is spent, call once per frame on the GL thread
+	void Update();
+
+	// Set the bytes uploaded per frame, at least one image is always uploaded so large images can't stall forever
+	void SetFrameBudget(const PUi64& frameBudget) { m_FrameBudget = frameBudget; }
+
+	// Get the number of images still being decoded or waiting to upload
+	PUi32 GetPendingCount() const { return m_Pending.load(std::memory_order_relaxed); }
+
+	// Get the streamer's counters
+	const PSTextureStreamerStats& GetStats() const { return m_Stats; }
+
+private:
+	// Create the texture storage and upload an image through the next pixel buffer
+	bool Upload(PSDecodedImage& image, PTexture& texture);
+
+	// Create compressed texture storage and upload every mip through the next pixel buffer
+	bool UploadCompressed(const PSCompressedImage& image, PTexture& texture);
+
+	// Copy data into the next pixel buffer, returns its ID or 0 if it couldn't be mapped
+	PUi32 FillPixelBuffer(const void* data, const PUi64& size);
+
+	// Images decoded and ready to upload
+	TShared<PSDecodedImageQueue> m_Decoded;
+
+	// Images still being decoded or waiting to upload
+	std::atomic<PUi32> m_Pending;
+
+	// Pixel unpack buffers used for uploads and the next one to use
+	PUi32 m_PixelBuffers[PTEXTURE_STREAMER_PIXEL_BUFFERS];
+	PUi32 m_NextPixelBuffer;
+
+	// Texture bound while images are loading
+	PUi32 m_Placeholder;
+
+	// Bytes that can be uploaded per frame
+	PUi64 m_FrameBudget;
+
+	// Counters
+	PSTextureStreamerStats m_Stats;
+};
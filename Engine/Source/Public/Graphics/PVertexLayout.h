@@ -0,0 +1,214 @@
+#pragma once
+#include "EngineTypes.h"
+
+// System libraries
+#include <array>
+#include <cstring>
+
+// Structure for storing vertex data
+// Meshes are built in this layout and encoded into a TVertexLayout when they're uploaded or cooked
+struct PSVertexData
+{
+	float m_Position[3] = { 0.0f, 0.0f, 0.0f }; // Position of the vertex
+	float m_Colour[3] = { 1.0f, 1.0f, 1.0f };   // Colour of the vertex
+	float m_TexCoords[2] = { 0.0f, 0.0f };      // Texture coordinates
+	float m_Normal[3] = { 0.0f, 0.0f, 0.0f };   // Normal vector for lighting
+};
+
+// Enum for the types vertex components are stored as, the values are the matching GL enums
+// so the header doesn't need GLEW
+enum PEVertexComponentType : PUi32
+{
+	VC_UNSIGNED_BYTE = 0x1401U, // GL_UNSIGNED_BYTE
+	VC_SHORT = 0x1402U,         // GL_SHORT
+	VC_FLOAT = 0x1406U,         // GL_FLOAT
+	VC_HALF_FLOAT = 0x140BU     // GL_HALF_FLOAT
+};
+
+// Enum for what a vertex attribute holds, the values are the shader locations
+// Locations 3 to 6 are taken by the per-instance model matrix
+// Normals are bound for shaders that light meshes, the engine's own shaders don't read them
+enum PEVertexSemantic : PUi32
+{
+	VS_POSITION = 0U,
+	VS_COLOUR = 1U,
+	VS_TEXCOORDS = 2U,
+	VS_NORMAL = 7U
+};
+
+// Structure describing one vertex attribute, stored as is in cooked mesh files
+struct PSVertexAttribute
+{
+	PUi32 location = 0;     // Shader attribute location
+	PUi32 components = 0;   // Number of components
+	PUi32 type = 0;         // GL component type such as GL_FLOAT
+	PUi32 normalized = 0;   // Non-zero if integer components are mapped to 0-1 or -1-1
+	PUi32 offset = 0;       // Byte offset of the attribute inside a vertex
+};
+
+// Structure describing a vertex layout at runtime, made by TVertexLayout::GetInfo
+// Layouts are compared by their attribute table, every TVertexLayout type has exactly one
+struct PSVertexLayoutInfo
+{
+	const PSVertexAttribute* attributes = nullptr;
+	PUi32 attributeCount = 0;
+	PUi32 stride = 0;                                               // Bytes per vertex
+	void (*encode)(const PSVertexData& vertex, PUi8* outVertex) = nullptr;  // Write one vertex in the layout
+
+	bool operator==(const PSVertexLayoutInfo& other) const { return attributes == other.attributes; }
+};
+
+// Class for the conversions vertex layouts encode their components with
+// Kept apart from PMesh so tools can describe and encode vertices without linking the renderer
+class PVertexLayout
+{
+public:
+	// Convert a float to a half float, rounding to nearest even
+	// Values past the half range are clamped to the largest half instead of becoming infinite
+	static PUi16 FloatToHalf(const float& value);
+
+	// Encode a unit normal as two signed 16-bit octahedral coordinates
+	static void EncodeOctahedral(const float normal[3], int16_t outEncoded[2]);
+
+	// Encode a run of vertices into a layout, outVertices needs count * layout.stride bytes
+	static void Encode(const PSVertexLayoutInfo& layout, const PSVertexData* vertices, const PUi64& count, PUi8* outVertices);
+
+	// Check if indices into a mesh with this many vertices fit in 16 bits
+	static bool FitsShortIndices(const PUi64& vertexCount) { return vertexCount <= 0x10000ULL; }
+};
+
+// Base of the component formats, describing how an attribute's components are stored
+template<PUi32 Components, PEVertexComponentType Type, bool Normalized, PUi32 Size>
+struct TVertexFormat
+{
+	static constexpr PUi32 components = Components;
+	static constexpr PEVertexComponentType type = Type;
+	static constexpr bool normalized = Normalized;
+	static constexpr PUi32 size = Size;   // Bytes the attribute takes in a vertex, always a multiple of 4
+};
+
+// Full precision floats, read from Count floats
+template<PUi32 Count>
+struct TFloatFormat : TVertexFormat<Count, VC_FLOAT, false, Count * 4>
+{
+	static void Encode(const float* values, PUi8* out) { std::memcpy(out, values, Count * sizeof(float)); }
+};
+
+// Half floats, read from Count floats
+// Three components are padded to four with w = 1 so the next attribute stays 4-byte aligned
+template<PUi32 Count>
+struct THalfFormat : TVertexFormat<Count == 3 ? 4 : Count, VC_HALF_FLOAT, false, (Count == 3 ? 4 : Count) * 2>
+{
+	static void Encode(const float* values, PUi8* out)
+	{
+		PUi16 halves[4] = { 0, 0, 0, 0x3C00 };
+		for (PUi32 i = 0; i < Count; ++i)
+			halves[i] = PVertexLayout::FloatToHalf(values[i]);
+
+		std::memcpy(out, halves, THalfFormat::size);
+	}
+};
+
+// RGB colour packed into four normalized bytes with an opaque alpha
+struct PSColourRGBA8Format : TVertexFormat<4, VC_UNSIGNED_BYTE, true, 4>
+{
+	static void Encode(const float* values, PUi8* out)
+	{
+		for (PUi32 i = 0; i < 3; ++i)
+		{
+			const float value = values[i] < 0.0f ? 0.0f : (values[i] > 1.0f ? 1.0f : values[i]);
+			out[i] = static_cast<PUi8>(value * 255.0f + 0.5f);
+		}
+
+		out[3] = 255;
+	}
+};
+
+// Unit normal stored as two normalized shorts in octahedral mapping
+// A shader reading it at VS_NORMAL gets the folded coordinates and has to unfold them into a vector
+struct PSOctahedralNormalFormat : TVertexFormat<2, VC_SHORT, true, 4>
+{
+	static void Encode(const float* values, PUi8* out)
+	{
+		int16_t encoded[2];
+		PVertexLayout::EncodeOctahedral(values, encoded);
+		std::memcpy(out, encoded, sizeof(encoded));
+	}
+};
+
+// Attribute of a TVertexLayout, reading its semantic's values from PSVertexData and storing them in Format
+template<PEVertexSemantic Semantic, typename Format>
+struct TVertexAttribute
+{
+	static constexpr PEVertexSemantic semantic = Semantic;
+	using FormatType = Format;
+
+	static const float* GetSource(const PSVertexData& vertex)
+	{
+		if constexpr (Semantic == VS_POSITION)
+			return vertex.m_Position;
+		else if constexpr (Semantic == VS_COLOUR)
+			return vertex.m_Colour;
+		else if constexpr (Semantic == VS_TEXCOORDS)
+			return vertex.m_TexCoords;
+		else
+			return vertex.m_Normal;
+	}
+};
+
+// Build the attribute table of a layout, attributes are placed back to back in order
+template<typename... Attributes>
+constexpr std::array<PSVertexAttribute, sizeof...(Attributes)> MakeVertexAttributes()
+{
+	std::array<PSVertexAttribute, sizeof...(Attributes)> result = {};
+	PUi32 index = 0, offset = 0;
+
+	((result[index++] = PSVertexAttribute{ Attributes::semantic, Attributes::FormatType::components,
+		Attributes::FormatType::type, Attributes::FormatType::normalized ? 1U : 0U, offset },
+		offset += Attributes::FormatType::size), ...);
+
+	return result;
+}
+
+// Vertex layout built at compile time from its attributes
+// The attribute table, stride and encoder all come from the attribute list, so the GL attribute setup
+// and the vertex data can't disagree
+template<typename... Attributes>
+class TVertexLayout
+{
+public:
+	static constexpr PUi32 attributeCount = sizeof...(Attributes);
+	static constexpr PUi32 stride = (Attributes::FormatType::size + ...);
+	static constexpr std::array<PSVertexAttribute, sizeof...(Attributes)> attributes = MakeVertexAttributes<Attributes...>();
+
+	// Write one vertex in the layout
+	static void Encode(const PSVertexData& vertex, PUi8* outVertex)
+	{
+		PUi32 offset = 0;
+		((Attributes::FormatType::Encode(Attributes::GetSource(vertex), outVertex + offset),
+			offset += Attributes::FormatType::size), ...);
+	}
+
+	// Get the layout's description for code that isn't templated on it
+	static PSVertexLayoutInfo GetInfo() { return { attributes.data(), attributeCount, stride, &Encode }; }
+};
+
+// PSVertexData as it is, 44 bytes
+typedef TVertexLayout<
+	TVertexAttribute<VS_POSITION, TFloatFormat<3>>,
+	TVertexAttribute<VS_COLOUR, TFloatFormat<3>>,
+	TVertexAttribute<VS_TEXCOORDS, TFloatFormat<2>>,
+	TVertexAttribute<VS_NORMAL, TFloatFormat<3>>
+> PStandardVertexLayout;
+
+// Half float position and texture coordinates, RGBA8 colour and an octahedral normal, 20 bytes
+// Half positions keep about three significant digits, so it suits meshes modelled around their origin
+typedef TVertexLayout<
+	TVertexAttribute<VS_POSITION, THalfFormat<3>>,
+	TVertexAttribute<VS_COLOUR, PSColourRGBA8Format>,
+	TVertexAttribute<VS_TEXCOORDS, THalfFormat<2>>,
+	TVertexAttribute<VS_NORMAL, PSOctahedralNormalFormat>
+> PCompactVertexLayout;
+
+static_assert(PStandardVertexLayout::stride == sizeof(PSVertexData), "PStandardVertexLayout must match PSVertexData");
+static_assert(PCompactVertexLayout::stride == 20, "PCompactVertexLayout changed size");
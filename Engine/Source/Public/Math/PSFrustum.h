@@ -0,0 +1,64 @@
+#pragma once
+
+// External libraries
+#include <GLM/glm.hpp>
+
+// Enum for the planes of a frustum
+enum PEFrustumPlane : unsigned char
+{
+	FP_LEFT = 0U,
+	FP_RIGHT,
+	FP_BOTTOM,
+	FP_TOP,
+	FP_NEAR,
+	FP_FAR,
+	FP_COUNT
+};
+
+// Structure representing a view volume as six inward facing planes
+// Each plane is stored as (normal.xyz, distance), a point is inside when dot(normal, p) + distance >= 0
+struct PSFrustum
+{
+	// Extract the planes from a combined projection * view matrix
+	static PSFrustum FromMatrix(const glm::mat4& viewProjection)
+	{
+		PSFrustum frustum;
+
+		// Rows of the matrix, GLM stores columns
+		const glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		const glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		const glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		const glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		frustum.planes[FP_LEFT] = row3 + row0;
+		frustum.planes[FP_RIGHT] = row3 - row0;
+		frustum.planes[FP_BOTTOM] = row3 + row1;
+		frustum.planes[FP_TOP] = row3 - row1;
+		frustum.planes[FP_NEAR] = row3 + row2;
+		frustum.planes[FP_FAR] = row3 - row2;
+
+		// Normalize so the plane distance is in world units
+		for (glm::vec4& plane : frustum.planes)
+		{
+			const float length = glm::length(glm::vec3(plane));
+			if (length > 0.0f)
+				plane /= length;
+		}
+
+		return frustum;
+	}
+
+	// Check if a sphere is at least partially inside the frustum
+	bool IntersectsSphere(const glm::vec3& center, const float& radius) const
+	{
+		for (const glm::vec4& plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	glm::vec4 planes[FP_COUNT];  // Planes of the frustum
+};
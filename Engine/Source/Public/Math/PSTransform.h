@@ -15,7 +15,7 @@ struct PSTransform
 	}
 
 	// Get the forward vector based on the current rotation
-	glm::vec3 Forward()
+	glm::vec3 Forward() const
 	{
 		glm::vec3 forward;
 		forward.x = sin(glm::radians(rotation.y)) * cos(glm::radians(rotation.x));
@@ -29,7 +29,7 @@ struct PSTransform
 	}
 
 	// Get the right vector based on the current rotation
-	glm::vec3 Right()
+	glm::vec3 Right() const
 	{
 		glm::vec3 right = glm::cross(Forward(), glm::vec3(0.0f, 1.0f, 0.0f));
 
@@ -40,7 +40,7 @@ struct PSTransform
 	}
 
 	// Get the up vector based on the current rotation
-	glm::vec3 Up()
+	glm::vec3 Up() const
 	{
 		glm::vec3 up = glm::cross(Right(), Forward());
 
@@ -50,6 +50,31 @@ struct PSTransform
 		return up;
 	}
 
+	// Build the model matrix: translate, rotate, then scale
+	glm::mat4 GetMatrix() const
+	{
+		glm::mat4 matrixT = glm::mat4(1.0f);
+
+		matrixT = glm::translate(matrixT, position);
+		matrixT = glm::rotate(matrixT, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		matrixT = glm::rotate(matrixT, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		matrixT = glm::rotate(matrixT, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		matrixT = glm::scale(matrixT, scale);
+
+		return matrixT;
+	}
+
+	// Blend between two transforms, alpha 0 returns a and alpha 1 returns b
+	static PSTransform Lerp(const PSTransform& a, const PSTransform& b, const float& alpha)
+	{
+		PSTransform result;
+		result.position = glm::mix(a.position, b.position, alpha);
+		result.rotation = glm::mix(a.rotation, b.rotation, alpha);
+		result.scale = glm::mix(a.scale, b.scale, alpha);
+
+		return result;
+	}
+
 	glm::vec3 position;  // Position of the transform in 3D space
 	glm::vec3 rotation;  // Rotation of the transform in 3D space
 	glm::vec3 scale;     // Scale of the transform in 3D space
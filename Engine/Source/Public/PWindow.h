@@ -12,17 +12,24 @@ struct PSWindowParams
 {
 	// Default constructor with default window settings
 	PSWindowParams()
-		: title("Perov Engine Window"), x(0), y(0), w(1280), h(720), vsync(false), fullscreen(false) {}
+		: title("Perov Engine Window"), x(0), y(0), w(1280), h(720), vsync(false), fullscreen(false),
+		headless(false), headlessFrames(0), dumpInterval(0), textureBudgetMB(256) {}
 
 	// Constructor with custom settings
 	PSWindowParams(PString title, int x, int y, unsigned int w, unsigned int h)
-		: title(title), x(x), y(y), w(w), h(h), vsync(false), fullscreen(false) {}
+		: title(title), x(x), y(y), w(w), h(h), vsync(false), fullscreen(false),
+		headless(false), headlessFrames(0), dumpInterval(0), textureBudgetMB(256) {}
 
 	PString title; // Title of the window
 	int x, y; // Position of the window
 	unsigned int w, h; // Width and height of the window
 	bool vsync; // VSync enable flag
 	bool fullscreen; // Fullscreen enable flag
+	bool headless; // Render offscreen without creating a window
+	unsigned int headlessFrames; // Frames to render before closing in headless mode, 0 runs until closed
+	unsigned int dumpInterval; // Save every Nth headless frame to dumpDirectory, 0 disables dumps
+	PString dumpDirectory; // Folder headless frame dumps are written to
+	unsigned int textureBudgetMB; // GPU memory streamed texture mips are kept under, in megabytes
 };
 
 struct SDL_Window;
@@ -45,8 +52,11 @@ public:
 	// Register input events
 	void RegisterInput(const TShared<PInput>& input);
 
-	// Render the graphics engine
-	void Render();
+	// Advance the simulation by one fixed tick of deltaTime seconds
+	void Update(const float& deltaTime);
+
+	// Render the graphics engine, alpha blends between the last two simulation ticks
+	void Render(const float& alpha);
 
 private:
 	SDL_Window* m_SDLWindow; // SDL window reference
@@ -54,7 +64,10 @@ private:
 	bool m_ShouldClose; // Flag to determine if the window should close
 	TUnique<PGraphicsEngine> m_GraphicsEngine; // Graphics engine instance
 	glm::vec3 m_CameraDirection; // Camera movement direction
-	glm::vec3 m_CameraRotation; // Camera rotation amount
+	glm::vec3 m_CameraRotation; // Camera rotation gathered from the mouse since the last tick
+	PSTransform m_CameraState; // Camera transform after the latest tick
+	PSTransform m_PrevCameraState; // Camera transform after the tick before that
 	bool m_CanZoom; // Zoom capability flag
 	bool m_InputMode; // User input mode flag
+	unsigned int m_FrameIndex; // Number of frames rendered so far
 };
@@ -3,10 +3,22 @@
 // External libraries
 #include <SDL/SDL.h>
 
+// System libraries
+#include <charconv>
+#include <cstring>
+
 // Engine libraries
 #include "PWindow.h"
 #include "Listeners/PInput.h"
 #include "Graphics/PSCamera.h"
+#include "Debug/PProfiler.h"
+#include "Core/PFrameTimer.h"
+#include "Graphics/PTextureEncoder.h"
+#include "Graphics/PMeshImporter.h"
+#include "Graphics/PCookedMesh.h"
+#include "Graphics/PMeshOptimizer.h"
+#include "Core/PFileSystem.h"
+#include "Core/PPackFile.h"
 
 // Note on smart pointers:
 // - Shared pointer: Shares ownership across all references.
@@ -17,11 +29,94 @@
 TShared<PWindow> m_Window = nullptr;
 TShared<PInput> m_Input = nullptr;
 
+// Path the profiler trace is written to on exit, empty if profiling is off
+PString m_TracePath;
+
+// Simulation ticks per second and the frame cap, 0 leaves the frame rate uncapped
+double m_TickRate = 60.0;
+double m_FrameCap = 0.0;
+
+// Read a number option's value, a value that doesn't parse leaves the option as it was
+// so a typo in an unattended run doesn't stop it
+template<typename T>
+void ParseNumber(const PString& option, const char* text, T& outValue)
+{
+	T value{};
+	const char* end = text + std::strlen(text);
+	const auto [last, error] = std::from_chars(text, end, value);
+
+	if (error != std::errc() || last != end || last == text)
+	{
+		PDebug::Log("Invalid value \"" + PString(text) + "\" for " + option + ", keeping " + std::to_string(outValue), LT_WARN);
+		return;
+	}
+
+	outValue = value;
+}
+
+// Read startup options from the command line
+// --headless renders offscreen, --frames N closes after N frames,
+// --dump-dir PATH and --dump-every N save headless frames as BMP images
+// --profile PATH records CPU and GPU zones and writes a Chrome trace on exit
+// --tick-rate N sets the simulation ticks per second, --fps-cap N limits the frame rate
+// --texture-budget MB sets the GPU memory streamed texture mips are kept under
+// --pack PATH mounts a pack archive, --no-loose-files stops loose files overriding packed ones
+// --no-cooked loads source assets even when the cooker has built them
+PSWindowParams ParseArguments(int argc, char* argv[])
+{
+	PSWindowParams params("Game Window", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 720, 720);
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const PString arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (arg == "--headless")
+			params.headless = true;
+		else if (arg == "--frames" && hasValue)
+			ParseNumber(arg, argv[++i], params.headlessFrames);
+		else if (arg == "--dump-dir" && hasValue)
+			params.dumpDirectory = argv[++i];
+		else if (arg == "--dump-every" && hasValue)
+			ParseNumber(arg, argv[++i], params.dumpInterval);
+		else if (arg == "--profile" && hasValue)
+			m_TracePath = argv[++i];
+		else if (arg == "--tick-rate" && hasValue)
+			ParseNumber(arg, argv[++i], m_TickRate);
+		else if (arg == "--fps-cap" && hasValue)
+			ParseNumber(arg, argv[++i], m_FrameCap);
+		else if (arg == "--texture-budget" && hasValue)
+			ParseNumber(arg, argv[++i], params.textureBudgetMB);
+		else if (arg == "--pack" && hasValue)
+			PFileSystem::Get().Mount(argv[++i]);
+		else if (arg == "--no-loose-files")
+			PFileSystem::Get().SetLooseFilesEnabled(false);
+		else if (arg == "--no-cooked")
+			PFileSystem::Get().SetCookedDataEnabled(false);
+		else
+			std::cout << "Unknown argument: " << arg << std::endl;
+	}
+
+	// Dumping without an interval saves every frame
+	if (!params.dumpDirectory.empty() && params.dumpInterval == 0)
+		params.dumpInterval = 1;
+
+	if (params.dumpDirectory.empty())
+		params.dumpDirectory = ".";
+
+	return params;
+}
+
 // Initialize SDL and create the window and input system
-bool Initialise()
+bool Initialise(const PSWindowParams& params)
 {
+	PPROFILE_SCOPE("Init");
+
+	// Headless runs have no window, so video is only initialized if a fallback context needs it
+	const PUi32 sdlFlags = params.headless ? (SDL_INIT_EVENTS | SDL_INIT_TIMER) : (SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER);
+
 	// Initialize the required SDL components
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER) != 0)
+	if (SDL_Init(sdlFlags) != 0)
 	{
 		std::cout << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
 		return false;
@@ -42,7 +137,7 @@ bool Initialise()
 
 	// Create the window
 	m_Window = TMakeShared<PWindow>();
-	if (!m_Window->CreateWindow({ "Game Window", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 720, 720 }))
+	if (!m_Window->CreateWindow(params))
 	{
 		return false;
 	}
@@ -62,26 +157,100 @@ void Cleanup()
 
 int main(int argc, char* argv[])
 {
+	// Offline mode: --encode-texture SOURCE OUTPUT.dds bc1|bc3|bc5|bc7 [srgb] compresses an image and exits
+	if (argc >= 5 && PString(argv[1]) == "--encode-texture")
+	{
+		const PECompressedFormat format = PCompressedTexture::FormatFromName(argv[4]);
+		if (format == CF_UNKNOWN)
+		{
+			std::cout << "Unknown compressed format: " << argv[4] << std::endl;
+			return -1;
+		}
+
+		const bool srgb = argc >= 6 && PString(argv[5]) == "srgb";
+		return PTextureEncoder::EncodeFile(argv[2], argv[3], format, srgb) ? 0 : -1;
+	}
+
+	// Offline mode: --import-benchmark MODEL parses an OBJ or glTF file, logs the throughput and exits
+	if (argc >= 3 && PString(argv[1]) == "--import-benchmark")
+		return PMeshImporter::Benchmark(argv[2]) ? 0 : -1;
+
+	// Offline mode: --optimize-benchmark MODEL optimizes an OBJ or glTF file's meshes, logs their ACMR and ATVR and exits
+	if (argc >= 3 && PString(argv[1]) == "--optimize-benchmark")
+		return PMeshOptimizer::Benchmark(argv[2]) ? 0 : -1;
+
+	// Offline mode: --build-pack FOLDER OUTPUT.pak packs every file under a folder and exits
+	if (argc >= 4 && PString(argv[1]) == "--build-pack")
+		return PPackFile::Write(argv[3], argv[2]) ? 0 : -1;
+
+	// Offline mode: --cook-mesh SOURCE OUTPUT.pmesh [compact] imports an OBJ or glTF file and writes it as a cooked mesh
+	if (argc >= 4 && PString(argv[1]) == "--cook-mesh")
+	{
+		const bool compact = argc >= 5 && PString(argv[4]) == "compact";
+		return PCookedMesh::Cook(argv[2], argv[3], compact ? PCompactVertexLayout::GetInfo() : PStandardVertexLayout::GetInfo()) ? 0 : -1;
+	}
+
+	const PSWindowParams params = ParseArguments(argc, argv);
+
+	// Start recording before anything is initialized so startup shows in the trace
+	if (!m_TracePath.empty())
+	{
+		PProfiler::SetEnabled(true);
+		PProfiler::SetThreadName("Main");
+	}
+
 	// Initialize the engine
-	if (!Initialise())
+	if (!Initialise(params))
 	{
 		Cleanup();
 		return -1;
 	}
 
-	// Register input handling for the window
-	m_Window->RegisterInput(m_Input);
+	// Register input handling for the window, headless runs have nothing to capture
+	if (!params.headless)
+		m_Window->RegisterInput(m_Input);
+
+	// Simulation runs at a fixed rate no matter how fast frames are rendered
+	PFrameTimer frameTimer;
+	frameTimer.SetTickRate(m_TickRate);
+	frameTimer.SetFrameCap(m_FrameCap);
 
 	// Main game loop: run until the window is closed
 	while (!m_Window->IsPendingClose())
 	{
+		// Collect GPU timings from earlier frames
+		PProfiler::BeginFrame();
+
+		PPROFILE_SCOPE("Frame");
+
+		frameTimer.BeginFrame();
+
 		// Update input states
-		m_Input->UpdateInputs();
+		{
+			PPROFILE_SCOPE("Input");
+			m_Input->UpdateInputs();
+		}
+
+		// Run as many simulation ticks as the elapsed time covers
+		{
+			PPROFILE_SCOPE("Simulate");
+			while (frameTimer.ShouldTick())
+			{
+				m_Window->Update(frameTimer.GetTickDelta());
+			}
+		}
 
-		// Render the scene
-		m_Window->Render();
+		// Render the scene between the last two ticks
+		m_Window->Render(frameTimer.GetAlpha());
+
+		// Wait out the rest of the frame if the frame rate is capped
+		frameTimer.LimitFrame();
 	}
 
+	// Write the trace before the engine is torn down
+	if (!m_TracePath.empty())
+		PProfiler::ExportChromeTrace(m_TracePath);
+
 	// Clean up and shut down the engine
 	Cleanup();
 